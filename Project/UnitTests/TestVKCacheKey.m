@@ -0,0 +1,164 @@
+//
+//  TestVKCacheKey.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKCacheKey.h"
+#import "VKCacheKey.h"
+
+
+@implementation TestVKCacheKey
+
+#pragma mark - MurmurHash3 tests
+
+- (void)testMurmurHash3EmptyInput
+{
+    uint64_t hash[2];
+    VKMurmurHash3_x64_128("", 0, 0, hash);
+
+    STAssertEquals(hash[0], 0x0000000000000000ULL, nil);
+    STAssertEquals(hash[1], 0x0000000000000000ULL, nil);
+}
+
+- (void)testMurmurHash3ReferenceVectors
+{
+    uint64_t hash[2];
+    const char *hello = "hello";
+
+    VKMurmurHash3_x64_128(hello, strlen(hello), 0, hash);
+
+    STAssertEquals(hash[0], 0xcbd8a7b341bd9b02ULL, nil);
+    STAssertEquals(hash[1], 0x5b1e906a48ae1d19ULL, nil);
+
+//    строка длиннее одного блока в 16 байт с "хвостом"
+    const char *fox = "The quick brown fox jumps over the lazy dog";
+
+    VKMurmurHash3_x64_128(fox, strlen(fox), 0, hash);
+
+    STAssertEquals(hash[0], 0xe34bbc7bbc071b6cULL, nil);
+    STAssertEquals(hash[1], 0x7a433ca9c49a9347ULL, nil);
+}
+
+#pragma mark - keyForMethod:options: tests
+
+- (void)testKeyFormat
+{
+    NSString *key = [VKCacheKey keyForMethod:@"users.get"
+                                     options:@{@"user_ids" : @"1"}];
+
+    STAssertEquals([key length], (NSUInteger) 32, nil);
+    STAssertTrue(NSNotFound == [key rangeOfCharacterFromSet:[[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdef"] invertedSet]].location,
+                 @"Key must consist of lowercase hex digits");
+}
+
+- (void)testAccessTokenDoesNotAffectKey
+{
+    NSString *key1 = [VKCacheKey keyForMethod:@"friends.get"
+                                      options:@{@"count" : @10, @"access_token" : @"aaa"}];
+    NSString *key2 = [VKCacheKey keyForMethod:@"friends.get"
+                                      options:@{@"count" : @10, @"access_token" : @"bbb"}];
+    NSString *key3 = [VKCacheKey keyForMethod:@"friends.get"
+                                      options:@{@"count" : @10}];
+
+    STAssertEqualObjects(key1, key2, nil);
+    STAssertEqualObjects(key1, key3, nil);
+}
+
+- (void)testParametersOrderDoesNotAffectKey
+{
+    NSString *key1 = [VKCacheKey keyForMethod:@"wall.get"
+                                      options:@{@"owner_id" : @1, @"count" : @20, @"offset" : @40}];
+    NSString *key2 = [VKCacheKey keyForMethod:@"wall.get"
+                                      options:@{@"offset" : @40, @"count" : @20, @"owner_id" : @1}];
+
+    STAssertEqualObjects(key1, key2, nil);
+}
+
+- (void)testParametersWithDifferentCaseAreKept
+{
+    NSString *key1 = [VKCacheKey keyForMethod:@"wall.get"
+                                      options:@{@"count" : @20, @"Count" : @10}];
+    NSString *key2 = [VKCacheKey keyForMethod:@"wall.get"
+                                      options:@{@"count" : @10, @"Count" : @20}];
+
+    STAssertFalse([key1 isEqualToString:key2], @"Parameters should not replace each other");
+}
+
+- (void)testSeparatorsInValuesDoNotMergeParameters
+{
+    NSString *key1 = [VKCacheKey keyForMethod:@"users.get"
+                                      options:@{@"fields" : @"a\nq=b"}];
+    NSString *key2 = [VKCacheKey keyForMethod:@"users.get"
+                                      options:@{@"fields" : @"a", @"q" : @"b"}];
+    NSString *key3 = [VKCacheKey keyForMethod:@"users.get"
+                                      options:@{@"fields=a" : @"b"}];
+    NSString *key4 = [VKCacheKey keyForMethod:@"users.get"
+                                      options:@{@"fields" : @"a=b"}];
+
+    STAssertFalse([key1 isEqualToString:key2], nil);
+    STAssertFalse([key3 isEqualToString:key4], nil);
+}
+
+- (void)testDifferentRequestsHaveDifferentKeys
+{
+    NSString *key1 = [VKCacheKey keyForMethod:@"wall.get"
+                                      options:@{@"owner_id" : @1, @"count" : @20}];
+    NSString *key2 = [VKCacheKey keyForMethod:@"wall.get"
+                                      options:@{@"owner_id" : @1, @"count" : @21}];
+    NSString *key3 = [VKCacheKey keyForMethod:@"wall.getById"
+                                      options:@{@"owner_id" : @1, @"count" : @20}];
+    NSString *key4 = [VKCacheKey keyForMethod:@"wall.get"
+                                      options:@{@"owner_id" : @12, @"count" : @0}];
+
+    STAssertFalse([key1 isEqualToString:key2], nil);
+    STAssertFalse([key1 isEqualToString:key3], nil);
+    STAssertFalse([key1 isEqualToString:key4], nil);
+}
+
+#pragma mark - keyForURL: tests
+
+- (void)testKeyForURLWithoutQuery
+{
+    STAssertEqualObjects([VKCacheKey keyForURL:[NSURL URLWithString:@"hello"]],
+                         @"cbd8a7b341bd9b025b1e906a48ae1d19", nil);
+}
+
+- (void)testKeyForURLSkipsAccessToken
+{
+    NSURL *url1 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=1&access_token=aaa"];
+    NSURL *url2 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?access_token=bbb&user_ids=1"];
+    NSURL *url3 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=1"];
+    NSURL *url4 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=2&access_token=aaa"];
+
+    STAssertEqualObjects([VKCacheKey keyForURL:url1], [VKCacheKey keyForURL:url3], nil);
+    STAssertEqualObjects([VKCacheKey keyForURL:url2], [VKCacheKey keyForURL:url3], nil);
+    STAssertFalse([[VKCacheKey keyForURL:url1] isEqualToString:[VKCacheKey keyForURL:url4]], nil);
+}
+
+- (void)testKeyForURLKeepsSimilarParameters
+{
+    NSURL *url1 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?my_access_token=aaa"];
+    NSURL *url2 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?my_access_token=bbb"];
+
+    STAssertFalse([[VKCacheKey keyForURL:url1] isEqualToString:[VKCacheKey keyForURL:url2]], nil);
+}
+
+- (void)testKeyForAPIURLMatchesKeyForMethod
+{
+    NSString *key = [VKCacheKey keyForMethod:@"users.get"
+                                     options:@{@"user_ids" : @"1,2", @"fields" : @"photo_50 city"}];
+
+    NSURL *url1 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?fields=photo_50%20city&user_ids=1%2C2"];
+    NSURL *url2 = [NSURL URLWithString:@"https://api.vk.com/method/users.get?access_token=aaa&user_ids=1%2C2&fields=photo_50%20city"];
+
+    STAssertEqualObjects([VKCacheKey keyForURL:url1], key, @"URL and method keys should be equal");
+    STAssertEqualObjects([VKCacheKey keyForURL:url2], key, @"Parameters order should not affect key");
+    STAssertEqualObjects([VKCacheKey keyForURL:[NSURL URLWithString:@"https://api.vk.com/method/users.get"]],
+                         [VKCacheKey keyForMethod:@"users.get"
+                                          options:@{}], nil);
+}
+
+@end
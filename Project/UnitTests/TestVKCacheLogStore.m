@@ -0,0 +1,536 @@
+//
+//  TestVKCacheLogStore.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKCacheLogStore.h"
+#import "VKCacheLogStore.h"
+
+
+@implementation TestVKCacheLogStore
+{
+    NSString *_storePath;
+    NSString *_copyPath;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+
+    _storePath = [path stringByAppendingPathComponent:@"Vkontakte-iOS-SDK-v2.0/Caches/logstore"];
+    _copyPath = [path stringByAppendingPathComponent:@"Vkontakte-iOS-SDK-v2.0/Caches/logstore-copy"];
+
+    [[NSFileManager defaultManager] removeItemAtPath:_storePath
+                                               error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:_copyPath
+                                               error:nil];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:_storePath
+                                               error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:_copyPath
+                                               error:nil];
+
+    [super tearDown];
+}
+
+- (NSData *)dataWithString:(NSString *)string
+{
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+//    копия каталога в том виде, в каком его оставило бы аварийное завершение
+- (VKCacheLogStore *)openCopyOfStore
+{
+    [[NSFileManager defaultManager] copyItemAtPath:_storePath
+                                            toPath:_copyPath
+                                             error:nil];
+
+    return [[VKCacheLogStore alloc] initWithDirectory:_copyPath];
+}
+
+#pragma mark - entries tests
+
+- (void)testSetAndRead
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    STAssertTrue([store setData:[self dataWithString:@"value1"]
+                         forKey:@"key1"
+                 expirationTime:100], nil);
+    STAssertTrue([store setData:[self dataWithString:@"value2"]
+                         forKey:@"key2"
+                 expirationTime:200], nil);
+
+    STAssertEqualObjects([store dataForKey:@"key1"], [self dataWithString:@"value1"], nil);
+    STAssertEqualObjects([store dataForKey:@"key2"], [self dataWithString:@"value2"], nil);
+    STAssertNil([store dataForKey:@"key3"], nil);
+    STAssertEquals([store expirationTimeForKey:@"key2"], (NSTimeInterval) 200, nil);
+    STAssertEquals(store.count, (NSUInteger) 2, nil);
+    STAssertEquals(store.segmentsCount, (NSUInteger) 1, nil);
+}
+
+- (void)testOverwriteAndRemove
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    [store setData:[self dataWithString:@"old"]
+            forKey:@"key"
+    expirationTime:100];
+    [store setData:[self dataWithString:@"new value"]
+            forKey:@"key"
+    expirationTime:100];
+
+    STAssertEqualObjects([store dataForKey:@"key"], [self dataWithString:@"new value"], nil);
+    STAssertTrue(store.liveBytes < store.totalBytes, @"Overwritten record must be dead");
+
+    [store removeDataForKey:@"key"];
+
+    STAssertNil([store dataForKey:@"key"], nil);
+    STAssertEquals(store.count, (NSUInteger) 0, nil);
+    STAssertEquals(store.liveBytes, 0ULL, nil);
+}
+
+- (void)testEmptyData
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    [store setData:[NSData data]
+            forKey:@"empty"
+    expirationTime:100];
+
+    STAssertEqualObjects([store dataForKey:@"empty"], [NSData data], nil);
+}
+
+- (void)testRemoveAllData
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    [store setData:[self dataWithString:@"value"]
+            forKey:@"key"
+    expirationTime:100];
+    [store synchronize];
+    [store removeAllData];
+
+    STAssertEquals(store.count, (NSUInteger) 0, nil);
+    STAssertEquals([[[NSFileManager defaultManager] contentsOfDirectoryAtPath:_storePath
+                                                                         error:nil] count], (NSUInteger) 0, nil);
+
+    [store setData:[self dataWithString:@"value"]
+            forKey:@"key"
+    expirationTime:100];
+
+    STAssertEqualObjects([store dataForKey:@"key"], [self dataWithString:@"value"], nil);
+}
+
+#pragma mark - index tests
+
+- (void)testReopenWithIndex
+{
+    @autoreleasepool {
+        VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+        for (NSUInteger i = 0; i < 1000; i++)
+            [store setData:[self dataWithString:[NSString stringWithFormat:@"value%lu", (unsigned long) i]]
+                    forKey:[NSString stringWithFormat:@"key%lu", (unsigned long) i]
+            expirationTime:i];
+
+        [store removeDataForKey:@"key5"];
+        [store synchronize];
+    }
+
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    STAssertEquals(store.count, (NSUInteger) 999, nil);
+    STAssertNil([store dataForKey:@"key5"], nil);
+    STAssertEqualObjects([store dataForKey:@"key999"], [self dataWithString:@"value999"], nil);
+    STAssertEquals([store expirationTimeForKey:@"key999"], (NSTimeInterval) 999, nil);
+}
+
+- (void)testRecordsAfterIndexSaveAreReplayed
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.indexSaveInterval = NSUIntegerMax;
+
+    [store setData:[self dataWithString:@"saved"]
+            forKey:@"saved"
+    expirationTime:100];
+    [store setData:[self dataWithString:@"removed"]
+            forKey:@"removed"
+    expirationTime:100];
+    [store synchronize];
+
+//    эти изменения есть только в сегменте
+    [store setData:[self dataWithString:@"appended"]
+            forKey:@"appended"
+    expirationTime:100];
+    [store setData:[self dataWithString:@"saved again"]
+            forKey:@"saved"
+    expirationTime:100];
+    [store removeDataForKey:@"removed"];
+
+    VKCacheLogStore *recoveredStore = [self openCopyOfStore];
+
+    STAssertEquals(recoveredStore.count, (NSUInteger) 2, nil);
+    STAssertEqualObjects([recoveredStore dataForKey:@"saved"], [self dataWithString:@"saved again"], nil);
+    STAssertEqualObjects([recoveredStore dataForKey:@"appended"], [self dataWithString:@"appended"], nil);
+    STAssertNil([recoveredStore dataForKey:@"removed"], nil);
+}
+
+- (void)testIndexIsRebuiltFromSegments
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.indexSaveInterval = NSUIntegerMax;
+    store.maxSegmentSize = 256;
+
+    for (NSUInteger i = 0; i < 50; i++)
+        [store setData:[self dataWithString:[NSString stringWithFormat:@"value%lu", (unsigned long) i]]
+                forKey:[NSString stringWithFormat:@"key%lu", (unsigned long) (i % 20)]
+        expirationTime:100];
+
+    STAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[_storePath stringByAppendingPathComponent:@"index"]], nil);
+
+    VKCacheLogStore *recoveredStore = [self openCopyOfStore];
+
+    STAssertEquals(recoveredStore.count, (NSUInteger) 20, nil);
+    STAssertEqualObjects([recoveredStore dataForKey:@"key9"], [self dataWithString:@"value49"], nil);
+    STAssertEqualObjects([recoveredStore dataForKey:@"key10"], [self dataWithString:@"value30"], nil);
+}
+
+- (void)testTornRecordIsTruncated
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.indexSaveInterval = NSUIntegerMax;
+
+    [store setData:[self dataWithString:@"value"]
+            forKey:@"key"
+    expirationTime:100];
+
+    [[NSFileManager defaultManager] copyItemAtPath:_storePath
+                                            toPath:_copyPath
+                                             error:nil];
+
+//    обрывок следующей записи в конце сегмента
+    NSString *segmentName = [[[NSFileManager defaultManager] contentsOfDirectoryAtPath:_copyPath
+                                                                                error:nil] lastObject];
+    NSFileHandle *segment = [NSFileHandle fileHandleForWritingAtPath:[_copyPath stringByAppendingPathComponent:segmentName]];
+    [segment seekToEndOfFile];
+    [segment writeData:[self dataWithString:@"VKCR garbage"]];
+    [segment closeFile];
+
+    VKCacheLogStore *recoveredStore = [[VKCacheLogStore alloc] initWithDirectory:_copyPath];
+
+    STAssertEqualObjects([recoveredStore dataForKey:@"key"], [self dataWithString:@"value"], nil);
+    STAssertEquals(recoveredStore.totalBytes, recoveredStore.liveBytes, nil);
+
+    [recoveredStore setData:[self dataWithString:@"next"]
+                     forKey:@"next"
+             expirationTime:100];
+
+    STAssertEqualObjects([recoveredStore dataForKey:@"next"], [self dataWithString:@"next"], nil);
+}
+
+#pragma mark - compaction tests
+
+- (void)testCompaction
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.maxSegmentSize = 1024;
+
+    for (NSUInteger i = 0; i < 500; i++)
+        [store setData:[self dataWithString:[NSString stringWithFormat:@"value%lu", (unsigned long) i]]
+                forKey:[NSString stringWithFormat:@"key%lu", (unsigned long) (i % 10)]
+        expirationTime:100];
+
+    [store compact];
+
+    STAssertEquals(store.count, (NSUInteger) 10, nil);
+    STAssertTrue(store.totalBytes <= 2 * store.liveBytes + 1024, @"Dead records must be compacted");
+
+    for (NSUInteger i = 490; i < 500; i++)
+        STAssertEqualObjects([store dataForKey:[NSString stringWithFormat:@"key%lu", (unsigned long) (i % 10)]],
+                             [self dataWithString:[NSString stringWithFormat:@"value%lu", (unsigned long) i]], nil);
+
+    [store synchronize];
+
+    NSUInteger segmentFilesCount = [[[NSFileManager defaultManager] contentsOfDirectoryAtPath:_storePath
+                                                                                        error:nil] count] - 1;
+
+    STAssertEquals(segmentFilesCount, store.segmentsCount, nil);
+
+    VKCacheLogStore *reopenedStore = [self openCopyOfStore];
+
+    STAssertEqualObjects([reopenedStore dataForKey:@"key0"], [self dataWithString:@"value490"], nil);
+    STAssertEquals(reopenedStore.count, (NSUInteger) 10, nil);
+}
+
+#pragma mark - eviction tests
+
+- (void)fillStore:(VKCacheLogStore *)store
+{
+//    10 записей примерно по 1 КБ
+    NSMutableData *data = [NSMutableData dataWithLength:1000];
+
+    for (NSUInteger i = 0; i < 10; i++) {
+        [store setData:data
+                forKey:[NSString stringWithFormat:@"key%lu", (unsigned long) i]
+        expirationTime:100];
+        [NSThread sleepForTimeInterval:0.01];
+    }
+}
+
+- (void)testLeastRecentlyUsedEntriesAreEvicted
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    [self fillStore:store];
+
+//    key0 и key1 - самые старые, но их недавно читали
+    [store dataForKey:@"key0"];
+    [store recordAccessForKey:@"key1"];
+
+    store.capacity = store.liveBytes / 2;
+    [store evictToCapacity];
+
+    STAssertTrue(store.liveBytes <= store.capacity, nil);
+    STAssertNotNil([store dataForKey:@"key0"], nil);
+    STAssertNotNil([store dataForKey:@"key1"], nil);
+    STAssertNotNil([store dataForKey:@"key9"], nil);
+    STAssertNil([store dataForKey:@"key2"], nil);
+    STAssertNil([store dataForKey:@"key3"], nil);
+}
+
+- (void)testLeastFrequentlyUsedEntriesAreEvicted
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.evictionPolicy = VKCacheEvictionPolicyLFU;
+
+    [self fillStore:store];
+
+//    key0 читают часто, key9 записана последней, но не читалась
+    for (NSUInteger i = 0; i < 5; i++)
+        [store dataForKey:@"key0"];
+
+    [store dataForKey:@"key1"];
+
+    store.capacity = 3000;
+    [store evictToCapacity];
+
+    STAssertTrue(store.liveBytes <= store.capacity, nil);
+    STAssertNotNil([store dataForKey:@"key0"], nil);
+    STAssertNotNil([store dataForKey:@"key1"], nil);
+    STAssertNil([store dataForKey:@"key2"], nil);
+}
+
+- (void)testEvictionRunsInBackground
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.capacity = 5000;
+
+    [self fillStore:store];
+
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+
+    while (store.liveBytes > store.capacity && [timeout timeIntervalSinceNow] > 0)
+        [NSThread sleepForTimeInterval:0.01];
+
+    STAssertTrue(store.liveBytes <= store.capacity, nil);
+    STAssertNotNil([store dataForKey:@"key9"], nil);
+    STAssertNil([store dataForKey:@"key0"], nil);
+}
+
+- (void)testAccessMetadataIsSavedInIndex
+{
+    @autoreleasepool {
+        VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+        store.evictionPolicy = VKCacheEvictionPolicyLFU;
+
+        [self fillStore:store];
+
+        for (NSUInteger i = 0; i < 3; i++)
+            [store dataForKey:@"key2"];
+
+        [store synchronize];
+    }
+
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.evictionPolicy = VKCacheEvictionPolicyLFU;
+    store.capacity = 1500;
+
+    [store evictToCapacity];
+
+    STAssertEquals(store.count, (NSUInteger) 1, nil);
+    STAssertNotNil([store dataForKey:@"key2"], nil);
+}
+
+- (void)testDeadBytesAreCompactedBeforeEviction
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    NSMutableData *data = [NSMutableData dataWithLength:1000];
+
+//    перезаписанные версии одной записи занимают место на диске, хотя живая
+//    только последняя
+    for (NSUInteger i = 0; i < 20; i++)
+        [store setData:data
+                forKey:@"key0"
+        expirationTime:0];
+
+    [store setData:data
+            forKey:@"key1"
+    expirationTime:0];
+
+    store.capacity = 5000;
+    [store evictToCapacity];
+
+    STAssertTrue(store.totalBytes <= store.capacity, @"Dead bytes should be counted");
+    STAssertNotNil([store dataForKey:@"key0"], @"Compaction should be enough");
+    STAssertNotNil([store dataForKey:@"key1"], nil);
+}
+
+- (void)testQuotaIsCheckedAgainstTotalSize
+{
+    VKCacheLogStore *store1 = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    VKCacheLogStore *store2 = [[VKCacheLogStore alloc] initWithDirectory:_copyPath];
+
+    VKCacheQuota *quota = [[VKCacheQuota alloc] init];
+    quota.capacity = 12000;
+
+    [quota addStore:store1];
+    [quota addStore:store2];
+
+    STAssertTrue(quota == store1.quota, nil);
+
+//    пока второе хранилище пустое, первое может занять больше половины квоты
+    [self fillStore:store1];
+    [quota evictToCapacity];
+
+    STAssertEquals(store1.count, (NSUInteger) 10, nil);
+
+    [self fillStore:store2];
+    [quota evictToCapacity];
+
+    STAssertTrue(quota.totalBytes <= quota.capacity, nil);
+    STAssertTrue(store1.count > 0 && store1.count < 10, nil);
+    STAssertTrue(store2.count > 0 && store2.count < 10, nil);
+    STAssertNotNil([store1 dataForKey:@"key9"], nil);
+    STAssertNil([store1 dataForKey:@"key0"], nil);
+
+    [quota removeStore:store2];
+
+    STAssertNil(store2.quota, nil);
+    STAssertEquals([[quota stores] count], (NSUInteger) 1, nil);
+}
+
+#pragma mark - expiration tests
+
+- (void)testExpiredEntriesAreSwept
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    NSTimeInterval currentTime = [[NSDate date] timeIntervalSince1970];
+
+//    истекших записей больше, чем удаляется за одну порцию
+    for (NSUInteger i = 0; i < 300; i++)
+        [store setData:[self dataWithString:@"expired"]
+                forKey:[NSString stringWithFormat:@"expired%lu", (unsigned long) i]
+        expirationTime:currentTime - 300 + i];
+
+    [store setData:[self dataWithString:@"fresh"]
+            forKey:@"fresh"
+    expirationTime:currentTime + 3600];
+    [store setData:[self dataWithString:@"retained"]
+            forKey:@"retained"
+    expirationTime:0];
+
+//    перезаписанная запись истекает по новому времени
+    [store setData:[self dataWithString:@"updated"]
+            forKey:@"expired299"
+    expirationTime:currentTime + 3600];
+
+    STAssertEquals([store sweepExpiredEntries], (NSUInteger) 299, nil);
+    STAssertEquals(store.count, (NSUInteger) 3, nil);
+    STAssertNil([store dataForKey:@"expired0"], nil);
+    STAssertNotNil([store dataForKey:@"expired299"], nil);
+    STAssertNotNil([store dataForKey:@"fresh"], nil);
+    STAssertNotNil([store dataForKey:@"retained"], nil);
+    STAssertEquals([store sweepExpiredEntries], (NSUInteger) 0, nil);
+}
+
+- (void)testSweptEntriesDoNotReturnAfterReopen
+{
+    @autoreleasepool {
+        VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+        NSTimeInterval currentTime = [[NSDate date] timeIntervalSince1970];
+
+        [store setData:[self dataWithString:@"expired"]
+                forKey:@"expired"
+        expirationTime:currentTime - 1];
+        [store setData:[self dataWithString:@"fresh"]
+                forKey:@"fresh"
+        expirationTime:currentTime + 3600];
+
+        [store sweepExpiredEntries];
+    }
+
+//    без индекса удаленные записи определяются по надгробиям в сегменте
+    [[NSFileManager defaultManager] removeItemAtPath:[_storePath stringByAppendingPathComponent:@"index"]
+                                               error:nil];
+
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    STAssertEquals(store.count, (NSUInteger) 1, nil);
+    STAssertNil([store dataForKey:@"expired"], nil);
+    STAssertNotNil([store dataForKey:@"fresh"], nil);
+}
+
+- (void)testExpirationIndexIsRestoredAfterReopen
+{
+    @autoreleasepool {
+        VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+        NSTimeInterval currentTime = [[NSDate date] timeIntervalSince1970];
+
+        for (NSUInteger i = 0; i < 10; i++)
+            [store setData:[self dataWithString:@"value"]
+                    forKey:[NSString stringWithFormat:@"key%lu", (unsigned long) i]
+            expirationTime:(0 == i % 2 ? currentTime - 1 : currentTime + 3600)];
+
+        [store synchronize];
+    }
+
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+
+    STAssertEquals([store sweepExpiredEntries], (NSUInteger) 5, nil);
+    STAssertNil([store dataForKey:@"key0"], nil);
+    STAssertNotNil([store dataForKey:@"key1"], nil);
+}
+
+- (void)testSweepRunsInBackground
+{
+    VKCacheLogStore *store = [[VKCacheLogStore alloc] initWithDirectory:_storePath];
+    store.sweepInterval = 0.1;
+
+    NSTimeInterval currentTime = [[NSDate date] timeIntervalSince1970];
+
+    [store setData:[self dataWithString:@"expiring"]
+            forKey:@"expiring"
+    expirationTime:currentTime + 0.2];
+    [store setData:[self dataWithString:@"fresh"]
+            forKey:@"fresh"
+    expirationTime:currentTime + 3600];
+
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+
+    while (2 == store.count && [timeout timeIntervalSinceNow] > 0)
+        [NSThread sleepForTimeInterval:0.01];
+
+    STAssertEquals(store.count, (NSUInteger) 1, nil);
+    STAssertNotNil([store dataForKey:@"fresh"], nil);
+}
+
+@end
@@ -9,6 +9,11 @@
 #import "TestVKCachedData.h"
 #import "VKCachedData.h"
 #import "NSString+toBase64.h"
+#import "VKCacheKey.h"
+#import "VKCacheLogStore.h"
+#import "VKMemoryCache.h"
+#import "NSData+zlib.h"
+#import "TestVKRequestHelper.h"
 
 
 @implementation TestVKCachedData
@@ -142,4 +147,441 @@
     STAssertTrue(YES, @"Always true");
 }
 
+#pragma mark - compression tests
+
+- (VKCachedDataEntryHeader)waitForCacheEntryForURL:(NSURL *)url
+                                        cachedData:(VKCachedData *)cachedData
+{
+    NSString *key = [VKCacheKey keyForURL:url];
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+
+//    запись выполняется в фоновой очереди
+    while (nil == [cachedData.store dataForKey:key] && [timeout timeIntervalSinceNow] > 0)
+        [NSThread sleepForTimeInterval:0.01];
+
+    VKCachedDataEntryHeader header;
+    memset(&header, 0, sizeof(header));
+
+    NSData *entryData = [cachedData.store dataForKey:key];
+
+    if ([entryData length] >= sizeof(header))
+        memcpy(&header, [entryData bytes], sizeof(header));
+
+    return header;
+}
+
+- (void)testCompressedEntry
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/compression/"];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSMutableString *json = [NSMutableString stringWithString:@"{\"response\":["];
+
+    for (NSUInteger i = 0; i < 500; i++)
+        [json appendFormat:@"{\"id\":%lu,\"first_name\":\"Pavel\",\"last_name\":\"Durov\"},", (unsigned long) i];
+
+    [json appendString:@"{}]}"];
+
+    NSData *response = [json dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *url = [NSURL URLWithString:@"https://api.vk.com/method/friends.get?fields=name"];
+
+//    запись прошлого запуска удаляется из хранилища синхронно, без ожидания фоновой очереди
+    [cachedData.store removeDataForKey:[VKCacheKey keyForURL:url]];
+
+    [cachedData addCachedData:response
+                       forURL:url
+                     liveTime:VKCachedDataLiveTimeOneHour];
+
+    VKCachedDataEntryHeader header = [self waitForCacheEntryForURL:url
+                                                        cachedData:cachedData];
+
+    STAssertEquals(header.codec, (uint16_t) VKCachedDataCodecDeflate, nil);
+    STAssertTrue(header.dataLength < [response length] / 5, @"JSON must be compressed at least 5x");
+    STAssertEqualObjects([cachedData cachedDataForURL:url], response, nil);
+
+    __block NSData *asyncData = nil;
+    __block BOOL isDone = NO;
+
+    [cachedData cachedDataForURL:url
+                    maxStaleTime:0
+                      completion:^(NSData *data, BOOL isStale)
+                      {
+                          asyncData = data;
+                          isDone = YES;
+                      }];
+
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+
+    while (!isDone && [timeout timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+
+    STAssertEqualObjects(asyncData, response, nil);
+}
+
+- (void)testSmallEntryIsNotCompressed
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/compression/"];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSData *response = [@"{\"response\":1}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *url = [NSURL URLWithString:@"https://api.vk.com/method/account.getCounters"];
+
+//    запись прошлого запуска удаляется из хранилища синхронно, без ожидания фоновой очереди
+    [cachedData.store removeDataForKey:[VKCacheKey keyForURL:url]];
+
+    [cachedData addCachedData:response
+                       forURL:url
+                     liveTime:VKCachedDataLiveTimeOneHour];
+
+    VKCachedDataEntryHeader header = [self waitForCacheEntryForURL:url
+                                                        cachedData:cachedData];
+
+    STAssertEquals(header.codec, (uint16_t) VKCachedDataCodecNone, nil);
+    STAssertEquals(header.dataLength, (uint32_t) [response length], nil);
+    STAssertEqualObjects([cachedData cachedDataForURL:url], response, nil);
+}
+
+#pragma mark - log-structured store tests
+
+- (void)testEntriesShareStoreFiles
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/log/"];
+
+    [[NSFileManager defaultManager] removeItemAtPath:myCachePath
+                                               error:nil];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    for (NSUInteger i = 0; i < 100; i++) {
+        NSURL *url = [NSURL URLWithString:[NSString stringWithFormat:@"https://api.vk.com/method/users.get?user_ids=%lu", (unsigned long) i]];
+
+        [cachedData addCachedData:[@"{\"response\":[]}" dataUsingEncoding:NSUTF8StringEncoding]
+                           forURL:url
+                         liveTime:VKCachedDataLiveTimeOneHour];
+    }
+
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+
+    while ([cachedData.store count] < 100 && [timeout timeIntervalSinceNow] > 0)
+        [NSThread sleepForTimeInterval:0.01];
+
+    STAssertEquals([cachedData.store count], (NSUInteger) 100, nil);
+
+    [cachedData.store synchronize];
+
+    NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:myCachePath
+                                                                         error:nil];
+
+//    сегмент и индекс
+    STAssertEquals([files count], (NSUInteger) 2, nil);
+}
+
+- (void)testStoreOperationsKeepTheirOrder
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/order/"];
+
+    [[NSFileManager defaultManager] removeItemAtPath:myCachePath
+                                               error:nil];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSData *response = [@"{\"response\":[]}" dataUsingEncoding:NSUTF8StringEncoding];
+
+//    удаление, отправленное после записи, не должно выполниться раньше нее
+    for (NSUInteger i = 0; i < 100; i++) {
+        NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long) i];
+
+        [cachedData addCachedData:response
+                           forKey:key
+                         liveTime:VKCachedDataLiveTimeOneHour];
+        [cachedData removeCachedDataForKey:key];
+    }
+
+    [cachedData addCachedData:response
+                       forKey:@"last"
+                     liveTime:VKCachedDataLiveTimeOneHour];
+
+//    асинхронное чтение выполняется после всех отправленных ранее операций
+    __block BOOL finished = NO;
+
+    [cachedData cachedDataForKey:@"last"
+                    maxStaleTime:0
+                      completion:^(NSData *data, BOOL isStale)
+                      {
+                          finished = YES;
+                      }];
+
+    BOOL completed = [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return finished;
+    }
+                                            timeout:5];
+
+    STAssertTrue(completed, nil);
+
+    STAssertEquals([cachedData.store count], (NSUInteger) 1, @"Removed entries should not be stored");
+    STAssertNotNil([cachedData.store dataForKey:@"last"], nil);
+
+    [cachedData clearCachedData];
+}
+
+- (void)testRemovedEntryDoesNotReturnToMemory
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/removal/"];
+
+    [[NSFileManager defaultManager] removeItemAtPath:myCachePath
+                                               error:nil];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSData *response = [@"{\"response\":[]}" dataUsingEncoding:NSUTF8StringEncoding];
+
+    for (NSUInteger i = 0; i < 50; i++) {
+        NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long) i];
+
+        [cachedData addCachedData:response
+                           forKey:key
+                         liveTime:VKCachedDataLiveTimeOneHour];
+    }
+
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+
+    while ([cachedData.store count] < 50 && [timeout timeIntervalSinceNow] > 0)
+        [NSThread sleepForTimeInterval:0.01];
+
+//    записи читаются с диска, пока их удаление из хранилища еще в очереди
+    [cachedData.memoryCache removeAllObjects];
+
+    for (NSUInteger i = 0; i < 50; i++) {
+        NSString *key = [NSString stringWithFormat:@"key%lu", (unsigned long) i];
+
+        [cachedData removeCachedDataForKey:key];
+
+        STAssertNil([cachedData cachedDataForKey:key
+                                    maxStaleTime:0
+                                         isStale:NULL], @"Removed entry should not be read");
+        STAssertNil([cachedData.memoryCache objectForKey:key], @"Removed entry should not return to memory");
+    }
+
+    [cachedData clearCachedData];
+}
+
+- (void)testContainsCachedDataDoesNotReadEntry
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/contains/"];
+
+    [[NSFileManager defaultManager] removeItemAtPath:myCachePath
+                                               error:nil];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    STAssertFalse([cachedData containsCachedDataForKey:@"key"], nil);
+
+    [cachedData addCachedData:[@"{\"response\":[]}" dataUsingEncoding:NSUTF8StringEncoding]
+                       forKey:@"key"
+                     liveTime:VKCachedDataLiveTimeOneHour];
+
+    STAssertTrue([cachedData containsCachedDataForKey:@"key"], @"Entry should be found in memory");
+
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+
+    while (0 == [cachedData.store count] && [timeout timeIntervalSinceNow] > 0)
+        [NSThread sleepForTimeInterval:0.01];
+
+    [cachedData.memoryCache removeAllObjects];
+
+    NSUInteger missesCount = cachedData.memoryCache.missesCount;
+
+    STAssertTrue([cachedData containsCachedDataForKey:@"key"], @"Entry should be found on disk");
+    STAssertEquals(cachedData.memoryCache.count, (NSUInteger) 0, @"Entry should not be read into memory");
+    STAssertEquals(cachedData.memoryCache.missesCount, missesCount, nil);
+
+    [cachedData removeCachedDataForKey:@"key"];
+
+    STAssertFalse([cachedData containsCachedDataForKey:@"key"], @"Removed entry should not be found");
+
+    [cachedData clearCachedData];
+}
+
+#pragma mark - entry format tests
+
+- (void)testCorruptedEntryIsDropped
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/format/"];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSData *response = [@"{\"response\":[1,2,3]}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *url = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=1"];
+    NSString *key = [VKCacheKey keyForURL:url];
+
+    [cachedData.store removeAllData];
+    [cachedData addCachedData:response
+                       forURL:url
+                     liveTime:VKCachedDataLiveTimeOneHour];
+
+    VKCachedDataEntryHeader header = [self waitForCacheEntryForURL:url
+                                                        cachedData:cachedData];
+
+    STAssertEquals(header.liveTime, (uint32_t) VKCachedDataLiveTimeOneHour, nil);
+    STAssertEqualObjects([cachedData cachedDataForURL:url], response, nil);
+
+//    данные записи не совпадают с контрольной суммой
+    NSMutableData *corruptedEntry = [[cachedData.store dataForKey:key] mutableCopy];
+    ((uint8_t *) [corruptedEntry mutableBytes])[sizeof(VKCachedDataEntryHeader)] ^= 0xff;
+
+    [cachedData.store setData:corruptedEntry
+                       forKey:key
+               expirationTime:0];
+    [cachedData.memoryCache removeAllObjects];
+
+    STAssertNil([cachedData cachedDataForURL:url], nil);
+
+//    запись в неизвестном формате
+    [cachedData.store setData:[@"<plist/>" dataUsingEncoding:NSUTF8StringEncoding]
+                       forKey:key
+               expirationTime:0];
+    [cachedData.memoryCache removeAllObjects];
+
+    STAssertNil([cachedData cachedDataForURL:url], nil);
+}
+
+#pragma mark - memory tier tests
+
+- (void)testRepeatedReadsAreServedFromMemory
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/memory/"];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSData *response = [@"{\"response\":[{\"id\":1}]}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *url = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=1"];
+
+    [cachedData.store removeAllData];
+    [cachedData addCachedData:response
+                       forURL:url
+                     liveTime:VKCachedDataLiveTimeOneHour];
+
+//    запись доступна сразу, не дожидаясь записи на диск
+    STAssertEqualObjects([cachedData cachedDataForURL:url], response, nil);
+
+    [self waitForCacheEntryForURL:url
+                       cachedData:cachedData];
+    [cachedData.memoryCache removeAllObjects];
+
+//    первое чтение - с диска, следующие - из памяти
+    NSUInteger hitsCount = cachedData.memoryCache.hitsCount;
+
+    for (NSUInteger i = 0; i < 10; i++)
+        STAssertEqualObjects([cachedData cachedDataForURL:url], response, nil);
+
+    STAssertEquals(cachedData.memoryCache.hitsCount - hitsCount, (NSUInteger) 9, nil);
+
+    [cachedData removeCachedDataForURL:url];
+
+    STAssertNil([cachedData.memoryCache objectForKey:[VKCacheKey keyForURL:url]], nil);
+}
+
+#pragma mark - expiration tests
+
+- (void)testExpirationTimeOfStoredEntry
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/expiration/"];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSData *response = [@"{\"response\":[1]}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *url = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=1"];
+    NSURL *offlineURL = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=2"];
+
+    [cachedData.store removeAllData];
+    [cachedData addCachedData:response
+                       forKey:[VKCacheKey keyForURL:url]
+                     liveTime:VKCachedDataLiveTimeOneHour
+                 maxStaleTime:100
+             retainForOffline:NO];
+    [cachedData addCachedData:response
+                       forKey:[VKCacheKey keyForURL:offlineURL]
+                     liveTime:VKCachedDataLiveTimeOneHour
+                 maxStaleTime:0
+             retainForOffline:YES];
+
+//    запись удаляется, когда ее нельзя использовать даже устаревшей
+    VKCachedDataEntryHeader header = [self waitForCacheEntryForURL:url
+                                                        cachedData:cachedData];
+
+    STAssertEquals([cachedData.store expirationTimeForKey:[VKCacheKey keyForURL:url]],
+            header.creationTime + VKCachedDataLiveTimeOneHour + 100, nil);
+
+//    сохраненная для оффлайн режима запись живет дольше, но тоже истекает
+    header = [self waitForCacheEntryForURL:offlineURL
+                                cachedData:cachedData];
+
+    STAssertTrue(0 != (header.flags & kVKCachedDataEntryFlagRetainForOffline), nil);
+    STAssertEquals([cachedData.store expirationTimeForKey:[VKCacheKey keyForURL:offlineURL]],
+            header.creationTime + VKCachedDataLiveTimeOneHour + kVKCachedDataOfflineRetentionTime, nil);
+    STAssertEquals([cachedData.store sweepExpiredEntries], (NSUInteger) 0, nil);
+}
+
+- (void)testExpiredEntryIsNotRemovedOnRead
+{
+    NSString *path = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *myCachePath = [path stringByAppendingFormat:@"/Vkontakte-iOS-SDK-v2.0/Caches/expiration/"];
+
+    VKCachedData *cachedData = [[VKCachedData alloc]
+                                              initWithCacheDirectory:myCachePath];
+
+    NSData *response = [@"{\"response\":[1]}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *url = [NSURL URLWithString:@"https://api.vk.com/method/users.get?user_ids=1"];
+    NSString *key = [VKCacheKey keyForURL:url];
+
+//    запись, истекшая час назад
+    VKCachedDataEntryHeader header;
+    memset(&header, 0, sizeof(header));
+
+    header.magic = 0x45434b56;
+    header.version = 1;
+    header.codec = VKCachedDataCodecNone;
+    header.creationTime = [[NSDate date] timeIntervalSince1970] - 2 * VKCachedDataLiveTimeOneHour;
+    header.liveTime = VKCachedDataLiveTimeOneHour;
+    header.flags = kVKCachedDataEntryFlagRetainForOffline;
+    header.dataLength = (uint32_t) [response length];
+    header.checksum = [response crc32Checksum];
+
+    NSMutableData *entryData = [NSMutableData dataWithBytes:&header
+                                                     length:sizeof(header)];
+    [entryData appendData:response];
+
+    [cachedData.store removeAllData];
+    [cachedData.store setData:entryData
+                       forKey:key
+               expirationTime:0];
+
+    STAssertNil([cachedData cachedDataForURL:url], nil);
+    STAssertNotNil([cachedData.store dataForKey:key], nil);
+    STAssertEqualObjects([cachedData cachedDataForURL:url
+                                          offlineMode:YES], response, nil);
+}
+
 @end
@@ -0,0 +1,255 @@
+//
+//  TestVKChunkedUploadRequest.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKChunkedUploadRequest.h"
+#import "VKChunkedUploadRequest.h"
+#import "VKRetryPolicy.h"
+#import "VKRetryBudget.h"
+#import "TestVKRequestHelper.h"
+
+
+static NSString *const kTestUploadHost = @"upload.test";
+
+
+//    состояние сервера-заглушки
+static NSMutableData *receivedFile;
+static NSMutableArray *receivedOffsets;
+static long long failingChunkOffset = -1;
+
+
+//    сервер-заглушка, принимающий файл по частям
+@interface TestChunkServerProtocol : NSURLProtocol
+@end
+
+@implementation TestChunkServerProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request
+{
+    return [kTestUploadHost isEqualToString:request.URL.host];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request
+{
+    return request;
+}
+
+- (void)startLoading
+{
+    unsigned long long start = 0, end = 0, total = 0;
+    NSScanner *scanner = [NSScanner scannerWithString:[self.request valueForHTTPHeaderField:@"Content-Range"]];
+
+    [scanner scanString:@"bytes" intoString:NULL];
+    [scanner scanUnsignedLongLong:&start];
+    [scanner scanString:@"-" intoString:NULL];
+    [scanner scanUnsignedLongLong:&end];
+    [scanner scanString:@"/" intoString:NULL];
+    [scanner scanUnsignedLongLong:&total];
+
+//    соединение "обрывается" на заданной части
+    if ((long long) start == failingChunkOffset) {
+        failingChunkOffset = -1;
+        [self.client URLProtocol:self
+                didFailWithError:[NSError errorWithDomain:NSURLErrorDomain
+                                                     code:NSURLErrorNetworkConnectionLost
+                                                 userInfo:nil]];
+        return;
+    }
+
+    NSInputStream *bodyStream = self.request.HTTPBodyStream;
+    NSMutableData *chunk = [NSMutableData data];
+    uint8_t buffer[4096];
+
+    [bodyStream open];
+
+    while (YES) {
+        NSInteger count = [bodyStream read:buffer
+                                 maxLength:sizeof(buffer)];
+
+        if (count <= 0)
+            break;
+
+        [chunk appendBytes:buffer
+                    length:(NSUInteger) count];
+    }
+
+    [bodyStream close];
+
+    [receivedOffsets addObject:@(start)];
+    [receivedFile setLength:(NSUInteger) start];
+    [receivedFile appendData:chunk];
+
+    BOOL isLast = (end + 1 == total);
+    NSString *body = (isLast ?
+            [NSString stringWithFormat:@"{\"response\":{\"size\":%llu}}", total] :
+            [NSString stringWithFormat:@"0-%llu/%llu", end, total]);
+
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                              statusCode:(isLast ? 200 : 201)
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:@{}];
+
+    [self.client URLProtocol:self
+          didReceiveResponse:response
+          cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    [self.client URLProtocol:self
+                 didLoadData:[body dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.client URLProtocolDidFinishLoading:self];
+}
+
+- (void)stopLoading
+{
+}
+
+@end
+
+
+@implementation TestVKChunkedUploadRequest
+{
+    NSURL *_fileURL;
+    NSData *_fileData;
+    NSURL *_uploadURL;
+
+    TestVKRequestHelper *_helper;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _helper = [[TestVKRequestHelper alloc] init];
+
+    [NSURLProtocol registerClass:[TestChunkServerProtocol class]];
+
+    receivedFile = [NSMutableData data];
+    receivedOffsets = [NSMutableArray array];
+    failingChunkOffset = -1;
+
+    NSMutableData *fileData = [NSMutableData dataWithLength:3500];
+    uint8_t *bytes = [fileData mutableBytes];
+
+    for (NSUInteger i = 0; i < [fileData length]; i++)
+        bytes[i] = (uint8_t) (i % 253);
+
+    _fileData = fileData;
+    _fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"TestVKChunkedUpload.mp4"]];
+    _uploadURL = [NSURL URLWithString:[NSString stringWithFormat:@"http://%@/upload.php", kTestUploadHost]];
+
+    [_fileData writeToURL:_fileURL
+               atomically:YES];
+}
+
+- (void)tearDown
+{
+    [NSURLProtocol unregisterClass:[TestChunkServerProtocol class]];
+    [[NSFileManager defaultManager] removeItemAtURL:_fileURL
+                                              error:nil];
+
+    [super tearDown];
+}
+
+- (VKChunkedUploadRequest *)uploadRequest
+{
+    VKChunkedUploadRequest *request = [[VKChunkedUploadRequest alloc] initWithUploadURL:_uploadURL
+                                                                                fileURL:_fileURL];
+    request.chunkSize = 1000;
+    request.maxChunkRetries = 0;
+    request.delegate = _helper;
+
+    return request;
+}
+
+#pragma mark - Tests
+
+- (void)testUploadByChunks
+{
+    VKChunkedUploadRequest *request = [self uploadRequest];
+    [request discardProgress];
+
+    [_helper runRequest:request];
+
+    STAssertNil(_helper.error, @"Unexpected error: %@", _helper.error);
+    STAssertEqualObjects(_helper.response[@"response"][@"size"], @3500, nil);
+    STAssertEqualObjects(receivedFile, _fileData, @"Server must receive the whole file");
+    STAssertEqualObjects(receivedOffsets, (@[@0, @1000, @2000, @3000]), nil);
+    STAssertEquals(_helper.uploadedBytes, (NSUInteger) 3500, @"Progress must be aggregated over chunks");
+}
+
+- (void)testResumeAfterConnectionLoss
+{
+    VKChunkedUploadRequest *request = [self uploadRequest];
+    [request discardProgress];
+
+    failingChunkOffset = 2000;
+    [_helper runRequest:request];
+
+    STAssertNotNil(_helper.error, @"Connection loss must be reported when retries are exhausted");
+    STAssertEquals(request.acknowledgedBytes, 2000ULL, nil);
+
+//    новый запрос продолжает загрузку с последней подтвержденной части
+    [receivedOffsets removeAllObjects];
+    [_helper runRequest:[self uploadRequest]];
+
+    STAssertNil(_helper.error, @"Unexpected error: %@", _helper.error);
+    STAssertEqualObjects(receivedOffsets, (@[@2000, @3000]), @"Acknowledged chunks must not be sent again");
+    STAssertEqualObjects(receivedFile, _fileData, nil);
+}
+
+- (void)testChunkRetryFollowsRetryPolicy
+{
+    VKRetryPolicy *policy = [VKRetryPolicy policy];
+    policy.baseDelay = 0.1;
+    policy.budget = [[VKRetryBudget alloc] init];
+
+    VKChunkedUploadRequest *request = [self uploadRequest];
+    request.maxChunkRetries = 3;
+    request.retryPolicy = policy;
+    [request discardProgress];
+
+    failingChunkOffset = 1000;
+    [_helper runRequest:request];
+
+    STAssertNil(_helper.error, @"Failed chunk must be sent again: %@", _helper.error);
+    STAssertEqualObjects(receivedFile, _fileData, nil);
+
+//    без политики повторов ошибка сразу передается делегату
+    request = [self uploadRequest];
+    request.maxChunkRetries = 3;
+    request.retryPolicy = nil;
+    [request discardProgress];
+
+    failingChunkOffset = 1000;
+    [_helper runRequest:request];
+
+    STAssertEquals(_helper.error.code, (NSInteger) NSURLErrorNetworkConnectionLost, nil);
+    STAssertEquals(request.acknowledgedBytes, 1000ULL, nil);
+}
+
+- (void)testChunkRetryDoesNotOutliveDeadline
+{
+    VKRetryPolicy *policy = [VKRetryPolicy policy];
+    policy.baseDelay = 5;
+    policy.budget = [[VKRetryBudget alloc] init];
+
+    VKChunkedUploadRequest *request = [self uploadRequest];
+    request.maxChunkRetries = 3;
+    request.retryPolicy = policy;
+    request.timeout = 1;
+    [request discardProgress];
+
+    failingChunkOffset = 1000;
+
+    NSDate *startDate = [NSDate date];
+    [_helper runRequest:request];
+
+//    повтор не успел бы до крайнего срока, поэтому ошибка приходит сразу
+    STAssertEquals(_helper.error.code, (NSInteger) NSURLErrorNetworkConnectionLost, nil);
+    STAssertTrue([[NSDate date] timeIntervalSinceDate:startDate] < 1, nil);
+    STAssertEquals(request.acknowledgedBytes, 1000ULL, @"Journal must be kept");
+}
+
+@end
@@ -0,0 +1,182 @@
+//
+//  TestVKEntityStore.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKEntityStore.h"
+#import "VKEntityStore.h"
+#import "VKRequest.h"
+#import "VKLoopbackTransport.h"
+
+
+@interface TestVKEntityStore () <VKRequestDelegate>
+@end
+
+
+@implementation TestVKEntityStore
+{
+    id _response;
+}
+
+#pragma mark - VKRequestDelegate
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    _response = response;
+}
+
+#pragma mark - tests
+
+- (void)testSameUserIsShared
+{
+    VKEntityStore *store = [[VKEntityStore alloc] init];
+
+    NSDictionary *friendsGet = @{@"response" : @{@"count" : @1,
+                                                 @"items" : @[@{@"id"         : @1,
+                                                                @"first_name" : @"Pavel",
+                                                                @"last_name"  : @"Durov",
+                                                                @"online"     : @0}]}};
+    NSDictionary *wallGet = @{@"response" : @{@"items"    : @[@{@"id"        : @10,
+                                                                @"owner_id"  : @1,
+                                                                @"from_id"   : @1,
+                                                                @"post_type" : @"post",
+                                                                @"text"      : @"Hello"}],
+                                              @"profiles" : @[@{@"id"         : @1,
+                                                                @"first_name" : @"Pavel",
+                                                                @"last_name"  : @"Durov",
+                                                                @"photo_50"   : @"http://vk.com/1.jpg",
+                                                                @"online"     : @1}],
+                                              @"groups"   : @[@{@"id"          : @1,
+                                                                @"name"        : @"VK API",
+                                                                @"screen_name" : @"apiclub"}]}};
+
+    id friends = [store mergeEntitiesFromJSON:friendsGet];
+    id wall = [store mergeEntitiesFromJSON:wallGet];
+
+    VKEntity *friend = friends[@"response"][@"items"][0];
+    VKEntity *profile = wall[@"response"][@"profiles"][0];
+
+    STAssertTrue([friend isKindOfClass:[VKEntity class]], nil);
+    STAssertTrue(friend == profile, @"Both responses must share one user instance");
+    STAssertEqualObjects(friend[@"photo_50"], @"http://vk.com/1.jpg", @"Fields must be merged");
+    STAssertEqualObjects(friend[@"online"], @1, @"Newer value must win");
+    STAssertEqualObjects(friend[@"last_name"], @"Durov", nil);
+
+    STAssertEquals([wall[@"response"][@"items"][0] entityType], VKEntityTypePost, nil);
+    STAssertEqualObjects([wall[@"response"][@"items"][0] entityID], @"1_10", nil);
+    STAssertEquals([wall[@"response"][@"groups"][0] entityType], VKEntityTypeGroup, nil);
+    STAssertEquals(store.count, (NSUInteger) 3, nil);
+
+    STAssertTrue(friend == [store entityOfType:VKEntityTypeUser
+                                      entityID:@1], nil);
+    STAssertNil([store entityOfType:VKEntityTypeGroup
+                           entityID:@2], nil);
+}
+
+- (void)testFieldFreshness
+{
+    VKEntityStore *store = [[VKEntityStore alloc] init];
+
+    VKEntity *user = [store mergeFields:@{@"first_name" : @"Pavel"}
+                           ofEntityType:VKEntityTypeUser
+                               entityID:@1];
+
+    [user mergeFields:@{@"photo_50" : @"http://vk.com/1.jpg"}
+           updateTime:[[NSDate date] timeIntervalSince1970] - 3600];
+
+    STAssertTrue([user isFieldFresh:@"first_name"
+                             maxAge:60], nil);
+    STAssertFalse([user isFieldFresh:@"photo_50"
+                              maxAge:60], nil);
+    STAssertFalse([user isFieldFresh:@"online"
+                              maxAge:60], nil);
+
+    NSArray *staleFields = [store staleFields:@[@"first_name", @"photo_50", @"online"]
+                                 ofEntityType:VKEntityTypeUser
+                                     entityID:@1
+                                       maxAge:60];
+
+    STAssertEqualObjects(staleFields, (@[@"photo_50", @"online"]), nil);
+
+    NSArray *staleIDs = [store entityIDs:@[@1, @2]
+                         withStaleFields:@[@"first_name"]
+                            ofEntityType:VKEntityTypeUser
+                                  maxAge:60];
+
+    STAssertEqualObjects(staleIDs, @[@2], nil);
+}
+
+- (void)testEntitiesAreNotRetained
+{
+    VKEntityStore *store = [[VKEntityStore alloc] init];
+
+    @autoreleasepool {
+        VKEntity *user = [store mergeFields:@{@"first_name" : @"Pavel"}
+                               ofEntityType:VKEntityTypeUser
+                                   entityID:@1];
+
+        STAssertEquals(store.count, (NSUInteger) 1, nil);
+        STAssertNotNil(user, nil);
+    }
+
+    STAssertNil([store entityOfType:VKEntityTypeUser
+                           entityID:@1], @"Store must not retain unused entities");
+    STAssertEquals(store.count, (NSUInteger) 0, nil);
+}
+
+- (void)testCopyIsSnapshot
+{
+    VKEntityStore *store = [[VKEntityStore alloc] init];
+
+    VKEntity *user = [store mergeFields:@{@"first_name" : @"Pavel", @"online" : @0}
+                           ofEntityType:VKEntityTypeUser
+                               entityID:@1];
+    NSDictionary *snapshot = [user copy];
+
+    [store mergeFields:@{@"online" : @1}
+          ofEntityType:VKEntityTypeUser
+              entityID:@1];
+
+    STAssertEqualObjects(user[@"online"], @1, nil);
+    STAssertEqualObjects(snapshot[@"online"], @0, nil);
+    STAssertEqualObjects(snapshot, (@{@"first_name" : @"Pavel", @"online" : @0}), nil);
+}
+
+- (void)testRequestMergesResponse
+{
+    VKEntityStore *store = [[VKEntityStore alloc] init];
+    VKEntity *user = [store mergeFields:@{@"first_name" : @"Pavel"}
+                           ofEntityType:VKEntityTypeUser
+                               entityID:@1];
+
+    VKLoopbackTransport *transport = [[VKLoopbackTransport alloc] init];
+    [transport setResponse:[VKLoopbackResponse responseWithJSONObject:@{@"response" : @[@{@"id"         : @1,
+                                                                                          @"first_name" : @"Pavel",
+                                                                                          @"photo_50"   : @"http://vk.com/1.jpg"}]}]
+                 forMethod:@"users.get"];
+
+    VKRequest *request = [VKRequest requestMethod:@"users.get"
+                                          options:@{@"fields" : @"photo_50"}
+                                         delegate:self];
+    request.cacheLiveTime = VKCachedDataLiveTimeNever;
+    request.cachePolicy = VKRequestCachePolicyNetworkOnly;
+    request.transport = transport;
+    request.entityStore = store;
+
+    [request start];
+
+    NSDate *date = [NSDate dateWithTimeIntervalSinceNow:5];
+
+    while (nil == _response && [date timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.02]];
+
+    STAssertTrue(_response[@"response"][0] == user, @"Response must contain shared entity");
+    STAssertEqualObjects(user[@"photo_50"], @"http://vk.com/1.jpg", nil);
+}
+
+@end
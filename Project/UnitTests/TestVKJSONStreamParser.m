@@ -0,0 +1,215 @@
+//
+//  TestVKJSONStreamParser.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKJSONStreamParser.h"
+#import "VKJSONStreamParser.h"
+
+
+@interface TestVKJSONStreamParser () <VKJSONStreamParserDelegate>
+@end
+
+
+@implementation TestVKJSONStreamParser
+{
+    NSMutableArray *_rootKeys;
+    NSMutableArray *_items;
+    BOOL _stopOnError;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _rootKeys = [NSMutableArray array];
+    _items = [NSMutableArray array];
+    _stopOnError = NO;
+}
+
+//    разбирает документ кусками заданного размера
+- (id)parseString:(NSString *)string
+        chunkSize:(NSUInteger)chunkSize
+            error:(NSError **)error
+{
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    VKJSONStreamParser *parser = [[VKJSONStreamParser alloc] init];
+    parser.delegate = self;
+
+    for (NSUInteger offset = 0; offset < [data length]; offset += chunkSize) {
+        NSRange range = NSMakeRange(offset, MIN(chunkSize, [data length] - offset));
+
+        if (![parser parseData:[data subdataWithRange:range]])
+            break;
+    }
+
+    BOOL finished = [parser finish];
+
+    if (nil != error)
+        *error = parser.error;
+
+    return (finished ? parser.rootObject : nil);
+}
+
+- (void)assertString:(NSString *)string
+{
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    id expected = [NSJSONSerialization JSONObjectWithData:data
+                                                  options:NSJSONReadingAllowFragments
+                                                    error:nil];
+
+//    результат не должен зависеть от того, как документ разбит на части
+    for (NSUInteger chunkSize = 1; chunkSize <= [data length]; chunkSize *= 2) {
+        NSError *error = nil;
+        id result = [self parseString:string
+                            chunkSize:chunkSize
+                                error:&error];
+
+        STAssertNil(error, @"Unexpected error: %@", error);
+        STAssertEqualObjects(result, expected, @"Chunk size: %u", chunkSize);
+    }
+}
+
+#pragma mark - VKJSONStreamParserDelegate
+
+- (void)      parser:(VKJSONStreamParser *)parser
+       didParseValue:(id)value
+          forRootKey:(NSString *)key
+{
+    [_rootKeys addObject:key];
+
+    if (_stopOnError && [@"error" isEqualToString:key])
+        [parser stop];
+}
+
+- (void)parser:(VKJSONStreamParser *)parser
+   didParseItem:(id)item
+{
+    [_items addObject:item];
+}
+
+#pragma mark - Tests
+
+- (void)testObjectsAndArrays
+{
+    [self assertString:@"{\"response\":[{\"uid\":1,\"first_name\":\"Pavel\",\"online\":0},{\"uid\":2,\"list\":[]}],\"empty\":{}}"];
+    [self assertString:@" [ 1 , [ 2 , [ 3 ] ] , { \"a\" : { \"b\" : null } } ] "];
+}
+
+- (void)testNumbers
+{
+    [self assertString:@"[0,-1,42,9223372036854775807,-9223372036854775808,1.5,-0.25,1e3,2.5E-2]"];
+
+    NSNumber *number = [self parseString:@"12345"
+                               chunkSize:2
+                                   error:nil];
+    STAssertEqualObjects(number, @12345, @"Root number fragment must be parsed on finish");
+
+    NSNumber *big = [self parseString:@"[18446744073709551616]"
+                            chunkSize:3
+                                error:nil][0];
+    STAssertEqualObjects([big stringValue], @"18446744073709551616", @"Big integer must not lose precision");
+}
+
+- (void)testLiterals
+{
+    NSArray *result = [self parseString:@"[true,false,null]"
+                              chunkSize:1
+                                  error:nil];
+
+    STAssertEqualObjects(result[0], @YES, nil);
+    STAssertEqualObjects(result[1], @NO, nil);
+    STAssertEqualObjects(result[2], [NSNull null], nil);
+}
+
+- (void)testStrings
+{
+    [self assertString:@"[\"\",\"plain\",\"quote \\\" slash \\\\ \\/ \\b\\f\\n\\r\\t\"]"];
+    [self assertString:@"[\"\\u041f\\u0440\\u0438\\u0432\\u0435\\u0442\",\"Привет\"]"];
+
+    NSString *emoji = [self parseString:@"\"\\ud83d\\ude00\""
+                              chunkSize:1
+                                  error:nil];
+    STAssertEqualObjects(emoji, @"\U0001F600", @"Surrogate pair must be decoded");
+}
+
+- (void)testMutableContainers
+{
+    NSMutableDictionary *result = [self parseString:@"{\"items\":[\"a\"]}"
+                                          chunkSize:4
+                                              error:nil];
+
+    STAssertNoThrow(result[@"new"] = @1, nil);
+    STAssertNoThrow([result[@"items"] addObject:@"b"], nil);
+}
+
+- (void)testInvalidDocuments
+{
+    for (NSString *string in @[@"", @"{", @"[1,]", @"{\"a\" 1}", @"[tru]", @"[1] 2", @"\"\\x\"", @"[-]"]) {
+        NSError *error = nil;
+        id result = [self parseString:string
+                            chunkSize:1
+                                error:&error];
+
+        STAssertNil(result, @"Document must be rejected: %@", string);
+        STAssertEqualObjects(error.domain, kVKJSONStreamParserErrorDomain, @"Document: %@", string);
+    }
+}
+
+- (void)testRootKeys
+{
+    [self parseString:@"{\"response\":{\"count\":2,\"items\":[1,2]},\"extra\":true}"
+            chunkSize:3
+                error:nil];
+
+    STAssertEqualObjects(_rootKeys, (@[@"response", @"extra"]), @"Only root keys must be reported");
+}
+
+- (void)testStopOnEarlyError
+{
+    _stopOnError = YES;
+
+    NSString *string = @"{\"error\":{\"error_code\":5},\"tail\":";
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    VKJSONStreamParser *parser = [[VKJSONStreamParser alloc] init];
+    parser.delegate = self;
+
+    STAssertFalse([parser parseData:data], @"Stopped parser must report NO");
+    STAssertNil(parser.error, @"Stopping is not an error");
+    STAssertEqualObjects(_rootKeys, @[@"error"], nil);
+}
+
+- (void)testStreamedArray
+{
+    NSData *data = [@"{\"response\":{\"count\":3,\"items\":[{\"id\":1,\"items\":[7]},2,[3]]}}" dataUsingEncoding:NSUTF8StringEncoding];
+    VKJSONStreamParser *parser = [[VKJSONStreamParser alloc] init];
+    parser.delegate = self;
+    parser.streamedArrayKeyPaths = [NSSet setWithObjects:@"response.items", nil];
+
+    for (NSUInteger i = 0; i < [data length]; i++)
+        [parser parseData:[data subdataWithRange:NSMakeRange(i, 1)]];
+
+    STAssertTrue([parser finish], @"Document must be parsed");
+    STAssertEqualObjects(_items, (@[@{@"id" : @1, @"items" : @[@7]}, @2, @[@3]]), @"Items must be passed one by one");
+    STAssertEqualObjects(parser.rootObject[@"response"][@"items"], @[], @"Streamed array must stay empty");
+    STAssertEqualObjects(parser.rootObject[@"response"][@"count"], @3, nil);
+}
+
+- (void)testOnlyFirstMatchingArrayIsStreamed
+{
+    NSData *data = [@"{\"response\":{\"items\":[1,2],\"users\":[3,4]}}" dataUsingEncoding:NSUTF8StringEncoding];
+    VKJSONStreamParser *parser = [[VKJSONStreamParser alloc] init];
+    parser.delegate = self;
+    parser.streamedArrayKeyPaths = [NSSet setWithObjects:@"response.items", @"response.users", nil];
+
+    [parser parseData:data];
+
+    STAssertTrue([parser finish], @"Document must be parsed");
+    STAssertEqualObjects(_items, (@[@1, @2]), @"Only the first matching array must be streamed");
+    STAssertEqualObjects(parser.rootObject[@"response"][@"users"], (@[@3, @4]), @"Next matching array must be parsed as usual");
+}
+
+@end
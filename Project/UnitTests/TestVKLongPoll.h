@@ -0,0 +1,13 @@
+//
+//  TestVKLongPoll.h
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import <SenTestingKit/SenTestingKit.h>
+
+@interface TestVKLongPoll : SenTestCase
+
+@end
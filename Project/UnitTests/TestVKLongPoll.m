@@ -0,0 +1,301 @@
+//
+//  TestVKLongPoll.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKLongPoll.h"
+#import "VKLongPoll.h"
+#import "VKAccessToken.h"
+#import "TestVKRequestHelper.h"
+
+
+#define kTestVKLongPollUserID 1234567
+
+
+@interface TestVKLongPoll () <VKLongPollDelegate>
+@end
+
+
+@implementation TestVKLongPoll
+{
+    TestVKRequestHelper *_helper;
+    VKAccessToken *_accessToken;
+
+//    состояние "сервера"
+    NSUInteger _serverTs;
+    NSMutableArray *_pendingUpdates;
+    NSMutableArray *_failures;
+    NSMutableArray *_checkedKeys;
+    NSUInteger _serverRequestsCount;
+    NSUInteger _historyRequestedTs;
+    NSUInteger _truncatedResponsesCount;
+
+    NSMutableArray *_events;
+    id _error;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _accessToken = [[VKAccessToken alloc] initWithUserID:kTestVKLongPollUserID
+                                             accessToken:@"token"];
+
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:[NSString stringWithFormat:@"VKLongPoll.%d", kTestVKLongPollUserID]];
+
+    _serverTs = 100;
+    _pendingUpdates = [[NSMutableArray alloc] init];
+    _failures = [[NSMutableArray alloc] init];
+    _checkedKeys = [[NSMutableArray alloc] init];
+    _serverRequestsCount = 0;
+    _historyRequestedTs = 0;
+    _truncatedResponsesCount = 0;
+    _events = [[NSMutableArray alloc] init];
+    _error = nil;
+
+    __weak TestVKLongPoll *weakSelf = self;
+
+    _helper = [[TestVKRequestHelper alloc] init];
+    _helper.transport.latency = 0.02;
+    _helper.transport.responseHandler = ^VKLoopbackResponse *(NSURLRequest *request)
+    {
+        return [weakSelf responseForRequest:request];
+    };
+}
+
+- (VKLoopbackResponse *)responseForRequest:(NSURLRequest *)request
+{
+    NSDictionary *parameters = [TestVKRequestHelper parametersOfRequest:request];
+    NSString *path = [request.URL lastPathComponent];
+
+    @synchronized (self) {
+        if ([@"messages.getLongPollServer" isEqualToString:path]) {
+            _serverRequestsCount++;
+
+            return [VKLoopbackResponse responseWithJSONObject:@{@"response" : @{@"key"    : [NSString stringWithFormat:@"key%lu", (unsigned long) _serverRequestsCount],
+                                                                                @"server" : @"localhost/im",
+                                                                                @"ts"     : @(_serverTs),
+                                                                                @"pts"    : @5000}}];
+        }
+
+        if ([@"messages.getLongPollHistory" isEqualToString:path]) {
+            _historyRequestedTs = (NSUInteger) [parameters[@"ts"] integerValue];
+
+            return [VKLoopbackResponse responseWithJSONObject:@{@"response" : @{@"history" : @[@[@4, @77, @1, @42, @1400000000, @"", @"missed", @{}]],
+                                                                                @"new_pts" : @5001}}];
+        }
+
+        [_checkedKeys addObject:parameters[@"key"]];
+
+        if (0 != [_failures count]) {
+            NSNumber *failed = _failures[0];
+            [_failures removeObjectAtIndex:0];
+
+            return [VKLoopbackResponse responseWithJSONObject:@{@"failed" : failed,
+                                                                @"ts"     : @(_serverTs)}];
+        }
+
+//        соединение обрывается на середине ответа, ts клиента при этом не меняется
+        if (0 != _truncatedResponsesCount) {
+            _truncatedResponsesCount--;
+
+            NSData *body = [NSJSONSerialization dataWithJSONObject:@{@"updates" : _pendingUpdates}
+                                                           options:0
+                                                             error:nil];
+
+            return [VKLoopbackResponse responseWithStatusCode:200
+                                                      headers:@{@"Content-Type" : @"application/json"}
+                                                         body:[body subdataWithRange:NSMakeRange(0, [body length] * 3 / 4)]];
+        }
+
+        NSArray *updates = [_pendingUpdates copy];
+        [_pendingUpdates removeAllObjects];
+        _serverTs += [updates count];
+
+        return [VKLoopbackResponse responseWithJSONObject:@{@"ts"      : @(_serverTs),
+                                                            @"updates" : updates}];
+    }
+}
+
+- (VKLongPoll *)longPoll
+{
+    VKLongPoll *longPoll = [[VKLongPoll alloc] initWithAccessToken:_accessToken];
+    longPoll.delegate = self;
+    longPoll.transport = _helper.transport;
+
+    return longPoll;
+}
+
+- (void)waitForEvents:(NSUInteger)count
+              timeout:(NSTimeInterval)timeout
+{
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return ([_events count] >= count || nil != _error);
+    }
+                           timeout:timeout];
+}
+
+#pragma mark - VKLongPollDelegate
+
+- (void)longPoll:(VKLongPoll *)longPoll
+didReceiveEvents:(NSArray *)events
+{
+    [_events addObjectsFromArray:events];
+}
+
+- (void)longPoll:(VKLongPoll *)longPoll
+didFailWithError:(id)error
+{
+    _error = error;
+}
+
+#pragma mark - tests
+
+- (void)testEventDecoding
+{
+    VKLongPollEvent *message = [VKLongPollEvent eventWithUpdate:@[@4, @10, @3, @2000000001, @1400000000, @" ... ", @"hello", @{@"attach1" : @"1_2"}]];
+
+    STAssertEquals(message.type, VKLongPollEventTypeNewMessage, nil);
+    STAssertEquals(message.messageID, (NSUInteger) 10, nil);
+    STAssertEquals(message.flags, (NSUInteger) 3, nil);
+    STAssertEquals(message.peerID, (NSInteger) 2000000001, nil);
+    STAssertEqualObjects(message.date, [NSDate dateWithTimeIntervalSince1970:1400000000], nil);
+    STAssertEqualObjects(message.text, @"hello", nil);
+    STAssertEqualObjects(message.attachments[@"attach1"], @"1_2", nil);
+
+    VKLongPollEvent *online = [VKLongPollEvent eventWithUpdate:@[@8, @-42, @1]];
+
+    STAssertEquals(online.type, VKLongPollEventTypeFriendOnline, nil);
+    STAssertEquals(online.userID, (NSUInteger) 42, nil);
+
+    VKLongPollEvent *typing = [VKLongPollEvent eventWithUpdate:@[@62, @42, @7]];
+
+    STAssertEquals(typing.userID, (NSUInteger) 42, nil);
+    STAssertEquals(typing.chatID, (NSUInteger) 7, nil);
+
+    STAssertNil([VKLongPollEvent eventWithUpdate:@[]], nil);
+    STAssertNil([VKLongPollEvent eventWithUpdate:(NSArray *) @{}], nil);
+}
+
+- (void)testEventsAreReceived
+{
+    [_pendingUpdates addObject:@[@4, @1, @1, @42, @1400000000, @"", @"first", @{}]];
+    [_pendingUpdates addObject:@[@8, @-42, @1]];
+
+    VKLongPoll *longPoll = [self longPoll];
+    [longPoll start];
+
+    [self waitForEvents:2
+                timeout:5];
+
+    STAssertEquals([_events count], (NSUInteger) 2, nil);
+    STAssertEqualObjects([_events[0] text], @"first", nil);
+    STAssertEquals([_events[1] type], VKLongPollEventTypeFriendOnline, nil);
+    STAssertEqualObjects(longPoll.server, @"localhost/im", nil);
+    STAssertEquals(_serverRequestsCount, (NSUInteger) 1, nil);
+
+    [longPoll stop];
+
+    STAssertEquals(longPoll.ts, (NSUInteger) 102, nil);
+}
+
+- (void)testEventsAreNotRepeatedAfterDroppedConnection
+{
+//    больше одной порции событий, чтобы часть успела дойти до делегата до обрыва
+    for (NSUInteger i = 1; i <= 150; i++)
+        [_pendingUpdates addObject:@[@8, @(-(NSInteger) i), @1]];
+
+    _truncatedResponsesCount = 1;
+
+    VKLongPoll *longPoll = [self longPoll];
+    [longPoll start];
+
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return ([_checkedKeys count] >= 3);
+    }
+                           timeout:10];
+
+    [longPoll stop];
+
+    STAssertEquals([_events count], (NSUInteger) 150, @"Events streamed before the drop must not be repeated");
+    STAssertEquals([[_events lastObject] userID], (NSUInteger) 150, nil);
+    STAssertEquals(longPoll.ts, (NSUInteger) 250, nil);
+}
+
+- (void)testExpiredKeyIsRefetched
+{
+    [_failures addObject:@2];
+
+    VKLongPoll *longPoll = [self longPoll];
+    [longPoll start];
+
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return ([_checkedKeys count] >= 2);
+    }
+                           timeout:5];
+
+    [longPoll stop];
+
+    STAssertEquals(_serverRequestsCount, (NSUInteger) 2, nil);
+    STAssertEqualObjects(_checkedKeys[0], @"key1", nil);
+    STAssertEqualObjects(_checkedKeys[1], @"key2", nil);
+    STAssertNil(_error, nil);
+}
+
+- (void)testOutdatedHistoryIsCaughtUp
+{
+    [_failures addObject:@1];
+
+    VKLongPoll *longPoll = [self longPoll];
+    [longPoll start];
+
+    [self waitForEvents:1
+                timeout:5];
+
+    [longPoll stop];
+
+    STAssertEquals(_historyRequestedTs, (NSUInteger) 100, nil);
+    STAssertEquals([_events count], (NSUInteger) 1, nil);
+    STAssertEqualObjects([_events[0] text], @"missed", nil);
+    STAssertEquals(longPoll.pts, (NSUInteger) 5001, nil);
+}
+
+- (void)testTsIsPersisted
+{
+    [_pendingUpdates addObject:@[@80, @3, @0]];
+
+    VKLongPoll *longPoll = [self longPoll];
+    [longPoll start];
+
+    [self waitForEvents:1
+                timeout:5];
+
+    [longPoll stop];
+
+    STAssertEquals(longPoll.ts, (NSUInteger) 101, nil);
+
+//    после "перезапуска" пропущенные события запрашиваются по сохраненному ts
+    VKLongPoll *restoredLongPoll = [self longPoll];
+
+    STAssertEquals(restoredLongPoll.ts, (NSUInteger) 101, nil);
+
+    _serverTs = 110;
+    [_events removeAllObjects];
+    [restoredLongPoll start];
+
+    [self waitForEvents:1
+                timeout:5];
+
+    [restoredLongPoll stop];
+
+    STAssertEquals(_historyRequestedTs, (NSUInteger) 101, nil);
+    STAssertEqualObjects([_events[0] text], @"missed", nil);
+}
+
+@end
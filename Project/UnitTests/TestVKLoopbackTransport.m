@@ -0,0 +1,74 @@
+//
+//  TestVKLoopbackTransport.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKLoopbackTransport.h"
+#import "TestVKRequestHelper.h"
+
+
+@implementation TestVKLoopbackTransport
+{
+    TestVKRequestHelper *_helper;
+    VKLoopbackTransport *_transport;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _helper = [[TestVKRequestHelper alloc] init];
+    _transport = _helper.transport;
+//    маленькие порции, чтобы ответ приходил в несколько вызовов
+    _transport.chunkSize = 7;
+}
+
+- (VKRequest *)requestMethod:(NSString *)methodName
+{
+    return [_helper requestMethod:methodName
+                          options:@{@"user_ids" : @"1"}];
+}
+
+#pragma mark - Tests
+
+- (void)testCannedResponse
+{
+    NSDictionary *json = @{@"response" : @[@{@"id" : @1, @"first_name" : @"Pavel"}]};
+    [_transport setResponse:[VKLoopbackResponse responseWithJSONObject:json]
+                  forMethod:@"users.get"];
+
+    [_helper runRequest:[self requestMethod:@"users.get"]];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 1, @"Request must finish without network access");
+    STAssertNil(_helper.error, @"Unexpected error: %@", _helper.error);
+    STAssertEqualObjects(_helper.response, json, nil);
+    STAssertEquals(_transport.startedTasksCount, (NSUInteger) 1, nil);
+}
+
+- (void)testResponseHandlerHasPriority
+{
+    [_transport setResponse:[VKLoopbackResponse responseWithJSONObject:@{@"response" : @0}]
+                  forMethod:@"users.get"];
+    _transport.responseHandler = ^VKLoopbackResponse *(NSURLRequest *request)
+    {
+        return [VKLoopbackResponse responseWithJSONObject:@{@"response" : @1}];
+    };
+
+    [_helper runRequest:[self requestMethod:@"users.get"]];
+
+    STAssertEqualObjects(_helper.response[@"response"], @1, nil);
+}
+
+- (void)testUnknownMethod
+{
+    [_helper runRequest:[self requestMethod:@"friends.get"]];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 1, nil);
+    STAssertNil(_helper.response, nil);
+    STAssertEqualObjects(_helper.responseError[@"error_code"], @3, @"Unknown method must be reported as API error");
+}
+
+@end
@@ -0,0 +1,114 @@
+//
+//  TestVKMemoryCache.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKMemoryCache.h"
+#import "VKMemoryCache.h"
+
+
+@implementation TestVKMemoryCache
+
+- (void)testSetAndGet
+{
+    VKMemoryCache *cache = [[VKMemoryCache alloc] initWithCapacity:100];
+
+    [cache setObject:@"a"
+              forKey:@"key1"
+                cost:10];
+    [cache setObject:@"b"
+              forKey:@"key2"
+                cost:20];
+
+    STAssertEqualObjects([cache objectForKey:@"key1"], @"a", nil);
+    STAssertEqualObjects([cache objectForKey:@"key2"], @"b", nil);
+    STAssertNil([cache objectForKey:@"key3"], nil);
+    STAssertEquals(cache.totalCost, (NSUInteger) 30, nil);
+    STAssertEquals(cache.count, (NSUInteger) 2, nil);
+    STAssertEquals(cache.hitsCount, (NSUInteger) 2, nil);
+    STAssertEquals(cache.missesCount, (NSUInteger) 1, nil);
+
+//    замена объекта пересчитывает стоимость
+    [cache setObject:@"c"
+              forKey:@"key1"
+                cost:5];
+
+    STAssertEqualObjects([cache objectForKey:@"key1"], @"c", nil);
+    STAssertEquals(cache.totalCost, (NSUInteger) 25, nil);
+
+    [cache removeObjectForKey:@"key2"];
+
+    STAssertNil([cache objectForKey:@"key2"], nil);
+    STAssertEquals(cache.totalCost, (NSUInteger) 5, nil);
+}
+
+- (void)testLeastRecentlyUsedObjectsAreEvicted
+{
+    VKMemoryCache *cache = [[VKMemoryCache alloc] initWithCapacity:30];
+
+    [cache setObject:@"a"
+              forKey:@"a"
+                cost:10];
+    [cache setObject:@"b"
+              forKey:@"b"
+                cost:10];
+    [cache setObject:@"c"
+              forKey:@"c"
+                cost:10];
+
+//    "a" становится последним использованным, вытесняется "b"
+    [cache objectForKey:@"a"];
+    [cache setObject:@"d"
+              forKey:@"d"
+                cost:10];
+
+    STAssertNil([cache objectForKey:@"b"], nil);
+    STAssertNotNil([cache objectForKey:@"a"], nil);
+    STAssertNotNil([cache objectForKey:@"c"], nil);
+    STAssertNotNil([cache objectForKey:@"d"], nil);
+    STAssertEquals(cache.totalCost, (NSUInteger) 30, nil);
+
+//    объект дороже всего кэша не хранится
+    [cache setObject:@"e"
+              forKey:@"e"
+                cost:31];
+
+    STAssertNil([cache objectForKey:@"e"], nil);
+    STAssertEquals(cache.count, (NSUInteger) 3, nil);
+}
+
+- (void)testCapacityDecrease
+{
+    VKMemoryCache *cache = [[VKMemoryCache alloc] initWithCapacity:100];
+
+    for (NSUInteger i = 0; i < 10; i++)
+        [cache setObject:@(i)
+                  forKey:@(i)
+                    cost:10];
+
+    cache.capacity = 35;
+
+    STAssertEquals(cache.count, (NSUInteger) 3, nil);
+    STAssertEqualObjects([cache objectForKey:@9], @9, nil);
+    STAssertNil([cache objectForKey:@6], nil);
+}
+
+- (void)testMemoryWarning
+{
+    VKMemoryCache *cache = [[VKMemoryCache alloc] initWithCapacity:100];
+
+    [cache setObject:@"a"
+              forKey:@"a"
+                cost:10];
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationDidReceiveMemoryWarningNotification
+                                                        object:nil];
+
+    STAssertEquals(cache.count, (NSUInteger) 0, nil);
+    STAssertEquals(cache.totalCost, (NSUInteger) 0, nil);
+}
+
+@end
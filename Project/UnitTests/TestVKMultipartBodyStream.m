@@ -0,0 +1,109 @@
+//
+//  TestVKMultipartBodyStream.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKMultipartBodyStream.h"
+#import "VKMultipartBodyStream.h"
+
+
+@implementation TestVKMultipartBodyStream
+{
+    NSURL *_fileURL;
+    NSData *_fileData;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+//    файл больше области отображения, чтобы проверить переход между областями
+    NSMutableData *fileData = [NSMutableData dataWithLength:kVKMultipartBodyStreamMappingSize + 12345];
+    uint8_t *bytes = [fileData mutableBytes];
+
+    for (NSUInteger i = 0; i < [fileData length]; i++)
+        bytes[i] = (uint8_t) (i % 251);
+
+    _fileData = fileData;
+    _fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"TestVKMultipartBodyStream.bin"]];
+
+    [_fileData writeToURL:_fileURL
+               atomically:YES];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:_fileURL
+                                              error:nil];
+
+    [super tearDown];
+}
+
+- (NSData *)readStream:(NSInputStream *)stream
+            bufferSize:(NSUInteger)bufferSize
+{
+    NSMutableData *result = [NSMutableData data];
+    uint8_t *buffer = malloc(bufferSize);
+
+    [stream open];
+
+    while (YES) {
+        NSInteger count = [stream read:buffer
+                             maxLength:bufferSize];
+
+        if (count <= 0)
+            break;
+
+        [result appendBytes:buffer
+                     length:(NSUInteger) count];
+    }
+
+    [stream close];
+    free(buffer);
+
+    return result;
+}
+
+- (void)testWholeFile
+{
+    NSData *header = [@"header" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *footer = [@"footer" dataUsingEncoding:NSUTF8StringEncoding];
+    VKBodyFilePart *filePart = [VKBodyFilePart partWithFileURL:_fileURL];
+
+    VKMultipartBodyStream *stream = [[VKMultipartBodyStream alloc] initWithParts:@[header, filePart, [NSData data], footer]];
+
+    NSMutableData *expected = [NSMutableData dataWithData:header];
+    [expected appendData:_fileData];
+    [expected appendData:footer];
+
+    STAssertEquals(stream.contentLength, (unsigned long long) [expected length], @"Content length must be exact");
+    STAssertEqualObjects([self readStream:stream bufferSize:32768], expected, nil);
+    STAssertEquals([stream streamStatus], NSStreamStatusClosed, nil);
+
+//    копия потока читается заново с самого начала
+    STAssertEqualObjects([self readStream:[stream streamCopy] bufferSize:1000], expected, nil);
+}
+
+- (void)testFileRegion
+{
+    VKBodyFilePart *filePart = [[VKBodyFilePart alloc] initWithFileURL:_fileURL
+                                                                offset:kVKMultipartBodyStreamMappingSize - 100
+                                                                length:5000];
+    VKMultipartBodyStream *stream = [[VKMultipartBodyStream alloc] initWithParts:@[filePart]];
+
+    NSData *expected = [_fileData subdataWithRange:NSMakeRange(kVKMultipartBodyStreamMappingSize - 100, 5000)];
+
+    STAssertEqualObjects([self readStream:stream bufferSize:777], expected, nil);
+}
+
+- (void)testMissingFile
+{
+    NSURL *missingURL = [NSURL fileURLWithPath:@"/nonexistent/file.bin"];
+
+    STAssertNil([VKBodyFilePart partWithFileURL:missingURL], @"Missing file must be rejected");
+}
+
+@end
@@ -0,0 +1,234 @@
+//
+//  TestVKPaginator.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKPaginator.h"
+#import "VKPaginator.h"
+#import "TestVKRequestHelper.h"
+
+
+@interface TestVKPaginator () <VKPaginatorDelegate>
+@end
+
+
+@implementation TestVKPaginator
+{
+    TestVKRequestHelper *_helper;
+    NSUInteger _totalCount;
+    NSUInteger _maxConcurrentRequests;
+    NSUInteger _executingRequests;
+
+    NSMutableArray *_items;
+    NSMutableArray *_offsets;
+    BOOL _isFinished;
+    id _error;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _totalCount = 250;
+    _maxConcurrentRequests = 0;
+    _executingRequests = 0;
+    _items = [[NSMutableArray alloc] init];
+    _offsets = [[NSMutableArray alloc] init];
+    _isFinished = NO;
+    _error = nil;
+
+    __weak TestVKPaginator *weakSelf = self;
+
+    _helper = [[TestVKRequestHelper alloc] init];
+    _helper.transport.latency = 0.05;
+    _helper.transport.responseHandler = ^VKLoopbackResponse *(NSURLRequest *request)
+    {
+        return [weakSelf responseForRequest:request];
+    };
+}
+
+- (VKLoopbackResponse *)responseForRequest:(NSURLRequest *)request
+{
+    NSDictionary *parameters = [TestVKRequestHelper parametersOfRequest:request];
+    NSUInteger offset = (NSUInteger) [parameters[@"offset"] integerValue];
+    NSUInteger count = (NSUInteger) [parameters[@"count"] integerValue];
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+
+    for (NSUInteger i = offset; i < MIN(offset + count, _totalCount); i++)
+        [items addObject:@{@"id" : @(i)}];
+
+    @synchronized (self) {
+        _executingRequests++;
+        _maxConcurrentRequests = MAX(_maxConcurrentRequests, _executingRequests);
+    }
+
+//    ответ отдается транспортом после задержки, к этому моменту запросы уже "выполняются"
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (0.04 * NSEC_PER_SEC)), dispatch_get_global_queue(0, 0), ^
+    {
+        @synchronized (self) {
+            _executingRequests--;
+        }
+    });
+
+    return [VKLoopbackResponse responseWithJSONObject:@{@"response" : @{@"count" : @(_totalCount),
+                                                                        @"items" : items}}];
+}
+
+- (VKPaginator *)paginatorWithOptions:(NSDictionary *)options
+{
+    VKRequest *request = [_helper requestMethod:@"wall.get"
+                                        options:options];
+
+    VKPaginator *paginator = [[VKPaginator alloc] initWithRequest:request];
+    paginator.delegate = self;
+
+    return paginator;
+}
+
+- (void)waitForPaginatorWithTimeout:(NSTimeInterval)timeout
+{
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return (_isFinished || nil != _error);
+    }
+                           timeout:timeout];
+}
+
+#pragma mark - VKPaginatorDelegate
+
+- (void)paginator:(VKPaginator *)paginator
+     didLoadItems:(NSArray *)items
+           offset:(NSUInteger)offset
+{
+    [_offsets addObject:@(offset)];
+    [_items addObjectsFromArray:items];
+}
+
+- (void)paginatorDidFinish:(VKPaginator *)paginator
+{
+    _isFinished = YES;
+}
+
+- (void)paginator:(VKPaginator *)paginator
+ didFailWithError:(id)error
+{
+    _error = error;
+}
+
+#pragma mark - tests
+
+- (void)testWholeListIsLoadedInOrder
+{
+    VKPaginator *paginator = [self paginatorWithOptions:@{@"owner_id" : @1}];
+    paginator.pageSize = 20;
+    paginator.readAhead = 4;
+
+    [paginator start];
+    [self waitForPaginatorWithTimeout:10];
+
+    STAssertTrue(_isFinished, nil);
+    STAssertNil(_error, nil);
+    STAssertEquals(paginator.totalCount, _totalCount, nil);
+    STAssertEquals(paginator.loadedCount, _totalCount, nil);
+    STAssertEquals([_items count], _totalCount, nil);
+
+    for (NSUInteger i = 0; i < [_items count]; i++)
+        STAssertEqualObjects(_items[i][@"id"], @(i), @"Items must be passed in order");
+
+    for (NSUInteger i = 0; i < [_offsets count]; i++)
+        STAssertEqualObjects(_offsets[i], @(i * 20), nil);
+
+    STAssertTrue(_maxConcurrentRequests > 1, @"Pages must be loaded simultaneously");
+    STAssertTrue(_maxConcurrentRequests <= 4, @"No more than readAhead pages must be loaded simultaneously");
+}
+
+- (void)testMaxItems
+{
+    VKPaginator *paginator = [self paginatorWithOptions:@{@"offset" : @10}];
+    paginator.pageSize = 20;
+    paginator.maxItems = 50;
+
+    [paginator start];
+    [self waitForPaginatorWithTimeout:10];
+
+    STAssertTrue(_isFinished, nil);
+    STAssertEquals([_items count], (NSUInteger) 50, nil);
+    STAssertEqualObjects(_items[0][@"id"], @10, nil);
+    STAssertEqualObjects([_items lastObject][@"id"], @59, nil);
+}
+
+- (void)testEmptyList
+{
+    _totalCount = 0;
+
+    VKPaginator *paginator = [self paginatorWithOptions:@{}];
+
+    [paginator start];
+    [self waitForPaginatorWithTimeout:5];
+
+    STAssertTrue(_isFinished, nil);
+    STAssertEquals([_items count], (NSUInteger) 0, nil);
+    STAssertEquals(paginator.totalCount, (NSUInteger) 0, nil);
+}
+
+- (void)testErrorStopsPaginator
+{
+//    без обработчика транспорт отвечает ошибкой "неизвестный метод"
+    _helper.transport.responseHandler = nil;
+
+    VKRequest *request = [_helper requestMethod:@"unknown.method"
+                                        options:@{}];
+
+    VKPaginator *paginator = [[VKPaginator alloc] initWithRequest:request];
+    paginator.delegate = self;
+
+    [paginator start];
+    [self waitForPaginatorWithTimeout:5];
+
+    STAssertNotNil(_error, nil);
+    STAssertFalse(_isFinished, nil);
+    STAssertTrue(paginator.isFinished, nil);
+}
+
+- (void)testDeadlineIsAppliedToEachPage
+{
+    _helper.transport.latency = 0.15;
+
+//    весь список загружается дольше, чем отведено шаблону, но каждая страница успевает
+    VKRequest *request = [_helper requestMethod:@"wall.get"
+                                        options:@{}];
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:0.4];
+
+    VKPaginator *paginator = [[VKPaginator alloc] initWithRequest:request];
+    paginator.delegate = self;
+    paginator.pageSize = 50;
+    paginator.readAhead = 1;
+
+    [paginator start];
+    [self waitForPaginatorWithTimeout:10];
+
+    STAssertNil(_error, @"Later pages must not inherit deadline of the template");
+    STAssertTrue(_isFinished, nil);
+    STAssertEquals([_items count], _totalCount, nil);
+}
+
+- (void)testExpiredDeadlineStopsPaginator
+{
+    VKRequest *request = [_helper requestMethod:@"wall.get"
+                                        options:@{}];
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:-1];
+
+    VKPaginator *paginator = [[VKPaginator alloc] initWithRequest:request];
+    paginator.delegate = self;
+
+    [paginator start];
+    [self waitForPaginatorWithTimeout:5];
+
+    STAssertEquals([_error code], (NSInteger) NSURLErrorTimedOut, nil);
+    STAssertFalse(_isFinished, nil);
+}
+
+@end
@@ -0,0 +1,531 @@
+//
+//  TestVKRequest.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKRequest.h"
+#import "TestVKRequestHelper.h"
+#import "VKUser.h"
+#import "VKStorage.h"
+#import "VKStorageItem.h"
+#import "VKCachedData.h"
+#import "VKAccessToken.h"
+#import "VKCacheKey.h"
+#import "VKRequestScheduler.h"
+
+
+//    делегат, получающий элементы списка по мере загрузки ответа
+@interface TestItemsDelegate : NSObject <VKRequestDelegate>
+
+@property (nonatomic, strong, readonly) NSMutableArray *batches;
+@property (nonatomic, strong, readonly) id response;
+@property (nonatomic, assign) BOOL pausesOnFirstBatch;
+
+- (NSArray *)items;
+
+@end
+
+@implementation TestItemsDelegate
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+        _batches = [[NSMutableArray alloc] init];
+    }
+
+    return self;
+}
+
+- (NSArray *)items
+{
+    NSMutableArray *items = [NSMutableArray array];
+
+    for (NSArray *batch in self.batches)
+        [items addObjectsFromArray:batch];
+
+    return items;
+}
+
+- (void)VKRequest:(VKRequest *)request
+    receivedItems:(NSArray *)items
+{
+    [self.batches addObject:items];
+
+    if (self.pausesOnFirstBatch && 1 == [self.batches count])
+        [request pauseItems];
+}
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    _response = response;
+}
+
+@end
+
+
+@implementation TestVKRequest
+{
+    TestVKRequestHelper *_helper;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _helper = [[TestVKRequestHelper alloc] init];
+    [_helper.transport setResponse:[VKLoopbackResponse responseWithJSONObject:@{@"response" : @[@{@"id" : @1}]}]
+                         forMethod:@"users.get"];
+}
+
+- (void)tearDown
+{
+    [[VKStorage sharedStorage] clean];
+
+    [super tearDown];
+}
+
+- (VKRequest *)requestWithSignature:(NSString *)signature
+{
+    VKRequest *request = [_helper requestMethod:@"users.get"
+                                        options:@{@"user_ids" : @"1"}];
+    request.signature = signature;
+
+    return request;
+}
+
+//    кэш текущего пользователя, в котором запросы ищут ответы
+- (VKCachedData *)cachedData
+{
+    VKAccessToken *token = [[VKAccessToken alloc] initWithUserID:1
+                                                     accessToken:@"token"];
+    VKStorageItem *item = [[VKStorage sharedStorage] createStorageItemForAccessToken:token];
+
+    [[VKStorage sharedStorage] addItem:item];
+    [VKUser activateUserWithID:1];
+
+    return item.cachedData;
+}
+
+- (NSString *)cacheKey
+{
+    return [VKCacheKey keyForMethod:@"users.get"
+                            options:@{@"user_ids" : @"1"}];
+}
+
+- (void)cacheResponse:(VKCachedData *)cachedData
+             liveTime:(VKCachedDataLiveTime)liveTime
+{
+    [cachedData addCachedData:[@"{\"response\":\"cached\"}" dataUsingEncoding:NSUTF8StringEncoding]
+                       forKey:[self cacheKey]
+                     liveTime:liveTime
+                 maxStaleTime:VKCachedDataLiveTimeOneDay
+             retainForOffline:NO];
+}
+
+//    свежий ответ из кэша; запись видна сразу, даже если еще не попала на диск
+- (id)cachedResponse:(VKCachedData *)cachedData
+{
+    NSData *data = [cachedData cachedDataForKey:[self cacheKey]
+                                   maxStaleTime:0
+                                        isStale:NULL];
+
+    return (nil == data ? nil : [NSJSONSerialization JSONObjectWithData:data
+                                                                options:0
+                                                                  error:nil]);
+}
+
+//    ответ, отправленный в callbackQueue, не виден делегату, поэтому ждем окончания запроса
+- (void)startRequestAndWaitForFinish:(VKRequest *)request
+{
+    __block BOOL isFinished = NO;
+    id observer = [[NSNotificationCenter defaultCenter]
+                                         addObserverForName:kVKRequestDidFinishNotification
+                                                     object:request
+                                                      queue:nil
+                                                 usingBlock:^(NSNotification *notification)
+                                                 {
+                                                     isFinished = YES;
+                                                 }];
+
+    [request start];
+
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return isFinished;
+    }
+                           timeout:5];
+
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+}
+
+#pragma mark - Single flight tests
+
+- (void)testIdenticalRequestsShareConnection
+{
+    _helper.transport.latency = 0.3;
+
+    for (NSString *signature in @[@"1", @"2", @"3"])
+        [[self requestWithSignature:signature] start];
+
+    [_helper waitForCallbacks:3
+                      timeout:5];
+
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, @"Identical requests must be sent once");
+    STAssertEquals([_helper.responses count], (NSUInteger) 3, @"Each request must receive the response");
+    STAssertEqualObjects(_helper.responses[@"3"], _helper.responses[@"1"], nil);
+}
+
+- (void)testFollowersSurviveLeaderCancel
+{
+    _helper.transport.latency = 0.3;
+
+    VKRequest *leader = [self requestWithSignature:@"leader"];
+    [leader start];
+    [[self requestWithSignature:@"1"] start];
+    [[self requestWithSignature:@"2"] start];
+
+    [leader cancel];
+
+//    лишний ответ пришел бы в течение этого времени
+    [_helper waitForCallbacks:3
+                      timeout:1];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 2, nil);
+    STAssertNil(_helper.responses[@"leader"], @"Cancelled leader must not reach delegate");
+    STAssertNotNil(_helper.responses[@"1"], nil);
+    STAssertNotNil(_helper.responses[@"2"], nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, @"Connection must not be restarted for followers");
+}
+
+- (void)testCancelledFollowerIsSkipped
+{
+    _helper.transport.latency = 0.3;
+
+    [[self requestWithSignature:@"leader"] start];
+
+    VKRequest *follower = [self requestWithSignature:@"1"];
+    [follower start];
+    [[self requestWithSignature:@"2"] start];
+
+    [follower cancel];
+
+    [_helper waitForCallbacks:3
+                      timeout:1];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 2, nil);
+    STAssertNil(_helper.responses[@"1"], @"Cancelled follower must not reach delegate");
+    STAssertNotNil(_helper.responses[@"leader"], nil);
+    STAssertNotNil(_helper.responses[@"2"], nil);
+}
+
+- (void)testScheduledDuplicateJoinsRunningRequest
+{
+    _helper.transport.latency = 0.3;
+
+    [[self requestWithSignature:@"leader"] start];
+
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    [scheduler scheduleRequest:[self requestWithSignature:@"1"]
+                         token:@"token"];
+
+    STAssertEquals(scheduler.queuedRequestsCount, (NSUInteger) 0, @"Duplicate must not wait for its turn");
+    STAssertEquals(scheduler.executingRequestsCount, (NSUInteger) 0, @"Duplicate must not take a connection");
+
+    [_helper waitForCallbacks:2
+                      timeout:5];
+
+    STAssertEquals([_helper.responses count], (NSUInteger) 2, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, nil);
+}
+
+- (void)testRequestsWithDeadlineAreNotShared
+{
+    _helper.transport.latency = 0.1;
+
+    [[self requestWithSignature:@"1"] start];
+
+    VKRequest *request = [self requestWithSignature:@"2"];
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    [request start];
+
+    [_helper waitForCallbacks:2
+                      timeout:5];
+
+    STAssertEquals([_helper.responses count], (NSUInteger) 2, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 2, nil);
+}
+
+#pragma mark - Cache policy tests
+
+- (void)testCacheElseNetwork
+{
+    VKCachedData *cachedData = [self cachedData];
+
+    VKRequest *request = [self requestWithSignature:@"1"];
+    request.cachePolicy = VKRequestCachePolicyCacheElseNetwork;
+    request.cacheLiveTime = VKCachedDataLiveTimeOneHour;
+
+    [_helper runRequest:request];
+
+    STAssertEqualObjects(_helper.response[@"response"][0][@"id"], @1, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, @"Missing response must be loaded from the server");
+    STAssertNotNil([self cachedResponse:cachedData], @"Response must be cached");
+
+    request = [self requestWithSignature:@"2"];
+    request.cachePolicy = VKRequestCachePolicyCacheElseNetwork;
+
+    [_helper runRequest:request];
+
+    STAssertEqualObjects(_helper.response[@"response"][0][@"id"], @1, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, @"Fresh cached response must not be loaded again");
+}
+
+- (void)testNetworkOnly
+{
+    [self cacheResponse:[self cachedData]
+               liveTime:VKCachedDataLiveTimeOneHour];
+
+    [_helper runRequest:[self requestWithSignature:@"1"]];
+
+    STAssertEqualObjects(_helper.response[@"response"][0][@"id"], @1, @"Cache must not be read");
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, nil);
+}
+
+- (void)testCacheOnly
+{
+    VKCachedData *cachedData = [self cachedData];
+
+    VKRequest *request = [self requestWithSignature:@"1"];
+    request.cachePolicy = VKRequestCachePolicyCacheOnly;
+
+    [_helper runRequest:request];
+
+    STAssertEquals(_helper.error.code, (NSInteger) NSURLErrorResourceUnavailable, nil);
+
+    [self cacheResponse:cachedData
+               liveTime:VKCachedDataLiveTimeOneHour];
+
+    request = [self requestWithSignature:@"2"];
+    request.cachePolicy = VKRequestCachePolicyCacheOnly;
+
+    [_helper runRequest:request];
+
+    STAssertEqualObjects(_helper.response[@"response"], @"cached", nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 0, @"Request must never be sent");
+}
+
+- (void)testCacheThenNetwork
+{
+    [self cacheResponse:[self cachedData]
+               liveTime:VKCachedDataLiveTimeOneHour];
+
+    VKRequest *request = [self requestWithSignature:@"1"];
+    request.cachePolicy = VKRequestCachePolicyCacheThenNetwork;
+
+    [request start];
+    [_helper waitForCallbacks:2
+                      timeout:5];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 2, @"Delegate must receive both responses");
+    STAssertEqualObjects(_helper.response[@"response"][0][@"id"], @1, @"Server response must be the last one");
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, nil);
+}
+
+- (void)testStaleWhileRevalidate
+{
+    VKCachedData *cachedData = [self cachedData];
+
+    [self cacheResponse:cachedData
+               liveTime:(VKCachedDataLiveTime) 1];
+
+    VKRequest *request = [self requestWithSignature:@"1"];
+    request.cachePolicy = VKRequestCachePolicyStaleWhileRevalidate;
+
+    [_helper runRequest:request];
+
+    STAssertEqualObjects(_helper.response[@"response"], @"cached", nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 0, @"Fresh response must not be revalidated");
+
+//    ждем, пока запись устареет
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return (nil == [self cachedResponse:cachedData]);
+    }
+                           timeout:5];
+
+    request = [self requestWithSignature:@"2"];
+    request.cachePolicy = VKRequestCachePolicyStaleWhileRevalidate;
+    request.cacheLiveTime = VKCachedDataLiveTimeOneHour;
+
+    [_helper runRequest:request];
+
+    STAssertEqualObjects(_helper.response[@"response"], @"cached", @"Stale response must be returned at once");
+
+//    обновленный ответ делегату не передается, но попадает в кэш
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return (nil != [self cachedResponse:cachedData]);
+    }
+                           timeout:5];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 1, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, nil);
+    STAssertEqualObjects([self cachedResponse:cachedData][@"response"][0][@"id"], @1, nil);
+}
+
+#pragma mark - Streamed items tests
+
+- (VKRequest *)itemsRequestWithDelegate:(TestItemsDelegate *)delegate
+{
+    NSMutableArray *items = [NSMutableArray array];
+
+    for (NSUInteger i = 1; i <= 25; i++)
+        [items addObject:@{@"id" : @(i)}];
+
+    [_helper.transport setResponse:[VKLoopbackResponse responseWithJSONObject:@{@"response" : @{@"count" : @25, @"items" : items}}]
+                         forMethod:@"friends.get"];
+
+//    ответ приходит частями меньше одного элемента
+    _helper.transport.chunkSize = 8;
+
+    VKRequest *request = [_helper requestMethod:@"friends.get"
+                                        options:@{}];
+    request.delegate = delegate;
+    request.itemsBatchSize = 10;
+
+    return request;
+}
+
+- (NSArray *)IDsOfItems:(NSArray *)items
+{
+    NSMutableArray *IDs = [NSMutableArray array];
+
+    for (NSDictionary *item in items)
+        [IDs addObject:item[@"id"]];
+
+    return IDs;
+}
+
+- (void)testItemsAreDeliveredInBatches
+{
+    TestItemsDelegate *delegate = [[TestItemsDelegate alloc] init];
+    VKRequest *request = [self itemsRequestWithDelegate:delegate];
+
+    [request start];
+
+    BOOL isFinished = [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return (nil != delegate.response);
+    }
+                                             timeout:5];
+
+    STAssertTrue(isFinished, nil);
+    STAssertEquals([delegate.batches count], (NSUInteger) 3, nil);
+    STAssertEquals([delegate.batches[0] count], (NSUInteger) 10, nil);
+    STAssertEquals([delegate.batches[1] count], (NSUInteger) 10, nil);
+    STAssertEquals([delegate.batches[2] count], (NSUInteger) 5, @"Rest of the items must be delivered with the response");
+    STAssertEqualObjects([[self IDsOfItems:[delegate items]] lastObject], @25, nil);
+    STAssertEqualObjects(delegate.response[@"response"][@"items"], @[], @"Final response must not contain streamed items");
+    STAssertEqualObjects(delegate.response[@"response"][@"count"], @25, nil);
+}
+
+- (void)testPausedItemsAreNotRead
+{
+    TestItemsDelegate *delegate = [[TestItemsDelegate alloc] init];
+    delegate.pausesOnFirstBatch = YES;
+
+    VKRequest *request = [self itemsRequestWithDelegate:delegate];
+
+//    ответ загружается медленно, чтобы приостановка успела до его конца
+    _helper.transport.bandwidth = 100;
+
+    [request start];
+
+    [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return (nil != delegate.response);
+    }
+                           timeout:4];
+
+    STAssertNil(delegate.response, @"Response must not be read while items are paused");
+    STAssertTrue([[delegate items] count] < 25, nil);
+
+    [request resumeItems];
+
+    BOOL isFinished = [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return (nil != delegate.response);
+    }
+                                             timeout:10];
+
+    STAssertTrue(isFinished, @"Response must be read after resumeItems");
+
+    NSMutableArray *IDs = [NSMutableArray array];
+
+    for (NSUInteger i = 1; i <= 25; i++)
+        [IDs addObject:@(i)];
+
+    STAssertEqualObjects([self IDsOfItems:[delegate items]], IDs, @"Each item must be delivered once and in order");
+    STAssertEqualObjects(delegate.response[@"response"][@"items"], @[], nil);
+}
+
+#pragma mark - Callback queue tests
+
+- (void)testDelegateIsCalledOnMainQueue
+{
+    [_helper runRequest:[self requestWithSignature:@"1"]];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 1, nil);
+    STAssertTrue([_helper.callbackThread isMainThread], @"Main queue is used by default");
+}
+
+- (void)testDelegateIsCalledOnCallbackQueue
+{
+    dispatch_queue_t queue = dispatch_queue_create("TestVKRequest.callbackQueue", DISPATCH_QUEUE_SERIAL);
+
+//    пока очередь приостановлена, ответ до делегата дойти не может
+    dispatch_suspend(queue);
+
+    VKRequest *request = [self requestWithSignature:@"1"];
+    request.callbackQueue = queue;
+
+    [self startRequestAndWaitForFinish:request];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 0, @"Response must be delivered through callbackQueue");
+
+    dispatch_resume(queue);
+
+    [_helper waitForCallbacks:1
+                      timeout:5];
+
+    STAssertEqualObjects(_helper.response[@"response"][0][@"id"], @1, nil);
+    STAssertFalse([_helper.callbackThread isMainThread], nil);
+}
+
+- (void)testCancelledRequestSkipsQueuedCallbacks
+{
+    dispatch_queue_t queue = dispatch_queue_create("TestVKRequest.callbackQueue", DISPATCH_QUEUE_SERIAL);
+    dispatch_suspend(queue);
+
+    VKRequest *request = [self requestWithSignature:@"1"];
+    request.callbackQueue = queue;
+
+    [self startRequestAndWaitForFinish:request];
+
+//    ответ уже ждет в очереди, но запрос отменен раньше, чем она дошла до него
+    [request cancel];
+    dispatch_resume(queue);
+
+    [_helper waitForCallbacks:1
+                      timeout:0.5];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 0, @"Cancelled request must not reach delegate");
+}
+
+@end
@@ -0,0 +1,255 @@
+//
+//  TestVKRequestBatcher.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKRequestBatcher.h"
+#import "VKRequestBatcher.h"
+#import "VKRetryPolicy.h"
+#import "VKRetryBudget.h"
+#import "TestVKRequestHelper.h"
+
+
+@implementation TestVKRequestBatcher
+{
+    TestVKRequestHelper *_helper;
+    VKRequestBatcher *_batcher;
+
+    NSMutableArray *_calls;
+    id _executeResponse;
+    NSUInteger _executeFailures;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _calls = [[NSMutableArray alloc] init];
+    _batcher = [[VKRequestBatcher alloc] init];
+    _executeResponse = nil;
+    _executeFailures = 0;
+
+    __weak TestVKRequestBatcher *weakSelf = self;
+
+    _helper = [[TestVKRequestHelper alloc] init];
+    _helper.transport.responseHandler = ^VKLoopbackResponse *(NSURLRequest *request)
+    {
+        return [weakSelf responseForRequest:request];
+    };
+
+    [_helper replaceDefaultTransport];
+}
+
+- (void)tearDown
+{
+    [_helper restoreDefaultTransport];
+
+    [super tearDown];
+}
+
+- (VKLoopbackResponse *)responseForRequest:(NSURLRequest *)request
+{
+    NSMutableDictionary *call = [[TestVKRequestHelper parametersOfRequest:request] mutableCopy];
+    call[@"method"] = [request.URL lastPathComponent];
+
+    @synchronized (self) {
+        [_calls addObject:call];
+    }
+
+    if ([@"execute" isEqualToString:call[@"method"]]) {
+        @synchronized (self) {
+            if (0 != _executeFailures) {
+                _executeFailures--;
+
+                return [VKLoopbackResponse responseWithJSONObject:@{@"error" : @{@"error_code" : @6}}];
+            }
+        }
+
+        return [VKLoopbackResponse responseWithJSONObject:_executeResponse];
+    }
+
+    return [VKLoopbackResponse responseWithJSONObject:@{@"response" : call[@"method"]}];
+}
+
+- (VKRequest *)requestMethod:(NSString *)methodName
+                     options:(NSDictionary *)options
+{
+    VKRequest *request = [_helper requestMethod:methodName
+                                        options:options];
+    request.signature = methodName;
+
+    return request;
+}
+
+#pragma mark - tests
+
+- (void)testCanBatchRequest
+{
+    STAssertTrue([_batcher canBatchRequest:[self requestMethod:@"users.get"
+                                                      options:@{}]], nil);
+    STAssertFalse([_batcher canBatchRequest:[self requestMethod:@"wall.post"
+                                                       options:@{}]], @"Methods which change data must not be batched");
+    STAssertFalse([_batcher canBatchRequest:[self requestMethod:@"execute"
+                                                       options:@{}]], nil);
+    STAssertFalse([_batcher canBatchRequest:[self requestMethod:@"users.get(1)"
+                                                       options:@{}]], @"Method name is a part of VKScript code");
+}
+
+- (void)testScriptIsBuiltFromRequests
+{
+    _executeResponse = @{@"response" : @[@[@{@"id" : @1}], @{@"count" : @0, @"items" : @[]}]};
+
+    [_batcher addRequest:[self requestMethod:@"users.get"
+                                     options:@{@"user_ids" : @"1", @"access_token" : @"other"}]
+                   token:@"token"];
+    [_batcher addRequest:[self requestMethod:@"friends.get"
+                                     options:@{@"user_id" : @1}]
+                   token:@"token"];
+
+    [_helper waitForCallbacks:2
+                      timeout:10];
+
+    STAssertEquals([_calls count], (NSUInteger) 1, @"Requests must be sent with one execute call");
+    STAssertEqualObjects(_calls[0][@"method"], @"execute", nil);
+    STAssertEqualObjects(_calls[0][@"access_token"], @"token", nil);
+    STAssertEqualObjects(_calls[0][@"code"], @"return [API.users.get({\"user_ids\":\"1\"}),API.friends.get({\"user_id\":\"1\"})];", @"Access token of the call must not get into the script");
+
+    STAssertEqualObjects(_helper.responses[@"users.get"], (@{@"response" : @[@{@"id" : @1}]}), nil);
+    STAssertEqualObjects(_helper.responses[@"friends.get"][@"response"][@"count"], @0, nil);
+}
+
+- (void)testExecuteErrorsAreSplit
+{
+    _executeResponse = @{@"response"       : @[@NO, @[@{@"id" : @1}], @NO, @NO],
+                         @"execute_errors" : @[@{@"method" : @"friends.get", @"error_code" : @15},
+                                               @{@"method" : @"groups.get", @"error_code" : @7}]};
+
+    for (NSString *methodName in @[@"friends.get", @"users.get", @"groups.get", @"likes.isLiked"])
+        [_batcher addRequest:[self requestMethod:methodName
+                                         options:@{}]
+                       token:@"token"];
+
+    [_helper waitForCallbacks:4
+                      timeout:10];
+
+    STAssertEquals([_calls count], (NSUInteger) 1, nil);
+    STAssertEquals([_helper.responses count], (NSUInteger) 2, nil);
+    STAssertEqualObjects(_helper.responses[@"users.get"][@"response"][0][@"id"], @1, nil);
+
+//    false без описания ошибки - обычный результат метода
+    STAssertEqualObjects(_helper.responses[@"likes.isLiked"][@"response"], @NO, nil);
+}
+
+- (void)testExecuteErrorsReachTheirRequests
+{
+    _executeResponse = @{@"response"       : @[@NO, @[]],
+                         @"execute_errors" : @[@{@"method" : @"friends.get", @"error_code" : @15}]};
+
+    [_batcher addRequest:[self requestMethod:@"friends.get"
+                                     options:@{}]
+                   token:@"token"];
+    [_batcher addRequest:[self requestMethod:@"users.get"
+                                     options:@{}]
+                   token:@"token"];
+
+    [_helper waitForCallbacks:2
+                      timeout:10];
+
+    STAssertEqualObjects(_helper.responseError[@"error_code"], @15, nil);
+    STAssertEqualObjects(_helper.responses[@"users.get"][@"response"], @[], nil);
+    STAssertNil(_helper.responses[@"friends.get"], @"Failed call must not receive a response");
+}
+
+- (void)testSingleRequestIsNotWrapped
+{
+    [_batcher addRequest:[self requestMethod:@"users.get"
+                                     options:@{@"user_ids" : @"1"}]
+                   token:@"token"];
+
+    [_helper waitForCallbacks:1
+                      timeout:10];
+
+    STAssertEquals([_calls count], (NSUInteger) 1, nil);
+    STAssertEqualObjects(_calls[0][@"method"], @"users.get", nil);
+    STAssertEqualObjects(_helper.responses[@"users.get"][@"response"], @"users.get", nil);
+}
+
+- (void)testFullBatchIsSentAtOnce
+{
+    _batcher.coalescingInterval = 60;
+    _batcher.maxBatchSize = 2;
+    _executeResponse = @{@"response" : @[@1, @2]};
+
+    [_batcher addRequest:[self requestMethod:@"users.get"
+                                     options:@{}]
+                   token:@"token"];
+    [_batcher addRequest:[self requestMethod:@"friends.get"
+                                     options:@{}]
+                   token:@"token"];
+
+    [_helper waitForCallbacks:2
+                      timeout:5];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 2, @"Full batch must not wait for coalescing interval");
+}
+
+- (void)testDeadlineOfBatchedRequest
+{
+    _helper.transport.latency = 1;
+    _executeResponse = @{@"response" : @[@1, @2]};
+
+    VKRequest *request = [self requestMethod:@"users.get"
+                                     options:@{}];
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:0.3];
+
+    [_batcher addRequest:request
+                   token:@"token"];
+    [_batcher addRequest:[self requestMethod:@"friends.get"
+                                     options:@{}]
+                   token:@"token"];
+
+    [_helper waitForCallbacks:1
+                      timeout:0.8];
+
+    STAssertEquals(_helper.error.code, (NSInteger) NSURLErrorTimedOut, @"Request must not wait for the batch after its deadline");
+
+//    результат execute, пришедший позже, получает только второй запрос
+    [_helper waitForCallbacks:3
+                      timeout:3];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 2, nil);
+    STAssertNil(_helper.responses[@"users.get"], nil);
+    STAssertEqualObjects(_helper.responses[@"friends.get"][@"response"], @2, nil);
+}
+
+- (void)testRetryPolicyOfBatchedRequests
+{
+    _executeFailures = 1;
+    _executeResponse = @{@"response" : @[@1, @2]};
+
+    VKRetryPolicy *policy = [VKRetryPolicy policy];
+    policy.baseDelay = 0.01;
+    policy.budget = [[VKRetryBudget alloc] init];
+
+    for (NSString *methodName in @[@"users.get", @"friends.get"]) {
+        VKRequest *request = [self requestMethod:methodName
+                                         options:@{}];
+        request.retryPolicy = policy;
+
+        [_batcher addRequest:request
+                       token:@"token"];
+    }
+
+    [_helper waitForCallbacks:2
+                      timeout:5];
+
+    STAssertEquals([_calls count], (NSUInteger) 2, @"Execute must be retried with the policy of its requests");
+    STAssertNil(_helper.responseError, nil);
+    STAssertEqualObjects(_helper.responses[@"users.get"][@"response"], @1, nil);
+    STAssertEqualObjects(_helper.responses[@"friends.get"][@"response"], @2, nil);
+}
+
+@end
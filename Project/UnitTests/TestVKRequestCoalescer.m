@@ -0,0 +1,316 @@
+//
+//  TestVKRequestCoalescer.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKRequestCoalescer.h"
+#import "VKRequestCoalescer.h"
+#import "TestVKRequestHelper.h"
+
+
+@implementation TestVKRequestCoalescer
+{
+    TestVKRequestHelper *_helper;
+    VKRequestCoalescer *_coalescer;
+
+    NSMutableArray *_calls;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _calls = [[NSMutableArray alloc] init];
+    _coalescer = [[VKRequestCoalescer alloc] init];
+
+    __weak TestVKRequestCoalescer *weakSelf = self;
+
+    _helper = [[TestVKRequestHelper alloc] init];
+    _helper.transport.responseHandler = ^VKLoopbackResponse *(NSURLRequest *request)
+    {
+        return [weakSelf responseForRequest:request];
+    };
+
+    [_helper replaceDefaultTransport];
+}
+
+- (void)tearDown
+{
+    [_helper restoreDefaultTransport];
+
+    [super tearDown];
+}
+
+- (VKLoopbackResponse *)responseForRequest:(NSURLRequest *)request
+{
+    NSDictionary *parameters = [TestVKRequestHelper parametersOfRequest:request];
+
+    @synchronized (self) {
+        [_calls addObject:parameters];
+    }
+
+    NSString *methodName = [request.URL lastPathComponent];
+
+    if ([@"wall.getById" isEqualToString:methodName]) {
+        NSMutableArray *posts = [[NSMutableArray alloc] init];
+
+//        "удаленная" запись 1_13 не возвращается
+        for (NSString *ID in [parameters[@"posts"] componentsSeparatedByString:@","]) {
+            NSArray *components = [ID componentsSeparatedByString:@"_"];
+
+            if (![@"1_13" isEqualToString:ID])
+                [posts addObject:@{@"owner_id" : @([components[0] integerValue]),
+                                   @"id"       : @([components[1] integerValue]),
+                                   @"text"     : ID}];
+        }
+
+//        расширенный ответ дополнительно содержит авторов записей
+        if ([@"1" isEqualToString:parameters[@"extended"]])
+            return [VKLoopbackResponse responseWithJSONObject:@{@"response" : @{@"items"    : posts,
+                                                                                @"profiles" : @[@{@"id" : @1}],
+                                                                                @"groups"   : @[@{@"id" : @5}]}}];
+
+        return [VKLoopbackResponse responseWithJSONObject:@{@"response" : posts}];
+    }
+
+    if ([@"messages.getById" isEqualToString:methodName]) {
+        NSMutableArray *messages = [[NSMutableArray alloc] init];
+
+        for (NSString *ID in [parameters[@"message_ids"] componentsSeparatedByString:@","])
+            [messages addObject:@{@"id" : @([ID integerValue])}];
+
+        return [VKLoopbackResponse responseWithJSONObject:@{@"response" : @{@"count" : @([messages count]),
+                                                                            @"items" : messages}}];
+    }
+
+    NSMutableArray *users = [[NSMutableArray alloc] init];
+
+    for (NSString *ID in [parameters[@"user_ids"] componentsSeparatedByString:@","])
+        [users addObject:@{@"id"         : @([ID integerValue]),
+                           @"first_name" : [NSString stringWithFormat:@"User %@", ID],
+                           @"fields"     : parameters[@"fields"]}];
+
+    return [VKLoopbackResponse responseWithJSONObject:@{@"response" : users}];
+}
+
+- (VKRequest *)requestForIDs:(NSString *)IDs
+                      fields:(NSString *)fields
+{
+    VKRequest *request = [_helper requestMethod:@"users.get"
+                                        options:@{@"user_ids" : IDs,
+                                                  @"fields"   : fields}];
+    request.signature = IDs;
+
+    return request;
+}
+
+- (VKRequest *)requestMethod:(NSString *)methodName
+                      options:(NSDictionary *)options
+{
+    VKRequest *request = [_helper requestMethod:methodName
+                                        options:options];
+    request.signature = [[options allValues] componentsJoinedByString:@"|"];
+
+    return request;
+}
+
+- (void)waitForResponses:(NSUInteger)count
+{
+    [_helper waitForCallbacks:count
+                      timeout:10];
+}
+
+#pragma mark - tests
+
+- (void)testCanCoalesceRequest
+{
+    STAssertTrue([_coalescer canCoalesceRequest:[self requestForIDs:@"1,2,3"
+                                                             fields:@"photo_50"]], nil);
+    STAssertFalse([_coalescer canCoalesceRequest:[self requestForIDs:@"durov"
+                                                              fields:@"photo_50"]], @"Screen names can not be matched with response");
+
+    VKRequest *friendsGet = [_helper requestMethod:@"friends.get"
+                                           options:@{@"user_ids" : @"1"}];
+
+    STAssertFalse([_coalescer canCoalesceRequest:friendsGet], nil);
+}
+
+- (void)testListOfProfilesTakesOneRequest
+{
+    for (NSUInteger i = 1; i <= 500; i++)
+        [_coalescer addRequest:[self requestForIDs:[NSString stringWithFormat:@"%lu", (unsigned long) i]
+                                            fields:@"photo_50"]
+                         token:@"token"];
+
+    [self waitForResponses:500];
+
+    STAssertEquals([_calls count], (NSUInteger) 1, nil);
+    STAssertEquals([_helper.responses count], (NSUInteger) 500, nil);
+    STAssertEquals([[_calls[0][@"user_ids"] componentsSeparatedByString:@","] count], (NSUInteger) 500, nil);
+    STAssertEqualObjects(_calls[0][@"access_token"], @"token", nil);
+
+    for (NSUInteger i = 1; i <= 500; i++) {
+        NSArray *users = _helper.responses[[NSString stringWithFormat:@"%lu", (unsigned long) i]][@"response"];
+
+        STAssertEquals([users count], (NSUInteger) 1, nil);
+        STAssertEqualObjects(users[0][@"id"], @(i), @"Each request must receive its own user");
+    }
+}
+
+- (void)testRequestsAreGroupedByFields
+{
+    [_coalescer addRequest:[self requestForIDs:@"1"
+                                        fields:@"photo_50"]
+                     token:@"token"];
+    [_coalescer addRequest:[self requestForIDs:@"2,3"
+                                        fields:@"photo_50"]
+                     token:@"token"];
+    [_coalescer addRequest:[self requestForIDs:@"3,1"
+                                        fields:@"online"]
+                     token:@"token"];
+    [_coalescer addRequest:[self requestForIDs:@"4"
+                                        fields:@"online"]
+                     token:@"token"];
+
+    [self waitForResponses:4];
+
+    STAssertEquals([_calls count], (NSUInteger) 2, nil);
+
+    NSArray *users = _helper.responses[@"3,1"][@"response"];
+
+    STAssertEquals([users count], (NSUInteger) 2, nil);
+    STAssertEqualObjects(users[0][@"id"], @3, @"Users must be in the order of the request");
+    STAssertEqualObjects(users[1][@"id"], @1, nil);
+    STAssertEqualObjects(users[0][@"fields"], @"online", nil);
+    STAssertEqualObjects([_helper.responses[@"2,3"][@"response"][0] objectForKey:@"fields"], @"photo_50", nil);
+}
+
+- (void)testCallsAreSplitByMaxBatchSize
+{
+    _coalescer.maxBatchSize = 10;
+
+    for (NSUInteger i = 1; i <= 25; i++)
+        [_coalescer addRequest:[self requestForIDs:[NSString stringWithFormat:@"%lu", (unsigned long) i]
+                                            fields:@"photo_50"]
+                         token:@"token"];
+
+    [self waitForResponses:25];
+
+    STAssertEquals([_calls count], (NSUInteger) 3, nil);
+    STAssertEquals([_helper.responses count], (NSUInteger) 25, nil);
+}
+
+- (void)testDescriptorKeys
+{
+    VKCoalescingDescriptor *descriptor = [_coalescer descriptorForMethod:@"photos.getById"];
+
+    STAssertEqualObjects([descriptor keyForID:@"-1_456"], @"-1_456", nil);
+    STAssertEqualObjects([descriptor keyForID:@"1_456_a1b2c3"], @"1_456", @"Access key must not be a part of the key");
+    STAssertNil([descriptor keyForID:@"456"], nil);
+    STAssertNil([descriptor keyForID:@"durov_456"], nil);
+    STAssertEqualObjects([descriptor keyForItem:@{@"owner_id" : @-1, @"pid" : @456}], @"-1_456", nil);
+    STAssertNil([descriptor keyForItem:@{@"owner_id" : @-1}], nil);
+
+    STAssertNotNil([_coalescer descriptorForMethod:@"groups.getById"], nil);
+    STAssertNil([_coalescer descriptorForMethod:@"polls.getById"], @"polls.getById takes one poll");
+}
+
+- (void)testPostsAreCoalesced
+{
+    [_coalescer addRequest:[self requestMethod:@"wall.getById"
+                                       options:@{@"posts" : @"1_10,1_11"}]
+                     token:@"token"];
+    [_coalescer addRequest:[self requestMethod:@"wall.getById"
+                                       options:@{@"posts" : @"1_12,1_13,-5_1"}]
+                     token:@"token"];
+
+    [self waitForResponses:2];
+
+    STAssertEquals([_calls count], (NSUInteger) 1, nil);
+    STAssertEqualObjects(_calls[0][@"posts"], @"1_10,1_11,1_12,1_13,-5_1", nil);
+
+    NSArray *posts = _helper.responses[@"1_12,1_13,-5_1"][@"response"];
+
+    STAssertEquals([posts count], (NSUInteger) 2, @"Missing post must be skipped");
+    STAssertEqualObjects(posts[0][@"text"], @"1_12", nil);
+    STAssertEqualObjects(posts[1][@"text"], @"-5_1", nil);
+}
+
+- (void)testResponseWithItemsIsSplit
+{
+    [_coalescer addRequest:[self requestMethod:@"messages.getById"
+                                       options:@{@"message_ids" : @"1,2"}]
+                     token:@"token"];
+    [_coalescer addRequest:[self requestMethod:@"messages.getById"
+                                       options:@{@"message_ids" : @"3"}]
+                     token:@"token"];
+
+    [self waitForResponses:2];
+
+    STAssertEquals([_calls count], (NSUInteger) 1, nil);
+    STAssertEqualObjects(_helper.responses[@"3"][@"response"][@"count"], @1, nil);
+    STAssertEqualObjects(_helper.responses[@"3"][@"response"][@"items"][0][@"id"], @3, nil);
+    STAssertEqualObjects(_helper.responses[@"1,2"][@"response"][@"count"], @2, nil);
+}
+
+- (void)testExtendedResponseKeepsProfiles
+{
+    VKRequest *first = [self requestMethod:@"wall.getById"
+                                   options:@{@"posts" : @"1_10", @"extended" : @1}];
+    first.signature = @"first";
+
+    VKRequest *second = [self requestMethod:@"wall.getById"
+                                    options:@{@"posts" : @"-5_1,1_11", @"extended" : @1}];
+    second.signature = @"second";
+
+    [_coalescer addRequest:first
+                     token:@"token"];
+    [_coalescer addRequest:second
+                     token:@"token"];
+
+    [self waitForResponses:2];
+
+    STAssertEquals([_calls count], (NSUInteger) 1, nil);
+    STAssertEqualObjects(_calls[0][@"extended"], @"1", nil);
+
+    NSDictionary *response = _helper.responses[@"second"][@"response"];
+
+    STAssertEquals([response[@"items"] count], (NSUInteger) 2, nil);
+    STAssertEqualObjects(response[@"items"][0][@"text"], @"-5_1", nil);
+    STAssertEqualObjects(response[@"profiles"], (@[@{@"id" : @1}]), @"Profiles must not be dropped");
+    STAssertEqualObjects(response[@"groups"], (@[@{@"id" : @5}]), @"Groups must not be dropped");
+    STAssertNil(response[@"count"], @"Response without count must keep its shape");
+    STAssertEqualObjects(_helper.responses[@"first"][@"response"][@"items"][0][@"text"], @"1_10", nil);
+}
+
+- (void)testDeadlineOfCoalescedRequest
+{
+    _helper.transport.latency = 1;
+
+    VKRequest *request = [self requestForIDs:@"1"
+                                      fields:@"photo_50"];
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:0.3];
+
+    [_coalescer addRequest:request
+                     token:@"token"];
+    [_coalescer addRequest:[self requestForIDs:@"2"
+                                        fields:@"photo_50"]
+                     token:@"token"];
+
+    [_helper waitForCallbacks:1
+                      timeout:0.8];
+
+    STAssertEquals(_helper.error.code, (NSInteger) NSURLErrorTimedOut, @"Request must not wait for the call after its deadline");
+
+    [_helper waitForCallbacks:3
+                      timeout:3];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 2, nil);
+    STAssertNil(_helper.responses[@"1"], nil);
+    STAssertEqualObjects(_helper.responses[@"2"][@"response"][0][@"id"], @2, nil);
+}
+
+@end
@@ -0,0 +1,140 @@
+//
+//  TestVKRequestGroup.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKRequestGroup.h"
+#import "VKRequestGroup.h"
+#import "VKRetryPolicy.h"
+#import "VKRetryBudget.h"
+#import "TestVKRequestHelper.h"
+
+
+@implementation TestVKRequestGroup
+{
+    TestVKRequestHelper *_helper;
+    VKLoopbackTransport *_transport;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _helper = [[TestVKRequestHelper alloc] init];
+    _transport = _helper.transport;
+    [_transport setResponse:[VKLoopbackResponse responseWithJSONObject:@{@"response" : @1}]
+                  forMethod:@"friends.get"];
+}
+
+- (VKRequest *)request
+{
+    return [_helper requestMethod:@"friends.get"
+                          options:@{}];
+}
+
+#pragma mark - Tests
+
+- (void)testCancelAll
+{
+    _transport.latency = 0.5;
+
+    VKRequestGroup *group = [[VKRequestGroup alloc] init];
+    VKRequest *first = [self request];
+    VKRequest *second = [self request];
+
+    [group addRequest:first];
+    [group addRequest:second];
+    STAssertEquals(group.count, (NSUInteger) 2, nil);
+
+    [first start];
+    [second start];
+    [group cancelAll];
+
+    [_helper waitForCallbacks:1
+                      timeout:1];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 0, @"Cancelled requests must not reach delegate");
+    STAssertEquals(group.count, (NSUInteger) 0, nil);
+}
+
+- (void)testFinishedRequestLeavesGroup
+{
+    VKRequestGroup *group = [[VKRequestGroup alloc] init];
+    VKRequest *request = [self request];
+
+    [group addRequest:request];
+    [request start];
+
+    [_helper waitForCallbacks:1
+                      timeout:5];
+
+    STAssertEqualObjects(_helper.response[@"response"], @1, nil);
+    STAssertEquals(group.count, (NSUInteger) 0, nil);
+}
+
+- (void)testDeadline
+{
+    _transport.latency = 2;
+
+    VKRequest *request = [self request];
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:0.2];
+
+    NSDate *startDate = [NSDate date];
+    [request start];
+
+    [_helper waitForCallbacks:1
+                      timeout:5];
+
+    STAssertEquals(_helper.error.code, (NSInteger) NSURLErrorTimedOut, nil);
+    STAssertTrue([[NSDate date] timeIntervalSinceDate:startDate] < 1, @"Request must not wait for the response");
+
+//    ответ после крайнего срока делегату не передается
+    [_helper waitForCallbacks:2
+                      timeout:2.5];
+
+    STAssertEquals(_helper.callbacksCount, (NSUInteger) 1, nil);
+}
+
+- (void)testExpiredRequestIsNotSent
+{
+    VKRequest *request = [self request];
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:-1];
+
+    [request start];
+
+    [_helper waitForCallbacks:1
+                      timeout:5];
+
+    STAssertEquals(_helper.error.code, (NSInteger) NSURLErrorTimedOut, nil);
+    STAssertEquals(_transport.startedTasksCount, (NSUInteger) 0, nil);
+}
+
+- (void)testDeadlineCoversRetries
+{
+    _transport.responseHandler = ^VKLoopbackResponse *(NSURLRequest *request)
+    {
+        return [VKLoopbackResponse responseWithJSONObject:@{@"error" : @{@"error_code" : @10}}];
+    };
+
+    VKRetryPolicy *policy = [VKRetryPolicy policy];
+    policy.baseDelay = 0.6;
+    policy.budget = [[VKRetryBudget alloc] init];
+
+    VKRequest *request = [self request];
+    request.retryPolicy = policy;
+    request.deadline = [NSDate dateWithTimeIntervalSinceNow:1];
+
+    [request start];
+
+    [_helper waitForCallbacks:1
+                      timeout:5];
+
+//    второй повтор уже не успевает до крайнего срока
+    STAssertEqualObjects(_helper.responseError[@"error_code"], @10, nil);
+    STAssertEquals(_transport.startedTasksCount, (NSUInteger) 2, nil);
+}
+
+@end
@@ -0,0 +1,108 @@
+//
+//  TestVKRequestHelper.h
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "VKRequest.h"
+#import "VKLoopbackTransport.h"
+
+
+/** Common fixture of the request tests.
+
+Owns loopback transport, creates requests which are never cached and are
+sent through this transport, waits for them on the current run loop and records
+every delegate callback.
+*/
+@interface TestVKRequestHelper : NSObject <VKRequestDelegate>
+
+/** Transport which requests created by helper are sent through.
+*/
+@property (nonatomic, strong, readonly) VKLoopbackTransport *transport;
+
+/** Number of delegate callbacks received since last reset.
+*/
+@property (nonatomic, assign, readonly) NSUInteger callbacksCount;
+
+/** Last received response.
+*/
+@property (nonatomic, strong, readonly) id response;
+
+/** Last received API error.
+*/
+@property (nonatomic, strong, readonly) id responseError;
+
+/** Last connection or parsing error.
+*/
+@property (nonatomic, strong, readonly) NSError *error;
+
+/** Thread on which last delegate callback was called.
+*/
+@property (nonatomic, strong, readonly) NSThread *callbackThread;
+
+/** Responses keyed by signature of requests which received them.
+*/
+@property (nonatomic, strong, readonly) NSDictionary *responses;
+
+/** Last reported number of uploaded bytes.
+*/
+@property (nonatomic, assign, readonly) NSUInteger uploadedBytes;
+
+/** Creates request with helper as delegate which ignores cache and is sent
+through loopback transport.
+
+@param methodName API method name
+@param options request parameters
+@return request
+*/
+- (VKRequest *)requestMethod:(NSString *)methodName
+                     options:(NSDictionary *)options;
+
+/** Starts request and waits for its callback (no more than 10 seconds).
+
+@param request request to start
+*/
+- (void)runRequest:(VKRequest *)request;
+
+/** Waits until callbacks count reaches count.
+
+@param count expected callbacks count
+@param timeout max waiting time
+*/
+- (void)waitForCallbacks:(NSUInteger)count
+                 timeout:(NSTimeInterval)timeout;
+
+/** Forgets all received callbacks.
+*/
+- (void)reset;
+
+/** Makes loopback transport default one for all requests. Used when requests
+are created by SDK itself (batched, coalesced requests).
+*/
+- (void)replaceDefaultTransport;
+
+/** Restores default transport replaced by replaceDefaultTransport.
+*/
+- (void)restoreDefaultTransport;
+
+/** Spins current run loop until condition is met or timeout expires.
+
+@param condition condition to wait for
+@param timeout max waiting time
+@return YES if condition is met
+*/
++ (BOOL)waitUntil:(BOOL (^)(void))condition
+          timeout:(NSTimeInterval)timeout;
+
+/** Parameters of request received by loopback transport, passed either in
+query or in url-encoded body.
+
+@param request URL request
+@return unescaped parameters
+*/
++ (NSDictionary *)parametersOfRequest:(NSURLRequest *)request;
+
+@end
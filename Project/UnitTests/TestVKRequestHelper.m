@@ -0,0 +1,181 @@
+//
+//  TestVKRequestHelper.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKRequestHelper.h"
+
+
+@implementation TestVKRequestHelper
+{
+    id <VKTransport> _defaultTransport;
+    NSMutableDictionary *_responses;
+}
+
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+        _transport = [[VKLoopbackTransport alloc] init];
+        _responses = [[NSMutableDictionary alloc] init];
+    }
+
+    return self;
+}
+
+#pragma mark - Requests
+
+- (VKRequest *)requestMethod:(NSString *)methodName
+                     options:(NSDictionary *)options
+{
+    VKRequest *request = [VKRequest requestMethod:methodName
+                                          options:options
+                                         delegate:self];
+    request.cacheLiveTime = VKCachedDataLiveTimeNever;
+    request.cachePolicy = VKRequestCachePolicyNetworkOnly;
+    request.transport = _transport;
+
+    return request;
+}
+
+- (void)runRequest:(VKRequest *)request
+{
+    [self reset];
+    [request start];
+
+    [self waitForCallbacks:1
+                   timeout:10];
+}
+
+- (void)waitForCallbacks:(NSUInteger)count
+                 timeout:(NSTimeInterval)timeout
+{
+    [[self class] waitUntil:^BOOL
+    {
+        return (_callbacksCount >= count);
+    }
+                    timeout:timeout];
+}
+
+- (void)reset
+{
+    _callbacksCount = 0;
+    _response = nil;
+    _responseError = nil;
+    _error = nil;
+    _callbackThread = nil;
+    _uploadedBytes = 0;
+
+    [_responses removeAllObjects];
+}
+
+- (NSDictionary *)responses
+{
+    return [_responses copy];
+}
+
+#pragma mark - Default transport
+
+- (void)replaceDefaultTransport
+{
+    _defaultTransport = [VKRequest defaultTransport];
+    [VKRequest setDefaultTransport:_transport];
+}
+
+- (void)restoreDefaultTransport
+{
+    [VKRequest setDefaultTransport:_defaultTransport];
+}
+
+#pragma mark - Class methods
+
++ (BOOL)waitUntil:(BOOL (^)(void))condition
+          timeout:(NSTimeInterval)timeout
+{
+    NSDate *date = [NSDate dateWithTimeIntervalSinceNow:timeout];
+
+    while (!condition() && [date timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.02]];
+
+    return condition();
+}
+
++ (NSDictionary *)parametersOfRequest:(NSURLRequest *)request
+{
+    NSMutableDictionary *parameters = [[NSMutableDictionary alloc] init];
+    NSMutableArray *pairs = [[NSMutableArray alloc] init];
+
+    if (nil != [request.URL query])
+        [pairs addObjectsFromArray:[[request.URL query] componentsSeparatedByString:@"&"]];
+
+//    POST запросы (execute) передают параметры в теле
+    if (nil != request.HTTPBody) {
+        NSString *body = [[NSString alloc] initWithData:request.HTTPBody
+                                               encoding:NSUTF8StringEncoding];
+
+        [pairs addObjectsFromArray:[body componentsSeparatedByString:@"&"]];
+    }
+
+    for (NSString *pair in pairs) {
+        NSArray *components = [pair componentsSeparatedByString:@"="];
+
+        if (2 == [components count])
+            parameters[components[0]] = [components[1] stringByReplacingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
+    }
+
+    return parameters;
+}
+
+#pragma mark - VKRequestDelegate
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    _response = response;
+
+    if (nil != request.signature)
+        _responses[request.signature] = response;
+
+    _callbackThread = [NSThread currentThread];
+    _callbacksCount++;
+}
+
+- (void)     VKRequest:(VKRequest *)request
+connectionErrorOccured:(NSError *)error
+{
+    _error = error;
+    _callbackThread = [NSThread currentThread];
+    _callbacksCount++;
+}
+
+- (void)  VKRequest:(VKRequest *)request
+parsingErrorOccured:(NSError *)error
+{
+    _error = error;
+    _callbackThread = [NSThread currentThread];
+    _callbacksCount++;
+}
+
+- (void)   VKRequest:(VKRequest *)request
+responseErrorOccured:(id)error
+{
+    _responseError = error;
+    _callbackThread = [NSThread currentThread];
+    _callbacksCount++;
+}
+
+- (void)VKRequest:(VKRequest *)request
+       totalBytes:(NSUInteger)totalBytes
+    uploadedBytes:(NSUInteger)uploadedBytes
+{
+    _uploadedBytes = uploadedBytes;
+}
+
+@end
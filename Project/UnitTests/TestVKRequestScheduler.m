@@ -0,0 +1,347 @@
+//
+//  TestVKRequestScheduler.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKRequestScheduler.h"
+#import "VKRequestScheduler.h"
+#import "VKTokenBucket.h"
+#import "VKRequest.h"
+#import "VKUser.h"
+#import "VKStorage.h"
+#import "VKStorageItem.h"
+#import "VKAccessToken.h"
+#import "VKCacheKey.h"
+#import "TestVKRequestHelper.h"
+
+
+//    запрос-заглушка, который не открывает соединение, а только запоминает факт запуска
+@interface TestScheduledRequest : VKRequest
+
+@property (nonatomic, assign) BOOL started;
+
+@end
+
+@implementation TestScheduledRequest
+
+- (void)start
+{
+    self.started = YES;
+}
+
+@end
+
+
+@interface TestVKRequestScheduler () <VKRequestDelegate>
+@end
+
+
+@implementation TestVKRequestScheduler
+{
+    NSTimeInterval _virtualTime;
+    NSUInteger _responsesCount;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _virtualTime = 1000;
+    _responsesCount = 0;
+}
+
+#pragma mark - VKRequestDelegate
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    _responsesCount++;
+}
+
+- (VKTimeSource)virtualClock
+{
+    return ^NSTimeInterval
+    {
+        return _virtualTime;
+    };
+}
+
+- (TestScheduledRequest *)stubRequest
+{
+    return [[TestScheduledRequest alloc] initWithMethod:@"users.get"
+                                                options:@{}];
+}
+
+#pragma mark - VKTokenBucket tests
+
+- (void)testTokenBucketBurst
+{
+    VKTokenBucket *bucket = [[VKTokenBucket alloc] initWithCapacity:3
+                                                         refillRate:3
+                                                         timeSource:[self virtualClock]];
+
+    STAssertTrue([bucket consumeToken], @"First token should be available");
+    STAssertTrue([bucket consumeToken], @"Second token should be available");
+    STAssertTrue([bucket consumeToken], @"Third token should be available");
+    STAssertFalse([bucket consumeToken], @"Bucket should be empty");
+}
+
+- (void)testTokenBucketRefill
+{
+    VKTokenBucket *bucket = [[VKTokenBucket alloc] initWithCapacity:3
+                                                         refillRate:3
+                                                         timeSource:[self virtualClock]];
+
+    while ([bucket consumeToken]);
+
+    STAssertEqualsWithAccuracy([bucket timeUntilNextToken], 1.0 / 3, 0.0001, @"Wrong time until next token");
+
+    _virtualTime += 1.0 / 3;
+    STAssertTrue([bucket consumeToken], @"Token should be refilled");
+    STAssertFalse([bucket consumeToken], @"Only one token should be refilled");
+
+    _virtualTime += 10;
+    STAssertEquals([bucket availableTokens], (NSUInteger) 3, @"Bucket can not hold more than capacity");
+}
+
+#pragma mark - VKRequestScheduler tests
+
+- (void)testSchedulerRateLimit
+{
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.timeSource = [self virtualClock];
+    scheduler.maxConcurrentRequests = 100;
+
+    NSMutableArray *requests = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < 5; i++) {
+        TestScheduledRequest *request = [self stubRequest];
+        [requests addObject:request];
+
+        [scheduler scheduleRequest:request
+                             token:@"token"];
+    }
+
+    STAssertEquals(scheduler.executingRequestsCount, (NSUInteger) 3, @"Only three requests per second are allowed");
+    STAssertFalse([requests[3] started], @"Fourth request should wait");
+
+    _virtualTime += 1.0 / 3;
+    [scheduler processQueue];
+
+    STAssertTrue([requests[3] started], @"Fourth request should be started");
+    STAssertFalse([requests[4] started], @"Fifth request should wait");
+}
+
+- (void)testSchedulerTokensAreIndependent
+{
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.timeSource = [self virtualClock];
+    scheduler.maxConcurrentRequests = 100;
+
+    for (NSUInteger i = 0; i < 3; i++)
+        [scheduler scheduleRequest:[self stubRequest]
+                             token:@"token1"];
+
+    TestScheduledRequest *request = [self stubRequest];
+    [scheduler scheduleRequest:request
+                         token:@"token2"];
+
+    STAssertTrue(request.started, @"Requests of another token should not be limited");
+}
+
+- (void)testSchedulerMaxConcurrentRequests
+{
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.timeSource = [self virtualClock];
+    scheduler.maxConcurrentRequests = 1;
+
+    [scheduler scheduleRequest:[self stubRequest]
+                         token:@"token1"];
+    [scheduler scheduleRequest:[self stubRequest]
+                         token:@"token2"];
+
+    STAssertEquals(scheduler.executingRequestsCount, (NSUInteger) 1, @"Only one request can be executed");
+    STAssertEquals(scheduler.queuedRequestsCount, (NSUInteger) 1, @"One request should be queued");
+}
+
+- (void)testSchedulerPriority
+{
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.timeSource = [self virtualClock];
+    scheduler.maxConcurrentRequests = 1;
+
+    [scheduler scheduleRequest:[self stubRequest]
+                         token:@"token"];
+
+    TestScheduledRequest *low = [self stubRequest];
+    TestScheduledRequest *high = [self stubRequest];
+
+    [scheduler scheduleRequest:low
+                         token:@"token"
+                      priority:VKRequestPriorityPrefetch];
+    [scheduler scheduleRequest:high
+                         token:@"token"
+                      priority:VKRequestPriorityInteractive];
+
+    scheduler.maxConcurrentRequests = 2;
+    [scheduler processQueue];
+
+    STAssertTrue(high.started, @"High priority request should be started first");
+    STAssertFalse(low.started, @"Low priority request should wait");
+}
+
+- (void)testSchedulerPriorityLimits
+{
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.timeSource = [self virtualClock];
+    scheduler.maxConcurrentRequests = 4;
+    scheduler.requestsPerSecond = 100;
+
+    NSMutableArray *background = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < 4; i++) {
+        TestScheduledRequest *request = [self stubRequest];
+        request.priority = VKRequestPriorityBackground;
+        [background addObject:request];
+
+        [scheduler scheduleRequest:request
+                             token:@"token"];
+    }
+
+    STAssertEquals(scheduler.executingRequestsCount, (NSUInteger) 2, @"Background requests should not occupy all connections");
+    STAssertFalse([background[2] started], nil);
+
+    TestScheduledRequest *prefetch = [self stubRequest];
+    [scheduler scheduleRequest:prefetch
+                         token:@"token"
+                      priority:VKRequestPriorityPrefetch];
+
+    TestScheduledRequest *interactive = [self stubRequest];
+    [scheduler scheduleRequest:interactive
+                         token:@"token"];
+
+    STAssertTrue(prefetch.started, @"Prefetch class has its own limit");
+    STAssertTrue(interactive.started, @"Interactive request should not wait for the background ones");
+    STAssertEquals(scheduler.queuedRequestsCount, (NSUInteger) 2, nil);
+}
+
+- (void)testRetryWaitsForRateLimit
+{
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.timeSource = [self virtualClock];
+    scheduler.maxConcurrentRequests = 100;
+
+    NSMutableArray *requests = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < 4; i++) {
+        TestScheduledRequest *request = [self stubRequest];
+        [requests addObject:request];
+
+        [scheduler scheduleRequest:request
+                             token:@"token"];
+    }
+
+    TestScheduledRequest *failedRequest = requests[0];
+    failedRequest.started = NO;
+
+    STAssertTrue([scheduler rescheduleRequest:failedRequest], nil);
+    STAssertFalse(failedRequest.started, @"Retry should wait for the rate limit");
+    STAssertFalse([scheduler rescheduleRequest:[self stubRequest]], @"Request was not started by the scheduler");
+
+//    повтор стартует раньше запроса, который ждал в очереди
+    _virtualTime += 1.0 / 3;
+    [scheduler processQueue];
+
+    STAssertTrue(failedRequest.started, nil);
+    STAssertFalse([requests[3] started], nil);
+}
+
+- (void)testEarlierWakeUpReplacesPendingOne
+{
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.maxConcurrentRequests = 1;
+    scheduler.requestsPerSecond = 1;
+
+    TestScheduledRequest *first = [self stubRequest];
+    [scheduler scheduleRequest:first
+                         token:@"token"];
+
+//    все соединения заняты - ждем только истечения срока второго запроса
+    TestScheduledRequest *second = [self stubRequest];
+    second.deadline = [NSDate dateWithTimeIntervalSinceNow:60];
+
+    [scheduler scheduleRequest:second
+                         token:@"token"];
+
+    STAssertFalse(second.started, nil);
+
+//    когда первый запрос завершится, корзина токена будет пуста; ее пополнения
+//    нельзя ждать минуту - до истечения срока второго запроса
+    [[NSNotificationCenter defaultCenter] postNotificationName:kVKRequestDidFinishNotification
+                                                        object:first];
+
+    BOOL started = [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return second.started;
+    }
+                                          timeout:3];
+
+    STAssertTrue(started, @"Request should be started when the token is refilled");
+}
+
+- (void)testCachedRequestsDoNotConsumeRateLimit
+{
+    VKAccessToken *token = [[VKAccessToken alloc] initWithUserID:1
+                                                     accessToken:@"token"];
+    VKStorageItem *item = [[VKStorage sharedStorage] createStorageItemForAccessToken:token];
+
+    [[VKStorage sharedStorage] addItem:item];
+    [VKUser activateUserWithID:1];
+
+    [item.cachedData addCachedData:[@"{\"response\":[]}" dataUsingEncoding:NSUTF8StringEncoding]
+                            forKey:[VKCacheKey keyForMethod:@"users.get"
+                                                    options:@{}]
+                          liveTime:VKCachedDataLiveTimeOneHour];
+
+    VKRequestScheduler *scheduler = [[VKRequestScheduler alloc] init];
+    scheduler.timeSource = [self virtualClock];
+    scheduler.maxConcurrentRequests = 100;
+
+//    целый экран запросов, которые есть в кэше
+    for (NSUInteger i = 0; i < 15; i++) {
+        TestScheduledRequest *request = [self stubRequest];
+        request.delegate = self;
+
+        [scheduler scheduleRequest:request
+                             token:@"token"];
+
+        STAssertFalse(request.started, @"Cached request should not be sent");
+    }
+
+//    кэш читается в фоне, ответы приходят в главный поток
+    BOOL isDelivered = [TestVKRequestHelper waitUntil:^BOOL
+    {
+        return (15 == _responsesCount);
+    }
+                                              timeout:5];
+
+    STAssertTrue(isDelivered, @"Cached responses should be delivered");
+    STAssertEquals(scheduler.queuedRequestsCount, (NSUInteger) 0, nil);
+    STAssertEquals(scheduler.executingRequestsCount, (NSUInteger) 0, @"Cached requests should not be queued");
+
+    TestScheduledRequest *request = [[TestScheduledRequest alloc] initWithMethod:@"users.get"
+                                                                         options:@{@"user_ids" : @"1"}];
+    request.delegate = self;
+
+    [scheduler scheduleRequest:request
+                         token:@"token"];
+
+    STAssertTrue(request.started, @"Rate limit should not be consumed by the cached requests");
+
+    [[VKStorage sharedStorage] clean];
+}
+
+@end
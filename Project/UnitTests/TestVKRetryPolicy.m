@@ -0,0 +1,166 @@
+//
+//  TestVKRetryPolicy.m
+//  Project
+//
+//  Created by AndrewShmig on 10/17/26.
+//  Copyright (c) 2013 AndrewShmig. All rights reserved.
+//
+
+#import "TestVKRetryPolicy.h"
+#import "VKRetryPolicy.h"
+#import "VKRetryBudget.h"
+#import "TestVKRequestHelper.h"
+
+
+@implementation TestVKRetryPolicy
+{
+    TestVKRequestHelper *_helper;
+    VKRetryPolicy *_policy;
+}
+
+- (void)setUp
+{
+    [super setUp];
+
+    _helper = [[TestVKRequestHelper alloc] init];
+
+    _policy = [VKRetryPolicy policy];
+    _policy.baseDelay = 0.01;
+    _policy.maxDelay = 0.05;
+    _policy.budget = [[VKRetryBudget alloc] initWithMaxTokens:10
+                                                   tokenRatio:0.1];
+}
+
+- (VKRequest *)requestMethod:(NSString *)methodName
+{
+    VKRequest *request = [_helper requestMethod:methodName
+                                        options:@{}];
+    request.retryPolicy = _policy;
+
+    return request;
+}
+
+//    первые failures ответов содержат ошибку с кодом errorCode
+- (void)failFirst:(NSUInteger)failures
+    withErrorCode:(NSInteger)errorCode
+{
+    __block NSUInteger served = 0;
+
+    _helper.transport.responseHandler = ^VKLoopbackResponse *(NSURLRequest *request)
+    {
+        if (served++ < failures)
+            return [VKLoopbackResponse responseWithJSONObject:@{@"error" : @{@"error_code" : @(errorCode)}}];
+
+        return [VKLoopbackResponse responseWithJSONObject:@{@"response" : @1}];
+    };
+}
+
+#pragma mark - Tests
+
+- (void)testRetryAfterInternalError
+{
+    [self failFirst:2
+      withErrorCode:10];
+
+    [_helper runRequest:[self requestMethod:@"friends.get"]];
+
+    STAssertEqualObjects(_helper.response[@"response"], @1, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 3, nil);
+}
+
+- (void)testMaxRetries
+{
+    _policy.maxRetries = 2;
+    [self failFirst:5
+      withErrorCode:6];
+
+    [_helper runRequest:[self requestMethod:@"friends.get"]];
+
+    STAssertEqualObjects(_helper.responseError[@"error_code"], @6, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 3, @"Request must be sent once and retried twice");
+}
+
+- (void)testNonIdempotentRequest
+{
+    [self failFirst:1
+      withErrorCode:10];
+
+    [_helper runRequest:[self requestMethod:@"wall.post"]];
+
+    STAssertEqualObjects(_helper.responseError[@"error_code"], @10, @"Method which changes data must not be retried");
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, nil);
+
+//    превышение частоты запросов означает, что метод не выполнялся
+    [self failFirst:1
+      withErrorCode:6];
+
+    [_helper runRequest:[self requestMethod:@"wall.post"]];
+
+    STAssertEqualObjects(_helper.response[@"response"], @1, nil);
+}
+
+- (void)testUnknownErrorIsNotRetried
+{
+    [self failFirst:1
+      withErrorCode:5];
+
+    [_helper runRequest:[self requestMethod:@"friends.get"]];
+
+    STAssertEqualObjects(_helper.responseError[@"error_code"], @5, nil);
+    STAssertEquals(_helper.transport.startedTasksCount, (NSUInteger) 1, nil);
+}
+
+- (void)testRetryBudget
+{
+    VKRetryBudget *budget = [[VKRetryBudget alloc] initWithMaxTokens:10
+                                                          tokenRatio:0.5];
+
+//    повторы разрешены, пока бюджет заполнен больше чем наполовину
+    for (NSUInteger i = 0; i < 5; i++)
+        STAssertTrue([budget withdrawRetry], nil);
+
+    STAssertFalse([budget withdrawRetry], @"Budget must be exhausted");
+
+    [budget depositSuccess];
+    [budget depositSuccess];
+
+    STAssertTrue([budget withdrawRetry], @"Successful requests must refill budget");
+    STAssertFalse([budget withdrawRetry], nil);
+}
+
+- (void)testDecorrelatedJitter
+{
+    _policy.baseDelay = 1;
+    _policy.maxDelay = 20;
+
+    NSTimeInterval delay = 0;
+
+    for (NSUInteger i = 0; i < 100; i++) {
+        NSTimeInterval nextDelay = [_policy delayAfterDelay:delay];
+
+        STAssertTrue(nextDelay >= 1, nil);
+        STAssertTrue(nextDelay <= MIN(20, (0 == delay ? 1 : delay) * 3), nil);
+
+        delay = nextDelay;
+    }
+}
+
+- (void)testFirstDelayIsJittered
+{
+    _policy.baseDelay = 1;
+    _policy.maxDelay = 20;
+
+    NSMutableSet *delays = [NSMutableSet set];
+
+//    иначе первые повторы всех клиентов, получивших ошибку одновременно, совпадут
+    for (NSUInteger i = 0; i < 20; i++) {
+        NSTimeInterval delay = [_policy delayAfterDelay:0];
+
+        STAssertTrue(delay >= 1 && delay <= 3, nil);
+        [delays addObject:@(delay)];
+    }
+
+    STAssertTrue([delays count] > 1, @"First delay must be random");
+}
+
+@end
@@ -10,6 +10,8 @@
 #import "VKStorage.h"
 #import "VKStorageItem.h"
 #import "VKAccessToken.h"
+#import "VKCachedData.h"
+#import "VKCacheLogStore.h"
 
 @implementation TestVKStorage
 
@@ -217,4 +219,50 @@
     [[VKStorage sharedStorage] clean];
 }
 
+- (void)testCacheCapacityIsSharedBetweenUsers
+{
+    VKStorage *storage = [VKStorage sharedStorage];
+
+    storage.cacheCapacity = 30 * 1024 * 1024;
+    storage.cacheCapacityPerUser = 20 * 1024 * 1024;
+
+    VKAccessToken *token1 = [[VKAccessToken alloc]
+                                            initWithUserID:1
+                                               accessToken:@"1"
+                                                  liveTime:0
+                                               permissions:@[@"offline"]];
+    VKStorageItem *item1 = [storage createStorageItemForAccessToken:token1];
+    [storage addItem:item1];
+
+//    один пользователь ограничен своим объемом
+    STAssertEquals(item1.cachedData.store.capacity, 20ULL * 1024 * 1024, nil);
+    STAssertEquals(item1.cachedData.store.quota.capacity, 30ULL * 1024 * 1024, nil);
+
+    VKAccessToken *token2 = [[VKAccessToken alloc]
+                                            initWithUserID:2
+                                               accessToken:@"2"
+                                                  liveTime:0
+                                               permissions:@[@"offline"]];
+    VKStorageItem *item2 = [storage createStorageItemForAccessToken:token2];
+    [storage addItem:item2];
+
+//    общий объем не делится поровну - он ограничивает сумму кэшей пользователей
+    STAssertEquals(item1.cachedData.store.capacity, 20ULL * 1024 * 1024, nil);
+    STAssertEquals(item2.cachedData.store.capacity, 20ULL * 1024 * 1024, nil);
+    STAssertTrue(item1.cachedData.store.quota == item2.cachedData.store.quota, nil);
+    STAssertEquals([[item1.cachedData.store.quota stores] count], (NSUInteger) 2, nil);
+
+    storage.cacheEvictionPolicy = VKCacheEvictionPolicyLFU;
+
+    STAssertEquals(item2.cachedData.store.evictionPolicy, VKCacheEvictionPolicyLFU, nil);
+
+    storage.cacheCapacity = kVKStorageDefaultCacheCapacity;
+    storage.cacheCapacityPerUser = kVKStorageDefaultCacheCapacityPerUser;
+    storage.cacheEvictionPolicy = VKCacheEvictionPolicyLRU;
+
+    [storage clean];
+
+    STAssertNil(item1.cachedData.store.quota, nil);
+}
+
 @end
@@ -0,0 +1,73 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "NSData+subdataNoCopy.h"
+
+
+//    байты принадлежат исходному объекту, освобождать их не нужно
+static void *NSDataSubdataNoCopyAllocate(CFIndex size, CFOptionFlags hint, void *info)
+{
+    return NULL;
+}
+
+static void NSDataSubdataNoCopyDeallocate(void *ptr, void *info)
+{
+}
+
+
+@implementation NSData (subdataNoCopy)
+
+- (NSData *)subdataNoCopyWithRange:(NSRange)range
+{
+    if (NSMaxRange(range) > [self length])
+        [NSException raise:NSRangeException
+                    format:@"Range %@ exceeds data length %lu", NSStringFromRange(range), (unsigned long) [self length]];
+
+    if (0 == range.length)
+        return [NSData data];
+
+//    распределитель держит исходный объект (например, отображенный в память
+//    файл), пока жив созданный объект
+    CFAllocatorContext context;
+    memset(&context, 0, sizeof(context));
+
+    context.info = (__bridge void *) self;
+    context.retain = CFRetain;
+    context.release = CFRelease;
+    context.allocate = NSDataSubdataNoCopyAllocate;
+    context.deallocate = NSDataSubdataNoCopyDeallocate;
+
+    CFAllocatorRef deallocator = CFAllocatorCreate(kCFAllocatorDefault, &context);
+    CFDataRef subdata = CFDataCreateWithBytesNoCopy(kCFAllocatorDefault,
+                                                    (const UInt8 *) [self bytes] + range.location,
+                                                    (CFIndex) range.length,
+                                                    deallocator);
+    CFRelease(deallocator);
+
+    return CFBridgingRelease(subdata);
+}
+
+@end
@@ -0,0 +1,113 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "NSData+zlib.h"
+#import <zlib.h>
+
+
+//    размер порции, на которую увеличивается буфер при распаковке
+#define kNSDataZlibInflateChunkSize (16 * 1024)
+
+
+@implementation NSData (zlib)
+
+- (NSData *)deflatedData
+{
+    if (0 == [self length])
+        return [NSData data];
+
+    uLongf length = compressBound((uLong) [self length]);
+    NSMutableData *output = [NSMutableData dataWithLength:length];
+
+    int result = compress2([output mutableBytes], &length,
+                           [self bytes], (uLong) [self length],
+                           Z_DEFAULT_COMPRESSION);
+
+    if (Z_OK != result)
+        return nil;
+
+    [output setLength:length];
+
+    return output;
+}
+
+- (NSData *)inflatedData
+{
+    if (0 == [self length])
+        return [NSData data];
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    stream.next_in = (Bytef *) [self bytes];
+    stream.avail_in = (uInt) [self length];
+
+//    32 + MAX_WBITS - формат (zlib или gzip) определяется по заголовку
+    if (Z_OK != inflateInit2(&stream, 32 + MAX_WBITS))
+        return nil;
+
+    NSMutableData *output = [NSMutableData dataWithLength:[self length] * 4];
+    int result = Z_OK;
+
+    while (Z_OK == result) {
+        if (stream.total_out >= [output length])
+            [output increaseLengthBy:kNSDataZlibInflateChunkSize];
+
+        stream.next_out = (Bytef *) [output mutableBytes] + stream.total_out;
+        stream.avail_out = (uInt) ([output length] - stream.total_out);
+
+        result = inflate(&stream, Z_NO_FLUSH);
+    }
+
+    inflateEnd(&stream);
+
+    if (Z_STREAM_END != result)
+        return nil;
+
+    [output setLength:stream.total_out];
+
+    return output;
+}
+
+- (uint32_t)crc32Checksum
+{
+    uLong checksum = crc32(0L, Z_NULL, 0);
+    const Bytef *bytes = [self bytes];
+    NSUInteger length = [self length];
+
+//    длина, которую принимает crc32, ограничена uInt
+    while (0 != length) {
+        uInt partLength = (uInt) MIN(length, (NSUInteger) UINT_MAX);
+
+        checksum = crc32(checksum, bytes, partLength);
+        bytes += partLength;
+        length -= partLength;
+    }
+
+    return (uint32_t) checksum;
+}
+
+@end
@@ -0,0 +1,113 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKRequest.h"
+
+
+/** Default size of one uploaded chunk in bytes
+*/
+#define kVKChunkedUploadDefaultChunkSize (1024 * 1024)
+
+
+/** Default number of attempts to resend a chunk after connection failure
+*/
+#define kVKChunkedUploadDefaultMaxChunkRetries 3
+
+
+/** Request which uploads large file (video, document) to the upload server
+by chunks using resumable upload protocol: each chunk is sent with Content-Range
+and Session-ID headers, server acknowledges received byte ranges.
+
+Upload progress is saved to the journal after each acknowledged chunk, so
+if connection is lost the upload can be resumed (even after application restart)
+from the last acknowledged offset by starting new request with the same upload URL
+and file URL.
+
+Chunk which failed with a transient error is sent again according to retryPolicy
+(by default [VKRetryPolicy policy]): delays between attempts grow as the policy
+defines and every attempt is paid from its budget. Deadline and timeout cover the
+whole upload including retries; when deadline passes, the current chunk is
+cancelled and the journal is kept.
+
+Aggregate progress is reported through VKRequest:totalBytes:uploadedBytes:,
+server response to the last chunk is delivered through VKRequest:response:.
+*/
+@interface VKChunkedUploadRequest : VKRequest
+
+/**
+@name Properties
+*/
+/** Upload server URL (for example one returned by video.save or docs.getUploadServer)
+*/
+@property (nonatomic, copy, readonly) NSURL *uploadURL;
+
+/** URL of the local file
+*/
+@property (nonatomic, copy, readonly) NSURL *fileURL;
+
+/** File name sent to the server. By default equals to the name of the local file
+*/
+@property (nonatomic, copy, readwrite) NSString *fileName;
+
+/** Size of one chunk in bytes. By default equals to kVKChunkedUploadDefaultChunkSize
+*/
+@property (nonatomic, assign, readwrite) unsigned long long chunkSize;
+
+/** Maximum number of attempts to resend one chunk after connection failure before
+the error is delivered to the delegate, maxRetries of retryPolicy limits them too.
+By default equals to kVKChunkedUploadDefaultMaxChunkRetries
+*/
+@property (nonatomic, assign, readwrite) NSUInteger maxChunkRetries;
+
+/** Size of the file in bytes
+*/
+@property (nonatomic, assign, readonly) unsigned long long totalBytes;
+
+/** Number of bytes acknowledged by the server
+*/
+@property (nonatomic, assign, readonly) unsigned long long acknowledgedBytes;
+
+/**
+@name Init methods
+*/
+/** Creates upload request
+
+@param uploadURL upload server URL
+@param fileURL URL of the local file
+@return request
+*/
+- (instancetype)initWithUploadURL:(NSURL *)uploadURL
+                          fileURL:(NSURL *)fileURL;
+
+/**
+@name Journal
+*/
+/** Removes saved progress, next start will upload file from the beginning
+*/
+- (void)discardProgress;
+
+@end
@@ -0,0 +1,503 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <sys/stat.h>
+#import "VKChunkedUploadRequest.h"
+#import "VKMultipartBodyStream.h"
+#import "VKNetworkThread.h"
+#import "VKRetryPolicy.h"
+#import "NSString+MD5.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+static NSString *const kVKChunkedUploadJournalDirectory = @"VKChunkedUploads";
+
+
+@implementation VKChunkedUploadRequest
+{
+    id _chunkTask;
+    NSMutableData *_chunkResponseData;
+    NSInteger _chunkStatusCode;
+
+    unsigned long long _chunkOffset;
+    unsigned long long _chunkLength;
+    NSUInteger _chunkAttempt;
+    NSTimeInterval _chunkRetryDelay;
+
+    NSString *_sessionID;
+    NSDate *_fileModificationDate;
+}
+
+#pragma mark Visible VKChunkedUploadRequest methods
+#pragma mark - Init methods
+
+- (instancetype)initWithUploadURL:(NSURL *)uploadURL
+                          fileURL:(NSURL *)fileURL
+{
+    INFO_LOG();
+
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:uploadURL];
+    [request setHTTPMethod:@"POST"];
+
+    self = [super initWithRequest:request];
+
+    if (nil == self)
+        return nil;
+
+    _uploadURL = [uploadURL copy];
+    _fileURL = [fileURL copy];
+    _fileName = [[fileURL lastPathComponent] copy];
+    _chunkSize = kVKChunkedUploadDefaultChunkSize;
+    _maxChunkRetries = kVKChunkedUploadDefaultMaxChunkRetries;
+
+//    обрыв соединения на большом файле - обычное дело, поэтому части повторяются
+//    и без явно заданной политики
+    self.retryPolicy = [VKRetryPolicy policy];
+
+//    ответ сервера загрузки не кэшируется
+    self.cacheLiveTime = VKCachedDataLiveTimeNever;
+    self.cachePolicy = VKRequestCachePolicyNetworkOnly;
+
+    return self;
+}
+
+#pragma mark - Getters
+
+- (BOOL)isIdempotent
+{
+//    часть, отправленная повторно с тем же Session-ID и Content-Range,
+//    принимается сервером один раз
+    return YES;
+}
+
+#pragma mark - Setters
+
+- (void)setChunkSize:(unsigned long long)chunkSize
+{
+    _chunkSize = MAX(1, chunkSize);
+}
+
+#pragma mark - Start & cancel request
+
+- (void)start
+{
+    INFO_LOG();
+
+//    без делегата загрузка не нужна - базовый класс просто завершит запрос
+    if (nil == self.delegate) {
+        [super start];
+        return;
+    }
+
+    [self applyTimeout];
+
+//    крайний срок относится ко всей загрузке, включая повторы частей
+    if (self.isDeadlineExceeded) {
+        [self deliverConnectionError:[self deadlineExceededError]];
+        return;
+    }
+
+    if (![self readFileAttributes]) {
+        NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
+                                             code:NSURLErrorFileDoesNotExist
+                                         userInfo:@{NSLocalizedDescriptionKey : @"File does not exist or is empty",
+                                                    NSURLErrorKey             : self.fileURL}];
+        [self deliverConnectionError:error];
+
+        return;
+    }
+
+//    продолжаем с последнего подтвержденного сервером байта
+    [self restoreJournal];
+
+    _chunkAttempt = 0;
+    _chunkRetryDelay = 0;
+
+//    части отправляются и повторяются в сетевом потоке
+    [VKNetworkThread performBlock:^
+    {
+        if (nil != self.deadline)
+            [self performSelector:@selector(chunkDeadlineExceeded)
+                       withObject:nil
+                       afterDelay:[self.deadline timeIntervalSinceNow]];
+
+        [self sendNextChunk];
+    }];
+}
+
+- (void)cancel
+{
+    INFO_LOG();
+
+//    журнал сохраняется, чтобы загрузку можно было продолжить позже
+    [VKNetworkThread performBlock:^
+    {
+        [self stopChunks];
+    }];
+
+    [super cancel];
+}
+
+#pragma mark - Journal
+
+- (void)discardProgress
+{
+    INFO_LOG();
+
+    [[NSFileManager defaultManager] removeItemAtPath:[self journalPath]
+                                               error:nil];
+
+    _sessionID = nil;
+    _acknowledgedBytes = 0;
+}
+
+#pragma mark - Overridden methods
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    VKChunkedUploadRequest *copy = [[VKChunkedUploadRequest alloc]
+                                                            initWithUploadURL:self.uploadURL
+                                                                      fileURL:self.fileURL];
+
+    copy.signature = self.signature;
+    copy.fileName = self.fileName;
+    copy.chunkSize = self.chunkSize;
+    copy.maxChunkRetries = self.maxChunkRetries;
+    copy.retryPolicy = self.retryPolicy;
+    copy.deadline = self.deadline;
+    copy.timeout = self.timeout;
+
+    return copy;
+}
+
+#pragma mark - VKTransportDelegate
+
+- (void)transport:(id <VKTransport>)transport
+             task:(id)task
+didReceiveResponse:(NSHTTPURLResponse *)response
+{
+    INFO_LOG();
+
+    _chunkStatusCode = [response statusCode];
+    [_chunkResponseData setLength:0];
+}
+
+- (void)transport:(id <VKTransport>)transport
+             task:(id)task
+   didReceiveData:(NSData *)data
+{
+    INFO_LOG();
+
+    [_chunkResponseData appendData:data];
+}
+
+- (void)           transport:(id <VKTransport>)transport
+                        task:(id)task
+              didSendBodyData:(int64_t)totalBytesSent
+    totalBytesExpectedToSend:(int64_t)totalBytesExpectedToSend
+{
+    INFO_LOG();
+
+//    прогресс всей загрузки, а не отдельной части
+    NSUInteger totalBytes = (NSUInteger) self.totalBytes;
+    NSUInteger uploadedBytes = (NSUInteger) (_chunkOffset + (unsigned long long) totalBytesSent);
+
+    [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+    {
+        if ([delegate respondsToSelector:@selector(VKRequest:totalBytes:uploadedBytes:)])
+            [delegate VKRequest:self
+                     totalBytes:totalBytes
+                  uploadedBytes:uploadedBytes];
+    }];
+}
+
+- (NSInputStream *)transport:(id <VKTransport>)transport
+    needNewBodyStreamForTask:(id)task
+{
+    INFO_LOG();
+
+    return [self chunkBodyStream];
+}
+
+- (void)     transport:(id <VKTransport>)transport
+                  task:(id)task
+  didCompleteWithError:(NSError *)error
+{
+    INFO_LOG();
+
+    _chunkTask = nil;
+
+    if (nil != error) {
+        [self retryChunkWithError:error];
+        return;
+    }
+
+//    часть принята, но загрузка еще не закончена
+    if (201 == _chunkStatusCode) {
+        [self chunkAcknowledged];
+        return;
+    }
+
+//    последняя часть - сервер вернул результат загрузки
+    if (200 == _chunkStatusCode) {
+        [self stopChunks];
+        [self discardProgress];
+        [self.retryPolicy requestDidSucceed:self];
+
+        NSError *parsingError = nil;
+        id json = [NSJSONSerialization JSONObjectWithData:_chunkResponseData
+                                                  options:NSJSONReadingAllowFragments | NSJSONReadingMutableContainers | NSJSONReadingMutableLeaves
+                                                    error:&parsingError];
+
+        if (nil != parsingError)
+            [self deliverParsingError:parsingError];
+        else
+            [self deliverResponseJSON:json];
+
+        return;
+    }
+
+//    ошибки сервера бывают временными, остальные - нет
+    if (_chunkStatusCode >= 500) {
+        [self retryChunkWithError:[self HTTPErrorWithStatusCode:_chunkStatusCode]];
+        return;
+    }
+
+//    сервер не принимает сессию - продолжить ее уже не получится
+    [self stopChunks];
+    [self discardProgress];
+    [self deliverConnectionError:[self HTTPErrorWithStatusCode:_chunkStatusCode]];
+}
+
+#pragma mark - Private methods
+
+- (BOOL)readFileAttributes
+{
+    struct stat fileStat;
+
+    if (![self.fileURL isFileURL] || 0 != stat([[self.fileURL path] fileSystemRepresentation], &fileStat))
+        return NO;
+
+    if (!S_ISREG(fileStat.st_mode) || 0 == fileStat.st_size)
+        return NO;
+
+    _totalBytes = (unsigned long long) fileStat.st_size;
+    _fileModificationDate = [NSDate dateWithTimeIntervalSince1970:fileStat.st_mtime];
+
+    return YES;
+}
+
+- (void)sendNextChunk
+{
+    _chunkOffset = _acknowledgedBytes;
+    _chunkLength = MIN(self.chunkSize, self.totalBytes - _chunkOffset);
+    _chunkResponseData = [[NSMutableData alloc] init];
+    _chunkStatusCode = 0;
+
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:self.uploadURL];
+    [request setHTTPMethod:@"POST"];
+
+    NSString *contentDisposition = [NSString stringWithFormat:@"attachment; filename=\"%@\"",
+                                                              self.fileName];
+    NSString *contentRange = [NSString stringWithFormat:@"bytes %llu-%llu/%llu",
+                                                        _chunkOffset,
+                                                        _chunkOffset + _chunkLength - 1,
+                                                        self.totalBytes];
+
+    [request setValue:@"application/octet-stream"
+   forHTTPHeaderField:@"Content-Type"];
+    [request setValue:contentDisposition
+   forHTTPHeaderField:@"Content-Disposition"];
+    [request setValue:contentRange
+   forHTTPHeaderField:@"Content-Range"];
+    [request setValue:_sessionID
+   forHTTPHeaderField:@"Session-ID"];
+    [request setValue:[NSString stringWithFormat:@"%llu", _chunkLength]
+   forHTTPHeaderField:@"Content-Length"];
+
+//    часть файла читается из файла по мере отправки
+    [request setHTTPBodyStream:[self chunkBodyStream]];
+
+    _chunkTask = [self.transport startTaskWithRequest:request
+                                             delegate:self];
+}
+
+- (VKMultipartBodyStream *)chunkBodyStream
+{
+    VKBodyFilePart *part = [[VKBodyFilePart alloc] initWithFileURL:self.fileURL
+                                                            offset:_chunkOffset
+                                                            length:_chunkLength];
+
+    return [[VKMultipartBodyStream alloc] initWithParts:@[part]];
+}
+
+- (void)chunkAcknowledged
+{
+//    сервер возвращает принятые диапазоны: "0-1048575/5242880"
+//    продолжать можно только с конца непрерывного диапазона, начинающегося с нуля
+    NSString *ranges = [[NSString alloc] initWithData:_chunkResponseData
+                                             encoding:NSUTF8StringEncoding];
+    unsigned long long acknowledgedBytes = _chunkOffset + _chunkLength;
+
+    NSScanner *scanner = [NSScanner scannerWithString:(nil == ranges ? @"" : ranges)];
+    unsigned long long rangeStart = 0;
+    unsigned long long rangeEnd = 0;
+
+    if ([scanner scanUnsignedLongLong:&rangeStart] && [scanner scanString:@"-" intoString:NULL] && [scanner scanUnsignedLongLong:&rangeEnd] && 0 == rangeStart)
+        acknowledgedBytes = MIN(rangeEnd + 1, self.totalBytes);
+
+    _acknowledgedBytes = acknowledgedBytes;
+    _chunkAttempt = 0;
+    _chunkRetryDelay = 0;
+
+    [self saveJournal];
+    [self.retryPolicy requestDidSucceed:self];
+
+    if (_acknowledgedBytes >= self.totalBytes) {
+        NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
+                                             code:NSURLErrorCannotParseResponse
+                                         userInfo:@{NSLocalizedDescriptionKey : @"Upload server did not return upload result"}];
+        [self stopChunks];
+        [self discardProgress];
+        [self deliverParsingError:error];
+
+        return;
+    }
+
+    [self sendNextChunk];
+}
+
+- (void)retryChunkWithError:(NSError *)error
+{
+    NSTimeInterval delay = [self.retryPolicy delayAfterDelay:_chunkRetryDelay];
+
+//    попытки считаются для каждой части отдельно, задержки и бюджет повторов
+//    определяет политика запроса; повтор, не успевающий до крайнего срока, не нужен
+    BOOL canRetry = (_chunkAttempt < self.maxChunkRetries &&
+            (nil == self.deadline || [self.deadline timeIntervalSinceNow] > delay) &&
+            [self.retryPolicy shouldRetryRequest:self
+                                 connectionError:error
+                                         attempt:_chunkAttempt]);
+
+    if (!canRetry) {
+//        журнал остается - загрузку можно будет продолжить позже
+        [self stopChunks];
+        [self deliverConnectionError:error];
+        return;
+    }
+
+    _chunkAttempt++;
+    _chunkRetryDelay = delay;
+
+    [self performSelector:@selector(sendNextChunk)
+               withObject:nil
+               afterDelay:delay];
+}
+
+- (void)chunkDeadlineExceeded
+{
+    INFO_LOG();
+
+//    журнал остается - загрузку можно будет продолжить позже
+    [self stopChunks];
+    [self deliverConnectionError:[self deadlineExceededError]];
+}
+
+- (void)stopChunks
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                             selector:@selector(sendNextChunk)
+                                               object:nil];
+    [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                             selector:@selector(chunkDeadlineExceeded)
+                                               object:nil];
+
+    [self.transport cancelTask:_chunkTask];
+    _chunkTask = nil;
+}
+
+- (NSError *)HTTPErrorWithStatusCode:(NSInteger)statusCode
+{
+    return [NSError errorWithDomain:@"VKRequestErrorDomain"
+                               code:statusCode
+                           userInfo:@{@"Localized status code string" : [NSHTTPURLResponse localizedStringForStatusCode:statusCode]}];
+}
+
+- (NSString *)journalPath
+{
+    NSString *cachePath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *journalKey = [[NSString stringWithFormat:@"%@|%@",
+                                                      [self.uploadURL absoluteString],
+                                                      [self.fileURL path]] md5];
+
+    return [[cachePath stringByAppendingPathComponent:kVKChunkedUploadJournalDirectory]
+                       stringByAppendingPathComponent:[journalKey stringByAppendingPathExtension:@"plist"]];
+}
+
+- (void)restoreJournal
+{
+    NSDictionary *journal = [NSDictionary dictionaryWithContentsOfFile:[self journalPath]];
+
+//    журнал годится только для того же самого, не изменившегося файла
+    BOOL isValid = (nil != journal &&
+            [journal[@"fileSize"] unsignedLongLongValue] == self.totalBytes &&
+            [journal[@"fileModificationDate"] isEqualToDate:_fileModificationDate] &&
+            nil != journal[@"sessionID"]);
+
+    if (isValid) {
+        _sessionID = journal[@"sessionID"];
+        _acknowledgedBytes = MIN([journal[@"acknowledgedBytes"] unsignedLongLongValue], self.totalBytes - 1);
+    } else {
+        _sessionID = [[NSProcessInfo processInfo] globallyUniqueString];
+        _acknowledgedBytes = 0;
+    }
+}
+
+- (void)saveJournal
+{
+    NSString *journalPath = [self journalPath];
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:[journalPath stringByDeletingLastPathComponent]
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+
+    NSDictionary *journal = @{
+            @"uploadURL"            : [self.uploadURL absoluteString],
+            @"filePath"             : [self.fileURL path],
+            @"fileSize"             : @(self.totalBytes),
+            @"fileModificationDate" : _fileModificationDate,
+            @"sessionID"            : _sessionID,
+            @"acknowledgedBytes"    : @(_acknowledgedBytes)
+    };
+
+    [journal writeToFile:journalPath
+              atomically:YES];
+}
+
+@end
@@ -0,0 +1,99 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Types of the entities kept by VKEntityStore
+*/
+typedef enum
+{
+    VKEntityTypeUser = 0,
+    VKEntityTypeGroup,
+    VKEntityTypePost
+} VKEntityType;
+
+
+/** Entity (user, group, post) shared by all responses in which it was received.
+
+VKEntity is a dictionary, so it can be used in place of the dictionary from
+the response. Unlike an ordinary dictionary it is updated every time the entity
+arrives in another response: fields are merged, each field remembers the time
+of its last update. Use copy to get a snapshot which does not change.
+*/
+@interface VKEntity : NSDictionary
+
+/**
+@name Properties
+*/
+/** Entity type
+*/
+@property (nonatomic, assign, readonly) VKEntityType entityType;
+
+/** Entity ID: user or group ID, "ownerID_postID" for posts
+*/
+@property (nonatomic, copy, readonly) NSString *entityID;
+
+/**
+@name Initialization methods
+*/
+/** Creates empty entity
+
+@param entityType entity type
+@param entityID entity ID
+@return VKEntity instance
+*/
+- (instancetype)initWithEntityType:(VKEntityType)entityType
+                          entityID:(NSString *)entityID;
+
+/**
+@name Fields
+*/
+/** Sets values of the fields, other fields are kept
+
+@param fields new values of the fields
+@param updateTime time of the update (timeIntervalSince1970)
+*/
+- (void)mergeFields:(NSDictionary *)fields
+         updateTime:(NSTimeInterval)updateTime;
+
+/** Returns time of the last update of the field
+
+@param field field name
+@return timeIntervalSince1970 or 0 if entity has no such field
+*/
+- (NSTimeInterval)updateTimeForField:(NSString *)field;
+
+/** Checks if the field was updated not earlier than maxAge seconds ago
+
+@param field field name
+@param maxAge maximum age of the field in seconds
+@return YES if the field is known and fresh
+*/
+- (BOOL)isFieldFresh:(NSString *)field
+              maxAge:(NSTimeInterval)maxAge;
+
+@end
@@ -0,0 +1,119 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKEntity.h"
+
+
+@implementation VKEntity
+{
+    NSMutableDictionary *_fields;
+    NSMutableDictionary *_updateTimes;
+}
+
+#pragma mark Visible VKEntity methods
+#pragma mark - Init methods
+
+- (instancetype)initWithEntityType:(VKEntityType)entityType
+                          entityID:(NSString *)entityID
+{
+    self = [super init];
+
+    if (self) {
+        _entityType = entityType;
+        _entityID = [entityID copy];
+        _fields = [[NSMutableDictionary alloc] init];
+        _updateTimes = [[NSMutableDictionary alloc] init];
+    }
+
+    return self;
+}
+
+#pragma mark - Fields
+
+- (void)mergeFields:(NSDictionary *)fields
+         updateTime:(NSTimeInterval)updateTime
+{
+    NSNumber *time = @(updateTime);
+
+//    сущность читается в главном потоке, а обновляется в потоке разбора ответа
+    @synchronized (self) {
+        [fields enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop)
+        {
+            _fields[key] = obj;
+            _updateTimes[key] = time;
+        }];
+    }
+}
+
+- (NSTimeInterval)updateTimeForField:(NSString *)field
+{
+    @synchronized (self) {
+        return [_updateTimes[field] doubleValue];
+    }
+}
+
+- (BOOL)isFieldFresh:(NSString *)field
+              maxAge:(NSTimeInterval)maxAge
+{
+    NSTimeInterval updateTime = [self updateTimeForField:field];
+
+    return (0 != updateTime && [[NSDate date] timeIntervalSince1970] - updateTime <= maxAge);
+}
+
+#pragma mark - NSDictionary
+
+- (NSUInteger)count
+{
+    @synchronized (self) {
+        return [_fields count];
+    }
+}
+
+- (id)objectForKey:(id)aKey
+{
+    @synchronized (self) {
+        return _fields[aKey];
+    }
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    @synchronized (self) {
+        return [[_fields allKeys] objectEnumerator];
+    }
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+//    копия не изменяется при последующих обновлениях сущности
+    @synchronized (self) {
+        return [[NSDictionary allocWithZone:zone] initWithDictionary:_fields];
+    }
+}
+
+@end
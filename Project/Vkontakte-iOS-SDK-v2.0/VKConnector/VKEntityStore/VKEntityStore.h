@@ -0,0 +1,141 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKEntity.h"
+
+
+/** Store of users, groups and posts received in the responses.
+
+Every entity is kept in one instance (VKEntity) however many responses it came
+in: friends.get, "profiles" of wall.get, users of messages.getDialogs etc share
+the same object, new fields are merged into it. Entities are referenced weakly:
+entity is released when no response and no screen uses it anymore, so memory
+depends on the number of distinct entities, not on the number of responses.
+
+Requests with entityStore (see VKRequest entityStore) merge entities into the
+store while decoding the response, dictionaries of the response are replaced
+with the VKEntity instances.
+
+Each field remembers the time of its last update, so later requests can skip
+fields (or IDs) which are already known and fresh, see staleFields:... methods.
+
+Entities are recognized by their fields:
+
+- posts - dictionaries with "post_type" key;
+- users - dictionaries with "id" (or "uid") and "first_name" keys;
+- groups - dictionaries with "id" (or "gid"), "name" and "screen_name" keys.
+
+All methods are thread safe.
+*/
+@interface VKEntityStore : NSObject
+
+/**
+@name Class methods
+*/
+/** Shared store
+
+@return VKEntityStore instance
+*/
++ (instancetype)sharedStore;
+
+/**
+@name Entities
+*/
+/** Number of entities which are alive
+*/
+@property (nonatomic, readonly) NSUInteger count;
+
+/** Returns entity if it is alive
+
+@param entityType entity type
+@param entityID user or group ID, "ownerID_postID" for posts
+@return VKEntity instance or nil
+*/
+- (VKEntity *)entityOfType:(VKEntityType)entityType
+                  entityID:(id)entityID;
+
+/** Merges fields into the entity, entity is created if needed
+
+@param fields new values of the fields
+@param entityType entity type
+@param entityID user or group ID, "ownerID_postID" for posts
+@return VKEntity instance
+*/
+- (VKEntity *)mergeFields:(NSDictionary *)fields
+             ofEntityType:(VKEntityType)entityType
+                 entityID:(id)entityID;
+
+/** Merges all entities found in the Foundation object (response) into the store
+
+@param json Foundation object
+@return the same object in which entity dictionaries are replaced with VKEntity instances
+*/
+- (id)mergeEntitiesFromJSON:(id)json;
+
+/** Removes all entities from the store, entities which are in use stay valid
+but are not updated anymore
+*/
+- (void)removeAllEntities;
+
+/**
+@name Freshness
+*/
+/** Returns fields which are unknown or older than maxAge seconds
+
+@param fields field names (keys of the response dictionary)
+@param entityType entity type
+@param entityID entity ID
+@param maxAge maximum age of the field in seconds
+@return subarray of fields which should be requested
+*/
+- (NSArray *)staleFields:(NSArray *)fields
+            ofEntityType:(VKEntityType)entityType
+                entityID:(id)entityID
+                  maxAge:(NSTimeInterval)maxAge;
+
+/** Returns IDs of the entities which have at least one unknown or older than
+maxAge seconds field
+
+Example:
+
+NSArray *IDs = [[VKEntityStore sharedStore] entityIDs:friendsIDs
+withStaleFields:@[@"photo_50", @"online"]
+ofEntityType:VKEntityTypeUser
+maxAge:60];
+
+@param entityIDs entity IDs
+@param fields field names (keys of the response dictionary)
+@param entityType entity type
+@param maxAge maximum age of the field in seconds
+@return subarray of entityIDs which should be requested
+*/
+- (NSArray *)entityIDs:(NSArray *)entityIDs
+       withStaleFields:(NSArray *)fields
+          ofEntityType:(VKEntityType)entityType
+                maxAge:(NSTimeInterval)maxAge;
+
+@end
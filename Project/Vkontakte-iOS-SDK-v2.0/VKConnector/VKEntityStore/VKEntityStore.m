@@ -0,0 +1,243 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKEntityStore.h"
+
+
+@implementation VKEntityStore
+{
+    NSMapTable *_entities;
+}
+
+#pragma mark Visible VKEntityStore methods
+#pragma mark - Class methods
+
++ (instancetype)sharedStore
+{
+    static VKEntityStore *sharedStore;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        sharedStore = [[self alloc] init];
+    });
+
+    return sharedStore;
+}
+
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+//        хранилище не удерживает сущности - они живут, пока используются
+        _entities = [NSMapTable strongToWeakObjectsMapTable];
+    }
+
+    return self;
+}
+
+#pragma mark - Entities
+
+- (NSUInteger)count
+{
+    @synchronized (self) {
+//        NSMapTable не сразу удаляет записи с освобожденными объектами
+        return [[[_entities objectEnumerator] allObjects] count];
+    }
+}
+
+- (VKEntity *)entityOfType:(VKEntityType)entityType
+                  entityID:(id)entityID
+{
+    @synchronized (self) {
+        return [_entities objectForKey:[self keyForEntityType:entityType
+                                                     entityID:entityID]];
+    }
+}
+
+- (VKEntity *)mergeFields:(NSDictionary *)fields
+             ofEntityType:(VKEntityType)entityType
+                 entityID:(id)entityID
+{
+    NSString *key = [self keyForEntityType:entityType
+                                  entityID:entityID];
+    VKEntity *entity;
+
+    @synchronized (self) {
+        entity = [_entities objectForKey:key];
+
+        if (nil == entity) {
+            entity = [[VKEntity alloc] initWithEntityType:entityType
+                                                 entityID:[entityID description]];
+            [_entities setObject:entity
+                          forKey:key];
+        }
+    }
+
+    [entity mergeFields:fields
+             updateTime:[[NSDate date] timeIntervalSince1970]];
+
+    return entity;
+}
+
+- (id)mergeEntitiesFromJSON:(id)json
+{
+    if ([json isKindOfClass:[VKEntity class]])
+        return json;
+
+    if ([json isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:[json count]];
+
+        for (id object in json)
+            [array addObject:[self mergeEntitiesFromJSON:object]];
+
+        return array;
+    }
+
+    if (![json isKindOfClass:[NSDictionary class]])
+        return json;
+
+//    вложенные сущности (например, репосты) объединяются первыми
+    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] initWithCapacity:[json count]];
+
+    [json enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop)
+    {
+        dictionary[key] = [self mergeEntitiesFromJSON:obj];
+    }];
+
+    VKEntityType entityType;
+    NSString *entityID = [self entityIDForFields:dictionary
+                                      entityType:&entityType];
+
+    if (nil == entityID)
+        return dictionary;
+
+    return [self mergeFields:dictionary
+                ofEntityType:entityType
+                    entityID:entityID];
+}
+
+- (void)removeAllEntities
+{
+    @synchronized (self) {
+        [_entities removeAllObjects];
+    }
+}
+
+#pragma mark - Freshness
+
+- (NSArray *)staleFields:(NSArray *)fields
+            ofEntityType:(VKEntityType)entityType
+                entityID:(id)entityID
+                  maxAge:(NSTimeInterval)maxAge
+{
+    VKEntity *entity = [self entityOfType:entityType
+                                 entityID:entityID];
+
+    if (nil == entity)
+        return [fields copy];
+
+    NSMutableArray *staleFields = [[NSMutableArray alloc] init];
+
+    for (NSString *field in fields)
+        if (![entity isFieldFresh:field
+                           maxAge:maxAge])
+            [staleFields addObject:field];
+
+    return staleFields;
+}
+
+- (NSArray *)entityIDs:(NSArray *)entityIDs
+       withStaleFields:(NSArray *)fields
+          ofEntityType:(VKEntityType)entityType
+                maxAge:(NSTimeInterval)maxAge
+{
+    NSMutableArray *staleEntityIDs = [[NSMutableArray alloc] init];
+
+    for (id entityID in entityIDs) {
+        NSArray *staleFields = [self staleFields:fields
+                                    ofEntityType:entityType
+                                        entityID:entityID
+                                          maxAge:maxAge];
+
+        if (0 != [staleFields count])
+            [staleEntityIDs addObject:entityID];
+    }
+
+    return staleEntityIDs;
+}
+
+#pragma mark - Private methods
+
+- (NSString *)keyForEntityType:(VKEntityType)entityType
+                      entityID:(id)entityID
+{
+    return [NSString stringWithFormat:@"%d:%@", entityType, entityID];
+}
+
+- (NSString *)entityIDForFields:(NSDictionary *)fields
+                     entityType:(VKEntityType *)entityType
+{
+    if (nil != fields[@"post_type"]) {
+        id ownerID = (nil != fields[@"owner_id"] ? fields[@"owner_id"] : fields[@"to_id"]);
+
+        if (nil == ownerID || nil == fields[@"id"])
+            return nil;
+
+        *entityType = VKEntityTypePost;
+
+        return [NSString stringWithFormat:@"%@_%@", ownerID, fields[@"id"]];
+    }
+
+    if (nil != fields[@"first_name"]) {
+        id userID = (nil != fields[@"id"] ? fields[@"id"] : fields[@"uid"]);
+
+        if (nil == userID)
+            return nil;
+
+        *entityType = VKEntityTypeUser;
+
+        return [userID description];
+    }
+
+    if (nil != fields[@"name"] && nil != fields[@"screen_name"]) {
+        id groupID = (nil != fields[@"id"] ? fields[@"id"] : fields[@"gid"]);
+
+        if (nil == groupID)
+            return nil;
+
+        *entityType = VKEntityTypeGroup;
+
+        return [groupID description];
+    }
+
+    return nil;
+}
+
+@end
@@ -0,0 +1,125 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Error domain of the parsing errors
+*/
+static NSString *const kVKJSONStreamParserErrorDomain = @"VKJSONStreamParserErrorDomain";
+
+
+@class VKJSONStreamParser;
+
+
+/** Protocol allows tracking parsing progress of the root object
+*/
+@protocol VKJSONStreamParserDelegate <NSObject>
+
+@optional
+/**
+@name Optional
+*/
+/** Is called as soon as the value of the root object key is completely parsed,
+while the rest of the document can still be downloading
+
+@param parser parser
+@param value parsed value
+@param key key of the root object
+*/
+- (void)      parser:(VKJSONStreamParser *)parser
+       didParseValue:(id)value
+          forRootKey:(NSString *)key;
+
+/** Is called for each element of the streamed array (see streamedArrayKeyPaths).
+Streamed elements are not added to the array, so the document never holds all of them
+
+@param parser parser
+@param item parsed element of the streamed array
+*/
+- (void)parser:(VKJSONStreamParser *)parser
+   didParseItem:(id)item;
+
+@end
+
+
+/** Incremental JSON parser. Document can be passed in arbitrary chunks (for example
+as soon as they are received from the network), so parsing overlaps downloading and
+the object graph is ready almost as soon as the last byte arrives.
+
+Parser produces the same objects as NSJSONSerialization with NSJSONReadingAllowFragments,
+NSJSONReadingMutableContainers and NSJSONReadingMutableLeaves options.
+*/
+@interface VKJSONStreamParser : NSObject
+
+/**
+@name Properties
+*/
+/** Delegate
+*/
+@property (nonatomic, weak, readwrite) id <VKJSONStreamParserDelegate> delegate;
+
+/** Parsed document. Equals to nil until document is completely parsed
+*/
+@property (nonatomic, strong, readonly) id rootObject;
+
+/** Parsing error, nil if no error occurred
+*/
+@property (nonatomic, strong, readonly) NSError *error;
+
+/** Number of bytes passed to the parser
+*/
+@property (nonatomic, assign, readonly) NSUInteger parsedBytes;
+
+/** Key paths (relative to the root object, for example @"response.items") of
+the arrays which elements should be passed to the delegate one by one instead of
+being accumulated. Only the first matching array of the document is streamed,
+in the parsed document it stays empty
+*/
+@property (nonatomic, copy, readwrite) NSSet *streamedArrayKeyPaths;
+
+/**
+@name Parsing
+*/
+/** Parses next chunk of the document
+
+@param data next chunk of the document
+@return NO if parsing error occurred or parsing was stopped
+*/
+- (BOOL)parseData:(NSData *)data;
+
+/** Tells parser that there is no more data
+
+@return YES if document was parsed completely and without errors
+*/
+- (BOOL)finish;
+
+/** Stops parsing, all subsequent data will be ignored. Can be called from
+the delegate methods
+*/
+- (void)stop;
+
+@end
@@ -0,0 +1,643 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKJSONStreamParser.h"
+
+
+#define kVKJSONStreamParserInitialTokenCapacity 256
+
+
+typedef enum
+{
+    VKJSONStreamParserStateExpectValue = 0,
+    VKJSONStreamParserStateExpectValueOrArrayEnd,
+    VKJSONStreamParserStateExpectKeyOrObjectEnd,
+    VKJSONStreamParserStateExpectKey,
+    VKJSONStreamParserStateExpectColon,
+    VKJSONStreamParserStateExpectCommaOrEnd,
+    VKJSONStreamParserStateString,
+    VKJSONStreamParserStateStringEscape,
+    VKJSONStreamParserStateStringUnicode,
+    VKJSONStreamParserStateNumber,
+    VKJSONStreamParserStateLiteral,
+    VKJSONStreamParserStateDone,
+    VKJSONStreamParserStateError,
+    VKJSONStreamParserStateStopped,
+
+} VKJSONStreamParserState;
+
+
+@implementation VKJSONStreamParser
+{
+    VKJSONStreamParserState _state;
+
+    NSMutableArray *_containers;
+    NSMutableArray *_keys;
+    NSMutableArray *_streamedArray;
+    BOOL _hasStreamedArray;
+
+    char *_token;
+    NSUInteger _tokenLength;
+    NSUInteger _tokenCapacity;
+
+    BOOL _isKey;
+    uint32_t _unicodeValue;
+    NSUInteger _unicodeDigits;
+    uint32_t _highSurrogate;
+}
+
+#pragma mark Visible VKJSONStreamParser methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+        _state = VKJSONStreamParserStateExpectValue;
+        _containers = [[NSMutableArray alloc] init];
+        _keys = [[NSMutableArray alloc] init];
+
+        _tokenCapacity = kVKJSONStreamParserInitialTokenCapacity;
+        _token = malloc(_tokenCapacity);
+        _tokenLength = 0;
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_token);
+}
+
+#pragma mark - Parsing
+
+- (BOOL)parseData:(NSData *)data
+{
+    if (VKJSONStreamParserStateError == _state || VKJSONStreamParserStateStopped == _state)
+        return NO;
+
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger i = 0;
+
+    while (i < length) {
+        if (VKJSONStreamParserStateError == _state || VKJSONStreamParserStateStopped == _state)
+            break;
+
+        uint8_t c = bytes[i];
+
+//        состояния, в которых накапливается значение (строка, число, литерал)
+        switch (_state) {
+            case VKJSONStreamParserStateString: {
+//                быстрый путь: копируем сразу весь участок строки до кавычки или экранирования
+                NSUInteger start = i;
+
+                while (i < length && '"' != bytes[i] && '\\' != bytes[i] && bytes[i] >= 0x20)
+                    i++;
+
+                [self appendTokenBytes:(const char *) (bytes + start)
+                                length:i - start];
+
+                if (i == length)
+                    continue;
+
+                if ('"' == bytes[i]) {
+                    [self finishStringAtOffset:_parsedBytes + i];
+                } else if ('\\' == bytes[i]) {
+                    _state = VKJSONStreamParserStateStringEscape;
+                } else {
+                    [self failWithDescription:@"Unescaped control character in string"
+                                       offset:_parsedBytes + i];
+                }
+
+                i++;
+                continue;
+            }
+
+            case VKJSONStreamParserStateStringEscape: {
+                char unescaped = 0;
+
+                switch (c) {
+                    case '"':  unescaped = '"';  break;
+                    case '\\': unescaped = '\\'; break;
+                    case '/':  unescaped = '/';  break;
+                    case 'b':  unescaped = '\b'; break;
+                    case 'f':  unescaped = '\f'; break;
+                    case 'n':  unescaped = '\n'; break;
+                    case 'r':  unescaped = '\r'; break;
+                    case 't':  unescaped = '\t'; break;
+                    default:
+                        break;
+                }
+
+                if ('u' == c) {
+                    _unicodeValue = 0;
+                    _unicodeDigits = 0;
+                    _state = VKJSONStreamParserStateStringUnicode;
+                } else if (0 != unescaped) {
+                    [self appendTokenBytes:&unescaped
+                                    length:1];
+                    _state = VKJSONStreamParserStateString;
+                } else {
+                    [self failWithDescription:@"Invalid escape sequence"
+                                       offset:_parsedBytes + i];
+                }
+
+                i++;
+                continue;
+            }
+
+            case VKJSONStreamParserStateStringUnicode: {
+                int digit = -1;
+
+                if (c >= '0' && c <= '9')
+                    digit = c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    digit = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    digit = c - 'A' + 10;
+
+                if (-1 == digit) {
+                    [self failWithDescription:@"Invalid unicode escape sequence"
+                                       offset:_parsedBytes + i];
+                } else {
+                    _unicodeValue = (_unicodeValue << 4) | (uint32_t) digit;
+                    _unicodeDigits++;
+
+                    if (4 == _unicodeDigits) {
+                        [self appendCodeUnit:_unicodeValue];
+                        _state = VKJSONStreamParserStateString;
+                    }
+                }
+
+                i++;
+                continue;
+            }
+
+            case VKJSONStreamParserStateNumber:
+                if ((c >= '0' && c <= '9') || '-' == c || '+' == c || '.' == c || 'e' == c || 'E' == c) {
+                    char character = (char) c;
+                    [self appendTokenBytes:&character
+                                    length:1];
+                    i++;
+                } else {
+//                    символ после числа обработаем повторно уже как структурный
+                    [self finishNumberAtOffset:_parsedBytes + i];
+                }
+
+                continue;
+
+            case VKJSONStreamParserStateLiteral:
+                if (c >= 'a' && c <= 'z') {
+                    char character = (char) c;
+                    [self appendTokenBytes:&character
+                                    length:1];
+                    i++;
+                } else {
+                    [self finishLiteralAtOffset:_parsedBytes + i];
+                }
+
+                continue;
+
+            default:
+                break;
+        }
+
+        i++;
+
+//        пробельные символы между лексемами пропускаем
+        if (' ' == c || '\n' == c || '\r' == c || '\t' == c)
+            continue;
+
+        NSUInteger offset = _parsedBytes + i - 1;
+
+        switch (_state) {
+            case VKJSONStreamParserStateExpectValueOrArrayEnd:
+                if (']' == c) {
+                    [self closeContainer];
+                    break;
+                }
+
+                [self beginValue:c
+                          offset:offset];
+                break;
+
+            case VKJSONStreamParserStateExpectValue:
+                [self beginValue:c
+                          offset:offset];
+                break;
+
+            case VKJSONStreamParserStateExpectKeyOrObjectEnd:
+                if ('}' == c) {
+                    [self closeContainer];
+                    break;
+                }
+
+                [self beginKey:c
+                        offset:offset];
+                break;
+
+            case VKJSONStreamParserStateExpectKey:
+                [self beginKey:c
+                        offset:offset];
+                break;
+
+            case VKJSONStreamParserStateExpectColon:
+                if (':' == c)
+                    _state = VKJSONStreamParserStateExpectValue;
+                else
+                    [self failWithDescription:@"Colon expected"
+                                       offset:offset];
+                break;
+
+            case VKJSONStreamParserStateExpectCommaOrEnd: {
+                BOOL isObject = [[_containers lastObject] isKindOfClass:[NSDictionary class]];
+
+                if (',' == c)
+                    _state = (isObject ? VKJSONStreamParserStateExpectKey : VKJSONStreamParserStateExpectValue);
+                else if ((isObject && '}' == c) || (!isObject && ']' == c))
+                    [self closeContainer];
+                else
+                    [self failWithDescription:@"Comma or end of container expected"
+                                       offset:offset];
+                break;
+            }
+
+            case VKJSONStreamParserStateDone:
+                [self failWithDescription:@"Unexpected data after the end of document"
+                                   offset:offset];
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    _parsedBytes += length;
+
+    return (VKJSONStreamParserStateError != _state && VKJSONStreamParserStateStopped != _state);
+}
+
+- (BOOL)finish
+{
+    if (VKJSONStreamParserStateError == _state || VKJSONStreamParserStateStopped == _state)
+        return NO;
+
+//    число или литерал в самом конце документа заканчиваются вместе с данными
+    if (VKJSONStreamParserStateNumber == _state)
+        [self finishNumberAtOffset:_parsedBytes];
+    else if (VKJSONStreamParserStateLiteral == _state)
+        [self finishLiteralAtOffset:_parsedBytes];
+
+    if (VKJSONStreamParserStateDone != _state && VKJSONStreamParserStateError != _state)
+        [self failWithDescription:@"Unexpected end of data"
+                           offset:_parsedBytes];
+
+    return (VKJSONStreamParserStateDone == _state);
+}
+
+- (void)stop
+{
+    if (VKJSONStreamParserStateError != _state)
+        _state = VKJSONStreamParserStateStopped;
+}
+
+#pragma mark - Private methods
+
+- (void)beginValue:(uint8_t)c
+            offset:(NSUInteger)offset
+{
+    _tokenLength = 0;
+
+    switch (c) {
+        case '{':
+            [self pushContainer:[[NSMutableDictionary alloc] init]];
+            _state = VKJSONStreamParserStateExpectKeyOrObjectEnd;
+            break;
+
+        case '[':
+            [self pushContainer:[[NSMutableArray alloc] init]];
+            _state = VKJSONStreamParserStateExpectValueOrArrayEnd;
+            break;
+
+        case '"':
+            _isKey = NO;
+            _highSurrogate = 0;
+            _state = VKJSONStreamParserStateString;
+            break;
+
+        case 't':
+        case 'f':
+        case 'n': {
+            char character = (char) c;
+            [self appendTokenBytes:&character
+                            length:1];
+            _state = VKJSONStreamParserStateLiteral;
+            break;
+        }
+
+        default:
+            if ('-' == c || (c >= '0' && c <= '9')) {
+                char character = (char) c;
+                [self appendTokenBytes:&character
+                                length:1];
+                _state = VKJSONStreamParserStateNumber;
+            } else {
+                [self failWithDescription:@"Value expected"
+                                   offset:offset];
+            }
+            break;
+    }
+}
+
+- (void)beginKey:(uint8_t)c
+          offset:(NSUInteger)offset
+{
+    if ('"' != c) {
+        [self failWithDescription:@"Object key expected"
+                           offset:offset];
+        return;
+    }
+
+    _tokenLength = 0;
+    _isKey = YES;
+    _highSurrogate = 0;
+    _state = VKJSONStreamParserStateString;
+}
+
+- (void)pushContainer:(id)container
+{
+//    элементы потокового массива отдаются делегату, а в сам массив не попадают;
+//    потоковым бывает только первый подходящий массив документа, остальные
+//    (например, response.users после response.items) разбираются как обычно
+    if (!_hasStreamedArray && 0 != [self.streamedArrayKeyPaths count] && [container isKindOfClass:[NSArray class]]) {
+        NSString *keyPath = [self keyPathOfNextValue];
+
+        if (nil != keyPath && [self.streamedArrayKeyPaths containsObject:keyPath]) {
+            _streamedArray = container;
+            _hasStreamedArray = YES;
+        }
+    }
+
+    [_containers addObject:container];
+    [_keys addObject:[NSNull null]];
+}
+
+- (void)closeContainer
+{
+    id container = [_containers lastObject];
+
+    [_containers removeLastObject];
+    [_keys removeLastObject];
+
+    if (container == _streamedArray)
+        _streamedArray = nil;
+
+    [self addValue:container];
+}
+
+- (void)addValue:(id)value
+{
+//    корневое значение - документ разобран
+    if (0 == [_containers count]) {
+        _rootObject = value;
+        _state = VKJSONStreamParserStateDone;
+
+        return;
+    }
+
+    id container = [_containers lastObject];
+    _state = VKJSONStreamParserStateExpectCommaOrEnd;
+
+    if ([container isKindOfClass:[NSDictionary class]]) {
+        NSString *key = [_keys lastObject];
+        container[key] = value;
+
+//        значения корневого объекта интересны делегату сразу после разбора
+        if (1 == [_containers count] && [self.delegate respondsToSelector:@selector(parser:didParseValue:forRootKey:)]) {
+            [self.delegate parser:self
+                    didParseValue:value
+                       forRootKey:key];
+        }
+    } else if (container == _streamedArray) {
+        if ([self.delegate respondsToSelector:@selector(parser:didParseItem:)])
+            [self.delegate parser:self
+                     didParseItem:value];
+    } else {
+        [container addObject:value];
+    }
+}
+
+- (NSString *)keyPathOfNextValue
+{
+//    путь определен только для значений, вложенных исключительно в объекты
+    NSMutableArray *components = [NSMutableArray arrayWithCapacity:[_containers count]];
+
+    for (NSUInteger i = 0; i < [_containers count]; i++) {
+        if (![_containers[i] isKindOfClass:[NSDictionary class]])
+            return nil;
+
+        [components addObject:_keys[i]];
+    }
+
+    if (0 == [components count])
+        return nil;
+
+    return [components componentsJoinedByString:@"."];
+}
+
+- (void)finishStringAtOffset:(NSUInteger)offset
+{
+    [self flushHighSurrogate];
+
+    NSMutableString *string = [[NSMutableString alloc] initWithBytes:_token
+                                                              length:_tokenLength
+                                                            encoding:NSUTF8StringEncoding];
+
+    if (nil == string) {
+        [self failWithDescription:@"Invalid UTF-8 string"
+                           offset:offset];
+        return;
+    }
+
+    if (_isKey) {
+        [_keys replaceObjectAtIndex:[_keys count] - 1
+                         withObject:string];
+        _state = VKJSONStreamParserStateExpectColon;
+    } else {
+        [self addValue:string];
+    }
+}
+
+- (void)finishNumberAtOffset:(NSUInteger)offset
+{
+    [self appendTokenBytes:"\0"
+                    length:1];
+
+    char *end = NULL;
+    NSNumber *number = nil;
+    BOOL isInteger = (NULL == strpbrk(_token, ".eE"));
+
+    if (isInteger) {
+        errno = 0;
+        long long value = strtoll(_token, &end, 10);
+
+//        целое, не помещающееся в long long, сохраним с полной точностью
+        if (ERANGE == errno)
+            number = [NSDecimalNumber decimalNumberWithString:@(_token)];
+        else
+            number = @(value);
+    } else {
+        number = @(strtod(_token, &end));
+    }
+
+    if (NULL != end && '\0' != *end) {
+        [self failWithDescription:@"Invalid number"
+                           offset:offset];
+        return;
+    }
+
+    [self addValue:number];
+}
+
+- (void)finishLiteralAtOffset:(NSUInteger)offset
+{
+    id value = nil;
+
+    if (4 == _tokenLength && 0 == strncmp(_token, "true", 4))
+        value = @YES;
+    else if (5 == _tokenLength && 0 == strncmp(_token, "false", 5))
+        value = @NO;
+    else if (4 == _tokenLength && 0 == strncmp(_token, "null", 4))
+        value = [NSNull null];
+
+    if (nil == value) {
+        [self failWithDescription:@"Invalid literal"
+                           offset:offset];
+        return;
+    }
+
+    [self addValue:value];
+}
+
+- (void)appendTokenBytes:(const char *)bytes
+                  length:(NSUInteger)length
+{
+    if (0 == length)
+        return;
+
+    if (0 != _highSurrogate)
+        [self flushHighSurrogate];
+
+    if (_tokenLength + length > _tokenCapacity) {
+        while (_tokenLength + length > _tokenCapacity)
+            _tokenCapacity *= 2;
+
+        _token = realloc(_token, _tokenCapacity);
+    }
+
+    memcpy(_token + _tokenLength, bytes, length);
+    _tokenLength += length;
+}
+
+- (void)appendCodeUnit:(uint32_t)codeUnit
+{
+//    старшая половина суррогатной пары ждет младшую
+    if (codeUnit >= 0xD800 && codeUnit <= 0xDBFF) {
+        [self flushHighSurrogate];
+        _highSurrogate = codeUnit;
+
+        return;
+    }
+
+    uint32_t codePoint = codeUnit;
+
+    if (codeUnit >= 0xDC00 && codeUnit <= 0xDFFF) {
+        if (0 == _highSurrogate) {
+            codePoint = 0xFFFD;
+        } else {
+            codePoint = 0x10000 + ((_highSurrogate - 0xD800) << 10) + (codeUnit - 0xDC00);
+            _highSurrogate = 0;
+        }
+    }
+
+    [self appendCodePoint:codePoint];
+}
+
+- (void)flushHighSurrogate
+{
+//    непарная суррогатная половина заменяется символом U+FFFD
+    if (0 == _highSurrogate)
+        return;
+
+    _highSurrogate = 0;
+    [self appendCodePoint:0xFFFD];
+}
+
+- (void)appendCodePoint:(uint32_t)codePoint
+{
+    char utf8[4];
+    NSUInteger length;
+
+    if (codePoint < 0x80) {
+        utf8[0] = (char) codePoint;
+        length = 1;
+    } else if (codePoint < 0x800) {
+        utf8[0] = (char) (0xC0 | (codePoint >> 6));
+        utf8[1] = (char) (0x80 | (codePoint & 0x3F));
+        length = 2;
+    } else if (codePoint < 0x10000) {
+        utf8[0] = (char) (0xE0 | (codePoint >> 12));
+        utf8[1] = (char) (0x80 | ((codePoint >> 6) & 0x3F));
+        utf8[2] = (char) (0x80 | (codePoint & 0x3F));
+        length = 3;
+    } else {
+        utf8[0] = (char) (0xF0 | (codePoint >> 18));
+        utf8[1] = (char) (0x80 | ((codePoint >> 12) & 0x3F));
+        utf8[2] = (char) (0x80 | ((codePoint >> 6) & 0x3F));
+        utf8[3] = (char) (0x80 | (codePoint & 0x3F));
+        length = 4;
+    }
+
+    [self appendTokenBytes:utf8
+                    length:length];
+}
+
+- (void)failWithDescription:(NSString *)description
+                     offset:(NSUInteger)offset
+{
+    _state = VKJSONStreamParserStateError;
+    _error = [NSError errorWithDomain:kVKJSONStreamParserErrorDomain
+                                 code:NSPropertyListReadCorruptError
+                             userInfo:@{
+                                     NSLocalizedDescriptionKey : description,
+                                     @"Offset"                 : @(offset)
+                             }];
+}
+
+@end
@@ -0,0 +1,184 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKRequest.h"
+#import "VKLongPollEvent.h"
+
+
+@class VKLongPoll;
+@class VKUser;
+@class VKAccessToken;
+@class VKRetryPolicy;
+
+
+/** Default time in seconds during which long poll server holds the connection
+*/
+#define kVKLongPollDefaultWait 25
+
+/** Default mode of the long poll server: 2 - return attachments
+*/
+#define kVKLongPollDefaultMode 2
+
+
+/** Protocol allows receiving events from the long poll server
+*/
+@protocol VKLongPollDelegate <NSObject>
+
+@required
+/**
+@name Required
+*/
+/** Is called with the next portion of events. Events are decoded while the
+response is still downloading, so one response can be passed in several portions
+
+@param longPoll long poll
+@param events array of VKLongPollEvent instances
+*/
+- (void)longPoll:(VKLongPoll *)longPoll
+didReceiveEvents:(NSArray *)events;
+
+@optional
+/**
+@name Optional
+*/
+/** Is called if long poll can not continue (no access to messages, invalid
+access token etc). Long poll stops
+
+@param longPoll long poll
+@param error NSError instance or server response with error description
+*/
+- (void)longPoll:(VKLongPoll *)longPoll
+didFailWithError:(id)error;
+
+@end
+
+
+/** Client of the messages long poll server.
+
+Long poll gets the server address and key with messages.getLongPollServer and
+then holds one connection which the server answers as soon as new events appear
+(or after wait seconds). Events are decoded into VKLongPollEvent instances while
+the response is downloading. If the connection drops in the middle of the response,
+the server sends the same events again, those already passed to the delegate are skipped.
+
+Server errors are handled automatically:
+
+- "failed": 1 - events history is outdated, events are requested with
+messages.getLongPollHistory and long poll continues with the new ts;
+- "failed": 2 - key is expired, new key is requested with messages.getLongPollServer;
+- "failed": 3 - key and ts are lost, new key is requested and missed events are
+requested with messages.getLongPollHistory.
+
+Last ts and pts are stored in NSUserDefaults, so after the application restart
+events missed while it was not running are requested with messages.getLongPollHistory
+too. Connection errors are retried with growing delays.
+
+All methods should be called from the main thread, delegate is called on the main thread.
+*/
+@interface VKLongPoll : NSObject <VKRequestDelegate>
+
+/**
+@name Properties
+*/
+/** Delegate
+*/
+@property (nonatomic, weak, readwrite) id <VKLongPollDelegate> delegate;
+
+/** Time in seconds during which long poll server holds the connection.
+By default equals to kVKLongPollDefaultWait
+*/
+@property (nonatomic, assign, readwrite) NSUInteger wait;
+
+/** Mode of the long poll server. By default equals to kVKLongPollDefaultMode
+*/
+@property (nonatomic, assign, readwrite) NSUInteger mode;
+
+/** Transport which is used by all requests of the long poll, nil means
+VKRequest default transport
+*/
+@property (nonatomic, strong, readwrite) id <VKTransport> transport;
+
+/** Policy which defines delays between reconnects after connection errors.
+By default equals to [VKRetryPolicy policy]
+*/
+@property (nonatomic, strong, readwrite) VKRetryPolicy *retryPolicy;
+
+/** Long poll server address
+*/
+@property (nonatomic, copy, readonly) NSString *server;
+
+/** Long poll server key
+*/
+@property (nonatomic, copy, readonly) NSString *key;
+
+/** Number of the last received event
+*/
+@property (nonatomic, assign, readonly) NSUInteger ts;
+
+/** Number of the last received event for messages.getLongPollHistory, 0 if unknown
+*/
+@property (nonatomic, assign, readonly) NSUInteger pts;
+
+/** Key under which ts and pts are stored in NSUserDefaults
+*/
+@property (nonatomic, copy, readonly) NSString *persistenceKey;
+
+/** YES after start and until stop or error
+*/
+@property (nonatomic, assign, readonly) BOOL isRunning;
+
+/**
+@name Initialization methods
+*/
+/** Creates long poll for the user with the passed access token. ts and pts
+saved for this user are restored
+
+@param accessToken access token with messages permission
+@return VKLongPoll instance
+*/
+- (instancetype)initWithAccessToken:(VKAccessToken *)accessToken;
+
+/** Creates long poll for the user
+
+@param user user with messages permission
+@return VKLongPoll instance
+*/
+- (instancetype)initWithUser:(VKUser *)user;
+
+/**
+@name Control
+*/
+/** Connects to the long poll server
+*/
+- (void)start;
+
+/** Closes connection to the long poll server. Saved ts is kept, so events
+received since stop are requested after next start
+*/
+- (void)stop;
+
+@end
@@ -0,0 +1,491 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKLongPoll.h"
+#import "VKUser.h"
+#import "VKAccessToken.h"
+#import "VKMethods.h"
+#import "VKRetryPolicy.h"
+#import "VKRequestScheduler.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+static NSString *const kVKLongPollServerSignature = @"server";
+static NSString *const kVKLongPollHistorySignature = @"history";
+static NSString *const kVKLongPollCheckSignature = @"check";
+
+
+@implementation VKLongPoll
+{
+    VKAccessToken *_accessToken;
+    VKRequest *_currentRequest;
+
+    NSUInteger _serverTs;
+    NSTimeInterval _reconnectDelay;
+    SEL _failedStep;
+
+//    ts, события после которого уже отдавались делегату, и число отданных событий;
+//    число событий, полученных в текущем ответе
+    NSUInteger _deliveredTs;
+    NSUInteger _deliveredUpdatesCount;
+    NSUInteger _receivedUpdatesCount;
+}
+
+#pragma mark Visible VKLongPoll methods
+#pragma mark - Init methods
+
+- (instancetype)initWithAccessToken:(VKAccessToken *)accessToken
+{
+    INFO_LOG();
+
+    self = [super init];
+
+    if (self) {
+        _accessToken = accessToken;
+        _wait = kVKLongPollDefaultWait;
+        _mode = kVKLongPollDefaultMode;
+        _retryPolicy = [VKRetryPolicy policy];
+        _persistenceKey = [NSString stringWithFormat:@"VKLongPoll.%lu", (unsigned long) accessToken.userID];
+
+        NSDictionary *state = [[NSUserDefaults standardUserDefaults]
+                                               dictionaryForKey:_persistenceKey];
+        _ts = [state[@"ts"] unsignedIntegerValue];
+        _pts = [state[@"pts"] unsignedIntegerValue];
+    }
+
+    return self;
+}
+
+- (instancetype)initWithUser:(VKUser *)user
+{
+    return [self initWithAccessToken:user.accessToken];
+}
+
+- (void)dealloc
+{
+    [_currentRequest cancel];
+}
+
+#pragma mark - Control
+
+- (void)start
+{
+    INFO_LOG();
+
+    if (self.isRunning)
+        return;
+
+    _isRunning = YES;
+    _reconnectDelay = 0;
+
+    [self requestServer];
+}
+
+- (void)stop
+{
+    INFO_LOG();
+
+    _isRunning = NO;
+
+    [NSObject cancelPreviousPerformRequestsWithTarget:self];
+
+    [_currentRequest cancel];
+    _currentRequest = nil;
+}
+
+#pragma mark - VKRequestDelegate
+
+- (void)VKRequest:(VKRequest *)request
+    receivedItems:(NSArray *)items
+{
+    if (request != _currentRequest)
+        return;
+
+    [self deliverCheckUpdates:items];
+}
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    INFO_LOG();
+
+    if (request != _currentRequest)
+        return;
+
+    _currentRequest = nil;
+    _reconnectDelay = 0;
+
+    if ([kVKLongPollServerSignature isEqualToString:request.signature])
+        [self processServerResponse:response[@"response"]];
+    else if ([kVKLongPollHistorySignature isEqualToString:request.signature])
+        [self processHistoryResponse:response[@"response"]];
+    else
+        [self processCheckResponse:response];
+}
+
+- (void)     VKRequest:(VKRequest *)request
+connectionErrorOccured:(NSError *)error
+{
+    INFO_LOG();
+
+    if (request != _currentRequest)
+        return;
+
+    _currentRequest = nil;
+
+    [self reconnectWithStep:[self stepForRequest:request]];
+}
+
+- (void)  VKRequest:(VKRequest *)request
+parsingErrorOccured:(NSError *)error
+{
+    INFO_LOG();
+
+    if (request != _currentRequest)
+        return;
+
+    _currentRequest = nil;
+
+    [self reconnectWithStep:[self stepForRequest:request]];
+}
+
+- (void)   VKRequest:(VKRequest *)request
+responseErrorOccured:(id)error
+{
+    INFO_LOG();
+
+    if (request != _currentRequest)
+        return;
+
+    _currentRequest = nil;
+
+    [self failWithError:error];
+}
+
+- (void)VKRequest:(VKRequest *)request
+       captchaSid:(NSString *)captchaSid
+     captchaImage:(NSString *)captchaImage
+{
+    INFO_LOG();
+
+    if (request != _currentRequest)
+        return;
+
+    _currentRequest = nil;
+
+    [self failWithError:@{@"error_code"  : @14,
+                          @"captcha_sid" : (nil == captchaSid ? @"" : captchaSid),
+                          @"captcha_img" : (nil == captchaImage ? @"" : captchaImage)}];
+}
+
+#pragma mark - Private methods
+
+- (void)requestServer
+{
+    INFO_LOG();
+
+    VKRequest *request = [VKRequest requestMethod:kVKMessagesGetLongPollServer
+                                          options:@{@"use_ssl"      : @1,
+                                                    @"need_pts"     : @1,
+                                                    @"access_token" : _accessToken.token}
+                                         delegate:self];
+    request.signature = kVKLongPollServerSignature;
+
+    [self scheduleAPIRequest:request];
+}
+
+- (void)requestHistory
+{
+    INFO_LOG();
+
+    NSMutableDictionary *options = [@{@"ts"           : @(self.ts),
+                                      @"access_token" : _accessToken.token} mutableCopy];
+
+    if (0 != self.pts)
+        options[@"pts"] = @(self.pts);
+
+    VKRequest *request = [VKRequest requestMethod:kVKMessagesGetLongPollHistory
+                                          options:options
+                                         delegate:self];
+    request.signature = kVKLongPollHistorySignature;
+
+    [self scheduleAPIRequest:request];
+}
+
+- (void)check
+{
+    INFO_LOG();
+
+    NSString *server = self.server;
+
+    if (![server hasPrefix:@"http://"] && ![server hasPrefix:@"https://"])
+        server = [@"https://" stringByAppendingString:server];
+
+    NSString *key = [self.key stringByAddingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
+    NSString *urlString = [NSString stringWithFormat:@"%@?act=a_check&key=%@&ts=%lu&wait=%lu&mode=%lu",
+                                                     server,
+                                                     key,
+                                                     (unsigned long) self.ts,
+                                                     (unsigned long) self.wait,
+                                                     (unsigned long) self.mode];
+
+//    сервер держит соединение wait секунд, запрос не должен завершиться раньше
+    NSMutableURLRequest *urlRequest = [NSMutableURLRequest requestWithURL:[NSURL URLWithString:urlString]];
+    urlRequest.timeoutInterval = self.wait + 10;
+
+    VKRequest *request = [VKRequest request:urlRequest
+                                   delegate:self];
+    request.signature = kVKLongPollCheckSignature;
+
+//    события после одного и того же ts сервер всегда отдает в одном порядке
+    _receivedUpdatesCount = 0;
+
+    if (_deliveredTs != self.ts) {
+        _deliveredTs = self.ts;
+        _deliveredUpdatesCount = 0;
+    }
+
+    [self configureRequest:request];
+
+//    long poll сервер не относится к API, ограничение на частоту запросов к нему не применяется
+    _currentRequest = request;
+    [request start];
+}
+
+- (void)configureRequest:(VKRequest *)request
+{
+    request.cacheLiveTime = VKCachedDataLiveTimeNever;
+    request.cachePolicy = VKRequestCachePolicyNetworkOnly;
+    request.callbackQueue = dispatch_get_main_queue();
+
+    if (nil != self.transport)
+        request.transport = self.transport;
+}
+
+- (void)scheduleAPIRequest:(VKRequest *)request
+{
+    [self configureRequest:request];
+
+    _currentRequest = request;
+
+    [[VKRequestScheduler sharedScheduler] scheduleRequest:request
+                                                    token:_accessToken.token];
+}
+
+- (void)processServerResponse:(NSDictionary *)response
+{
+    INFO_LOG();
+
+    if (![response isKindOfClass:[NSDictionary class]] || nil == response[@"server"]) {
+        [self reconnectWithStep:@selector(requestServer)];
+        return;
+    }
+
+    _server = [response[@"server"] description];
+    _key = [response[@"key"] description];
+    _serverTs = [response[@"ts"] unsignedIntegerValue];
+
+    if (nil != response[@"pts"] && 0 == self.pts)
+        _pts = [response[@"pts"] unsignedIntegerValue];
+
+//    события, пришедшие с момента последнего ответа, запрашиваются отдельно
+    if (0 != self.ts && self.ts < _serverTs) {
+        [self requestHistory];
+        return;
+    }
+
+    _ts = _serverTs;
+    [self saveState];
+    [self check];
+}
+
+- (void)processHistoryResponse:(NSDictionary *)response
+{
+    INFO_LOG();
+
+    if ([response isKindOfClass:[NSDictionary class]]) {
+        [self deliverUpdates:response[@"history"]];
+
+        if (nil != response[@"new_pts"])
+            _pts = [response[@"new_pts"] unsignedIntegerValue];
+    }
+
+    if (!self.isRunning)
+        return;
+
+    _ts = MAX(_ts, _serverTs);
+    [self saveState];
+    [self check];
+}
+
+- (void)processCheckResponse:(NSDictionary *)response
+{
+    INFO_LOG();
+
+    if (![response isKindOfClass:[NSDictionary class]]) {
+        [self reconnectWithStep:@selector(check)];
+        return;
+    }
+
+    switch ([response[@"failed"] integerValue]) {
+        case 0:
+            break;
+
+        case 1:
+//            история событий устарела: пропущенные события запрашиваются по старому ts
+            _serverTs = [response[@"ts"] unsignedIntegerValue];
+            [self requestHistory];
+            return;
+
+        case 2:
+        case 3:
+//            ключ (и ts) больше не действителен - запрашиваем новый, а пропущенные
+//            события будут запрошены по сохраненному ts
+            [self requestServer];
+            return;
+
+        default:
+            [self failWithError:response];
+            return;
+    }
+
+//    ответ мог прийти не из потокового разбора (например, из другого транспорта)
+    [self deliverCheckUpdates:response[@"updates"]];
+
+    if (!self.isRunning)
+        return;
+
+    if (nil != response[@"ts"])
+        _ts = [response[@"ts"] unsignedIntegerValue];
+
+    if (nil != response[@"pts"])
+        _pts = [response[@"pts"] unsignedIntegerValue];
+
+    [self saveState];
+    [self check];
+}
+
+- (void)deliverUpdates:(NSArray *)updates
+{
+    if (![updates isKindOfClass:[NSArray class]] || 0 == [updates count] || !self.isRunning)
+        return;
+
+    NSMutableArray *events = [[NSMutableArray alloc] initWithCapacity:[updates count]];
+
+    for (NSArray *update in updates) {
+        VKLongPollEvent *event = [VKLongPollEvent eventWithUpdate:update];
+
+        if (nil != event)
+            [events addObject:event];
+    }
+
+    if (0 != [events count])
+        [self.delegate longPoll:self
+               didReceiveEvents:events];
+}
+
+- (void)deliverCheckUpdates:(NSArray *)updates
+{
+    if (![updates isKindOfClass:[NSArray class]])
+        return;
+
+//    ts сдвигается только после разбора всего ответа, поэтому после обрыва
+//    соединения сервер повторяет уже отданные по мере загрузки события -
+//    они пропускаются
+    NSUInteger index = _receivedUpdatesCount;
+    _receivedUpdatesCount += [updates count];
+
+    if (_receivedUpdatesCount <= _deliveredUpdatesCount)
+        return;
+
+    if (index < _deliveredUpdatesCount)
+        updates = [updates subarrayWithRange:NSMakeRange(_deliveredUpdatesCount - index, _receivedUpdatesCount - _deliveredUpdatesCount)];
+
+    _deliveredUpdatesCount = _receivedUpdatesCount;
+
+    [self deliverUpdates:updates];
+}
+
+- (SEL)stepForRequest:(VKRequest *)request
+{
+    if ([kVKLongPollServerSignature isEqualToString:request.signature])
+        return @selector(requestServer);
+
+    if ([kVKLongPollHistorySignature isEqualToString:request.signature])
+        return @selector(requestHistory);
+
+    return @selector(check);
+}
+
+- (void)reconnectWithStep:(SEL)step
+{
+    INFO_LOG();
+
+    if (!self.isRunning)
+        return;
+
+    _failedStep = step;
+    _reconnectDelay = [self.retryPolicy delayAfterDelay:_reconnectDelay];
+
+    [self performSelector:@selector(reconnect)
+               withObject:nil
+               afterDelay:_reconnectDelay];
+}
+
+- (void)reconnect
+{
+    INFO_LOG();
+
+    if (!self.isRunning)
+        return;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
+    [self performSelector:_failedStep];
+#pragma clang diagnostic pop
+}
+
+- (void)saveState
+{
+    [[NSUserDefaults standardUserDefaults] setObject:@{@"ts"  : @(self.ts),
+                                                       @"pts" : @(self.pts)}
+                                              forKey:self.persistenceKey];
+}
+
+- (void)failWithError:(id)error
+{
+    INFO_LOG();
+
+    [self stop];
+
+    if ([self.delegate respondsToSelector:@selector(longPoll:didFailWithError:)])
+        [self.delegate longPoll:self
+               didFailWithError:error];
+}
+
+@end
@@ -0,0 +1,132 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Types of the long poll server events
+*/
+typedef enum
+{
+    VKLongPollEventTypeUnknown = 0,
+    VKLongPollEventTypeMessageFlagsReplaced = 1,
+    VKLongPollEventTypeMessageFlagsSet = 2,
+    VKLongPollEventTypeMessageFlagsReset = 3,
+    VKLongPollEventTypeNewMessage = 4,
+    VKLongPollEventTypeIncomingMessagesRead = 6,
+    VKLongPollEventTypeOutgoingMessagesRead = 7,
+    VKLongPollEventTypeFriendOnline = 8,
+    VKLongPollEventTypeFriendOffline = 9,
+    VKLongPollEventTypeChatChanged = 51,
+    VKLongPollEventTypeUserTyping = 61,
+    VKLongPollEventTypeChatUserTyping = 62,
+    VKLongPollEventTypeCall = 70,
+    VKLongPollEventTypeUnreadCountChanged = 80
+} VKLongPollEventType;
+
+
+/** Event received from the long poll server (or from messages.getLongPollHistory).
+
+Properties which are not defined for the event type are equal to 0 or nil,
+raw event is always available in the update property.
+
+@see https://vk.com/dev/using_longpoll
+*/
+@interface VKLongPollEvent : NSObject
+
+/**
+@name Properties
+*/
+/** Event type
+*/
+@property (nonatomic, assign, readonly) VKLongPollEventType type;
+
+/** Raw event: array which starts with the event type code
+*/
+@property (nonatomic, copy, readonly) NSArray *update;
+
+/** Message ID (events 1-4)
+*/
+@property (nonatomic, assign, readonly) NSUInteger messageID;
+
+/** Message flags (events 1-4)
+*/
+@property (nonatomic, assign, readonly) NSUInteger flags;
+
+/** Dialog ID: user ID or 2000000000 + chat ID (events 2-4, 6, 7)
+*/
+@property (nonatomic, assign, readonly) NSInteger peerID;
+
+/** Message date (event 4)
+*/
+@property (nonatomic, strong, readonly) NSDate *date;
+
+/** Message subject (event 4)
+*/
+@property (nonatomic, copy, readonly) NSString *subject;
+
+/** Message text (event 4)
+*/
+@property (nonatomic, copy, readonly) NSString *text;
+
+/** Message attachments and additional fields (event 4)
+*/
+@property (nonatomic, copy, readonly) NSDictionary *attachments;
+
+/** ID of the last read message (events 6, 7)
+*/
+@property (nonatomic, assign, readonly) NSUInteger localID;
+
+/** User ID (events 8, 9, 61, 62, 70)
+*/
+@property (nonatomic, assign, readonly) NSUInteger userID;
+
+/** Chat ID (events 51, 62)
+*/
+@property (nonatomic, assign, readonly) NSUInteger chatID;
+
+/** Number of unread dialogs (event 80)
+*/
+@property (nonatomic, assign, readonly) NSUInteger unreadCount;
+
+/**
+@name Initialization methods
+*/
+/** Creates event from the raw update
+
+@param update array which starts with the event type code
+@return VKLongPollEvent instance or nil if update is not an array
+*/
++ (instancetype)eventWithUpdate:(NSArray *)update;
+
+/** Decodes event from the raw update
+
+@param update array which starts with the event type code
+@return VKLongPollEvent instance or nil if update is not an array
+*/
+- (instancetype)initWithUpdate:(NSArray *)update;
+
+@end
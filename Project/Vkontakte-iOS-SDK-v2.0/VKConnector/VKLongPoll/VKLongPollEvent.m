@@ -0,0 +1,143 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKLongPollEvent.h"
+
+
+@implementation VKLongPollEvent
+
+#pragma mark Visible VKLongPollEvent methods
+#pragma mark - Init methods
+
++ (instancetype)eventWithUpdate:(NSArray *)update
+{
+    return [[self alloc] initWithUpdate:update];
+}
+
+- (instancetype)initWithUpdate:(NSArray *)update
+{
+    if (![update isKindOfClass:[NSArray class]] || 0 == [update count])
+        return nil;
+
+    self = [super init];
+
+    if (self) {
+        _update = [update copy];
+        _type = (VKLongPollEventType) [self integerAtIndex:0];
+
+        switch (_type) {
+            case VKLongPollEventTypeMessageFlagsReplaced:
+            case VKLongPollEventTypeMessageFlagsSet:
+            case VKLongPollEventTypeMessageFlagsReset:
+                _messageID = (NSUInteger) [self integerAtIndex:1];
+                _flags = (NSUInteger) [self integerAtIndex:2];
+                _peerID = [self integerAtIndex:3];
+                break;
+
+            case VKLongPollEventTypeNewMessage:
+                _messageID = (NSUInteger) [self integerAtIndex:1];
+                _flags = (NSUInteger) [self integerAtIndex:2];
+                _peerID = [self integerAtIndex:3];
+                _date = [NSDate dateWithTimeIntervalSince1970:[self integerAtIndex:4]];
+                _subject = [self objectOfClass:[NSString class]
+                                       atIndex:5];
+                _text = [self objectOfClass:[NSString class]
+                                    atIndex:6];
+                _attachments = [self objectOfClass:[NSDictionary class]
+                                           atIndex:7];
+                break;
+
+            case VKLongPollEventTypeIncomingMessagesRead:
+            case VKLongPollEventTypeOutgoingMessagesRead:
+                _peerID = [self integerAtIndex:1];
+                _localID = (NSUInteger) [self integerAtIndex:2];
+                break;
+
+            case VKLongPollEventTypeFriendOnline:
+            case VKLongPollEventTypeFriendOffline:
+//                ID друга передается со знаком минус
+                _userID = (NSUInteger) labs([self integerAtIndex:1]);
+                break;
+
+            case VKLongPollEventTypeChatChanged:
+                _chatID = (NSUInteger) [self integerAtIndex:1];
+                break;
+
+            case VKLongPollEventTypeUserTyping:
+            case VKLongPollEventTypeCall:
+                _userID = (NSUInteger) [self integerAtIndex:1];
+                break;
+
+            case VKLongPollEventTypeChatUserTyping:
+                _userID = (NSUInteger) [self integerAtIndex:1];
+                _chatID = (NSUInteger) [self integerAtIndex:2];
+                break;
+
+            case VKLongPollEventTypeUnreadCountChanged:
+                _unreadCount = (NSUInteger) [self integerAtIndex:1];
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return self;
+}
+
+#pragma mark - Overridden methods
+
+- (NSString *)description
+{
+    NSDictionary *desc = @{
+            @"Type"   : @(self.type),
+            @"Update" : self.update
+    };
+
+    return [desc description];
+}
+
+#pragma mark - Private methods
+
+- (NSInteger)integerAtIndex:(NSUInteger)index
+{
+    id value = (index < [_update count] ? _update[index] : nil);
+
+    if ([value isKindOfClass:[NSNumber class]] || [value isKindOfClass:[NSString class]])
+        return [value integerValue];
+
+    return 0;
+}
+
+- (id)objectOfClass:(Class)objectClass
+            atIndex:(NSUInteger)index
+{
+    id value = (index < [_update count] ? _update[index] : nil);
+
+    return ([value isKindOfClass:objectClass] ? value : nil);
+}
+
+@end
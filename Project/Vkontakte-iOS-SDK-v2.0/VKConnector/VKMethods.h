@@ -43,7 +43,7 @@ static NSString *const kVKUsersGetFollowers     = @"users.getFollowers";
 // Groups
 // -----------------------------------------------------------------------------
 static NSString *const kVKGroupsIsMember   = @"groups.isMember";
-static NSString *const kVKGroupsGetById    = @"groupd.getById";
+static NSString *const kVKGroupsGetById    = @"groups.getById";
 static NSString *const kVKGroupsGet        = @"groups.get";
 static NSString *const kVKGroupsGetMembers = @"groups.getMembers";
 static NSString *const kVKGroupsJoin       = @"groups.join";
@@ -0,0 +1,118 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Size of the file region which is mapped into memory at once
+*/
+#define kVKMultipartBodyStreamMappingSize (4 * 1024 * 1024)
+
+
+/** Part of the request body which is read from a file
+*/
+@interface VKBodyFilePart : NSObject
+
+/**
+@name Properties
+*/
+/** File URL
+*/
+@property (nonatomic, copy, readonly) NSURL *fileURL;
+
+/** Offset of the first byte of the part in the file
+*/
+@property (nonatomic, assign, readonly) unsigned long long offset;
+
+/** Number of bytes in the part
+*/
+@property (nonatomic, assign, readonly) unsigned long long length;
+
+/**
+@name Class methods
+*/
+/** Creates part which contains the whole file
+
+@param fileURL file URL
+@return part or nil if file does not exist or is not a regular file
+*/
++ (instancetype)partWithFileURL:(NSURL *)fileURL;
+
+/**
+@name Init methods
+*/
+/** Creates part which contains a region of the file
+
+@param fileURL file URL
+@param offset offset of the first byte of the region
+@param length number of bytes in the region
+@return part
+*/
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+                         offset:(unsigned long long)offset
+                         length:(unsigned long long)length;
+
+@end
+
+
+/** Input stream which lazily generates request body from in-memory parts (NSData)
+and file parts (VKBodyFilePart). Files are never read into memory completely: they are
+mapped into memory by regions of kVKMultipartBodyStreamMappingSize bytes while stream
+is read, so memory consumption does not depend on the size of the files.
+
+Stream is used as HTTPBodyStream of NSURLRequest.
+*/
+@interface VKMultipartBodyStream : NSInputStream
+
+/**
+@name Properties
+*/
+/** Exact number of bytes in the stream, should be used as Content-Length
+*/
+@property (nonatomic, assign, readonly) unsigned long long contentLength;
+
+/** Body parts: NSData and VKBodyFilePart objects
+*/
+@property (nonatomic, copy, readonly) NSArray *parts;
+
+/**
+@name Init methods
+*/
+/** Creates stream
+
+@param parts NSData and VKBodyFilePart objects in the order they should be sent
+@return stream
+*/
+- (instancetype)initWithParts:(NSArray *)parts;
+
+/** Creates new unopened stream with the same parts. Is used when request body
+has to be sent again (for example after redirect or authentication challenge)
+
+@return stream
+*/
+- (instancetype)streamCopy;
+
+@end
@@ -0,0 +1,333 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import "VKMultipartBodyStream.h"
+
+
+@implementation VKBodyFilePart
+
+#pragma mark Visible VKBodyFilePart methods
+#pragma mark - Class methods
+
++ (instancetype)partWithFileURL:(NSURL *)fileURL
+{
+    if (![fileURL isFileURL])
+        return nil;
+
+    struct stat fileStat;
+
+    if (0 != stat([[fileURL path] fileSystemRepresentation], &fileStat) || !S_ISREG(fileStat.st_mode))
+        return nil;
+
+    return [[self alloc] initWithFileURL:fileURL
+                                  offset:0
+                                  length:(unsigned long long) fileStat.st_size];
+}
+
+#pragma mark - Init methods
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+                         offset:(unsigned long long)offset
+                         length:(unsigned long long)length
+{
+    self = [super init];
+
+    if (self) {
+        _fileURL = [fileURL copy];
+        _offset = offset;
+        _length = length;
+    }
+
+    return self;
+}
+
+@end
+
+
+@implementation VKMultipartBodyStream
+{
+    NSStreamStatus _streamStatus;
+    NSError *_streamError;
+    id <NSStreamDelegate> __weak _delegate;
+
+    NSUInteger _partIndex;
+    unsigned long long _partOffset;
+
+//    текущий открытый файл и отображенная в память область
+    int _fileDescriptor;
+    void *_mapping;
+    size_t _mappingLength;
+    unsigned long long _mappingOffset;
+}
+
+#pragma mark Visible VKMultipartBodyStream methods
+#pragma mark - Init methods
+
+- (instancetype)initWithParts:(NSArray *)parts
+{
+    self = [super init];
+
+    if (self) {
+        _parts = [parts copy];
+        _streamStatus = NSStreamStatusNotOpen;
+        _fileDescriptor = -1;
+        _mapping = MAP_FAILED;
+
+        for (id part in _parts)
+            _contentLength += [self lengthOfPart:part];
+    }
+
+    return self;
+}
+
+- (instancetype)streamCopy
+{
+    return [[[self class] alloc] initWithParts:self.parts];
+}
+
+- (void)dealloc
+{
+    [self closeFile];
+}
+
+#pragma mark - NSStream
+
+- (void)open
+{
+    _streamStatus = NSStreamStatusOpen;
+}
+
+- (void)close
+{
+    [self closeFile];
+    _streamStatus = NSStreamStatusClosed;
+}
+
+- (NSStreamStatus)streamStatus
+{
+    return _streamStatus;
+}
+
+- (NSError *)streamError
+{
+    return _streamError;
+}
+
+- (id <NSStreamDelegate>)delegate
+{
+    return _delegate;
+}
+
+- (void)setDelegate:(id <NSStreamDelegate>)delegate
+{
+    _delegate = delegate;
+}
+
+- (void)scheduleInRunLoop:(NSRunLoop *)aRunLoop
+                  forMode:(NSString *)mode
+{
+//    данные всегда доступны синхронно, планировать нечего
+}
+
+- (void)removeFromRunLoop:(NSRunLoop *)aRunLoop
+                  forMode:(NSString *)mode
+{
+}
+
+- (id)propertyForKey:(NSString *)key
+{
+    return nil;
+}
+
+- (BOOL)setProperty:(id)property
+             forKey:(NSString *)key
+{
+    return NO;
+}
+
+#pragma mark - NSInputStream
+
+- (NSInteger)read:(uint8_t *)buffer
+        maxLength:(NSUInteger)length
+{
+    if (NSStreamStatusOpen != _streamStatus && NSStreamStatusReading != _streamStatus)
+        return (NSStreamStatusAtEnd == _streamStatus ? 0 : -1);
+
+    _streamStatus = NSStreamStatusReading;
+    NSUInteger totalRead = 0;
+
+    while (totalRead < length && _partIndex < [_parts count]) {
+        id part = _parts[_partIndex];
+        unsigned long long partLength = [self lengthOfPart:part];
+        NSUInteger count = (NSUInteger) MIN((unsigned long long) (length - totalRead), partLength - _partOffset);
+
+        if (0 == count) {
+//            пустая часть - пропускаем
+        } else if ([part isKindOfClass:[NSData class]]) {
+            [(NSData *) part getBytes:buffer + totalRead
+                                range:NSMakeRange((NSUInteger) _partOffset, count)];
+        } else {
+            count = [self readFilePart:part
+                                buffer:buffer + totalRead
+                             maxLength:count];
+
+            if (NSNotFound == count) {
+                _streamStatus = NSStreamStatusError;
+                return -1;
+            }
+        }
+
+        totalRead += count;
+        _partOffset += count;
+
+//        часть прочитана полностью - переходим к следующей
+        if (_partOffset >= partLength) {
+            [self closeFile];
+            _partIndex++;
+            _partOffset = 0;
+        }
+    }
+
+    _streamStatus = (_partIndex < [_parts count] ? NSStreamStatusOpen : NSStreamStatusAtEnd);
+
+    return (NSInteger) totalRead;
+}
+
+- (BOOL)getBuffer:(uint8_t **)buffer
+           length:(NSUInteger *)len
+{
+    return NO;
+}
+
+- (BOOL)hasBytesAvailable
+{
+    return (NSStreamStatusOpen == _streamStatus);
+}
+
+#pragma mark - Private methods
+
+//    NSURLConnection работает с потоком как с CFReadStream и вызывает эти методы
+//    у любого NSInputStream, без них наследник не работает
+
+- (void)_scheduleInCFRunLoop:(CFRunLoopRef)runLoop
+                     forMode:(CFStringRef)mode
+{
+}
+
+- (void)_unscheduleFromCFRunLoop:(CFRunLoopRef)runLoop
+                         forMode:(CFStringRef)mode
+{
+}
+
+- (BOOL)_setCFClientFlags:(CFOptionFlags)flags
+                 callback:(CFReadStreamClientCallBack)callback
+                  context:(CFStreamClientContext *)context
+{
+    return NO;
+}
+
+- (unsigned long long)lengthOfPart:(id)part
+{
+    if ([part isKindOfClass:[NSData class]])
+        return [(NSData *) part length];
+
+    return [(VKBodyFilePart *) part length];
+}
+
+- (NSUInteger)readFilePart:(VKBodyFilePart *)part
+                    buffer:(uint8_t *)buffer
+                 maxLength:(NSUInteger)length
+{
+    if (-1 == _fileDescriptor) {
+        _fileDescriptor = open([[part.fileURL path] fileSystemRepresentation], O_RDONLY);
+
+        if (-1 == _fileDescriptor) {
+            [self failWithPOSIXError];
+            return NSNotFound;
+        }
+    }
+
+    unsigned long long fileOffset = part.offset + _partOffset;
+
+//    отображаем очередную область файла, если текущая уже прочитана
+    if (MAP_FAILED == _mapping || fileOffset < _mappingOffset || fileOffset >= _mappingOffset + _mappingLength) {
+        [self unmapFile];
+
+        unsigned long long pageSize = (unsigned long long) getpagesize();
+        unsigned long long partEnd = part.offset + part.length;
+
+        _mappingOffset = fileOffset - fileOffset % pageSize;
+        _mappingLength = (size_t) MIN((unsigned long long) kVKMultipartBodyStreamMappingSize, partEnd - _mappingOffset);
+        _mapping = mmap(NULL, _mappingLength, PROT_READ, MAP_PRIVATE, _fileDescriptor, (off_t) _mappingOffset);
+
+        if (MAP_FAILED == _mapping) {
+            [self failWithPOSIXError];
+            return NSNotFound;
+        }
+
+//        файл читается строго последовательно
+        madvise(_mapping, _mappingLength, MADV_SEQUENTIAL);
+    }
+
+    NSUInteger count = (NSUInteger) MIN((unsigned long long) length, _mappingOffset + _mappingLength - fileOffset);
+    memcpy(buffer, (uint8_t *) _mapping + (fileOffset - _mappingOffset), count);
+
+    return count;
+}
+
+- (void)unmapFile
+{
+    if (MAP_FAILED == _mapping)
+        return;
+
+    munmap(_mapping, _mappingLength);
+    _mapping = MAP_FAILED;
+    _mappingLength = 0;
+}
+
+- (void)closeFile
+{
+    [self unmapFile];
+
+    if (-1 != _fileDescriptor) {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+}
+
+- (void)failWithPOSIXError
+{
+    _streamError = [NSError errorWithDomain:NSPOSIXErrorDomain
+                                       code:errno
+                                   userInfo:nil];
+    [self closeFile];
+}
+
+@end
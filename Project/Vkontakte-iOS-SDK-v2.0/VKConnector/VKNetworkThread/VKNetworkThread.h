@@ -0,0 +1,59 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Dedicated thread which runs all network connections of the SDK. Connection
+callbacks, incremental parsing of responses and cache updates happen on this thread,
+so they never delay user interface updates on the main thread
+*/
+@interface VKNetworkThread : NSObject
+
+/**
+@name Class methods
+*/
+/** Network thread, is started on the first call
+
+@return thread
+*/
++ (NSThread *)thread;
+
+/** Run loop of the network thread, connections should be scheduled in it
+in NSDefaultRunLoopMode
+
+@return run loop
+*/
++ (NSRunLoop *)runLoop;
+
+/** Executes block on the network thread. If called from the network thread,
+block is executed immediately
+
+@param block block to execute
+*/
++ (void)performBlock:(dispatch_block_t)block;
+
+@end
@@ -0,0 +1,110 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKNetworkThread.h"
+
+
+static NSThread *networkThread;
+static NSRunLoop *networkRunLoop;
+
+
+@implementation VKNetworkThread
+
+#pragma mark Visible VKNetworkThread methods
+#pragma mark - Class methods
+
++ (NSThread *)thread
+{
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        dispatch_semaphore_t started = dispatch_semaphore_create(0);
+
+        networkThread = [[NSThread alloc] initWithTarget:self
+                                                selector:@selector(threadMain:)
+                                                  object:started];
+        [networkThread setName:@"VKNetworkThread"];
+        [networkThread start];
+
+//        дожидаемся, пока цикл выполнения будет готов принимать соединения
+        dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+    });
+
+    return networkThread;
+}
+
++ (NSRunLoop *)runLoop
+{
+    [self thread];
+
+    return networkRunLoop;
+}
+
++ (void)performBlock:(dispatch_block_t)block
+{
+    NSThread *thread = [self thread];
+
+    if ([NSThread currentThread] == thread) {
+        block();
+        return;
+    }
+
+    [self performSelector:@selector(runBlock:)
+                 onThread:thread
+               withObject:[block copy]
+            waitUntilDone:NO];
+}
+
+#pragma mark - Private methods
+
++ (void)threadMain:(dispatch_semaphore_t)started
+{
+    @autoreleasepool {
+        networkRunLoop = [NSRunLoop currentRunLoop];
+
+//        без источников цикл выполнения сразу завершается, порт удерживает его;
+//        NSPort выбирает доступную на платформе реализацию (не только Mach)
+        [networkRunLoop addPort:[NSPort port]
+                        forMode:NSDefaultRunLoopMode];
+
+        dispatch_semaphore_signal(started);
+    }
+
+    while (YES) {
+        @autoreleasepool {
+            [networkRunLoop runMode:NSDefaultRunLoopMode
+                         beforeDate:[NSDate distantFuture]];
+        }
+    }
+}
+
++ (void)runBlock:(dispatch_block_t)block
+{
+    block();
+}
+
+@end
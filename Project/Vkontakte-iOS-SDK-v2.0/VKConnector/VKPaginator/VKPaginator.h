@@ -0,0 +1,177 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKRequest.h"
+
+
+@class VKPaginator;
+@class VKUser;
+
+
+/** Default number of list items requested with one request
+*/
+#define kVKPaginatorDefaultPageSize 100
+
+/** Default number of pages which are loaded simultaneously
+*/
+#define kVKPaginatorDefaultReadAhead 3
+
+
+/** Protocol allows receiving pages of the list loaded by the paginator
+*/
+@protocol VKPaginatorDelegate <NSObject>
+
+@required
+/**
+@name Required
+*/
+/** Is called with the next page of the list. Pages are passed strictly in
+order of their offsets, even if they were loaded in a different order
+
+@param paginator paginator
+@param items list items of the page
+@param offset offset of the first item of the page
+*/
+- (void)paginator:(VKPaginator *)paginator
+     didLoadItems:(NSArray *)items
+           offset:(NSUInteger)offset;
+
+@optional
+/**
+@name Optional
+*/
+/** Is called after the last page was passed to the delegate
+
+@param paginator paginator
+*/
+- (void)paginatorDidFinish:(VKPaginator *)paginator;
+
+/** Is called if one of the pages was not loaded. Paginator cancels all its
+requests and stops
+
+@param paginator paginator
+@param error NSError instance for connection and parsing errors or server
+response with error description
+*/
+- (void)paginator:(VKPaginator *)paginator
+ didFailWithError:(id)error;
+
+@end
+
+
+/** Paginator loads the whole list from the API methods which page by offset and count
+parameters (wall.get, friends.get, groups.getMembers, messages.getHistory, photos.getAll,
+likes.getList etc).
+
+Once the total number of items is known (from the first page), the next readAhead
+pages are requested simultaneously. Requests are started by VKRequestScheduler, so
+they respect API rate limit, and the download is bounded by bandwidth instead of the
+round trip time of each page.
+
+Both response formats are supported: object with "count" and "items" keys and array
+which starts with the total number of items. Lists without total number are loaded
+page by page until a short page is received.
+
+All methods should be called from the main thread, delegate is called on the main thread.
+*/
+@interface VKPaginator : NSObject <VKRequestDelegate>
+
+/**
+@name Properties
+*/
+/** Delegate
+*/
+@property (nonatomic, weak, readwrite) id <VKPaginatorDelegate> delegate;
+
+/** Number of items requested with one request. By default equals to kVKPaginatorDefaultPageSize
+*/
+@property (nonatomic, assign, readwrite) NSUInteger pageSize;
+
+/** Maximum number of pages loaded simultaneously. By default equals to kVKPaginatorDefaultReadAhead
+*/
+@property (nonatomic, assign, readwrite) NSUInteger readAhead;
+
+/** Maximum number of items to load, 0 means the whole list (default value)
+*/
+@property (nonatomic, assign, readwrite) NSUInteger maxItems;
+
+/** Total number of items in the list as reported by the server. Equals to
+NSNotFound until the first page is loaded or if server does not report it
+*/
+@property (nonatomic, assign, readonly) NSUInteger totalCount;
+
+/** Number of items passed to the delegate
+*/
+@property (nonatomic, assign, readonly) NSUInteger loadedCount;
+
+/** YES after the last page was passed to the delegate or loading failed
+*/
+@property (nonatomic, assign, readonly) BOOL isFinished;
+
+/**
+@name Initialization methods
+*/
+/** Creates paginator which uses request as a template for all pages. Request
+is not started, its offset and count parameters are replaced for each page.
+
+Deadline of the template limits each page separately: every page gets as much time
+as the template had left when paginator was started (or timeout of the template)
+
+@param request request to the API method created with initWithMethod:options:
+@return VKPaginator instance
+*/
+- (instancetype)initWithRequest:(VKRequest *)request;
+
+/** Creates paginator for the VKUser method
+
+Example:
+
+VKPaginator *paginator = [[VKPaginator alloc] initWithUser:[VKUser currentUser]
+selector:@selector(friendsGet:)
+options:@{@"fields" : @"photo_50"}];
+
+@param user user on behalf of which requests are performed
+@param selector VKUser method which takes options dictionary and returns VKRequest
+@param options parameters of the method
+@return VKPaginator instance
+*/
+- (instancetype)initWithUser:(VKUser *)user
+                    selector:(SEL)selector
+                     options:(NSDictionary *)options;
+
+/**
+@name Loading
+*/
+/** Starts loading the list
+*/
+- (void)start;
+
+/** Cancels all requests of the paginator, delegate is not called anymore
+*/
+- (void)cancel;
+
+@end
@@ -0,0 +1,337 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKPaginator.h"
+#import "VKUser.h"
+#import "VKAccessToken.h"
+#import "VKRequestGroup.h"
+#import "VKRequestScheduler.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+@implementation VKPaginator
+{
+    VKRequest *_template;
+    NSString *_token;
+    VKRequestGroup *_group;
+
+    NSUInteger _nextOffset;
+    NSUInteger _deliveredOffset;
+    NSMutableDictionary *_loadedPages;
+    NSMutableDictionary *_pageCounts;
+    NSUInteger _executingRequestsCount;
+    NSTimeInterval _pageTimeout;
+    BOOL _isStarted;
+    BOOL _isLastPageRequested;
+}
+
+#pragma mark Visible VKPaginator methods
+#pragma mark - Init methods
+
+- (instancetype)initWithRequest:(VKRequest *)request
+{
+    INFO_LOG();
+
+    self = [super init];
+
+    if (self) {
+        _template = request;
+        _token = [request.options[@"access_token"] description];
+        _group = [[VKRequestGroup alloc] init];
+        _loadedPages = [[NSMutableDictionary alloc] init];
+        _pageCounts = [[NSMutableDictionary alloc] init];
+
+        _pageSize = kVKPaginatorDefaultPageSize;
+        _readAhead = kVKPaginatorDefaultReadAhead;
+        _maxItems = 0;
+        _totalCount = NSNotFound;
+    }
+
+    return self;
+}
+
+- (instancetype)initWithUser:(VKUser *)user
+                    selector:(SEL)selector
+                     options:(NSDictionary *)options
+{
+    INFO_LOG();
+
+//    метод VKUser нужен только как шаблон запроса, запускать его не надо
+    BOOL startAllRequestsImmediately = user.startAllRequestsImmediately;
+    user.startAllRequestsImmediately = NO;
+
+    VKRequest *(*method)(id, SEL, NSDictionary *) = (void *) [user methodForSelector:selector];
+    VKRequest *request = method(user, selector, options);
+
+    user.startAllRequestsImmediately = startAllRequestsImmediately;
+
+    self = [self initWithRequest:request];
+
+    if (nil == self)
+        return nil;
+
+    _token = user.accessToken.token;
+
+    return self;
+}
+
+#pragma mark - Loading
+
+- (void)start
+{
+    INFO_LOG();
+
+    if (_isStarted)
+        return;
+
+    _isStarted = YES;
+
+    if (nil == _template.methodName) {
+        NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
+                                             code:NSURLErrorBadURL
+                                         userInfo:@{NSLocalizedDescriptionKey : @"Paginator requires request to the API method"}];
+        [self failWithError:error];
+
+        return;
+    }
+
+    _nextOffset = [_template.options[@"offset"] unsignedIntegerValue];
+    _deliveredOffset = _nextOffset;
+
+//    крайний срок шаблона относится к каждой странице: страница получает столько же
+//    времени, сколько оставалось у шаблона при запуске пагинатора
+    _pageTimeout = _template.timeout;
+
+    if (nil != _template.deadline)
+        _pageTimeout = [_template.deadline timeIntervalSinceNow];
+
+    [self requestPages];
+}
+
+- (void)cancel
+{
+    INFO_LOG();
+
+    _isFinished = YES;
+    [_group cancelAll];
+}
+
+#pragma mark - VKRequestDelegate
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    INFO_LOG();
+
+    if (_isFinished)
+        return;
+
+    _executingRequestsCount--;
+
+    NSUInteger offset = [request.signature unsignedIntegerValue];
+    NSUInteger count = [request.options[@"count"] unsignedIntegerValue];
+    NSArray *items = [self itemsFromResponse:response[@"response"]];
+
+//    короткая страница - последняя, даже если сервер не сообщил размер списка
+    if ([items count] < count && NSNotFound == _totalCount)
+        _isLastPageRequested = YES;
+
+    _pageCounts[@(offset)] = @(count);
+
+    _loadedPages[@(offset)] = items;
+
+    [self deliverLoadedPages];
+    [self requestPages];
+}
+
+- (void)     VKRequest:(VKRequest *)request
+connectionErrorOccured:(NSError *)error
+{
+    [self failWithError:error];
+}
+
+- (void)  VKRequest:(VKRequest *)request
+parsingErrorOccured:(NSError *)error
+{
+    [self failWithError:error];
+}
+
+- (void)   VKRequest:(VKRequest *)request
+responseErrorOccured:(id)error
+{
+    [self failWithError:error];
+}
+
+- (void)VKRequest:(VKRequest *)request
+       captchaSid:(NSString *)captchaSid
+     captchaImage:(NSString *)captchaImage
+{
+    [self failWithError:@{@"error_code"  : @14,
+                          @"captcha_sid" : (nil == captchaSid ? @"" : captchaSid),
+                          @"captcha_img" : (nil == captchaImage ? @"" : captchaImage)}];
+}
+
+#pragma mark - Private methods
+
+- (NSUInteger)endOffset
+{
+    NSUInteger endOffset = NSUIntegerMax;
+
+    if (NSNotFound != _totalCount)
+        endOffset = _totalCount;
+
+    if (0 != self.maxItems)
+        endOffset = MIN(endOffset, [_template.options[@"offset"] unsignedIntegerValue] + self.maxItems);
+
+    return endOffset;
+}
+
+- (NSUInteger)countForOffset:(NSUInteger)offset
+{
+    return MIN(MAX(self.pageSize, 1), [self endOffset] - offset);
+}
+
+- (void)requestPages
+{
+    if (_isFinished)
+        return;
+
+//    пока размер списка неизвестен, страницы запрашиваются по одной
+    NSUInteger limit = (NSNotFound == _totalCount ? 1 : MAX(self.readAhead, 1));
+
+    while (!_isLastPageRequested && _executingRequestsCount < limit && _nextOffset < [self endOffset]) {
+        NSUInteger offset = _nextOffset;
+        NSUInteger count = [self countForOffset:offset];
+
+        _nextOffset += count;
+
+        if (_nextOffset >= [self endOffset])
+            _isLastPageRequested = YES;
+
+        VKRequest *request = [_template copyWithOptions:@{@"offset" : @(offset),
+                                                          @"count"  : @(count)}];
+        request.delegate = self;
+        request.signature = @(offset);
+
+//        копия получила абсолютный срок шаблона, а отсчитывать его нужно от запуска
+//        страницы; истекший срок остается как есть - страница сразу завершится ошибкой
+        if (_pageTimeout > 0) {
+            request.deadline = nil;
+            request.timeout = _pageTimeout;
+        }
+
+//        состояние пагинатора изменяется только в главном потоке
+        request.callbackQueue = dispatch_get_main_queue();
+
+        _executingRequestsCount++;
+        [_group addRequest:request];
+
+        [[VKRequestScheduler sharedScheduler] scheduleRequest:request
+                                                        token:_token];
+    }
+
+    [self finishIfNeeded];
+}
+
+- (NSArray *)itemsFromResponse:(id)response
+{
+    if ([response isKindOfClass:[NSDictionary class]]) {
+        if (nil != response[@"count"])
+            _totalCount = [response[@"count"] unsignedIntegerValue];
+
+        return ([response[@"items"] isKindOfClass:[NSArray class]] ? response[@"items"] : @[]);
+    }
+
+    if (![response isKindOfClass:[NSArray class]])
+        return @[];
+
+//    старый формат ответа: первый элемент массива - размер списка
+    if (0 != [response count] && [response[0] isKindOfClass:[NSNumber class]] && [response count] > 1 &&
+            ![response[1] isKindOfClass:[NSNumber class]]) {
+        _totalCount = [response[0] unsignedIntegerValue];
+
+        return [response subarrayWithRange:NSMakeRange(1, [response count] - 1)];
+    }
+
+    return response;
+}
+
+- (void)deliverLoadedPages
+{
+    NSArray *items;
+
+    while (nil != (items = _loadedPages[@(_deliveredOffset)])) {
+        NSUInteger offset = _deliveredOffset;
+
+//        следующая страница начинается там, где заканчивается запрошенная, даже
+//        если сервер вернул меньше элементов (например, удаленные записи)
+        _deliveredOffset += MAX([_pageCounts[@(offset)] unsignedIntegerValue], [items count]);
+
+        [_loadedPages removeObjectForKey:@(offset)];
+        [_pageCounts removeObjectForKey:@(offset)];
+        _loadedCount += [items count];
+
+        [self.delegate paginator:self
+                    didLoadItems:items
+                          offset:offset];
+
+        if (_isFinished)
+            return;
+    }
+}
+
+- (void)finishIfNeeded
+{
+    if (_isFinished || 0 != _executingRequestsCount || 0 != [_loadedPages count])
+        return;
+
+    if (!_isLastPageRequested && _nextOffset < [self endOffset])
+        return;
+
+    _isFinished = YES;
+
+    if ([self.delegate respondsToSelector:@selector(paginatorDidFinish:)])
+        [self.delegate paginatorDidFinish:self];
+}
+
+- (void)failWithError:(id)error
+{
+    INFO_LOG();
+
+    if (_isFinished)
+        return;
+
+    _isFinished = YES;
+    [_group cancelAll];
+
+    if ([self.delegate respondsToSelector:@selector(paginator:didFailWithError:)])
+        [self.delegate paginator:self
+                didFailWithError:error];
+}
+
+@end
@@ -26,6 +26,11 @@
 //
 #import <Foundation/Foundation.h>
 #import "VKCachedData.h"
+#import "VKTransport.h"
+
+
+@class VKRetryPolicy;
+@class VKEntityStore;
 
 
 /** Unknown size of the transmitted data from server
@@ -38,6 +43,74 @@
 static NSString *const kVKAPIURLPrefix = @"https://api.vk.com/method/";
 
 
+/** Notification is posted every time request finishes its work: a response or an
+error was delivered to the delegate or request was cancelled. Notification object
+is the request itself
+*/
+static NSString *const kVKRequestDidFinishNotification = @"VKRequestDidFinishNotification";
+
+
+/** Default number of list items passed to VKRequest:receivedItems: at once
+*/
+#define kVKRequestDefaultItemsBatchSize 100
+
+
+/** Cache policies of the request
+*/
+typedef enum
+{
+
+/** Cached data is returned if it is fresh, otherwise request is sent to the server.
+Default policy
+*/
+    VKRequestCachePolicyCacheElseNetwork = 0,
+
+/** Cache is not read, request is always sent to the server
+*/
+    VKRequestCachePolicyNetworkOnly,
+
+/** Request is never sent to the server. If there is no cached data, connection
+error with NSURLErrorResourceUnavailable code is delivered
+*/
+    VKRequestCachePolicyCacheOnly,
+
+/** Cached data is returned if it is fresh and then request is sent to the server anyway,
+delegate receives both responses
+*/
+    VKRequestCachePolicyCacheThenNetwork,
+
+/** Fresh cached data is returned without sending request to the server. Expired data
+which is not older than maxStaleTime is returned too, but then the request is sent
+to the server to update cache, delegate does not receive the second response
+*/
+    VKRequestCachePolicyStaleWhileRevalidate,
+
+} VKRequestCachePolicy;
+
+
+/** Priority classes of the requests. Queued requests of a higher class are started
+before queued requests of the lower classes, lower classes have bounded concurrency
+(see VKRequestScheduler)
+*/
+typedef enum
+{
+
+/** Request the user is waiting for (sending a message, opening a profile). Default class
+*/
+    VKRequestPriorityInteractive = 0,
+
+/** Request which is not visible to the user (synchronization, uploading in the background)
+*/
+    VKRequestPriorityBackground,
+
+/** Request for the data which may be needed later (next page of the list, photos
+of the next screen)
+*/
+    VKRequestPriorityPrefetch,
+
+} VKRequestPriority;
+
+
 @class VKRequest;
 
 
@@ -126,12 +199,29 @@ reasons cannot be determined, this number will be transferred to 0
        totalBytes:(NSUInteger)totalBytes
     uploadedBytes:(NSUInteger)uploadedBytes;
 
+/** Is called with the next portion of the list items while the response is still
+downloading. If delegate implements this method, elements of the "response" array
+(or of the "response.items", "response.users" arrays and of the "updates" array
+of the long poll server response) are never accumulated:
+they are passed to this method in portions of itemsBatchSize elements, and the
+array in the final response passed to VKRequest:response: is empty.
+
+Delegate can call pauseItems to stop receiving items until resumeItems is called,
+while paused, data is not read from the connection (portions which were already
+passed to the callbackQueue are still delivered).
+
+@param request request
+@param items next portion of the list items
+*/
+- (void)VKRequest:(VKRequest *)request
+    receivedItems:(NSArray *)items;
+
 @end
 
 
 /** Class to perform requests to the social network Vkontakte
 */
-@interface VKRequest : NSObject <NSURLConnectionDataDelegate, NSCopying>
+@interface VKRequest : NSObject <VKTransportDelegate, NSCopying>
 
 /**
 @name Properties
@@ -151,13 +241,120 @@ one delegate performs the process of multiple requests.
 
 /** Offline request mode. In this mode, the data will be requested from the cache and returned
 even in the case of expiration (removal will not happen).
+Expired data is removed from the cache in the background unless the response was cached
+with retainsCacheForOffline set to YES.
 The default mode is turned off.
 */
 @property (nonatomic, assign, readwrite) BOOL offlineMode;
 
+/** Cache policy of the request. By default equals to VKRequestCachePolicyCacheElseNetwork,
+so fresh cached data costs no network traffic at all.
+
+In offline mode any cached data is considered to be fresh.
+*/
+@property (nonatomic, assign, readwrite) VKRequestCachePolicy cachePolicy;
+
+/** Number of seconds expired cached data can still be returned when cache policy
+equals to VKRequestCachePolicyStaleWhileRevalidate. Freshness window is defined by
+cacheLiveTime. By default equals to one day.
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval maxStaleTime;
+
+/** If YES, cached response of the request is removed in the background only
+kVKCachedDataOfflineRetentionTime after its expiration, so it can be read in offline
+mode meanwhile (it still can be evicted when the cache is full). By default equals to NO.
+*/
+@property (nonatomic, assign, readwrite) BOOL retainsCacheForOffline;
+
+/** Name of the API method (users.get, groups.join etc). Equals to nil if request
+was not created with initWithMethod:options:
+*/
+@property (nonatomic, copy, readonly) NSString *methodName;
+
+/** Parameters of the API method. Equals to nil if request was not created with
+initWithMethod:options:
+*/
+@property (nonatomic, copy, readonly) NSDictionary *options;
+
+/** Maximum number of list items passed to VKRequest:receivedItems: at once.
+By default equals to kVKRequestDefaultItemsBatchSize
+*/
+@property (nonatomic, assign, readwrite) NSUInteger itemsBatchSize;
+
+/** YES if delivery of the list items is paused. Is changed on the network thread
+(see VKNetworkThread), so it may not reflect pauseItems or resumeItems called a moment ago
+*/
+@property (nonatomic, assign, readonly) BOOL isItemsPaused;
+
+/** Queue on which delegate methods are called. By default equals to the main queue.
+
+Connection itself is served by the dedicated network thread (see VKNetworkThread),
+where the response is parsed and cached, so only ready results reach this queue.
+*/
+@property (nonatomic, strong, readwrite) dispatch_queue_t callbackQueue;
+
+/** Transport which performs the request. By default equals to defaultTransport
+*/
+@property (nonatomic, strong, readwrite) id <VKTransport> transport;
+
+/** Policy which decides whether request is sent again after a transient failure.
+By default equals to nil - errors are delivered to the delegate immediately
+*/
+@property (nonatomic, strong, readwrite) VKRetryPolicy *retryPolicy;
+
+/** Priority class of the request. By default equals to VKRequestPriorityInteractive.
+Should be set before request is scheduled
+*/
+@property (nonatomic, assign, readwrite) VKRequestPriority priority;
+
+/** Absolute time by which request has to be completed, including all retries.
+If response is not received by this time, request is cancelled and connection error
+with NSURLErrorTimedOut code is delivered. By default equals to nil - no deadline.
+
+Requests with deadline do not share connection with identical requests
+*/
+@property (nonatomic, strong, readwrite) NSDate *deadline;
+
+/** Time interval in seconds in which request has to be completed, including all
+retries. Deadline is computed from it when request is started, so unlike deadline
+it remains valid for copies of the request which are started later (for example,
+pages of VKPaginator). Is ignored if deadline is set. By default equals to 0 - no timeout
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval timeout;
+
+/** YES if deadline has passed
+*/
+@property (nonatomic, readonly) BOOL isDeadlineExceeded;
+
+/** Store into which users, groups and posts of the response are merged while it is
+decoding, their dictionaries in the response are replaced with shared VKEntity instances.
+By default equals to nil - response is not changed
+*/
+@property (nonatomic, strong, readwrite) VKEntityStore *entityStore;
+
+/** YES if sending request several times has the same effect as sending it once:
+GET request to an arbitrary URL or to the API method which does not change any
+data (friends.get, users.search, groups.isMember etc)
+*/
+@property (nonatomic, readonly) BOOL isIdempotent;
+
 /**
 @name Class methods
 */
+/** Transport used by all new requests. By default equals to
+[VKURLConnectionTransport sharedTransport]
+
+@return transport
+*/
++ (id <VKTransport>)defaultTransport;
+
+/** Sets transport used by all new requests, for example NSURLSession based transport
+or loopback transport for tests and benchmarks
+
+@param transport transport, nil resets default transport
+*/
++ (void)setDefaultTransport:(id <VKTransport>)transport;
+
 /** Creates and returns a request
 
 @param request request that will be used as the basis
@@ -243,6 +440,15 @@ social network will return the nickname, date of birth and the status of the cur
 - (instancetype)initWithMethod:(NSString *)methodName
                        options:(NSDictionary *)options;
 
+/** Creates request to the same API method with the same settings (delegate, cache policy,
+transport, priority etc), parameters of the method are replaced with the passed ones.
+Allows using one request as a template for a series of requests, for example pages of a list
+
+@param options parameters which are added to the parameters of the request or replace them
+@return new request or nil if request was not created with initWithMethod:options:
+*/
+- (instancetype)copyWithOptions:(NSDictionary *)options;
+
 /** Start request
 */
 - (void)start;
@@ -251,6 +457,92 @@ social network will return the nickname, date of birth and the status of the cur
 */
 - (void)cancel;
 
+/** Pauses delivery of the list items to VKRequest:receivedItems: and stops reading
+data from the connection, so the server is slowed down by TCP flow control instead of
+the items being accumulated in memory. Final response is not delivered while paused
+*/
+- (void)pauseItems;
+
+/** Resumes delivery of the list items and reading data from the connection
+*/
+- (void)resumeItems;
+
+/**
+@name Delivering results
+*/
+/** Looks up cached response for the request and delivers it to the delegate according
+to the cache policy. Is used by layers which execute request on their own instead of
+calling start (for example VKRequestBatcher) and by VKRequestScheduler before the
+request is queued. Cache is checked only once, later calls (including the one made
+by start) complete with NO
+
+If there is no cached entry, completion is called at once. Otherwise cached data is read
+and parsed in the background and completion is called in the main queue.
+
+@param completion block which receives YES if request is completed and should not be
+sent to the server
+*/
+- (void)deliverCachedResponseWithCompletion:(void (^)(BOOL isCompleted))completion;
+
+/** Attaches request to the identical request which is being executed right now, so
+request receives its result instead of opening a connection of its own. Is used by
+VKRequestScheduler, VKRequestBatcher and VKRequestCoalescer before the request is
+queued. Requests which are not started yet are never joined.
+
+@return YES if request is attached and should not be sent to the server
+*/
+- (BOOL)joinSingleFlight;
+
+/** Processes parsed server response (dictionary with "response" or "error" key)
+as if it was received by this request: notifies delegate, caches successful
+response and finishes request.
+
+Is used by layers which execute several requests at once (for example VKRequestBatcher)
+
+@param json server response as a Foundation object
+*/
+- (void)deliverResponseJSON:(id)json;
+
+/** Notifies delegate about connection error and finishes request
+
+@param error error with a description of the cause of failure
+*/
+- (void)deliverConnectionError:(NSError *)error;
+
+/** Notifies delegate about response parsing error and finishes request
+
+@param error error with a description of the causes of failure
+*/
+- (void)deliverParsingError:(NSError *)error;
+
+/** Arms deadline of the request which is never started itself, but is executed
+as a part of another request (for example by VKRequestBatcher). When deadline passes,
+connection error with NSURLErrorTimedOut code is delivered, the result which arrives
+later is ignored. Should be called from the main thread, results of such requests
+are delivered there too
+*/
+- (void)startDeadlineTimer;
+
+/** Computes deadline from timeout if deadline is not set. Is called when request
+is started, is used by subclasses which override start method and send their
+own connections (for example VKChunkedUploadRequest)
+*/
+- (void)applyTimeout;
+
+/** Connection error with NSURLErrorTimedOut code which is delivered when deadline
+passes
+
+@return NSError instance
+*/
+- (NSError *)deadlineExceededError;
+
+/** Calls block with the delegate on the callbackQueue. Block is not called if
+request is cancelled or delegate is not set. Is used by subclasses to notify delegate
+
+@param block block which calls delegate methods
+*/
+- (void)notifyDelegate:(void (^)(id <VKRequestDelegate> delegate))block;
+
 /**
 @name Add files to the body of the request
 */
@@ -293,4 +585,55 @@ social network will return the nickname, date of birth and the status of the cur
 - (void)appendImageFile:(NSData *)file
                    name:(NSString *)name
                   field:(NSString *)field;
+
+/**
+@name Add files to the body of the request without loading them into memory
+*/
+/** Adding audio file to the HTTP request body. File is not loaded into memory,
+it is read by small portions while request body is sent
+
+@param fileURL URL of the local audio file
+@param name the name of the audio file, if nil then the name of the local file is used
+@param field names the HTML field that was used to send a file
+@return NO if file does not exist
+*/
+- (BOOL)appendAudioFileAtURL:(NSURL *)fileURL
+                        name:(NSString *)name
+                       field:(NSString *)field;
+
+/** Adding video file to the HTTP request body. File is not loaded into memory,
+it is read by small portions while request body is sent
+
+@param fileURL URL of the local video file
+@param name the name of the video file, if nil then the name of the local file is used
+@param field name of an HTML field which was used to send a file
+@return NO if file does not exist
+*/
+- (BOOL)appendVideoFileAtURL:(NSURL *)fileURL
+                        name:(NSString *)name
+                       field:(NSString *)field;
+
+/** Adding document file to the HTTP request body. File is not loaded into memory,
+it is read by small portions while request body is sent
+
+@param fileURL URL of the local document file
+@param name the name of the document file, if nil then the name of the local file is used
+@param field name of an HTML field which was used to send a file
+@return NO if file does not exist
+*/
+- (BOOL)appendDocumentFileAtURL:(NSURL *)fileURL
+                           name:(NSString *)name
+                          field:(NSString *)field;
+
+/** Add image file to the HTTP request body. File is not loaded into memory,
+it is read by small portions while request body is sent
+
+@param fileURL URL of the local image file
+@param name the name of the image file, if nil then the name of the local file is used
+@param field name of an HTML field which was used to send a file
+@return NO if file does not exist
+*/
+- (BOOL)appendImageFileAtURL:(NSURL *)fileURL
+                        name:(NSString *)name
+                       field:(NSString *)field;
 @end
\ No newline at end of file
@@ -30,6 +30,14 @@
 #import "VKStorage.h"
 #import "VKStorageItem.h"
 #import "VKAccessToken.h"
+#import "VKJSONStreamParser.h"
+#import "VKMultipartBodyStream.h"
+#import "VKNetworkThread.h"
+#import "VKURLConnectionTransport.h"
+#import "VKRetryPolicy.h"
+#import "VKEntityStore.h"
+#import "VKCacheKey.h"
+#import "VKRequestScheduler.h"
 
 
 #define INFO_LOG() NSLog(@"%s", __FUNCTION__)
@@ -38,17 +46,42 @@
 #define kCaptchaErrorCode 14
 
 
+#define kVKJSONReadingOptions (NSJSONReadingAllowFragments | NSJSONReadingMutableContainers | NSJSONReadingMutableLeaves)
+
+
+@interface VKRequest () <VKJSONStreamParserDelegate>
+@end
+
+
 @implementation VKRequest
 {
     NSMutableURLRequest *_request;
-    NSURLConnection *_connection;
+    id _task;
 
     NSMutableData *_receivedData;
-    NSMutableData* _body;
+    VKJSONStreamParser *_parser;
+    NSUInteger _receivedDataSize;
+
+    NSMutableArray *_streamedItems;
+    id _pendingResponse;
+    NSMutableArray *_bodyParts;
+    unsigned long long _bodyLength;
     NSString* _boundary, *_boundaryHeader, *_boundaryFooter;
     NSUInteger _expectedDataSize;
 
     BOOL _isBodyEmpty;
+    BOOL _isCancelled;
+    BOOL _isFinished;
+    BOOL _isCacheChecked;
+    BOOL _isRevalidating;
+    BOOL _isRetryPending;
+
+    NSString *_cacheKey;
+    NSString *_singleFlightKey;
+    NSMutableArray *_followers;
+
+    NSUInteger _retryAttempt;
+    NSTimeInterval _retryDelay;
 }
 
 #pragma mark Visible VKRequest methods
@@ -100,6 +133,25 @@
     return request;
 }
 
+static id <VKTransport> defaultTransport;
+
++ (id <VKTransport>)defaultTransport
+{
+    @synchronized ([VKRequest class]) {
+        if (nil == defaultTransport)
+            defaultTransport = [VKURLConnectionTransport sharedTransport];
+
+        return defaultTransport;
+    }
+}
+
++ (void)setDefaultTransport:(id <VKTransport>)transport
+{
+    @synchronized ([VKRequest class]) {
+        defaultTransport = transport;
+    }
+}
+
 #pragma mark - Init methods
 
 - (instancetype)initWithRequest:(NSURLRequest *)request
@@ -112,8 +164,14 @@
         return nil;
 
     _request = [request mutableCopy];
+
+//    JSON хорошо сжимается, ответ распаковывается транспортом
+    if (nil == [_request valueForHTTPHeaderField:@"Accept-Encoding"])
+        [_request setValue:@"gzip, deflate"
+        forHTTPHeaderField:@"Accept-Encoding"];
+
     _receivedData = [[NSMutableData alloc] init];
-    _body = [[NSMutableData alloc] init];
+    _bodyParts = [[NSMutableArray alloc] init];
     _boundary = [[NSProcessInfo processInfo] globallyUniqueString];
     _boundaryHeader = [NSString stringWithFormat:@"\r\n--%@\r\n",
                                                  _boundary];
@@ -122,7 +180,16 @@
     _expectedDataSize = NSURLResponseUnknownContentLength;
     _cacheLiveTime = VKCachedDataLiveTimeOneHour;
     _offlineMode = NO;
+    _cachePolicy = VKRequestCachePolicyCacheElseNetwork;
+    _maxStaleTime = VKCachedDataLiveTimeOneDay;
+    _retainsCacheForOffline = NO;
     _isBodyEmpty = YES;
+    _isCancelled = NO;
+    _itemsBatchSize = kVKRequestDefaultItemsBatchSize;
+    _streamedItems = [[NSMutableArray alloc] init];
+    _callbackQueue = dispatch_get_main_queue();
+    _transport = [[self class] defaultTransport];
+    _priority = VKRequestPriorityInteractive;
 
     return self;
 }
@@ -168,10 +235,10 @@
         [params addObject:param];
     }];
 
-//    сортировка нужна для того, чтобы одинаковые запросы имели одинаковый MD5
+//    сортировка нужна для того, чтобы одинаковые запросы имели одинаковый URL
 //    не стоит забывать, что при итерации по словарю порядок чтения записей может
-//    быть каждый раз разный
-    [params sortUsingSelector:@selector(localizedCaseInsensitiveCompare:)];
+//    быть каждый раз разный; правила локали для этого не нужны
+    [params sortUsingSelector:@selector(compare:)];
 
     [fullURL appendString:[params componentsJoinedByString:@"&"]];
 
@@ -179,7 +246,15 @@
     NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:url];
     [request setHTTPMethod:@"GET"];
 
-    return [self initWithRequest:request];
+    self = [self initWithRequest:request];
+
+    if (nil == self)
+        return nil;
+
+    _methodName = [methodName copy];
+    _options = [options copy];
+
+    return self;
 }
 
 #pragma mark - Start & cancel request
@@ -188,51 +263,355 @@
 {
     INFO_LOG();
 
+//    повтор, дождавшийся своей очереди в планировщике, - все проверки запрос
+//    уже прошел при первом запуске
+    if (_isRetryPending) {
+        _isRetryPending = NO;
+
+        [VKNetworkThread performBlock:^
+        {
+            if ([self shouldStartRetry])
+                [self startTask];
+        }];
+
+        return;
+    }
+
 //    установлен ли делегат? если нет, то и запрос выполнять нет смысла
-    if (nil == self.delegate)
+//    (кроме "обновляющего" запроса, уже отдавшего делегату устаревшие данные)
+    if (nil == self.delegate && !_isRevalidating) {
+        [self finish];
         return;
+    }
 
-//    перед тем как начать выполнение запроса проверим кэш
-    NSUInteger currentUserID = [[[VKUser currentUser] accessToken] userID];
-    VKStorageItem *item = [[VKStorage sharedStorage]
-                                      storageItemForUserID:currentUserID];
+    [self applyTimeout];
 
-    NSData *cachedResponseData = [item.cachedData cachedDataForURL:[self removeAccessTokenFromURL:_request.URL]
-                                                       offlineMode:_offlineMode];
-    if (nil != cachedResponseData) {
-        _receivedData = [cachedResponseData mutableCopy];
-        [self connectionDidFinishLoading:_connection];
+//    ответ, полученный после крайнего срока, никому не нужен
+    if (self.isDeadlineExceeded) {
+        [self deliverConnectionError:[self deadlineExceededError]];
+        return;
+    }
 
-//        нет надобности следить за состоянием "обновляющего" запроса
-//        только при удачном исходе данные в кэше будут обновлены
+//    перед тем как начать выполнение запроса проверим кэш, возможно сервер
+//    и вовсе не понадобится
+    [self deliverCachedResponseWithCompletion:^(BOOL isCompleted)
+    {
+        if (!isCompleted)
+            [self startLoading];
+    }];
+}
+
+- (void)cancel
+{
+    INFO_LOG();
+
+    _isCancelled = YES;
+
+//    если к запросу присоединились другие, то соединение нужно им - отключаемся
+//    только от делегата
+    if (0 != [_followers count]) {
         self.delegate = nil;
+        [self finish];
+
+        return;
     }
 
-//    если тело запроса установлено, то внесем кое-какие завершающие штрихи
-    if(!_isBodyEmpty){
-        [_request setValue:[NSString stringWithFormat:@"%d", [_body length]]
-        forHTTPHeaderField:@"Content-Length"];
-        [_request setValue:[NSString stringWithFormat:@"multipart/form-data; boundary=\"%@\"", _boundary]
-        forHTTPHeaderField:@"Content-Type"];
+//    состояние соединения изменяется только в сетевом потоке
+    [VKNetworkThread performBlock:^
+    {
+        _receivedData = nil;
+        _expectedDataSize = NSURLResponseUnknownContentLength;
+        [_streamedItems removeAllObjects];
+        _pendingResponse = nil;
+        [_parser stop];
+        [self.transport cancelTask:_task];
+
+        [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                                 selector:@selector(retry)
+                                                   object:nil];
+    }];
+
+    [self finish];
+}
+
+- (void)pauseItems
+{
+    INFO_LOG();
+
+//    флаг читается при разборе ответа, поэтому изменяется только в сетевом потоке
+    [VKNetworkThread performBlock:^
+    {
+        if (_isItemsPaused)
+            return;
+
+        _isItemsPaused = YES;
+
+//        пока соединение не обслуживается циклом выполнения, данные из сокета
+//        не читаются и сервер притормаживается самим TCP
+        [self.transport suspendTask:_task];
+    }];
+}
+
+- (void)resumeItems
+{
+    INFO_LOG();
+
+    [VKNetworkThread performBlock:^
+    {
+        if (!_isItemsPaused)
+            return;
+
+        _isItemsPaused = NO;
+
+//        сначала отдаем то, что уже успели разобрать
+        [self deliverStreamedItems:(nil != _pendingResponse)];
+
+        [self.transport resumeTask:_task];
+
+        if (nil != _pendingResponse) {
+            id json = _pendingResponse;
+            _pendingResponse = nil;
+
+            [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+            {
+                [delegate VKRequest:self
+                           response:json];
+            }];
+        }
+    }];
+}
+
+#pragma mark - Delivering results
+
+- (void)deliverCachedResponseWithCompletion:(void (^)(BOOL isCompleted))completion
+{
+    INFO_LOG();
+
+//    кэш мог быть уже проверен до постановки запроса в очередь (например,
+//    планировщиком), второй раз данные из кэша делегату не нужны
+    if (_isCacheChecked || VKRequestCachePolicyNetworkOnly == self.cachePolicy) {
+        completion(NO);
+        return;
+    }
+
+    _isCacheChecked = YES;
+
+    NSUInteger currentUserID = [[[VKUser currentUser] accessToken] userID];
+    VKStorageItem *item = [[VKStorage sharedStorage]
+                                      storageItemForUserID:currentUserID];
+    NSString *cacheKey = [self cacheKey];
 
-//        "закроем" тело
-        [_body appendData:[_boundaryFooter dataUsingEncoding:NSUTF8StringEncoding]];
-        [_request setHTTPBody:_body];
+//    отсутствие записи выясняется без чтения кэша, и запрос продолжает
+//    выполняться сразу же
+    if (![item.cachedData containsCachedDataForKey:cacheKey]) {
+        completion([self deliverCachedJSON:nil
+                                   isStale:NO]);
+        return;
     }
 
-    _connection = [[NSURLConnection alloc]
-                                    initWithRequest:_request
-                                           delegate:self
-                                   startImmediately:YES];
+//    в оффлайн режиме подойдут любые данные, а устаревшие данные интересны
+//    только при stale-while-revalidate
+    NSTimeInterval maxStaleTime = 0;
+
+    if (_offlineMode)
+        maxStaleTime = DBL_MAX;
+    else if (VKRequestCachePolicyStaleWhileRevalidate == self.cachePolicy)
+        maxStaleTime = self.maxStaleTime;
+
+//    чтение, распаковка и разбор ответа не занимают главный поток
+    [item.cachedData cachedDataForKey:cacheKey
+                         maxStaleTime:maxStaleTime
+                           completion:^(NSData *data, BOOL isStale)
+    {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^
+        {
+            id json = nil;
+
+            if (nil != data)
+                json = [NSJSONSerialization JSONObjectWithData:data
+                                                       options:kVKJSONReadingOptions
+                                                         error:nil];
+
+            dispatch_async(dispatch_get_main_queue(), ^
+            {
+//                пока читался кэш, запрос могли отменить
+                if (_isCancelled || _isFinished) {
+                    completion(YES);
+                    return;
+                }
+
+                completion([self deliverCachedJSON:json
+                                           isStale:isStale]);
+            });
+        });
+    }];
 }
 
-- (void)cancel
+- (BOOL)joinSingleFlight
 {
     INFO_LOG();
 
-    _receivedData = nil;
-    _expectedDataSize = NSURLResponseUnknownContentLength;
-    [_connection cancel];
+    return [self joinSingleFlightAsLeader:NO];
+}
+
+- (void)deliverResponseJSON:(id)json
+{
+    INFO_LOG();
+
+//    результат отмененного запроса никому не нужен, кроме присоединившихся к нему;
+//    запрос из общего вызова мог уже завершиться по крайнему сроку
+    if ((_isCancelled || _isFinished) && 0 == [_followers count])
+        return;
+
+    [self processJSON:json
+        cacheResponse:YES];
+    [self finish];
+}
+
+- (void)deliverConnectionError:(NSError *)error
+{
+    INFO_LOG();
+
+//    результат отмененного запроса никому не нужен, кроме присоединившихся к нему;
+//    запрос из общего вызова мог уже завершиться по крайнему сроку
+    if ((_isCancelled || _isFinished) && 0 == [_followers count])
+        return;
+
+    [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+    {
+        if ([delegate respondsToSelector:@selector(VKRequest:connectionErrorOccured:)])
+            [delegate VKRequest:self
+         connectionErrorOccured:error];
+    }];
+
+    [self notifyFollowers:^(VKRequest *follower)
+    {
+        [follower deliverConnectionError:error];
+    }];
+
+    [self finish];
+}
+
+- (void)deliverParsingError:(NSError *)error
+{
+    INFO_LOG();
+
+//    результат отмененного запроса никому не нужен, кроме присоединившихся к нему;
+//    запрос из общего вызова мог уже завершиться по крайнему сроку
+    if ((_isCancelled || _isFinished) && 0 == [_followers count])
+        return;
+
+    [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+    {
+        if ([delegate respondsToSelector:@selector(VKRequest:parsingErrorOccured:)])
+            [delegate VKRequest:self
+            parsingErrorOccured:error];
+    }];
+
+    [self notifyFollowers:^(VKRequest *follower)
+    {
+        [follower deliverParsingError:error];
+    }];
+
+    [self finish];
+}
+
+- (void)startDeadlineTimer
+{
+    INFO_LOG();
+
+    [self applyTimeout];
+
+    if (nil == self.deadline)
+        return;
+
+    NSTimeInterval interval = MAX(0, [self.deadline timeIntervalSinceNow]);
+    __weak VKRequest *weakSelf = self;
+
+//    соединения у запроса нет - прерывать нечего, достаточно сообщить делегату;
+//    результат общего вызова, пришедший позже, завершенному запросу уже не передается
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (interval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^
+    {
+        VKRequest *request = weakSelf;
+
+        [request deliverConnectionError:[request deadlineExceededError]];
+    });
+}
+
+- (void)applyTimeout
+{
+//    относительный срок отсчитывается от запуска запроса
+    if (nil == self.deadline && self.timeout > 0)
+        self.deadline = [NSDate dateWithTimeIntervalSinceNow:self.timeout];
+}
+
+- (NSError *)deadlineExceededError
+{
+    return [NSError errorWithDomain:@"VKRequestErrorDomain"
+                               code:NSURLErrorTimedOut
+                           userInfo:@{NSLocalizedDescriptionKey : @"Request deadline exceeded"}];
+}
+
+- (void)notifyDelegate:(void (^)(id <VKRequestDelegate> delegate))block
+{
+    dispatch_queue_t queue = (nil == self.callbackQueue ? dispatch_get_main_queue() : self.callbackQueue);
+
+//    на главном потоке делегат вызывается сразу, чтобы сохранить порядок событий
+//    (например, ответ из кэша приходит раньше, чем запрос уйдет на сервер)
+    if (dispatch_get_main_queue() == queue && [NSThread isMainThread]) {
+        id <VKRequestDelegate> delegate = self.delegate;
+
+        if (!_isCancelled && nil != delegate)
+            block(delegate);
+
+        return;
+    }
+
+    dispatch_async(queue, ^
+    {
+//        запрос мог быть отменен, пока событие ожидало в очереди
+        id <VKRequestDelegate> delegate = self.delegate;
+
+        if (!_isCancelled && nil != delegate)
+            block(delegate);
+    });
+}
+
+#pragma mark - Getters
+
+- (BOOL)isDeadlineExceeded
+{
+    return (nil != self.deadline && [self.deadline timeIntervalSinceNow] <= 0);
+}
+
+- (BOOL)isIdempotent
+{
+    NSString *httpMethod = [_request.HTTPMethod uppercaseString];
+
+    if (![@"GET" isEqualToString:httpMethod] && ![@"HEAD" isEqualToString:httpMethod])
+        return NO;
+
+//    методы API передаются GET запросами, даже если что-то изменяют, поэтому
+//    о них судим по названию действия
+    if (nil == self.methodName)
+        return YES;
+
+    NSArray *parts = [self.methodName componentsSeparatedByString:@"."];
+    NSString *action = [parts lastObject];
+
+    for (NSString *prefix in @[@"get", @"search", @"is", @"are"]) {
+        if ([action hasPrefix:prefix])
+            return YES;
+    }
+
+    return NO;
+}
+
+#pragma mark - Setters
+
+- (void)setItemsBatchSize:(NSUInteger)itemsBatchSize
+{
+    _itemsBatchSize = MAX(1, itemsBatchSize);
 }
 
 #pragma mark - Request body manipulations
@@ -274,6 +653,42 @@
                field:field];
 }
 
+- (BOOL)appendAudioFileAtURL:(NSURL *)fileURL
+                        name:(NSString *)name
+                       field:(NSString *)field
+{
+    return [self appendFileAtURL:fileURL
+                            name:name
+                           field:field];
+}
+
+- (BOOL)appendDocumentFileAtURL:(NSURL *)fileURL
+                           name:(NSString *)name
+                          field:(NSString *)field
+{
+    return [self appendFileAtURL:fileURL
+                            name:name
+                           field:field];
+}
+
+- (BOOL)appendImageFileAtURL:(NSURL *)fileURL
+                        name:(NSString *)name
+                       field:(NSString *)field
+{
+    return [self appendFileAtURL:fileURL
+                            name:name
+                           field:field];
+}
+
+- (BOOL)appendVideoFileAtURL:(NSURL *)fileURL
+                        name:(NSString *)name
+                       field:(NSString *)field
+{
+    return [self appendFileAtURL:fileURL
+                            name:name
+                           field:field];
+}
+
 #pragma mark - Overridden methods
 
 - (NSString *)description
@@ -283,6 +698,7 @@
             @"signature"     : self.signature,
             @"cacheLiveTime" : @(self.cacheLiveTime),
             @"offlineMode"   : (self.offlineMode ? @"YES" : @"NO"),
+            @"cachePolicy"   : @(self.cachePolicy),
             @"request"       : [_request description]
     };
 
@@ -294,41 +710,76 @@
     VKRequest *copy = [[VKRequest alloc]
                                   initWithRequest:_request];
 
-    copy.signature = _signature;
-    copy.cacheLiveTime = _cacheLiveTime;
-    copy.offlineMode = _offlineMode;
+    [self copySettingsToRequest:copy];
+
+    copy->_bodyParts = [_bodyParts mutableCopy];
+    copy->_boundary = _boundary;
+    copy->_boundaryHeader = _boundaryHeader;
+    copy->_boundaryFooter = _boundaryFooter;
+    copy->_isBodyEmpty = _isBodyEmpty;
+    copy->_methodName = [_methodName copy];
+    copy->_options = [_options copy];
+
+    return copy;
+}
+
+#pragma mark - Templates
+
+- (instancetype)copyWithOptions:(NSDictionary *)options
+{
+    INFO_LOG();
+
+    if (nil == _methodName)
+        return nil;
+
+    NSMutableDictionary *mergedOptions = [NSMutableDictionary dictionaryWithDictionary:_options];
+    [mergedOptions addEntriesFromDictionary:options];
+
+    VKRequest *copy = [[[self class] alloc] initWithMethod:_methodName
+                                                   options:mergedOptions];
+
+    [self copySettingsToRequest:copy];
+    copy.delegate = self.delegate;
 
     return copy;
 }
 
-#pragma mark - NSURLConnectionDataDelegate
+#pragma mark - VKTransportDelegate
 
-- (void)connection:(NSURLConnection *)connection
-didReceiveResponse:(NSURLResponse *)response
+- (void)transport:(id <VKTransport>)transport
+             task:(id)task
+didReceiveResponse:(NSHTTPURLResponse *)response
 {
     INFO_LOG();
 
-    NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *) response;
+    NSHTTPURLResponse *httpResponse = response;
 
     if (200 != [httpResponse statusCode]) {
 
-        if (nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:connectionErrorOccured:)]) {
+        NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
+                                             code:[httpResponse statusCode]
+                                         userInfo:@{
+                                                 @"Response headers"             : [httpResponse allHeaderFields],
+                                                 @"Localized status code string" : [NSHTTPURLResponse localizedStringForStatusCode:[httpResponse statusCode]]
+                                         }];
 
-            NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
-                                                 code:[httpResponse statusCode]
-                                             userInfo:@{
-                                                     @"Response headers"             : [httpResponse allHeaderFields],
-                                                     @"Localized status code string" : [NSHTTPURLResponse localizedStringForStatusCode:[httpResponse statusCode]]
-                                             }];
+//        тело ответа с ошибкой разбирать не будем
+        [transport cancelTask:task];
+        _task = nil;
 
-            [self.delegate VKRequest:self
-              connectionErrorOccured:error];
-        }
+        if (![self retryAfterConnectionError:error])
+            [self deliverConnectionError:error];
 
         return;
     }
 
-    if (NSURLResponseUnknownLength == response.expectedContentLength) {
+    NSString *contentEncoding = [httpResponse.allHeaderFields[@"Content-Encoding"] lowercaseString];
+    BOOL isCompressed = (nil != contentEncoding && ![@"identity" isEqualToString:contentEncoding]);
+
+//    длина сжатого ответа не совпадает с количеством распакованных байт
+    if (isCompressed) {
+        _expectedDataSize = NSURLResponseUnknownContentLength;
+    } else if (NSURLResponseUnknownLength == response.expectedContentLength) {
         NSString *contentLength = httpResponse.allHeaderFields[@"Content-Length"];
 
         if (nil != contentLength) {
@@ -339,80 +790,459 @@ didReceiveResponse:(NSURLResponse *)response
     } else {
         _expectedDataSize = (NSUInteger) response.expectedContentLength;
     }
+
+//    ответ разбирается по мере загрузки, ответ мог начаться заново (например, после
+//    перенаправления), поэтому и разбор начинаем заново
+    [_receivedData setLength:0];
+    _receivedDataSize = 0;
+
+    _parser = [[VKJSONStreamParser alloc] init];
+    _parser.delegate = self;
+
+    if ([self shouldStreamItems])
+        _parser.streamedArrayKeyPaths = [[self class] streamedItemsKeyPaths];
 }
 
-- (void)connection:(NSURLConnection *)connection
-    didReceiveData:(NSData *)data
+- (void)transport:(id <VKTransport>)transport
+             task:(id)task
+   didReceiveData:(NSData *)data
 {
     INFO_LOG();
 
-    [_receivedData appendData:data];
+    _receivedDataSize += [data length];
 
-    if (nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:totalBytes:downloadedBytes:)]) {
+//    сырые данные нужны только для кэша, иначе в памяти хранится лишь разобранный ответ
+    if ([self shouldCacheResponse])
+        [_receivedData appendData:data];
 
-        if (nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:totalBytes:downloadedBytes:)]) {
+    if ([self.delegate respondsToSelector:@selector(VKRequest:totalBytes:downloadedBytes:)]) {
+        NSUInteger totalBytes = _expectedDataSize;
+        NSUInteger downloadedBytes = _receivedDataSize;
 
-            [self.delegate VKRequest:self
-                          totalBytes:_expectedDataSize
-                     downloadedBytes:[_receivedData length]];
-        }
+        [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+        {
+            [delegate VKRequest:self
+                     totalBytes:totalBytes
+                downloadedBytes:downloadedBytes];
+        }];
+    }
+
+//    делегат мог отменить запрос
+    if (_isCancelled && 0 == [_followers count])
+        return;
+
+//    разбор идет параллельно с загрузкой, ошибку разбора нет смысла дожидаться до конца
+    VKJSONStreamParser *parser = _parser;
+
+    if (![parser parseData:data] && nil != parser.error) {
+        [transport cancelTask:task];
+        [self deliverParsingError:parser.error];
     }
 }
 
-- (void)connection:(NSURLConnection *)connection
-   didSendBodyData:(NSInteger)bytesWritten
-        totalBytesWritten:(NSInteger)totalBytesWritten
-totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
+- (void)           transport:(id <VKTransport>)transport
+                        task:(id)task
+              didSendBodyData:(int64_t)totalBytesSent
+    totalBytesExpectedToSend:(int64_t)totalBytesExpectedToSend
 {
     INFO_LOG();
 
-    if (nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:totalBytes:uploadedBytes:)]) {
+    if ([self.delegate respondsToSelector:@selector(VKRequest:totalBytes:uploadedBytes:)]) {
+        NSUInteger totalBytes = (NSUInteger) _bodyLength;
 
-        if (nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:totalBytes:uploadedBytes:)]) {
+        [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+        {
+            [delegate VKRequest:self
+                     totalBytes:totalBytes
+                  uploadedBytes:(NSUInteger) totalBytesSent];
+        }];
+    }
+}
 
-            [self.delegate VKRequest:self
-                          totalBytes:[_body length]
-                       uploadedBytes:(NSUInteger) totalBytesWritten];
-        }
+- (NSInputStream *)transport:(id <VKTransport>)transport
+    needNewBodyStreamForTask:(id)task
+{
+    INFO_LOG();
+
+//    тело нужно отправить заново (например, после перенаправления)
+    return [self bodyStream];
+}
+
+- (void)     transport:(id <VKTransport>)transport
+                  task:(id)task
+  didCompleteWithError:(NSError *)error
+{
+    INFO_LOG();
+
+    _task = nil;
+
+    if (nil != error) {
+        if (![self retryAfterConnectionError:error])
+            [self deliverConnectionError:error];
+
+        return;
     }
+
+//    ошибка разбора уже была доставлена досрочно
+    if (nil != _parser.error)
+        return;
+
+    [self processReceivedData];
+    [self finish];
 }
 
-- (void)connectionDidFinishLoading:(NSURLConnection *)connection
+#pragma mark - VKJSONStreamParserDelegate
+
+- (void)      parser:(VKJSONStreamParser *)parser
+       didParseValue:(id)value
+          forRootKey:(NSString *)key
+{
+//    ответ с ошибкой можно обработать, не дожидаясь окончания загрузки
+    if (![@"error" isEqualToString:key])
+        return;
+
+    INFO_LOG();
+
+    [parser stop];
+    [self.transport cancelTask:_task];
+    _task = nil;
+
+    if ([self retryAfterResponseError:value])
+        return;
+
+    NSMutableDictionary *json = [@{@"error" : value} mutableCopy];
+
+//    ошибки не кэшируются, поэтому сырые данные не нужны
+    [self processJSON:json
+        cacheResponse:NO];
+
+    [self notifyFollowers:^(VKRequest *follower)
+    {
+        if (follower->_isCancelled)
+            return;
+
+        [follower processJSON:json
+                cacheResponse:NO];
+        [follower finish];
+    }];
+
+    [self finish];
+}
+
+- (void)parser:(VKJSONStreamParser *)parser
+   didParseItem:(id)item
+{
+    if (nil != self.entityStore)
+        item = [self.entityStore mergeEntitiesFromJSON:item];
+
+    [_streamedItems addObject:item];
+
+    if ([_streamedItems count] >= self.itemsBatchSize)
+        [self deliverStreamedItems:NO];
+}
+
+#pragma mark - private methods
+
+- (void)finish
+{
+    _isFinished = YES;
+
+    [self leaveSingleFlight];
+
+    if (nil != self.deadline) {
+        [VKNetworkThread performBlock:^
+        {
+            [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                                     selector:@selector(deadlineExceeded)
+                                                       object:nil];
+        }];
+    }
+
+    [[NSNotificationCenter defaultCenter]
+                           postNotificationName:kVKRequestDidFinishNotification
+                                         object:self];
+}
+
+- (void)startLoading
+{
+//    одинаковые запросы, выполняющиеся одновременно, используют одно соединение
+    if ([self joinSingleFlightAsLeader:YES])
+        return;
+
+    if (nil != self.deadline) {
+        NSTimeInterval interval = [self.deadline timeIntervalSinceNow];
+
+        [VKNetworkThread performBlock:^
+        {
+            [self performSelector:@selector(deadlineExceeded)
+                       withObject:nil
+                       afterDelay:interval];
+        }];
+    }
+
+    [self startTask];
+}
+
+- (BOOL)deliverCachedJSON:(id)json
+                  isStale:(BOOL)isStale
+{
+    if (nil == json) {
+        if (VKRequestCachePolicyCacheOnly != self.cachePolicy)
+            return NO;
+
+        NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
+                                             code:NSURLErrorResourceUnavailable
+                                         userInfo:@{NSLocalizedDescriptionKey : @"There is no cached data for the request"}];
+        [self deliverConnectionError:error];
+
+        return YES;
+    }
+
+//    данные взяты из кэша - повторно их не кэшируем, иначе продлим им жизнь
+    [self processJSON:json
+        cacheResponse:NO];
+
+    if (VKRequestCachePolicyCacheThenNetwork == self.cachePolicy)
+        return NO;
+
+    if (VKRequestCachePolicyStaleWhileRevalidate == self.cachePolicy && isStale && !_offlineMode) {
+//        нет надобности следить за состоянием "обновляющего" запроса
+//        только при удачном исходе данные в кэше будут обновлены
+        self.delegate = nil;
+        _isRevalidating = YES;
+
+        return NO;
+    }
+
+    [self finish];
+
+    return YES;
+}
+
+- (void)copySettingsToRequest:(VKRequest *)request
+{
+    request.signature = _signature;
+    request.cacheLiveTime = _cacheLiveTime;
+    request.offlineMode = _offlineMode;
+    request.cachePolicy = _cachePolicy;
+    request.maxStaleTime = _maxStaleTime;
+    request.retainsCacheForOffline = _retainsCacheForOffline;
+    request.itemsBatchSize = _itemsBatchSize;
+    request.callbackQueue = _callbackQueue;
+    request.transport = _transport;
+    request.retryPolicy = _retryPolicy;
+    request.deadline = _deadline;
+    request.timeout = _timeout;
+    request.priority = _priority;
+    request.entityStore = _entityStore;
+}
+
+- (void)startTask
+{
+//    если тело запроса установлено, то внесем кое-какие завершающие штрихи
+//    тело не собирается в памяти, а читается из потока по мере отправки
+    if(!_isBodyEmpty){
+        VKMultipartBodyStream *bodyStream = [self bodyStream];
+        _bodyLength = bodyStream.contentLength;
+
+        [_request setValue:[NSString stringWithFormat:@"%llu", _bodyLength]
+        forHTTPHeaderField:@"Content-Length"];
+        [_request setValue:[NSString stringWithFormat:@"multipart/form-data; boundary=\"%@\"", _boundary]
+        forHTTPHeaderField:@"Content-Type"];
+        [_request setHTTPBodyStream:bodyStream];
+    }
+
+//    системный тайм-аут не должен выходить за крайний срок
+    if (nil != self.deadline)
+        _request.timeoutInterval = MAX(1, MIN(_request.timeoutInterval, [self.deadline timeIntervalSinceNow]));
+
+//    события транспорта приходят в сетевой поток, там же разбирается ответ
+    _task = [self.transport startTaskWithRequest:_request
+                                        delegate:self];
+}
+
+- (BOOL)retryAfterConnectionError:(NSError *)error
+{
+//    часть списка уже могла уйти делегату, повтор передал бы ее еще раз
+    if ([self shouldStreamItems] && 0 != _receivedDataSize)
+        return NO;
+
+    NSTimeInterval delay = [self.retryPolicy delayAfterDelay:_retryDelay];
+
+    if (![self canRetryAfterDelay:delay] || ![self.retryPolicy shouldRetryRequest:self
+                                                                  connectionError:error
+                                                                          attempt:_retryAttempt])
+        return NO;
+
+    [self scheduleRetryAfterDelay:delay];
+
+    return YES;
+}
+
+- (BOOL)retryAfterResponseError:(id)error
+{
+    NSTimeInterval delay = [self.retryPolicy delayAfterDelay:_retryDelay];
+
+    if (![self canRetryAfterDelay:delay] || ![self.retryPolicy shouldRetryRequest:self
+                                                                    responseError:error
+                                                                          attempt:_retryAttempt])
+        return NO;
+
+    [self scheduleRetryAfterDelay:delay];
+
+    return YES;
+}
+
+- (BOOL)canRetryAfterDelay:(NSTimeInterval)delay
+{
+//    повтор, который не успеет до крайнего срока, только зря потратит бюджет
+    return (nil == self.deadline || [self.deadline timeIntervalSinceNow] > delay);
+}
+
+- (void)scheduleRetryAfterDelay:(NSTimeInterval)delay
 {
     INFO_LOG();
 
-//    обработка полного ответа сервера
-    NSJSONReadingOptions mask = NSJSONReadingAllowFragments |
-            NSJSONReadingMutableContainers |
-            NSJSONReadingMutableLeaves;
-    NSError *error;
-    id json = [NSJSONSerialization JSONObjectWithData:_receivedData
-                                              options:mask
-                                                error:&error];
+    _retryAttempt++;
+    _retryDelay = delay;
+
+//    вызывается в сетевом потоке, там же запрос и будет отправлен повторно
+    [self performSelector:@selector(retry)
+               withObject:nil
+               afterDelay:delay];
+}
+
+- (void)deadlineExceeded
+{
+    INFO_LOG();
+
+    if (_isFinished || _isCancelled)
+        return;
+
+    [_parser stop];
+    [self.transport cancelTask:_task];
+    _task = nil;
+
+    [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                             selector:@selector(retry)
+                                               object:nil];
+
+    [self deliverConnectionError:[self deadlineExceededError]];
+}
+
+- (void)retry
+{
+    INFO_LOG();
+
+    if (![self shouldStartRetry])
+        return;
+
+    _parser = nil;
+    [_receivedData setLength:0];
+    _receivedDataSize = 0;
+
+//    повтор запроса, запущенного планировщиком, снова проходит через лимит
+//    запросов, иначе повторы после ошибки 6 сами превысили бы его
+    dispatch_async(dispatch_get_main_queue(), ^
+    {
+        _isRetryPending = YES;
+
+        if ([[VKRequestScheduler sharedScheduler] rescheduleRequest:self])
+            return;
+
+        _isRetryPending = NO;
+
+        [VKNetworkThread performBlock:^
+        {
+            if ([self shouldStartRetry])
+                [self startTask];
+        }];
+    });
+}
+
+- (BOOL)shouldStartRetry
+{
+//    отмененный запрос повторяется только ради присоединившихся к нему,
+//    завершенный (например, по истечении крайнего срока) не повторяется
+    if (_isCancelled)
+        return (0 != [_followers count]);
+
+    return !_isFinished;
+}
+
+- (BOOL)shouldCacheResponse
+{
+    return (VKCachedDataLiveTimeNever != self.cacheLiveTime && ![@"POST" isEqualToString:_request.HTTPMethod]);
+}
+
+- (void)processReceivedData
+{
+//    к этому моменту почти весь ответ уже разобран, осталось завершить разбор
+    NSError *error = nil;
+    id json = nil;
+
+//    пустой ответ без данных тоже разбирается, чтобы получить ошибку разбора
+    VKJSONStreamParser *parser = (nil == _parser ? [[VKJSONStreamParser alloc] init] : _parser);
+
+    if ([parser finish])
+        json = parser.rootObject;
+    else
+        error = parser.error;
+
+    _parser = nil;
 
     if (nil != error) {
-        if (nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:parsingErrorOccured:)]) {
-            [self.delegate VKRequest:self
-                 parsingErrorOccured:error];
-        }
+        [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+        {
+            if ([delegate respondsToSelector:@selector(VKRequest:parsingErrorOccured:)])
+                [delegate VKRequest:self
+                parsingErrorOccured:error];
+        }];
+
+        [self notifyFollowers:^(VKRequest *follower)
+        {
+            [follower deliverParsingError:error];
+        }];
 
         return;
     }
 
+    [self.retryPolicy requestDidSucceed:self];
+
+    [self processJSON:json
+        cacheResponse:YES];
+
+//    разобранный ответ получают и присоединившиеся запросы, кэш уже обновлен
+    [self notifyFollowers:^(VKRequest *follower)
+    {
+        if (follower->_isCancelled)
+            return;
+
+        [follower processJSON:json
+                cacheResponse:NO];
+        [follower finish];
+    }];
+}
+
+- (void)processJSON:(id)json
+      cacheResponse:(BOOL)cacheResponse
+{
 //    проверим, если в ответе содержится ошибка
     if(nil != json[@"error"]){
 
 //      капча ли?
         if(kCaptchaErrorCode == [json[@"error"][@"error_code"] integerValue]){
 
-            if(nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:captchaSid:captchaImage:)]){
-                NSString *captchaSid = json[@"error"][@"captcha_sid"];
-                NSString *captchaImage = json[@"error"][@"captcha_img"];
+            NSString *captchaSid = json[@"error"][@"captcha_sid"];
+            NSString *captchaImage = json[@"error"][@"captcha_img"];
 
-                [self.delegate VKRequest:self
-                              captchaSid:captchaSid
-                            captchaImage:captchaImage];
-            }
+            [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+            {
+                if ([delegate respondsToSelector:@selector(VKRequest:captchaSid:captchaImage:)])
+                    [delegate VKRequest:self
+                             captchaSid:captchaSid
+                           captchaImage:captchaImage];
+            }];
 
 //        прекращаем дальнейшую обработку
 //        кэшировать ошибки не будем
@@ -420,10 +1250,14 @@ totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
         }
 
 //        другая ошибка
-        if(nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:responseErrorOccured:)]){
-            [self.delegate VKRequest:self
-                responseErrorOccured:json[@"error"]];
-        }
+        id error = json[@"error"];
+
+        [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+        {
+            if ([delegate respondsToSelector:@selector(VKRequest:responseErrorOccured:)])
+                [delegate VKRequest:self
+               responseErrorOccured:error];
+        }];
 
 //        прекращаем дальнейшую обработку
 //        кэшировать ошибки не будем
@@ -434,52 +1268,221 @@ totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
 //    1. данные запроса не из кэша
 //    2. время жизни кэша не установлено в "никогда"
 //    3. метод запроса GET
-    if (VKCachedDataLiveTimeNever != self.cacheLiveTime && ![@"POST" isEqualToString:_request.HTTPMethod]) {
+    if (cacheResponse && [self shouldCacheResponse]) {
 
         NSUInteger currentUserID = [[[VKUser currentUser] accessToken] userID];
         VKStorageItem *item = [[VKStorage sharedStorage]
                                           storageItemForUserID:currentUserID];
 
-        [item.cachedData addCachedData:_receivedData
-                                forURL:[self removeAccessTokenFromURL:_request.URL]
-                              liveTime:self.cacheLiveTime];
+//        ответ мог быть получен не этим запросом (например, в составе execute),
+//        тогда сырых данных нет и их нужно получить из Foundation объекта
+        NSData *responseData = _receivedData;
+
+        if (0 == [responseData length])
+            responseData = [NSJSONSerialization dataWithJSONObject:json
+                                                           options:0
+                                                             error:nil];
+
+//        устаревший ответ нужен только при соответствующей политике кэширования
+        NSTimeInterval maxStaleTime = (VKRequestCachePolicyStaleWhileRevalidate == self.cachePolicy ? self.maxStaleTime : 0);
+
+        [item.cachedData addCachedData:responseData
+                                forKey:[self cacheKey]
+                              liveTime:self.cacheLiveTime
+                          maxStaleTime:maxStaleTime
+                      retainForOffline:self.retainsCacheForOffline];
+    }
+
+//    одинаковые сущности разных ответов заменяются одним общим объектом
+    if (nil != self.entityStore)
+        json = [self.entityStore mergeEntitiesFromJSON:json];
+
+//    оставшиеся элементы списка отдаются до окончательного ответа
+    if ([self shouldStreamItems]) {
+        [self extractStreamedItemsFromJSON:json];
+        [self deliverStreamedItems:YES];
+
+//        окончательный ответ дождется возобновления
+        if (_isItemsPaused) {
+            _pendingResponse = json;
+            return;
+        }
     }
 
 //    возвращаем Foundation объект
-    [self.delegate VKRequest:self
-                    response:json];
+    [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+    {
+        [delegate VKRequest:self
+                   response:json];
+    }];
 }
 
-- (void)connection:(NSURLConnection *)connection
-  didFailWithError:(NSError *)error
++ (NSSet *)streamedItemsKeyPaths
 {
-    INFO_LOG();
+    static NSSet *streamedItemsKeyPaths;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        streamedItemsKeyPaths = [NSSet setWithObjects:@"response", @"response.items", @"response.users", @"updates", nil];
+    });
+
+    return streamedItemsKeyPaths;
+}
 
-    if (nil != self.delegate && [self.delegate respondsToSelector:@selector(VKRequest:connectionErrorOccured:)]) {
-        [self.delegate VKRequest:self
-          connectionErrorOccured:error];
+- (BOOL)shouldStreamItems
+{
+    return [self.delegate respondsToSelector:@selector(VKRequest:receivedItems:)];
+}
+
+- (void)extractStreamedItemsFromJSON:(id)json
+{
+//    ответ из кэша или из пакета execute не разбирался потоково - элементы списка
+//    забираем из уже готового ответа
+    id response = json[@"response"];
+    NSMutableArray *items = nil;
+
+    if ([response isKindOfClass:[NSArray class]]) {
+        items = response;
+    } else if ([response isKindOfClass:[NSDictionary class]]) {
+        for (NSString *key in @[@"items", @"users"]) {
+            if ([response[key] isKindOfClass:[NSArray class]]) {
+                items = response[key];
+                break;
+            }
+        }
+    }
+
+    if (0 == [items count] || ![items isKindOfClass:[NSMutableArray class]])
+        return;
+
+    [_streamedItems addObjectsFromArray:items];
+    [items removeAllObjects];
+}
+
+- (void)deliverStreamedItems:(BOOL)deliverAll
+{
+    while (!_isItemsPaused && 0 != [_streamedItems count]) {
+        if (!deliverAll && [_streamedItems count] < self.itemsBatchSize)
+            break;
+
+        NSRange range = NSMakeRange(0, MIN(self.itemsBatchSize, [_streamedItems count]));
+        NSArray *items = [_streamedItems subarrayWithRange:range];
+        [_streamedItems removeObjectsInRange:range];
+
+        [self notifyDelegate:^(id <VKRequestDelegate> delegate)
+        {
+            [delegate VKRequest:self
+                  receivedItems:items];
+        }];
     }
 }
 
-#pragma mark - private methods
 
-- (NSURL *)removeAccessTokenFromURL:(NSURL *)url
++ (NSMutableDictionary *)singleFlightRequests
 {
-//    уберем токен доступа из строки запроса
-//    токен доступа может меняться при каждом обновлении (повторном входе пользователя),
-//    но создавать каждый раз новый кэш для одинаковых запросов с всего лишь разными
-//    токенами доступа нет смысла.
-    NSString *query = [url query];
-    NSArray *params = [query componentsSeparatedByString:@"&"];
+    static NSMutableDictionary *singleFlightRequests;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        singleFlightRequests = [[NSMutableDictionary alloc] init];
+    });
+
+    return singleFlightRequests;
+}
+
+- (BOOL)joinSingleFlightAsLeader:(BOOL)canLead
+{
+//    объединять можно только запросы, которые ничего не изменяют
+    if (!_isBodyEmpty || ![@"GET" isEqualToString:_request.HTTPMethod])
+        return NO;
 
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"NOT (SELF BEGINSWITH \"access_token\")"];
-    NSArray *newParams = [params filteredArrayUsingPredicate:predicate];
+//    у запросов с разными крайними сроками общий результат может прийти слишком поздно
+    if (nil != self.deadline || self.timeout > 0)
+        return NO;
 
-    NSString *part1 = [[url absoluteString] componentsSeparatedByString:@"?"][0];
-    NSString *part2 = [newParams componentsJoinedByString:@"&"];
-    NSURL *newURL = [NSURL URLWithString:[NSString stringWithFormat:@"%@?%@", part1, part2]];
+//    элементы потокового списка не сохраняются в ответе, поделиться им не выйдет
+    if ([self shouldStreamItems])
+        return NO;
 
-    return newURL;
+//    ключ совпадает с ключом кэша, а кэш у каждого пользователя свой
+    NSUInteger currentUserID = [[[VKUser currentUser] accessToken] userID];
+    NSString *key = [NSString stringWithFormat:@"%@:%@",
+                                               @(currentUserID),
+                                               [self cacheKey]];
+
+    NSMutableDictionary *singleFlightRequests = [[self class] singleFlightRequests];
+
+    @synchronized (singleFlightRequests) {
+        VKRequest *leader = singleFlightRequests[key];
+
+        if (nil != leader && leader != self) {
+            if (nil == leader->_followers)
+                leader->_followers = [[NSMutableArray alloc] init];
+
+            [leader->_followers addObject:self];
+
+            return YES;
+        }
+
+//        запрос, еще не начавший выполняться, вести за собой других не может -
+//        он может так и не стартовать
+        if (!canLead)
+            return NO;
+
+        singleFlightRequests[key] = self;
+        _singleFlightKey = key;
+    }
+
+    return NO;
+}
+
+- (void)leaveSingleFlight
+{
+    if (nil == _singleFlightKey)
+        return;
+
+    NSMutableDictionary *singleFlightRequests = [[self class] singleFlightRequests];
+
+    @synchronized (singleFlightRequests) {
+        if (self == singleFlightRequests[_singleFlightKey])
+            [singleFlightRequests removeObjectForKey:_singleFlightKey];
+    }
+}
+
+- (void)notifyFollowers:(void (^)(VKRequest *follower))block
+{
+    NSArray *followers;
+    NSMutableDictionary *singleFlightRequests = [[self class] singleFlightRequests];
+
+//    после получения результата новые запросы уже не должны присоединяться
+    @synchronized (singleFlightRequests) {
+        if (nil != _singleFlightKey && self == singleFlightRequests[_singleFlightKey])
+            [singleFlightRequests removeObjectForKey:_singleFlightKey];
+
+        followers = [_followers copy];
+        _followers = nil;
+    }
+
+    for (VKRequest *follower in followers)
+        block(follower);
+}
+
+- (NSString *)cacheKey
+{
+//    токен доступа может меняться при каждом обновлении (повторном входе пользователя),
+//    но создавать каждый раз новый кэш для одинаковых запросов с всего лишь разными
+//    токенами доступа нет смысла - VKCacheKey его не учитывает
+    if (nil == _cacheKey) {
+        if (nil != _methodName)
+            _cacheKey = [VKCacheKey keyForMethod:_methodName
+                                         options:_options];
+        else
+            _cacheKey = [VKCacheKey keyForURL:_request.URL];
+    }
+
+    return _cacheKey;
 }
 
 - (void)appendFile:(NSData *)file
@@ -487,28 +1490,67 @@ totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
              field:(NSString *)field
 {
 //    header part
-    [_body appendData:[_boundaryHeader dataUsingEncoding:NSUTF8StringEncoding]];
+    [_bodyParts addObject:[self partHeaderWithName:name
+                                             field:field]];
+
+//    file part
+    [_bodyParts addObject:[file copy]];
+
+    _isBodyEmpty = NO;
+}
+
+- (BOOL)appendFileAtURL:(NSURL *)fileURL
+                   name:(NSString *)name
+                  field:(NSString *)field
+{
+//    файл будет прочитан только во время отправки
+    VKBodyFilePart *filePart = [VKBodyFilePart partWithFileURL:fileURL];
+
+    if (nil == filePart)
+        return NO;
+
+//    header part
+    [_bodyParts addObject:[self partHeaderWithName:(nil == name ? [fileURL lastPathComponent] : name)
+                                             field:field]];
+
+//    file part
+    [_bodyParts addObject:filePart];
+
+    _isBodyEmpty = NO;
+
+    return YES;
+}
 
-    NSString *contentDisposition = [NSString stringWithFormat:@"Content-Disposition: form-data; name=\"%@\"; filename=\"%@\"\r\n",
-                                                              field,
-                                                              name];
-    [_body appendData:[contentDisposition dataUsingEncoding:NSUTF8StringEncoding]];
+- (NSData *)partHeaderWithName:(NSString *)name
+                         field:(NSString *)field
+{
+    NSMutableString *header = [NSMutableString stringWithString:_boundaryHeader];
+
+    [header appendFormat:@"Content-Disposition: form-data; name=\"%@\"; filename=\"%@\"\r\n",
+                         field,
+                         name];
 
 //    Content-Type
     NSString *contentType = [self determineContentTypeFromExtension:[[name componentsSeparatedByString:@"."]
                                                                            lastObject]];
     if (nil != contentType) {
-        NSString *fullContentType = [NSString stringWithFormat:@"Content-Type: %@\r\n\r\n",
-                                                               contentType];
-        [_body appendData:[fullContentType dataUsingEncoding:NSUTF8StringEncoding]];
+        [header appendFormat:@"Content-Type: %@\r\n\r\n",
+                             contentType];
     } else {
-        [_body appendData:[@"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+        [header appendString:@"\r\n"];
     }
 
-//    file part
-    [_body appendData:file];
+    return [header dataUsingEncoding:NSUTF8StringEncoding];
+}
 
-    _isBodyEmpty = NO;
+- (VKMultipartBodyStream *)bodyStream
+{
+//    "закроем" тело, сами части тела при этом не изменяются, поэтому запрос
+//    можно запускать повторно
+    NSMutableArray *parts = [_bodyParts mutableCopy];
+    [parts addObject:[_boundaryFooter dataUsingEncoding:NSUTF8StringEncoding]];
+
+    return [[VKMultipartBodyStream alloc] initWithParts:parts];
 }
 
 - (NSString *)determineContentTypeFromExtension:(NSString *)extension
@@ -0,0 +1,100 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Maximum number of API calls which can be executed by one execute method call
+*/
+#define kVKExecuteMaxRequests 25
+
+
+/** Default time interval during which requests are gathered in one batch
+*/
+#define kVKRequestBatcherDefaultCoalescingInterval 0.05
+
+
+@class VKRequest;
+
+
+/** Batcher gathers independent API requests which are issued during a short time
+interval on behalf of one access token and executes them all at once with one
+execute method call (https://vk.com/dev/execute).
+
+Results are delivered to each original request delegate as if the request was
+executed on its own, request signatures are preserved.
+
+All methods should be called from the main thread.
+*/
+@interface VKRequestBatcher : NSObject
+
+/**
+@name Properties
+*/
+/** Time interval in seconds during which requests are gathered in one batch.
+By default equals to kVKRequestBatcherDefaultCoalescingInterval
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval coalescingInterval;
+
+/** Maximum number of requests in one batch, can not be greater than
+kVKExecuteMaxRequests (default value)
+*/
+@property (nonatomic, assign, readwrite) NSUInteger maxBatchSize;
+
+/**
+@name Class methods
+*/
+/** Shared batcher used by VKUser
+
+@return VKRequestBatcher instance
+*/
++ (instancetype)sharedBatcher;
+
+/**
+@name Batching requests
+*/
+/** Checks if request can be executed as a part of a batch. Only API methods
+which do not change any data and are executed with GET can be batched
+
+@param request request to check
+@return YES if request can be batched
+*/
+- (BOOL)canBatchRequest:(VKRequest *)request;
+
+/** Adds request to the batch of the access token. Batch is executed after
+coalescingInterval or as soon as it is full
+
+@param request request created with initWithMethod:options:
+@param token access token on behalf of which request will be executed
+*/
+- (void)addRequest:(VKRequest *)request
+             token:(NSString *)token;
+
+/** Executes all gathered requests of all access tokens immediately
+*/
+- (void)flush;
+
+@end
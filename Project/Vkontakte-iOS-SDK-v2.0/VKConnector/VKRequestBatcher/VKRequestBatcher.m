@@ -0,0 +1,433 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKRequestBatcher.h"
+#import "VKRequest.h"
+#import "VKRequestScheduler.h"
+#import "NSString+encodeURL.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+static NSString *const kVKExecuteMethodName = @"execute";
+
+
+/** Single execute call which carries several original requests
+*/
+@interface VKRequestBatch : NSObject <VKRequestDelegate>
+
+@property (nonatomic, strong, readonly) NSArray *requests;
+
+- (instancetype)initWithRequests:(NSArray *)requests;
+
+@end
+
+
+@implementation VKRequestBatcher
+{
+    NSMutableDictionary *_pendingRequests;
+    NSMutableSet *_activeBatches;
+}
+
+#pragma mark Visible VKRequestBatcher methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    INFO_LOG();
+
+    self = [super init];
+
+    if (self) {
+        _pendingRequests = [[NSMutableDictionary alloc] init];
+        _activeBatches = [[NSMutableSet alloc] init];
+        _coalescingInterval = kVKRequestBatcherDefaultCoalescingInterval;
+        _maxBatchSize = kVKExecuteMaxRequests;
+
+        [[NSNotificationCenter defaultCenter]
+                               addObserver:self
+                                  selector:@selector(requestDidFinish:)
+                                      name:kVKRequestDidFinishNotification
+                                    object:nil];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Class methods
+
++ (instancetype)sharedBatcher
+{
+    static VKRequestBatcher *sharedBatcher;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        sharedBatcher = [[[self class] alloc] init];
+    });
+
+    return sharedBatcher;
+}
+
+#pragma mark - Setters
+
+- (void)setMaxBatchSize:(NSUInteger)maxBatchSize
+{
+    _maxBatchSize = MAX(1, MIN(maxBatchSize, kVKExecuteMaxRequests));
+}
+
+#pragma mark - Batching requests
+
+- (BOOL)canBatchRequest:(VKRequest *)request
+{
+    NSString *methodName = request.methodName;
+
+    if (nil == methodName || [kVKExecuteMethodName isEqualToString:methodName])
+        return NO;
+
+//    имя метода вставляется в код VKScript, поэтому допускаем только "раздел.метод"
+    NSArray *parts = [methodName componentsSeparatedByString:@"."];
+
+    if (2 != [parts count])
+        return NO;
+
+    NSCharacterSet *invalidCharacters = [[NSCharacterSet letterCharacterSet] invertedSet];
+
+    for (NSString *part in parts) {
+        if (0 == [part length] || NSNotFound != [part rangeOfCharacterFromSet:invalidCharacters].location)
+            return NO;
+    }
+
+//    объединять можно только методы, которые ничего не изменяют
+    return request.isIdempotent;
+}
+
+- (void)addRequest:(VKRequest *)request
+             token:(NSString *)token
+{
+    INFO_LOG();
+
+    if (nil == request)
+        return;
+
+    if (![NSThread isMainThread]) {
+        dispatch_async(dispatch_get_main_queue(), ^
+        {
+            [self addRequest:request
+                       token:token];
+        });
+
+        return;
+    }
+
+//    без токена доступа execute не выполнить, да и без делегата результат никому не нужен
+    if (nil == token || nil == request.delegate || ![self canBatchRequest:request]) {
+        [[VKRequestScheduler sharedScheduler] scheduleRequest:request
+                                                        token:token];
+        return;
+    }
+
+//    запрос, полностью обслуженный кэшем или уже выполняющимся таким же
+//    запросом, в пакет не попадает
+    [request deliverCachedResponseWithCompletion:^(BOOL isCompleted)
+    {
+        if (!isCompleted && ![request joinSingleFlight])
+            [self addPendingRequest:request
+                              token:token];
+    }];
+}
+
+- (void)flush
+{
+    INFO_LOG();
+
+    for (NSString *token in [_pendingRequests allKeys])
+        [self flushToken:token];
+}
+
+#pragma mark - Private methods
+
+- (void)addPendingRequest:(VKRequest *)request
+                    token:(NSString *)token
+{
+    NSMutableArray *pending = _pendingRequests[token];
+
+    if (nil == pending) {
+        pending = [NSMutableArray array];
+        _pendingRequests[token] = pending;
+
+//        первый запрос пакета "открывает окно" ожидания остальных
+        dispatch_time_t time = dispatch_time(DISPATCH_TIME_NOW, (int64_t) (self.coalescingInterval * NSEC_PER_SEC));
+        dispatch_after(time, dispatch_get_main_queue(), ^
+        {
+//            пакет мог уже уйти раньше, если заполнился полностью
+            if (pending == _pendingRequests[token])
+                [self flushToken:token];
+        });
+    }
+
+    [pending addObject:request];
+
+    if ([pending count] >= self.maxBatchSize)
+        [self flushToken:token];
+}
+
+- (void)flushToken:(NSString *)token
+{
+    NSArray *requests = _pendingRequests[token];
+
+    if (nil == requests)
+        return;
+
+    [_pendingRequests removeObjectForKey:token];
+
+    if (0 == [requests count])
+        return;
+
+//    одиночный запрос нет смысла оборачивать в execute
+    if (1 == [requests count]) {
+        [[VKRequestScheduler sharedScheduler] scheduleRequest:requests[0]
+                                                        token:token];
+        return;
+    }
+
+    VKRequestBatch *batch = [[VKRequestBatch alloc] initWithRequests:requests];
+    [_activeBatches addObject:batch];
+
+    NSString *body = [NSString stringWithFormat:@"code=%@&access_token=%@",
+                                                [[self codeForRequests:requests] encodeURL],
+                                                [token encodeURL]];
+    NSURL *url = [NSURL URLWithString:[kVKAPIURLPrefix stringByAppendingString:kVKExecuteMethodName]];
+
+    VKRequest *executeRequest = [VKRequest requestHTTPMethod:@"POST"
+                                                         URL:url
+                                                     headers:@{@"Content-Type" : @"application/x-www-form-urlencoded"}
+                                                        body:[body dataUsingEncoding:NSUTF8StringEncoding]
+                                                    delegate:batch];
+    executeRequest.signature = kVKExecuteMethodName;
+    executeRequest.cacheLiveTime = VKCachedDataLiveTimeNever;
+
+//    ответ разбирается на ответы запросов, которые сериализуются для кэша, -
+//    главный поток для этого не нужен, делегатам результаты уйдут в их очереди
+    executeRequest.callbackQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+//    пакет не должен ждать дольше самого важного из своих запросов
+    VKRequestPriority priority = VKRequestPriorityPrefetch;
+
+    for (VKRequest *request in requests)
+        priority = MIN(priority, request.priority);
+
+    executeRequest.priority = priority;
+
+//    сами запросы не стартуют, поэтому крайний срок каждого отслеживается отдельно,
+//    а execute нужен, пока его результат ждет хотя бы один из них
+    NSDate *deadline = nil;
+    BOOL hasDeadline = YES;
+
+    for (VKRequest *request in requests) {
+        [request startDeadlineTimer];
+
+        if (nil == request.deadline)
+            hasDeadline = NO;
+        else
+            deadline = (nil == deadline ? request.deadline : [deadline laterDate:request.deadline]);
+
+        if (nil == executeRequest.retryPolicy)
+            executeRequest.retryPolicy = request.retryPolicy;
+    }
+
+    executeRequest.deadline = (hasDeadline ? deadline : nil);
+
+    [[VKRequestScheduler sharedScheduler] scheduleRequest:executeRequest
+                                                    token:token];
+}
+
+- (NSString *)codeForRequests:(NSArray *)requests
+{
+    NSMutableArray *calls = [NSMutableArray array];
+
+    for (VKRequest *request in requests) {
+        NSMutableDictionary *params = [NSMutableDictionary dictionary];
+
+        [request.options enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop)
+        {
+            NSString *param = [[key description] lowercaseString];
+
+//            токен доступа передается один раз для всего execute
+            if ([@"access_token" isEqualToString:param])
+                return;
+
+            params[param] = [obj description];
+        }];
+
+//        JSON объект является корректным объектом VKScript, заодно экранирует значения
+        NSData *paramsData = [NSJSONSerialization dataWithJSONObject:params
+                                                             options:0
+                                                               error:nil];
+        NSString *paramsString = [[NSString alloc] initWithData:paramsData
+                                                       encoding:NSUTF8StringEncoding];
+
+        [calls addObject:[NSString stringWithFormat:@"API.%@(%@)",
+                                                    request.methodName,
+                                                    paramsString]];
+    }
+
+    return [NSString stringWithFormat:@"return [%@];",
+                                      [calls componentsJoinedByString:@","]];
+}
+
+- (void)requestDidFinish:(NSNotification *)notification
+{
+    VKRequest *request = notification.object;
+
+    dispatch_async(dispatch_get_main_queue(), ^
+    {
+//        отмененные до отправки пакета запросы в него не попадают
+        for (NSMutableArray *pending in [_pendingRequests allValues])
+            [pending removeObjectIdenticalTo:request];
+
+//        выполненный execute освобождает свой пакет
+        if ([request.delegate isKindOfClass:[VKRequestBatch class]])
+            [_activeBatches removeObject:request.delegate];
+    });
+}
+
+@end
+
+
+@implementation VKRequestBatch
+
+#pragma mark - Init methods
+
+- (instancetype)initWithRequests:(NSArray *)requests
+{
+    self = [super init];
+
+    if (self) {
+        _requests = [requests copy];
+    }
+
+    return self;
+}
+
+#pragma mark - VKRequestDelegate
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    INFO_LOG();
+
+    NSArray *results = response[@"response"];
+    NSMutableArray *executeErrors = [response[@"execute_errors"] mutableCopy];
+
+    if (![results isKindOfClass:[NSArray class]]) {
+        NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
+                                             code:NSURLErrorCannotParseResponse
+                                         userInfo:@{@"Response" : (nil == response ? [NSNull null] : response)}];
+
+        for (VKRequest *original in self.requests)
+            [original deliverParsingError:error];
+
+        return;
+    }
+
+    [self.requests enumerateObjectsUsingBlock:^(VKRequest *original, NSUInteger idx, BOOL *stop)
+    {
+        id result = (idx < [results count] ? results[idx] : (__bridge id) kCFBooleanFalse);
+
+//        неудачный вызов внутри execute возвращает false, а описание ошибки
+//        лежит в execute_errors в порядке выполнения вызовов
+        if ((__bridge id) kCFBooleanFalse == result) {
+            NSDictionary *executeError = nil;
+
+            for (NSDictionary *error in executeErrors) {
+                if ([original.methodName isEqualToString:error[@"method"]]) {
+                    executeError = error;
+                    break;
+                }
+            }
+
+            if (nil != executeError) {
+                [executeErrors removeObjectIdenticalTo:executeError];
+                [original deliverResponseJSON:@{@"error" : executeError}];
+
+                return;
+            }
+        }
+
+        [original deliverResponseJSON:@{@"response" : result}];
+    }];
+}
+
+- (void)     VKRequest:(VKRequest *)request
+connectionErrorOccured:(NSError *)error
+{
+    INFO_LOG();
+
+    for (VKRequest *original in self.requests)
+        [original deliverConnectionError:error];
+}
+
+- (void)  VKRequest:(VKRequest *)request
+parsingErrorOccured:(NSError *)error
+{
+    INFO_LOG();
+
+    for (VKRequest *original in self.requests)
+        [original deliverParsingError:error];
+}
+
+- (void)   VKRequest:(VKRequest *)request
+responseErrorOccured:(id)error
+{
+    INFO_LOG();
+
+//    ошибка всего execute (например, превышена частота запросов) касается каждого запроса
+    for (VKRequest *original in self.requests)
+        [original deliverResponseJSON:@{@"error" : error}];
+}
+
+- (void)VKRequest:(VKRequest *)request
+       captchaSid:(NSString *)captchaSid
+     captchaImage:(NSString *)captchaImage
+{
+    INFO_LOG();
+
+    NSDictionary *error = @{@"error_code"  : @14,
+                            @"captcha_sid" : (nil == captchaSid ? @"" : captchaSid),
+                            @"captcha_img" : (nil == captchaImage ? @"" : captchaImage)};
+
+    for (VKRequest *original in self.requests)
+        [original deliverResponseJSON:@{@"error" : error}];
+}
+
+@end
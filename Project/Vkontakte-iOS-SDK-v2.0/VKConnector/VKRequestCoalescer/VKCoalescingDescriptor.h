@@ -0,0 +1,117 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Describes how requests to one getById-like API method are coalesced:
+which parameter carries the IDs, how many IDs one call can take and how to
+find the ID of each item of the response.
+
+IDs can consist of several components separated by "_" (owner ID and item ID
+for posts, photos, audio and documents), all components should be integers,
+other components (access keys) are passed to the server but are not used to
+match items of the response.
+
+Example: posts of wall.getById are passed as "posts=1_10,2_20", each post of
+the response has owner_id (or to_id) and id fields:
+
+[VKCoalescingDescriptor descriptorWithMethod:@"wall.getById"
+IDsParameters:@[@"posts"]
+itemIDFields:@[@[@"owner_id", @"to_id"], @[@"id"]]
+maxBatchSize:100];
+*/
+@interface VKCoalescingDescriptor : NSObject
+
+/**
+@name Properties
+*/
+/** API method name
+*/
+@property (nonatomic, copy, readonly) NSString *methodName;
+
+/** Names of the parameter which carries the IDs, the first one which is present
+in the request options is used
+*/
+@property (nonatomic, copy, readonly) NSArray *IDsParameters;
+
+/** For each component of the ID - array of the item field names which can
+contain it, the first present field is used
+*/
+@property (nonatomic, copy, readonly) NSArray *itemIDFields;
+
+/** Maximum number of IDs in one call
+*/
+@property (nonatomic, assign, readonly) NSUInteger maxBatchSize;
+
+/**
+@name Initialization methods
+*/
+/** Creates descriptor
+
+@param methodName API method name
+@param IDsParameters names of the parameter which carries the IDs
+@param itemIDFields for each ID component - names of the item fields which contain it
+@param maxBatchSize maximum number of IDs in one call
+@return VKCoalescingDescriptor instance
+*/
++ (instancetype)descriptorWithMethod:(NSString *)methodName
+                       IDsParameters:(NSArray *)IDsParameters
+                        itemIDFields:(NSArray *)itemIDFields
+                        maxBatchSize:(NSUInteger)maxBatchSize;
+
+/** Descriptors of users.get, wall.getById, photos.getById, groups.getById,
+audio.getById, docs.getById, messages.getById and places.getById
+
+@return array of VKCoalescingDescriptor instances
+*/
++ (NSArray *)defaultDescriptors;
+
+/**
+@name IDs
+*/
+/** Returns parameter which carries the IDs in the options
+
+@param options request options
+@return parameter name (as it is in options) or nil
+*/
+- (NSString *)IDsParameterInOptions:(NSDictionary *)options;
+
+/** Returns key by which the ID is matched with the response items
+
+@param ID ID as it is passed in the request
+@return key or nil if ID is not valid (for example, screen name instead of numeric ID)
+*/
+- (NSString *)keyForID:(NSString *)ID;
+
+/** Returns key of the response item
+
+@param item response item
+@return key or nil if item has no ID fields
+*/
+- (NSString *)keyForItem:(id)item;
+
+@end
@@ -0,0 +1,155 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKCoalescingDescriptor.h"
+#import "VKMethods.h"
+#import "VKRequestCoalescer.h"
+
+
+@implementation VKCoalescingDescriptor
+
+#pragma mark Visible VKCoalescingDescriptor methods
+#pragma mark - Class methods
+
++ (instancetype)descriptorWithMethod:(NSString *)methodName
+                       IDsParameters:(NSArray *)IDsParameters
+                        itemIDFields:(NSArray *)itemIDFields
+                        maxBatchSize:(NSUInteger)maxBatchSize
+{
+    VKCoalescingDescriptor *descriptor = [[self alloc] init];
+
+    descriptor->_methodName = [methodName copy];
+    descriptor->_IDsParameters = [IDsParameters copy];
+    descriptor->_itemIDFields = [itemIDFields copy];
+    descriptor->_maxBatchSize = MAX(1, maxBatchSize);
+
+    return descriptor;
+}
+
++ (NSArray *)defaultDescriptors
+{
+//    polls.getById принимает один опрос, поэтому объединять нечего
+    return @[
+            [self descriptorWithMethod:kVKUsersGet
+                         IDsParameters:@[@"user_ids", @"uids"]
+                          itemIDFields:@[@[@"id", @"uid"]]
+                          maxBatchSize:kVKUsersGetMaxIDs],
+            [self descriptorWithMethod:kVKWallGetById
+                         IDsParameters:@[@"posts"]
+                          itemIDFields:@[@[@"owner_id", @"to_id"], @[@"id"]]
+                          maxBatchSize:100],
+            [self descriptorWithMethod:kVKPhotosGetById
+                         IDsParameters:@[@"photos"]
+                          itemIDFields:@[@[@"owner_id"], @[@"id", @"pid"]]
+                          maxBatchSize:100],
+            [self descriptorWithMethod:kVKGroupsGetById
+                         IDsParameters:@[@"group_ids", @"gids"]
+                          itemIDFields:@[@[@"id", @"gid"]]
+                          maxBatchSize:500],
+            [self descriptorWithMethod:kVKAudioGetById
+                         IDsParameters:@[@"audios"]
+                          itemIDFields:@[@[@"owner_id", @"owner"], @[@"id", @"aid"]]
+                          maxBatchSize:100],
+            [self descriptorWithMethod:kVKDocsGetById
+                         IDsParameters:@[@"docs"]
+                          itemIDFields:@[@[@"owner_id"], @[@"id", @"did"]]
+                          maxBatchSize:100],
+            [self descriptorWithMethod:kVKMessagesGetById
+                         IDsParameters:@[@"message_ids", @"mids"]
+                          itemIDFields:@[@[@"id", @"mid"]]
+                          maxBatchSize:100],
+            [self descriptorWithMethod:kVKPlacesGetById
+                         IDsParameters:@[@"places"]
+                          itemIDFields:@[@[@"id", @"pid"]]
+                          maxBatchSize:100]
+    ];
+}
+
+#pragma mark - IDs
+
+- (NSString *)IDsParameterInOptions:(NSDictionary *)options
+{
+    for (NSString *parameter in self.IDsParameters) {
+        for (id key in options) {
+            if ([parameter isEqualToString:[[key description] lowercaseString]])
+                return key;
+        }
+    }
+
+    return nil;
+}
+
+- (NSString *)keyForID:(NSString *)ID
+{
+    NSArray *components = [[ID stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]
+                               componentsSeparatedByString:@"_"];
+
+    if ([components count] < [self.itemIDFields count])
+        return nil;
+
+//    лишние части ID (ключи доступа) в ответе не возвращаются
+    NSMutableArray *keyComponents = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < [self.itemIDFields count]; i++) {
+        NSScanner *scanner = [NSScanner scannerWithString:components[i]];
+        long long value;
+
+        if (![scanner scanLongLong:&value] || ![scanner isAtEnd])
+            return nil;
+
+        [keyComponents addObject:[NSString stringWithFormat:@"%lld", value]];
+    }
+
+    return [keyComponents componentsJoinedByString:@"_"];
+}
+
+- (NSString *)keyForItem:(id)item
+{
+    if (![item isKindOfClass:[NSDictionary class]])
+        return nil;
+
+    NSMutableArray *keyComponents = [NSMutableArray array];
+
+    for (NSArray *fields in self.itemIDFields) {
+        id value = nil;
+
+        for (NSString *field in fields) {
+            value = item[field];
+
+            if (nil != value)
+                break;
+        }
+
+        if (nil == value)
+            return nil;
+
+        [keyComponents addObject:[NSString stringWithFormat:@"%lld", [value longLongValue]]];
+    }
+
+    return [keyComponents componentsJoinedByString:@"_"];
+}
+
+@end
@@ -0,0 +1,124 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKCoalescingDescriptor.h"
+
+
+/** Maximum number of user IDs which can be passed to one users.get call
+*/
+#define kVKUsersGetMaxIDs 1000
+
+
+/** Default time interval during which requests are gathered in one call
+*/
+#define kVKRequestCoalescerDefaultCoalescingInterval 0.01
+
+
+@class VKRequest;
+
+
+/** Coalescer gathers requests to getById-like methods (users.get, wall.getById,
+photos.getById, groups.getById etc) which are issued during a short time interval
+with the same parameters and executes them with one call with all requested IDs.
+
+Each method is described by VKCoalescingDescriptor: parameter which carries the IDs,
+maximum number of IDs in one call and fields which identify items of the response.
+Descriptors of the methods wrapped by VKUser are registered by default.
+
+Each original request delegate receives its own items in its own order as if the
+request was executed on its own, request signatures are preserved. Showing a list
+of 500 users, each cell of which requests its user, takes one request instead of 500.
+When response is an object with the "items" key, other keys of the object (such as
+"profiles" and "groups" of extended responses) are passed to each request unchanged.
+
+All methods should be called from the main thread.
+*/
+@interface VKRequestCoalescer : NSObject
+
+/**
+@name Properties
+*/
+/** Time interval in seconds during which requests are gathered in one call.
+By default equals to kVKRequestCoalescerDefaultCoalescingInterval
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval coalescingInterval;
+
+/** Maximum number of IDs in one call, calls are also limited by maxBatchSize of
+the method descriptor. By default equals to kVKUsersGetMaxIDs
+*/
+@property (nonatomic, assign, readwrite) NSUInteger maxBatchSize;
+
+/**
+@name Class methods
+*/
+/** Shared coalescer used by VKUser
+
+@return VKRequestCoalescer instance
+*/
++ (instancetype)sharedCoalescer;
+
+/**
+@name Descriptors
+*/
+/** Registers descriptor, descriptor of the same method is replaced
+
+@param descriptor method descriptor
+*/
+- (void)registerDescriptor:(VKCoalescingDescriptor *)descriptor;
+
+/** Returns descriptor of the method
+
+@param methodName API method name
+@return VKCoalescingDescriptor instance or nil if method is not coalesced
+*/
+- (VKCoalescingDescriptor *)descriptorForMethod:(NSString *)methodName;
+
+/**
+@name Coalescing requests
+*/
+/** Checks if request can be coalesced with others: method has descriptor and
+all IDs of the request are numeric
+
+@param request request to check
+@return YES if request can be coalesced
+*/
+- (BOOL)canCoalesceRequest:(VKRequest *)request;
+
+/** Adds request to the call with the same parameters. Call is executed after
+coalescingInterval or as soon as it is full
+
+@param request request created with initWithMethod:options:
+@param token access token on behalf of which request will be executed, can be nil
+*/
+- (void)addRequest:(VKRequest *)request
+             token:(NSString *)token;
+
+/** Executes all gathered calls immediately
+*/
+- (void)flush;
+
+@end
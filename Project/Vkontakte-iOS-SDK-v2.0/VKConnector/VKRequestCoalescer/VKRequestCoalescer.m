@@ -0,0 +1,545 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKRequestCoalescer.h"
+#import "VKRequest.h"
+#import "VKRequestScheduler.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+/** Single call which carries several original requests
+*/
+@interface VKCoalescedCall : NSObject <VKRequestDelegate>
+
+@property (nonatomic, strong, readonly) VKCoalescingDescriptor *descriptor;
+@property (nonatomic, copy, readonly) NSString *token;
+@property (nonatomic, copy, readonly) NSString *IDsParameter;
+@property (nonatomic, copy, readonly) NSDictionary *options;
+@property (nonatomic, strong, readonly) NSMutableArray *requests;
+@property (nonatomic, strong, readonly) NSMutableOrderedSet *IDs;
+
+- (instancetype)initWithDescriptor:(VKCoalescingDescriptor *)descriptor
+                             token:(NSString *)token
+                      IDsParameter:(NSString *)IDsParameter
+                           options:(NSDictionary *)options;
+
+- (VKRequest *)request;
+
+@end
+
+
+@implementation VKRequestCoalescer
+{
+    NSMutableDictionary *_descriptors;
+    NSMutableDictionary *_pendingCalls;
+    NSMutableSet *_activeCalls;
+}
+
+#pragma mark Visible VKRequestCoalescer methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    INFO_LOG();
+
+    self = [super init];
+
+    if (self) {
+        _descriptors = [[NSMutableDictionary alloc] init];
+        _pendingCalls = [[NSMutableDictionary alloc] init];
+        _activeCalls = [[NSMutableSet alloc] init];
+        _coalescingInterval = kVKRequestCoalescerDefaultCoalescingInterval;
+        _maxBatchSize = kVKUsersGetMaxIDs;
+
+        for (VKCoalescingDescriptor *descriptor in [VKCoalescingDescriptor defaultDescriptors])
+            [self registerDescriptor:descriptor];
+
+        [[NSNotificationCenter defaultCenter]
+                               addObserver:self
+                                  selector:@selector(requestDidFinish:)
+                                      name:kVKRequestDidFinishNotification
+                                    object:nil];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Class methods
+
++ (instancetype)sharedCoalescer
+{
+    static VKRequestCoalescer *sharedCoalescer;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        sharedCoalescer = [[[self class] alloc] init];
+    });
+
+    return sharedCoalescer;
+}
+
+#pragma mark - Setters
+
+- (void)setMaxBatchSize:(NSUInteger)maxBatchSize
+{
+    _maxBatchSize = MAX(1, maxBatchSize);
+}
+
+#pragma mark - Descriptors
+
+- (void)registerDescriptor:(VKCoalescingDescriptor *)descriptor
+{
+    if (nil == descriptor.methodName)
+        return;
+
+    @synchronized (_descriptors) {
+        _descriptors[descriptor.methodName] = descriptor;
+    }
+}
+
+- (VKCoalescingDescriptor *)descriptorForMethod:(NSString *)methodName
+{
+    if (nil == methodName)
+        return nil;
+
+    @synchronized (_descriptors) {
+        return _descriptors[methodName];
+    }
+}
+
+#pragma mark - Coalescing requests
+
+- (BOOL)canCoalesceRequest:(VKRequest *)request
+{
+    VKCoalescingDescriptor *descriptor = [self descriptorForMethod:request.methodName];
+    NSString *IDsParameter = [descriptor IDsParameterInOptions:request.options];
+
+    if (nil == IDsParameter)
+        return NO;
+
+    NSArray *IDs = [self IDsOfRequest:request
+                         IDsParameter:IDsParameter];
+
+    if (0 == [IDs count] || [IDs count] > [self maxBatchSizeForDescriptor:descriptor])
+        return NO;
+
+//    ответ разбирается по ID, короткие имена сопоставить с ним не получится
+    for (NSString *ID in IDs)
+        if (nil == [descriptor keyForID:ID])
+            return NO;
+
+    return YES;
+}
+
+- (void)addRequest:(VKRequest *)request
+             token:(NSString *)token
+{
+    INFO_LOG();
+
+    if (nil == request)
+        return;
+
+    if (![NSThread isMainThread]) {
+        dispatch_async(dispatch_get_main_queue(), ^
+        {
+            [self addRequest:request
+                       token:token];
+        });
+
+        return;
+    }
+
+    if (nil == request.delegate || ![self canCoalesceRequest:request]) {
+        [[VKRequestScheduler sharedScheduler] scheduleRequest:request
+                                                        token:token];
+        return;
+    }
+
+//    запрос, полностью обслуженный кэшем или уже выполняющимся таким же
+//    запросом, в общий вызов не попадает
+    [request deliverCachedResponseWithCompletion:^(BOOL isCompleted)
+    {
+        if (!isCompleted && ![request joinSingleFlight])
+            [self addPendingRequest:request
+                              token:token];
+    }];
+}
+
+- (void)flush
+{
+    INFO_LOG();
+
+    for (NSString *key in [_pendingCalls allKeys])
+        [self flushKey:key];
+}
+
+#pragma mark - Private methods
+
+- (void)addPendingRequest:(VKRequest *)request
+                    token:(NSString *)token
+{
+    VKCoalescingDescriptor *descriptor = [self descriptorForMethod:request.methodName];
+    NSString *IDsParameter = [descriptor IDsParameterInOptions:request.options];
+    NSArray *IDs = [self IDsOfRequest:request
+                         IDsParameter:IDsParameter];
+    NSDictionary *options = [self sharedOptionsOfRequest:request
+                                            IDsParameter:IDsParameter];
+    NSString *key = [self keyForMethod:descriptor.methodName
+                                 token:token
+                          IDsParameter:IDsParameter
+                               options:options];
+    NSUInteger maxBatchSize = [self maxBatchSizeForDescriptor:descriptor];
+
+    VKCoalescedCall *call = _pendingCalls[key];
+
+//    не поместившиеся ID уходят в следующий вызов
+    if (nil != call) {
+        NSMutableOrderedSet *IDsUnion = [call.IDs mutableCopy];
+        [IDsUnion addObjectsFromArray:IDs];
+
+        if ([IDsUnion count] > maxBatchSize) {
+            [self flushKey:key];
+            call = nil;
+        }
+    }
+
+    if (nil == call) {
+        call = [[VKCoalescedCall alloc] initWithDescriptor:descriptor
+                                                     token:token
+                                              IDsParameter:IDsParameter
+                                                   options:options];
+        _pendingCalls[key] = call;
+
+//        первый запрос "открывает окно" ожидания остальных
+        dispatch_time_t time = dispatch_time(DISPATCH_TIME_NOW, (int64_t) (self.coalescingInterval * NSEC_PER_SEC));
+        dispatch_after(time, dispatch_get_main_queue(), ^
+        {
+//            вызов мог уже уйти раньше, если заполнился полностью
+            if (call == _pendingCalls[key])
+                [self flushKey:key];
+        });
+    }
+
+    [call.requests addObject:request];
+    [call.IDs addObjectsFromArray:IDs];
+
+    if ([call.IDs count] >= maxBatchSize)
+        [self flushKey:key];
+}
+
+- (NSUInteger)maxBatchSizeForDescriptor:(VKCoalescingDescriptor *)descriptor
+{
+    return MIN(self.maxBatchSize, descriptor.maxBatchSize);
+}
+
+- (void)flushKey:(NSString *)key
+{
+    VKCoalescedCall *call = _pendingCalls[key];
+
+    if (nil == call)
+        return;
+
+    [_pendingCalls removeObjectForKey:key];
+
+    if (0 == [call.requests count])
+        return;
+
+//    одиночный запрос выполняется как есть
+    if (1 == [call.requests count]) {
+        [[VKRequestScheduler sharedScheduler] scheduleRequest:call.requests[0]
+                                                        token:call.token];
+        return;
+    }
+
+    VKRequest *request = [call request];
+    [_activeCalls addObject:call];
+
+//    сами запросы не стартуют, поэтому крайний срок каждого отслеживается отдельно
+    for (VKRequest *original in call.requests)
+        [original startDeadlineTimer];
+
+    [[VKRequestScheduler sharedScheduler] scheduleRequest:request
+                                                    token:call.token];
+}
+
+- (NSArray *)IDsOfRequest:(VKRequest *)request
+             IDsParameter:(NSString *)IDsParameter
+{
+    id value = request.options[IDsParameter];
+
+    if ([value isKindOfClass:[NSArray class]])
+        value = [value componentsJoinedByString:@","];
+
+    NSMutableArray *IDs = [NSMutableArray array];
+
+    for (NSString *ID in [[value description] componentsSeparatedByString:@","])
+        [IDs addObject:[ID stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]];
+
+    return IDs;
+}
+
+- (NSDictionary *)sharedOptionsOfRequest:(VKRequest *)request
+                            IDsParameter:(NSString *)IDsParameter
+{
+    NSMutableDictionary *options = [NSMutableDictionary dictionary];
+
+    [request.options enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop)
+    {
+        NSString *parameter = [[key description] lowercaseString];
+
+//        токен доступа передается планировщику отдельно
+        if ([key isEqual:IDsParameter] || [@"access_token" isEqualToString:parameter])
+            return;
+
+        options[parameter] = [obj description];
+    }];
+
+    return options;
+}
+
+- (NSString *)keyForMethod:(NSString *)methodName
+                     token:(NSString *)token
+              IDsParameter:(NSString *)IDsParameter
+                   options:(NSDictionary *)options
+{
+    NSMutableArray *params = [NSMutableArray array];
+
+    for (NSString *parameter in [[options allKeys] sortedArrayUsingSelector:@selector(compare:)])
+        [params addObject:[NSString stringWithFormat:@"%@=%@", parameter, options[parameter]]];
+
+    return [NSString stringWithFormat:@"%@|%@|%@|%@",
+                                      methodName,
+                                      (nil == token ? @"" : token),
+                                      IDsParameter,
+                                      [params componentsJoinedByString:@"&"]];
+}
+
+- (void)requestDidFinish:(NSNotification *)notification
+{
+    VKRequest *request = notification.object;
+
+    dispatch_async(dispatch_get_main_queue(), ^
+    {
+//        отмененные до отправки вызова запросы в него не попадают, их ID
+//        остаются в вызове - лишний элемент в ответе никому не мешает
+        for (VKCoalescedCall *call in [_pendingCalls allValues])
+            [call.requests removeObjectIdenticalTo:request];
+
+//        выполненный вызов освобождается
+        if ([request.delegate isKindOfClass:[VKCoalescedCall class]])
+            [_activeCalls removeObject:request.delegate];
+    });
+}
+
+@end
+
+
+@implementation VKCoalescedCall
+
+#pragma mark - Init methods
+
+- (instancetype)initWithDescriptor:(VKCoalescingDescriptor *)descriptor
+                             token:(NSString *)token
+                      IDsParameter:(NSString *)IDsParameter
+                           options:(NSDictionary *)options
+{
+    self = [super init];
+
+    if (self) {
+        _descriptor = descriptor;
+        _token = [token copy];
+        _IDsParameter = [IDsParameter copy];
+        _options = [options copy];
+        _requests = [[NSMutableArray alloc] init];
+        _IDs = [[NSMutableOrderedSet alloc] init];
+    }
+
+    return self;
+}
+
+- (VKRequest *)request
+{
+    NSMutableDictionary *options = [self.options mutableCopy];
+    options[self.IDsParameter] = [[self.IDs array] componentsJoinedByString:@","];
+
+    if (nil != self.token)
+        options[@"access_token"] = self.token;
+
+    VKRequest *request = [VKRequest requestMethod:self.descriptor.methodName
+                                          options:options
+                                         delegate:self];
+    request.signature = self.descriptor.methodName;
+    request.cacheLiveTime = VKCachedDataLiveTimeNever;
+
+//    ответ раскладывается по запросам, которые сериализуют свои части для кэша, -
+//    главный поток для этого не нужен, делегатам результаты уйдут в их очереди
+    request.callbackQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+//    вызов не должен ждать дольше самого важного из своих запросов
+    VKRequestPriority priority = VKRequestPriorityPrefetch;
+
+    for (VKRequest *original in self.requests)
+        priority = MIN(priority, original.priority);
+
+    request.priority = priority;
+
+//    вызов нужен, пока его результат ждет хотя бы один из запросов
+    NSDate *deadline = nil;
+    BOOL hasDeadline = YES;
+
+    for (VKRequest *original in self.requests) {
+        if (nil == original.deadline)
+            hasDeadline = NO;
+        else
+            deadline = (nil == deadline ? original.deadline : [deadline laterDate:original.deadline]);
+
+        if (nil == request.retryPolicy)
+            request.retryPolicy = original.retryPolicy;
+    }
+
+    request.deadline = (hasDeadline ? deadline : nil);
+
+    return request;
+}
+
+#pragma mark - VKRequestDelegate
+
+- (void)VKRequest:(VKRequest *)request
+         response:(id)response
+{
+    INFO_LOG();
+
+    id result = response[@"response"];
+    NSArray *items = result;
+
+//    часть методов возвращает объект с количеством и списком элементов
+    if ([result isKindOfClass:[NSDictionary class]])
+        items = result[@"items"];
+
+    if (![items isKindOfClass:[NSArray class]]) {
+        NSError *error = [NSError errorWithDomain:@"VKRequestErrorDomain"
+                                             code:NSURLErrorCannotParseResponse
+                                         userInfo:@{@"Response" : (nil == response ? [NSNull null] : response)}];
+
+        for (VKRequest *original in self.requests)
+            [original deliverParsingError:error];
+
+        return;
+    }
+
+    NSMutableDictionary *itemsByKey = [NSMutableDictionary dictionary];
+
+    for (id item in items) {
+        NSString *key = [self.descriptor keyForItem:item];
+
+        if (nil != key)
+            itemsByKey[key] = item;
+    }
+
+//    каждый запрос получает свои элементы в своем порядке
+    for (VKRequest *original in self.requests) {
+        NSMutableArray *originalItems = [NSMutableArray array];
+        id value = original.options[self.IDsParameter];
+
+        if ([value isKindOfClass:[NSArray class]])
+            value = [value componentsJoinedByString:@","];
+
+        for (NSString *ID in [[value description] componentsSeparatedByString:@","]) {
+            NSString *key = [self.descriptor keyForID:ID];
+            id item = (nil == key ? nil : itemsByKey[key]);
+
+            if (nil != item)
+                [originalItems addObject:item];
+        }
+
+        id originalResult = originalItems;
+
+//        остальные ключи объекта (например, profiles и groups при extended=1)
+//        относятся ко всему ответу и передаются каждому запросу как есть
+        if ([result isKindOfClass:[NSDictionary class]]) {
+            NSMutableDictionary *dictionary = [result mutableCopy];
+            dictionary[@"items"] = originalItems;
+
+            if (nil != result[@"count"])
+                dictionary[@"count"] = @([originalItems count]);
+
+            originalResult = dictionary;
+        }
+
+        [original deliverResponseJSON:@{@"response" : originalResult}];
+    }
+}
+
+- (void)     VKRequest:(VKRequest *)request
+connectionErrorOccured:(NSError *)error
+{
+    INFO_LOG();
+
+    for (VKRequest *original in self.requests)
+        [original deliverConnectionError:error];
+}
+
+- (void)  VKRequest:(VKRequest *)request
+parsingErrorOccured:(NSError *)error
+{
+    INFO_LOG();
+
+    for (VKRequest *original in self.requests)
+        [original deliverParsingError:error];
+}
+
+- (void)   VKRequest:(VKRequest *)request
+responseErrorOccured:(id)error
+{
+    INFO_LOG();
+
+    for (VKRequest *original in self.requests)
+        [original deliverResponseJSON:@{@"error" : error}];
+}
+
+- (void)VKRequest:(VKRequest *)request
+       captchaSid:(NSString *)captchaSid
+     captchaImage:(NSString *)captchaImage
+{
+    INFO_LOG();
+
+    NSDictionary *error = @{@"error_code"  : @14,
+                            @"captcha_sid" : (nil == captchaSid ? @"" : captchaSid),
+                            @"captcha_img" : (nil == captchaImage ? @"" : captchaImage)};
+
+    for (VKRequest *original in self.requests)
+        [original deliverResponseJSON:@{@"error" : error}];
+}
+
+@end
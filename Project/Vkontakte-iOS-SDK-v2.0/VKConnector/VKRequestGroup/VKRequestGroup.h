@@ -0,0 +1,74 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+@class VKRequest;
+
+
+/** Group of requests which can be cancelled at once, for example all requests
+of a view controller or of a user session.
+
+Group keeps weak references to the requests, finished requests leave the group
+automatically. Group cancels all its requests when it is deallocated, so a group owned
+by a view controller stops loading data nobody will read as soon as the screen is closed.
+
+Methods can be called from any thread.
+*/
+@interface VKRequestGroup : NSObject
+
+/**
+@name Properties
+*/
+/** Requests which are queued or executing at the moment
+*/
+@property (nonatomic, readonly) NSArray *requests;
+
+/** Number of requests in the group
+*/
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+@name Managing requests
+*/
+/** Adds request to the group
+
+@param request request
+*/
+- (void)addRequest:(VKRequest *)request;
+
+/** Removes request from the group without cancelling it
+
+@param request request
+*/
+- (void)removeRequest:(VKRequest *)request;
+
+/** Cancels all queued and executing requests of the group
+*/
+- (void)cancelAll;
+
+@end
@@ -0,0 +1,132 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKRequestGroup.h"
+#import "VKRequest.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+@implementation VKRequestGroup
+{
+    NSHashTable *_requests;
+}
+
+#pragma mark Visible VKRequestGroup methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    INFO_LOG();
+
+    self = [super init];
+
+    if (self) {
+        _requests = [NSHashTable weakObjectsHashTable];
+
+        [[NSNotificationCenter defaultCenter]
+                               addObserver:self
+                                  selector:@selector(requestDidFinish:)
+                                      name:kVKRequestDidFinishNotification
+                                    object:nil];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+//    владелец группы (например, закрытый экран) в результатах уже не нуждается
+    for (VKRequest *request in [_requests allObjects])
+        [request cancel];
+}
+
+#pragma mark - Getters
+
+- (NSArray *)requests
+{
+    @synchronized (_requests) {
+        return [_requests allObjects];
+    }
+}
+
+- (NSUInteger)count
+{
+    @synchronized (_requests) {
+        return [[_requests allObjects] count];
+    }
+}
+
+#pragma mark - Managing requests
+
+- (void)addRequest:(VKRequest *)request
+{
+    if (nil == request)
+        return;
+
+    @synchronized (_requests) {
+        [_requests addObject:request];
+    }
+}
+
+- (void)removeRequest:(VKRequest *)request
+{
+    if (nil == request)
+        return;
+
+    @synchronized (_requests) {
+        [_requests removeObject:request];
+    }
+}
+
+- (void)cancelAll
+{
+    INFO_LOG();
+
+    NSArray *requests;
+
+    @synchronized (_requests) {
+        requests = [_requests allObjects];
+        [_requests removeAllObjects];
+    }
+
+//    отмена уведомляет планировщик и пакетную обработку, поэтому запросы,
+//    ожидающие в очереди, тоже не будут отправлены
+    for (VKRequest *request in requests)
+        [request cancel];
+}
+
+#pragma mark - Private methods
+
+- (void)requestDidFinish:(NSNotification *)notification
+{
+    [self removeRequest:notification.object];
+}
+
+@end
@@ -0,0 +1,170 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKTokenBucket.h"
+#import "VKRequest.h"
+
+
+/** Maximum number of API requests per second allowed by Vkontakte for one access token
+*/
+#define kVKAPIRequestsPerSecond 3
+
+
+/** Default maximum number of simultaneously executing requests
+*/
+#define kVKRequestSchedulerDefaultMaxConcurrentRequests 4
+
+
+/** Default maximum number of simultaneously executing background requests
+*/
+#define kVKRequestSchedulerDefaultMaxBackgroundRequests 2
+
+/** Default maximum number of simultaneously executing prefetch requests
+*/
+#define kVKRequestSchedulerDefaultMaxPrefetchRequests 1
+
+
+/** Scheduler owns starts of API requests. It keeps a token bucket per access token
+which matches Vkontakte API rate limit and limits number of simultaneously
+executing requests, so a screen which issues lots of requests at once does not
+get "Too many requests per second" errors (error code 6).
+
+Requests are started in order of their priority class (see VKRequest priority),
+requests of one class are started in FIFO order. Background and prefetch requests
+can occupy only a limited number of connections, so there are always free connections
+for the interactive requests, while the lower classes make progress.
+
+Cache is checked before the request is queued (see VKRequest deliverCachedResponseWithCompletion:),
+so requests served from the cache neither wait for their turn nor consume the rate
+limit. The same is true for requests which join identical request being executed
+right now (see VKRequest joinSingleFlight).
+
+Queued requests whose deadline (see VKRequest deadline) has passed do not wait
+for their turn: they are removed from the queue and completed with an error.
+
+All methods should be called from the main thread.
+*/
+@interface VKRequestScheduler : NSObject
+
+/**
+@name Properties
+*/
+/** Maximum number of simultaneously executing requests. By default equals to
+kVKRequestSchedulerDefaultMaxConcurrentRequests
+*/
+@property (nonatomic, assign, readwrite) NSUInteger maxConcurrentRequests;
+
+/** Maximum number of requests per second for one access token. By default
+equals to kVKAPIRequestsPerSecond. Affects only token buckets created after the change
+*/
+@property (nonatomic, assign, readwrite) NSUInteger requestsPerSecond;
+
+/** Time source used by token buckets. By default wall clock is used, can be
+replaced with a virtual clock. Affects only token buckets created after the change
+*/
+@property (nonatomic, copy, readwrite) VKTimeSource timeSource;
+
+/** Number of requests waiting to be started
+*/
+@property (nonatomic, readonly) NSUInteger queuedRequestsCount;
+
+/** Number of started requests which have not finished yet
+*/
+@property (nonatomic, readonly) NSUInteger executingRequestsCount;
+
+/**
+@name Class methods
+*/
+/** Shared scheduler used by VKUser
+
+@return VKRequestScheduler instance
+*/
++ (instancetype)sharedScheduler;
+
+/**
+@name Scheduling requests
+*/
+/** Adds request to the queue with priority of the request
+
+@param request request to be started
+@param token access token on behalf of which request will be executed, can be nil
+*/
+- (void)scheduleRequest:(VKRequest *)request
+                  token:(NSString *)token;
+
+/** Changes priority of the request and adds it to the queue
+
+@param request request to be started
+@param token access token on behalf of which request will be executed, can be nil
+@param priority request priority
+*/
+- (void)scheduleRequest:(VKRequest *)request
+                  token:(NSString *)token
+               priority:(VKRequestPriority)priority;
+
+/** Returns started request to the head of the queue of its priority class, so
+the next attempt of the request waits for the rate limit and a free connection as
+new requests do. Is used by VKRequest to retry failed requests
+
+@param request started request
+@return NO if request was not started by the scheduler
+*/
+- (BOOL)rescheduleRequest:(VKRequest *)request;
+
+/** Removes request from the queue if it was not started yet
+
+@param request request to be removed
+*/
+- (void)unscheduleRequest:(VKRequest *)request;
+
+/**
+@name Priority classes
+*/
+/** Limits number of simultaneously executing requests of the priority class. Interactive
+requests are limited only by maxConcurrentRequests by default, background and prefetch
+requests - by kVKRequestSchedulerDefaultMaxBackgroundRequests and
+kVKRequestSchedulerDefaultMaxPrefetchRequests
+
+@param count maximum number of requests, NSUIntegerMax removes the limit
+@param priority priority class
+*/
+- (void)setMaxConcurrentRequests:(NSUInteger)count
+                     forPriority:(VKRequestPriority)priority;
+
+/** Maximum number of simultaneously executing requests of the priority class
+
+@param priority priority class
+@return maximum number of requests
+*/
+- (NSUInteger)maxConcurrentRequestsForPriority:(VKRequestPriority)priority;
+
+/** Starts as many queued requests as current limits allow. Is called automatically,
+but can be called manually after advancing a virtual clock
+*/
+- (void)processQueue;
+
+@end
@@ -0,0 +1,411 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKRequestScheduler.h"
+#import "VKRequest.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+#define kVKRequestSchedulerPrioritiesCount (VKRequestPriorityPrefetch + 1)
+
+
+@implementation VKRequestScheduler
+{
+    NSMutableArray *_queues;
+    NSMapTable *_requestTokens;
+    NSMutableSet *_executingRequests;
+    NSMutableDictionary *_tokenBuckets;
+    NSMutableArray *_priorityLimits;
+
+//    время ближайшего назначенного "пробуждения" (0 - не назначено) и его номер:
+//    срабатывает только последнее назначенное пробуждение
+    NSTimeInterval _wakeUpTime;
+    NSUInteger _wakeUpGeneration;
+}
+
+#pragma mark Visible VKRequestScheduler methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    INFO_LOG();
+
+    self = [super init];
+
+    if (self) {
+        _queues = [[NSMutableArray alloc] init];
+
+        for (NSUInteger i = 0; i < kVKRequestSchedulerPrioritiesCount; i++)
+            [_queues addObject:[NSMutableArray array]];
+
+        _requestTokens = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                               valueOptions:NSPointerFunctionsStrongMemory];
+        _executingRequests = [[NSMutableSet alloc] init];
+        _tokenBuckets = [[NSMutableDictionary alloc] init];
+        _priorityLimits = [@[@(NSUIntegerMax),
+                             @(kVKRequestSchedulerDefaultMaxBackgroundRequests),
+                             @(kVKRequestSchedulerDefaultMaxPrefetchRequests)] mutableCopy];
+
+        _maxConcurrentRequests = kVKRequestSchedulerDefaultMaxConcurrentRequests;
+        _requestsPerSecond = kVKAPIRequestsPerSecond;
+        _wakeUpTime = 0;
+        _wakeUpGeneration = 0;
+
+        [[NSNotificationCenter defaultCenter]
+                               addObserver:self
+                                  selector:@selector(requestDidFinish:)
+                                      name:kVKRequestDidFinishNotification
+                                    object:nil];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Class methods
+
++ (instancetype)sharedScheduler
+{
+    static VKRequestScheduler *sharedScheduler;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        sharedScheduler = [[[self class] alloc] init];
+    });
+
+    return sharedScheduler;
+}
+
+#pragma mark - Getters
+
+- (NSUInteger)queuedRequestsCount
+{
+    NSUInteger count = 0;
+
+    for (NSArray *queue in _queues)
+        count += [queue count];
+
+    return count;
+}
+
+- (NSUInteger)executingRequestsCount
+{
+    return [_executingRequests count];
+}
+
+#pragma mark - Scheduling requests
+
+- (void)scheduleRequest:(VKRequest *)request
+                  token:(NSString *)token
+{
+    [self scheduleRequest:request
+                    token:token
+                 priority:request.priority];
+}
+
+- (void)scheduleRequest:(VKRequest *)request
+                  token:(NSString *)token
+               priority:(VKRequestPriority)priority
+{
+    INFO_LOG();
+
+    if (nil == request)
+        return;
+
+//    планировщик работает только в главном потоке
+    if (![NSThread isMainThread]) {
+        dispatch_async(dispatch_get_main_queue(), ^
+        {
+            [self scheduleRequest:request
+                            token:token
+                         priority:priority];
+        });
+
+        return;
+    }
+
+//    ответ из кэша или уже выполняющегося такого же запроса не расходует
+//    ни лимит запросов, ни соединение
+    if (nil != request.delegate && !request.isDeadlineExceeded) {
+        [request deliverCachedResponseWithCompletion:^(BOOL isCompleted)
+        {
+            if (!isCompleted && ![request joinSingleFlight])
+                [self enqueueRequest:request
+                               token:token
+                            priority:priority];
+        }];
+
+        return;
+    }
+
+    [self enqueueRequest:request
+                   token:token
+                priority:priority];
+}
+
+- (BOOL)rescheduleRequest:(VKRequest *)request
+{
+    INFO_LOG();
+
+    if (![_executingRequests containsObject:request])
+        return NO;
+
+    [_executingRequests removeObject:request];
+
+//    повтор уже отождал свою задержку, поэтому встает в начало очереди своего класса
+    VKRequestPriority priority = MIN(request.priority, VKRequestPriorityPrefetch);
+    [_queues[priority] insertObject:request
+                            atIndex:0];
+
+    [self processQueue];
+
+    return YES;
+}
+
+- (void)unscheduleRequest:(VKRequest *)request
+{
+    INFO_LOG();
+
+    for (NSMutableArray *queue in _queues)
+        [queue removeObjectIdenticalTo:request];
+
+    if (![_executingRequests containsObject:request])
+        [_requestTokens removeObjectForKey:request];
+}
+
+- (void)processQueue
+{
+    INFO_LOG();
+
+    NSTimeInterval wakeUpInterval = [self dropExpiredRequests];
+
+    while ([_executingRequests count] < self.maxConcurrentRequests) {
+        VKRequest *nextRequest = nil;
+
+//        ищем первый запрос с наибольшим приоритетом, для токена которого есть
+//        свободное "окно" в лимите запросов
+        for (NSUInteger priority = 0; priority < kVKRequestSchedulerPrioritiesCount; priority++) {
+            NSMutableArray *queue = _queues[priority];
+            NSMutableSet *blockedTokens = [NSMutableSet set];
+
+//            класс, занявший все свои соединения, ждет завершения своих же запросов
+            if ([self executingRequestsCountForPriority:(VKRequestPriority) priority] >= [_priorityLimits[priority] unsignedIntegerValue])
+                continue;
+
+            for (VKRequest *request in queue) {
+                id token = [_requestTokens objectForKey:request];
+
+//                запросы одного токена стартуют строго по очереди
+                if ([blockedTokens containsObject:token])
+                    continue;
+
+                VKTokenBucket *bucket = [self tokenBucketForToken:token];
+
+                if ([bucket consumeToken]) {
+                    nextRequest = request;
+                    break;
+                }
+
+                [blockedTokens addObject:token];
+                wakeUpInterval = MIN(wakeUpInterval, [bucket timeUntilNextToken]);
+            }
+
+            if (nil != nextRequest) {
+                [queue removeObjectIdenticalTo:nextRequest];
+                break;
+            }
+        }
+
+        if (nil == nextRequest)
+            break;
+
+        [_executingRequests addObject:nextRequest];
+        [nextRequest start];
+    }
+
+//    если в очереди остались запросы, ожидающие пополнения корзины - "проснемся" позже
+    if (DBL_MAX != wakeUpInterval && 0 != self.queuedRequestsCount)
+        [self scheduleWakeUpAfter:wakeUpInterval];
+}
+
+#pragma mark - Priority classes
+
+- (void)setMaxConcurrentRequests:(NSUInteger)count
+                     forPriority:(VKRequestPriority)priority
+{
+    if (priority >= kVKRequestSchedulerPrioritiesCount)
+        return;
+
+    _priorityLimits[priority] = @(MAX(count, 1));
+
+    [self processQueue];
+}
+
+- (NSUInteger)maxConcurrentRequestsForPriority:(VKRequestPriority)priority
+{
+    if (priority >= kVKRequestSchedulerPrioritiesCount)
+        return 0;
+
+    return [_priorityLimits[priority] unsignedIntegerValue];
+}
+
+#pragma mark - Setters
+
+- (void)setRequestsPerSecond:(NSUInteger)requestsPerSecond
+{
+    _requestsPerSecond = MAX(requestsPerSecond, 1);
+    [_tokenBuckets removeAllObjects];
+}
+
+- (void)setTimeSource:(VKTimeSource)timeSource
+{
+    _timeSource = [timeSource copy];
+    [_tokenBuckets removeAllObjects];
+}
+
+#pragma mark - Private methods
+
+- (void)enqueueRequest:(VKRequest *)request
+                 token:(NSString *)token
+              priority:(VKRequestPriority)priority
+{
+    if (priority >= kVKRequestSchedulerPrioritiesCount)
+        priority = VKRequestPriorityPrefetch;
+
+    request.priority = priority;
+
+    [_requestTokens setObject:(nil == token ? [NSNull null] : token)
+                       forKey:request];
+    [_queues[priority] addObject:request];
+
+    [self processQueue];
+}
+
+- (NSUInteger)executingRequestsCountForPriority:(VKRequestPriority)priority
+{
+    NSUInteger count = 0;
+
+    for (VKRequest *request in _executingRequests) {
+        if (priority == request.priority)
+            count++;
+    }
+
+    return count;
+}
+
+- (NSTimeInterval)dropExpiredRequests
+{
+    NSMutableArray *expiredRequests = [NSMutableArray array];
+    NSTimeInterval nextExpiration = DBL_MAX;
+
+    for (NSMutableArray *queue in _queues) {
+        for (VKRequest *request in queue) {
+            if (nil == request.deadline)
+                continue;
+
+            NSTimeInterval interval = [request.deadline timeIntervalSinceNow];
+
+            if (interval <= 0)
+                [expiredRequests addObject:request];
+            else
+                nextExpiration = MIN(nextExpiration, interval);
+        }
+    }
+
+//    просроченный запрос не тратит лимит: start сразу сообщит делегату об истечении срока
+    for (VKRequest *request in expiredRequests) {
+        for (NSMutableArray *queue in _queues)
+            [queue removeObjectIdenticalTo:request];
+
+        [_requestTokens removeObjectForKey:request];
+        [request start];
+    }
+
+    return nextExpiration;
+}
+
+- (VKTokenBucket *)tokenBucketForToken:(id)token
+{
+    VKTokenBucket *bucket = _tokenBuckets[token];
+
+    if (nil == bucket) {
+        bucket = [[VKTokenBucket alloc] initWithCapacity:self.requestsPerSecond
+                                              refillRate:self.requestsPerSecond
+                                              timeSource:self.timeSource];
+        _tokenBuckets[token] = bucket;
+    }
+
+    return bucket;
+}
+
+- (void)scheduleWakeUpAfter:(NSTimeInterval)interval
+{
+    NSTimeInterval wakeUpTime = [[NSDate date] timeIntervalSince1970] + interval;
+
+//    уже назначенное пробуждение подходит, если оно наступит не позже нужного;
+//    иначе (например, ожидание срока запроса назначено раньше, чем ожидание
+//    пополнения корзины) назначается новое, а прежнее ничего не сделает
+    if (0 != _wakeUpTime && _wakeUpTime <= wakeUpTime)
+        return;
+
+    _wakeUpTime = wakeUpTime;
+    NSUInteger generation = ++_wakeUpGeneration;
+
+    dispatch_time_t time = dispatch_time(DISPATCH_TIME_NOW, (int64_t) (interval * NSEC_PER_SEC));
+    dispatch_after(time, dispatch_get_main_queue(), ^
+    {
+        if (generation != _wakeUpGeneration)
+            return;
+
+        _wakeUpTime = 0;
+        [self processQueue];
+    });
+}
+
+- (void)requestDidFinish:(NSNotification *)notification
+{
+    VKRequest *request = notification.object;
+
+    dispatch_async(dispatch_get_main_queue(), ^
+    {
+        BOOL wasExecuting = [_executingRequests containsObject:request];
+
+        [_executingRequests removeObject:request];
+        [self unscheduleRequest:request];
+
+        if (wasExecuting)
+            [self processQueue];
+    });
+}
+
+@end
@@ -0,0 +1,95 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Block which returns current time in seconds. Allows replacing wall clock
+with a virtual one (for example in unit tests)
+*/
+typedef NSTimeInterval (^VKTimeSource)(void);
+
+
+/** Classic token bucket: tokens are refilled with a constant rate up to the
+bucket capacity, each consumed token allows one action.
+*/
+@interface VKTokenBucket : NSObject
+
+/**
+@name Properties
+*/
+/** Maximum number of tokens bucket can hold (burst size)
+*/
+@property (nonatomic, assign, readonly) NSUInteger capacity;
+
+/** Number of tokens added to the bucket each second
+*/
+@property (nonatomic, assign, readonly) double refillRate;
+
+/** Number of whole tokens currently available
+*/
+@property (nonatomic, readonly) NSUInteger availableTokens;
+
+/**
+@name Initialization methods
+*/
+/** Creates a full bucket which uses wall clock as time source
+
+@param capacity maximum number of tokens
+@param refillRate tokens per second
+@return VKTokenBucket instance
+*/
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                      refillRate:(double)refillRate;
+
+/** Creates a full bucket
+
+@param capacity maximum number of tokens
+@param refillRate tokens per second
+@param timeSource current time provider, if nil wall clock will be used
+@return VKTokenBucket instance
+*/
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                      refillRate:(double)refillRate
+                      timeSource:(VKTimeSource)timeSource;
+
+/**
+@name Tokens
+*/
+/** Takes one token from the bucket
+
+@return YES if token was taken, NO if bucket is empty
+*/
+- (BOOL)consumeToken;
+
+/** Time in seconds left until next token becomes available. If there are
+available tokens 0 will be returned
+
+@return time interval in seconds
+*/
+- (NSTimeInterval)timeUntilNextToken;
+
+@end
@@ -0,0 +1,123 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKTokenBucket.h"
+
+
+@implementation VKTokenBucket
+{
+    VKTimeSource _timeSource;
+
+    double _tokens;
+    NSTimeInterval _lastRefillTime;
+}
+
+#pragma mark Visible VKTokenBucket methods
+#pragma mark - Init methods
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                      refillRate:(double)refillRate
+{
+    return [self initWithCapacity:capacity
+                       refillRate:refillRate
+                       timeSource:nil];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                      refillRate:(double)refillRate
+                      timeSource:(VKTimeSource)timeSource
+{
+    self = [super init];
+
+    if (self) {
+        _capacity = MAX(capacity, 1);
+        _refillRate = (refillRate > 0 ? refillRate : 1);
+        _timeSource = [timeSource copy];
+
+        if (nil == _timeSource) {
+            _timeSource = [^NSTimeInterval
+            {
+                return [NSDate timeIntervalSinceReferenceDate];
+            } copy];
+        }
+
+//        корзина изначально заполнена полностью
+        _tokens = _capacity;
+        _lastRefillTime = _timeSource();
+    }
+
+    return self;
+}
+
+#pragma mark - Tokens
+
+- (NSUInteger)availableTokens
+{
+    [self refill];
+
+    return (NSUInteger) _tokens;
+}
+
+- (BOOL)consumeToken
+{
+    [self refill];
+
+    if (_tokens < 1)
+        return NO;
+
+    _tokens -= 1;
+
+    return YES;
+}
+
+- (NSTimeInterval)timeUntilNextToken
+{
+    [self refill];
+
+    if (_tokens >= 1)
+        return 0;
+
+    return (1 - _tokens) / _refillRate;
+}
+
+#pragma mark - Private methods
+
+- (void)refill
+{
+    NSTimeInterval now = _timeSource();
+    NSTimeInterval elapsed = now - _lastRefillTime;
+
+//    время могло "уйти назад" (например, виртуальные часы в тестах)
+    if (elapsed <= 0) {
+        _lastRefillTime = now;
+        return;
+    }
+
+    _tokens = MIN((double) _capacity, _tokens + elapsed * _refillRate);
+    _lastRefillTime = now;
+}
+
+@end
@@ -0,0 +1,97 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Default capacity of the retry budget
+*/
+#define kVKRetryBudgetDefaultMaxTokens 10.0
+
+/** Default share of the token each successful request returns to the budget
+*/
+#define kVKRetryBudgetDefaultTokenRatio 0.1
+
+
+/** Retry budget limits the share of the retried requests, so retries can not
+multiply load on the server during an outage.
+
+Each retry costs one token, each successful request returns tokenRatio tokens.
+Retries are allowed only while the budget is more than half full, so with the default
+values no more than about 10% of the requests are retried in the long run.
+*/
+@interface VKRetryBudget : NSObject
+
+/**
+@name Properties
+*/
+/** Maximum number of tokens
+*/
+@property (nonatomic, assign, readonly) double maxTokens;
+
+/** Number of tokens each successful request returns to the budget
+*/
+@property (nonatomic, assign, readonly) double tokenRatio;
+
+/** Number of tokens currently available
+*/
+@property (nonatomic, readonly) double availableTokens;
+
+/**
+@name Initialization methods
+*/
+/** Creates a full budget
+
+@param maxTokens maximum number of tokens
+@param tokenRatio number of tokens each successful request returns to the budget
+@return VKRetryBudget instance
+*/
+- (instancetype)initWithMaxTokens:(double)maxTokens
+                       tokenRatio:(double)tokenRatio;
+
+/**
+@name Class methods
+*/
+/** Budget shared by all retry policies by default
+
+@return VKRetryBudget instance
+*/
++ (instancetype)sharedBudget;
+
+/**
+@name Tokens
+*/
+/** Takes one token for the retry
+
+@return YES if retry is allowed
+*/
+- (BOOL)withdrawRetry;
+
+/** Returns part of the token after successful request
+*/
+- (void)depositSuccess;
+
+@end
@@ -0,0 +1,105 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKRetryBudget.h"
+
+
+@implementation VKRetryBudget
+{
+    double _tokens;
+}
+
+#pragma mark Visible VKRetryBudget methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    return [self initWithMaxTokens:kVKRetryBudgetDefaultMaxTokens
+                        tokenRatio:kVKRetryBudgetDefaultTokenRatio];
+}
+
+- (instancetype)initWithMaxTokens:(double)maxTokens
+                       tokenRatio:(double)tokenRatio
+{
+    self = [super init];
+
+    if (self) {
+        _maxTokens = MAX(1, maxTokens);
+        _tokenRatio = MAX(0, tokenRatio);
+        _tokens = _maxTokens;
+    }
+
+    return self;
+}
+
+#pragma mark - Class methods
+
++ (instancetype)sharedBudget
+{
+    static VKRetryBudget *sharedBudget;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        sharedBudget = [[[self class] alloc] init];
+    });
+
+    return sharedBudget;
+}
+
+#pragma mark - Getters
+
+- (double)availableTokens
+{
+    @synchronized (self) {
+        return _tokens;
+    }
+}
+
+#pragma mark - Tokens
+
+- (BOOL)withdrawRetry
+{
+    @synchronized (self) {
+//        во время сбоя бюджет быстро опустеет и повторы прекратятся до тех пор,
+//        пока удачные запросы его не пополнят
+        if (_tokens <= _maxTokens / 2)
+            return NO;
+
+        _tokens -= 1;
+
+        return YES;
+    }
+}
+
+- (void)depositSuccess
+{
+    @synchronized (self) {
+        _tokens = MIN(_maxTokens, _tokens + _tokenRatio);
+    }
+}
+
+@end
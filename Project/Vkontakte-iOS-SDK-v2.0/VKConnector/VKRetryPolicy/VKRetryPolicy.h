@@ -0,0 +1,141 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+@class VKRequest;
+@class VKRetryBudget;
+
+
+/** Default maximum number of retries of one request
+*/
+#define kVKRetryPolicyDefaultMaxRetries 3
+
+/** Default delay before the first retry in seconds
+*/
+#define kVKRetryPolicyDefaultBaseDelay 0.5
+
+/** Default maximum delay between retries in seconds
+*/
+#define kVKRetryPolicyDefaultMaxDelay 30.0
+
+
+/** Retry policy decides which failed requests are sent again and how long to wait
+before that.
+
+Requests are retried after transient connection errors (timeouts, lost connection,
+HTTP status codes 429 and 5xx) and after API errors listed in retryableErrorCodes
+(6 - too many requests per second, 10 - internal server error by default).
+Only idempotent requests (see VKRequest isIdempotent) are retried, except for the
+error 6: such request is rejected by the server without being executed.
+
+Delays grow exponentially with decorrelated jitter: each delay is a random value
+between baseDelay and three times the previous delay (three times baseDelay for the
+first retry), but not more than maxDelay, so clients which failed at the same time
+do not retry at the same time.
+
+Retries of the requests started by VKRequestScheduler wait for the rate limit in its
+queue as new requests do.
+
+All retries are paid from the budget (see VKRetryBudget), by default shared by all
+policies, so a failing server is not flooded with retries.
+*/
+@interface VKRetryPolicy : NSObject
+
+/**
+@name Properties
+*/
+/** Maximum number of retries of one request. By default equals to kVKRetryPolicyDefaultMaxRetries
+*/
+@property (nonatomic, assign, readwrite) NSUInteger maxRetries;
+
+/** Delay before the first retry in seconds. By default equals to kVKRetryPolicyDefaultBaseDelay
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval baseDelay;
+
+/** Maximum delay between retries in seconds. By default equals to kVKRetryPolicyDefaultMaxDelay
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval maxDelay;
+
+/** API error codes (NSNumber) after which request is retried. By default contains 6 and 10
+*/
+@property (nonatomic, copy, readwrite) NSSet *retryableErrorCodes;
+
+/** Retry budget. By default equals to [VKRetryBudget sharedBudget]
+*/
+@property (nonatomic, strong, readwrite) VKRetryBudget *budget;
+
+/**
+@name Class methods
+*/
+/** Creates policy with default values
+
+@return VKRetryPolicy instance
+*/
++ (instancetype)policy;
+
+/**
+@name Retry decisions
+*/
+/** Decides whether request should be sent again after connection error.
+Takes a token from the budget if request is going to be retried
+
+@param request failed request
+@param error connection error
+@param attempt number of retries already made
+@return YES if request should be retried
+*/
+- (BOOL)shouldRetryRequest:(VKRequest *)request
+           connectionError:(NSError *)error
+                   attempt:(NSUInteger)attempt;
+
+/** Decides whether request should be sent again after API error.
+Takes a token from the budget if request is going to be retried
+
+@param request failed request
+@param error value of the "error" key of the server response
+@param attempt number of retries already made
+@return YES if request should be retried
+*/
+- (BOOL)shouldRetryRequest:(VKRequest *)request
+             responseError:(id)error
+                   attempt:(NSUInteger)attempt;
+
+/** Returns delay before the next retry
+
+@param previousDelay previous delay, 0 for the first retry
+@return delay in seconds
+*/
+- (NSTimeInterval)delayAfterDelay:(NSTimeInterval)previousDelay;
+
+/** Is called after request completed successfully, returns part of the token to the budget
+
+@param request request
+*/
+- (void)requestDidSucceed:(VKRequest *)request;
+
+@end
@@ -0,0 +1,144 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKRetryPolicy.h"
+#import "VKRetryBudget.h"
+#import "VKRequest.h"
+
+
+#define INFO_LOG() NSLog(@"%s", __FUNCTION__)
+
+
+#define kVKTooManyRequestsErrorCode 6
+#define kVKInternalServerErrorCode 10
+
+
+@implementation VKRetryPolicy
+
+#pragma mark Visible VKRetryPolicy methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+        _maxRetries = kVKRetryPolicyDefaultMaxRetries;
+        _baseDelay = kVKRetryPolicyDefaultBaseDelay;
+        _maxDelay = kVKRetryPolicyDefaultMaxDelay;
+        _retryableErrorCodes = [NSSet setWithObjects:@kVKTooManyRequestsErrorCode, @kVKInternalServerErrorCode, nil];
+        _budget = [VKRetryBudget sharedBudget];
+    }
+
+    return self;
+}
+
+#pragma mark - Class methods
+
++ (instancetype)policy
+{
+    return [[self alloc] init];
+}
+
+#pragma mark - Retry decisions
+
+- (BOOL)shouldRetryRequest:(VKRequest *)request
+           connectionError:(NSError *)error
+                   attempt:(NSUInteger)attempt
+{
+    INFO_LOG();
+
+    if (attempt >= self.maxRetries || !request.isIdempotent || ![self isTransientError:error])
+        return NO;
+
+    return [self.budget withdrawRetry];
+}
+
+- (BOOL)shouldRetryRequest:(VKRequest *)request
+             responseError:(id)error
+                   attempt:(NSUInteger)attempt
+{
+    INFO_LOG();
+
+    if (attempt >= self.maxRetries || ![error isKindOfClass:[NSDictionary class]])
+        return NO;
+
+    NSNumber *errorCode = @([error[@"error_code"] integerValue]);
+
+    if (![self.retryableErrorCodes containsObject:errorCode])
+        return NO;
+
+//    запрос, отклоненный из-за превышения частоты, сервер не выполнял - его можно
+//    повторить, даже если он что-то изменяет
+    if (kVKTooManyRequestsErrorCode != [errorCode integerValue] && !request.isIdempotent)
+        return NO;
+
+    return [self.budget withdrawRetry];
+}
+
+- (NSTimeInterval)delayAfterDelay:(NSTimeInterval)previousDelay
+{
+    NSTimeInterval base = MAX(0, self.baseDelay);
+    NSTimeInterval upper = MAX(base, (0 == previousDelay ? base : previousDelay) * 3);
+    double random = (double) arc4random() / UINT32_MAX;
+
+//    "decorrelated jitter": случайная задержка между базовой и утроенной предыдущей,
+//    первая - между базовой и утроенной базовой, иначе первые повторы всех клиентов совпадут
+    return MIN(self.maxDelay, base + random * (upper - base));
+}
+
+- (void)requestDidSucceed:(VKRequest *)request
+{
+    [self.budget depositSuccess];
+}
+
+#pragma mark - Private methods
+
+- (BOOL)isTransientError:(NSError *)error
+{
+    if ([NSURLErrorDomain isEqualToString:error.domain]) {
+        switch (error.code) {
+            case NSURLErrorTimedOut:
+            case NSURLErrorCannotFindHost:
+            case NSURLErrorCannotConnectToHost:
+            case NSURLErrorNetworkConnectionLost:
+            case NSURLErrorDNSLookupFailed:
+            case NSURLErrorNotConnectedToInternet:
+                return YES;
+
+            default:
+                return NO;
+        }
+    }
+
+//    код ошибки VKRequestErrorDomain равен коду состояния HTTP
+    if ([@"VKRequestErrorDomain" isEqualToString:error.domain])
+        return (429 == error.code || (error.code >= 500 && error.code < 600));
+
+    return NO;
+}
+
+@end
@@ -0,0 +1,66 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKTransport.h"
+
+
+#ifdef VK_HAS_LIBCURL
+
+/** Transport based on libcurl. Allows to perform requests without Foundation URL
+loading system.
+
+Transport is compiled only when VK_HAS_LIBCURL is defined and the SDK is linked
+with libcurl 7.32 or later. Each task is performed by curl_easy_perform on a
+background queue, events are passed to the network thread, so a Foundation
+implementation with NSRunLoop and NSThread is still required. VKRequest itself
+depends on VKUser and VKStorage, which are linked with UIKit, so the transport does
+not make the SDK usable in headless builds on its own.
+
+Request timeoutInterval limits the whole transfer (CURLOPT_TIMEOUT_MS), not only
+the idle time as in NSURLConnection.
+*/
+@interface VKCurlTransport : NSObject <VKTransport>
+
+/**
+@name Properties
+*/
+/** Timeout of the connection establishment in seconds. By default equals to 30 seconds
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval connectTimeout;
+
+/**
+@name Class methods
+*/
+/** Shared transport
+
+@return VKCurlTransport instance
+*/
++ (instancetype)sharedTransport;
+
+@end
+
+#endif
@@ -0,0 +1,474 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKCurlTransport.h"
+
+
+#ifdef VK_HAS_LIBCURL
+
+#import <curl/curl.h>
+#import "VKNetworkThread.h"
+
+
+#define kVKCurlTransportDefaultConnectTimeout 30
+
+
+/** Single curl_easy_perform call of the transport
+*/
+@interface VKCurlTask : NSObject
+{
+@public
+    NSURLRequest *_request;
+    NSInputStream *_bodyStream;
+
+    NSInteger _statusCode;
+    NSString *_HTTPVersion;
+    NSMutableDictionary *_headers;
+    int64_t _totalBytesSent;
+}
+
+@property (nonatomic, assign, readonly) BOOL isCancelled;
+
+- (instancetype)initWithTransport:(VKCurlTransport *)transport
+                          request:(NSURLRequest *)request
+                         delegate:(id <VKTransportDelegate>)delegate;
+
+- (void)perform;
+- (void)cancel;
+- (void)suspend;
+- (void)resume;
+
+- (size_t)receiveBytes:(const char *)bytes
+                length:(size_t)length;
+- (void)receiveHeaderLine:(NSString *)line;
+- (size_t)readBodyBytes:(char *)buffer
+              maxLength:(size_t)length;
+- (void)sentBodyBytes:(int64_t)totalBytesSent;
+
+@end
+
+
+static size_t VKCurlWriteCallback(char *bytes, size_t size, size_t count, void *context)
+{
+    return [(__bridge VKCurlTask *) context receiveBytes:bytes
+                                                  length:size * count];
+}
+
+static size_t VKCurlHeaderCallback(char *bytes, size_t size, size_t count, void *context)
+{
+    NSString *line = [[NSString alloc] initWithBytes:bytes
+                                              length:size * count
+                                            encoding:NSISOLatin1StringEncoding];
+
+    [(__bridge VKCurlTask *) context receiveHeaderLine:line];
+
+    return size * count;
+}
+
+static size_t VKCurlReadCallback(char *buffer, size_t size, size_t count, void *context)
+{
+    return [(__bridge VKCurlTask *) context readBodyBytes:buffer
+                                                maxLength:size * count];
+}
+
+static int VKCurlProgressCallback(void *context, curl_off_t downloadTotal, curl_off_t downloadNow, curl_off_t uploadTotal, curl_off_t uploadNow)
+{
+    VKCurlTask *task = (__bridge VKCurlTask *) context;
+
+    [task sentBodyBytes:uploadNow];
+
+//    ненулевое значение прерывает передачу
+    return (task.isCancelled ? 1 : 0);
+}
+
+
+@implementation VKCurlTransport
+
+#pragma mark Visible VKCurlTransport methods
+#pragma mark - Class methods
+
++ (instancetype)sharedTransport
+{
+    static VKCurlTransport *sharedTransport;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        sharedTransport = [[[self class] alloc] init];
+    });
+
+    return sharedTransport;
+}
+
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+        _connectTimeout = kVKCurlTransportDefaultConnectTimeout;
+    }
+
+    return self;
+}
+
+#pragma mark - VKTransport
+
+- (id)startTaskWithRequest:(NSURLRequest *)request
+                  delegate:(id <VKTransportDelegate>)delegate
+{
+    VKCurlTask *task = [[VKCurlTask alloc] initWithTransport:self
+                                                     request:request
+                                                    delegate:delegate];
+
+//    curl_easy_perform блокирует поток до окончания передачи
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^
+    {
+        [task perform];
+    });
+
+    return task;
+}
+
+- (void)cancelTask:(VKCurlTask *)task
+{
+    [task cancel];
+}
+
+- (void)suspendTask:(VKCurlTask *)task
+{
+    [task suspend];
+}
+
+- (void)resumeTask:(VKCurlTask *)task
+{
+    [task resume];
+}
+
+@end
+
+
+@implementation VKCurlTask
+{
+    VKCurlTransport *_transport;
+    id <VKTransportDelegate> _delegate;
+
+    NSCondition *_condition;
+    BOOL _isSuspended;
+}
+
+#pragma mark - Init methods
+
+- (instancetype)initWithTransport:(VKCurlTransport *)transport
+                          request:(NSURLRequest *)request
+                         delegate:(id <VKTransportDelegate>)delegate
+{
+    self = [super init];
+
+    if (self) {
+        _transport = transport;
+        _request = [request copy];
+        _delegate = delegate;
+        _condition = [[NSCondition alloc] init];
+        _headers = [[NSMutableDictionary alloc] init];
+    }
+
+    return self;
+}
+
+#pragma mark - Task control
+
+- (void)cancel
+{
+    [_condition lock];
+    _isCancelled = YES;
+    [_condition signal];
+    [_condition unlock];
+}
+
+- (void)suspend
+{
+    [_condition lock];
+    _isSuspended = YES;
+    [_condition unlock];
+}
+
+- (void)resume
+{
+    [_condition lock];
+    _isSuspended = NO;
+    [_condition signal];
+    [_condition unlock];
+}
+
+- (void)perform
+{
+    CURL *curl = curl_easy_init();
+    struct curl_slist *headerList = NULL;
+
+    curl_easy_setopt(curl, CURLOPT_URL, [[_request.URL absoluteString] UTF8String]);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long) (_transport.connectTimeout * 1000));
+
+//    VKRequest ограничивает тайм-аутом запроса и крайний срок, поэтому он
+//    относится ко всей передаче
+    if (_request.timeoutInterval > 0)
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long) (_request.timeoutInterval * 1000));
+//    пустая строка - все поддерживаемые кодировки, ответ распаковывается самим libcurl
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, VKCurlWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (__bridge void *) self);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, VKCurlHeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, (__bridge void *) self);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, VKCurlProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, (__bridge void *) self);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+//    тело запроса читается потоком, как и в NSURLConnection
+    NSString *method = (nil == _request.HTTPMethod ? @"GET" : [_request.HTTPMethod uppercaseString]);
+    long long bodyLength = -1;
+
+    if (nil != _request.HTTPBodyStream) {
+        _bodyStream = _request.HTTPBodyStream;
+        NSString *contentLength = [_request valueForHTTPHeaderField:@"Content-Length"];
+
+        if (nil != contentLength)
+            bodyLength = [contentLength longLongValue];
+    } else if (nil != _request.HTTPBody) {
+        _bodyStream = [NSInputStream inputStreamWithData:_request.HTTPBody];
+        bodyLength = (long long) [_request.HTTPBody length];
+    }
+
+    if (nil != _bodyStream) {
+        [_bodyStream open];
+
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, VKCurlReadCallback);
+        curl_easy_setopt(curl, CURLOPT_READDATA, (__bridge void *) self);
+
+        if (bodyLength >= 0)
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t) bodyLength);
+    }
+
+    if (![method isEqualToString:@"GET"] && ![method isEqualToString:@"POST"])
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, [method UTF8String]);
+
+    for (NSString *field in [_request allHTTPHeaderFields]) {
+        NSString *header = [NSString stringWithFormat:@"%@: %@",
+                                                      field,
+                                                      [_request valueForHTTPHeaderField:field]];
+        headerList = curl_slist_append(headerList, [header UTF8String]);
+    }
+
+//    не ждем "100 Continue" перед отправкой тела
+    headerList = curl_slist_append(headerList, "Expect:");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
+
+    CURLcode result = curl_easy_perform(curl);
+
+    curl_slist_free_all(headerList);
+    curl_easy_cleanup(curl);
+    [_bodyStream close];
+
+    NSError *error = nil;
+
+    if (CURLE_OK != result)
+        error = [self errorWithCode:result];
+
+    [self performOnNetworkThread:^(id <VKTransportDelegate> delegate)
+    {
+        [delegate transport:_transport
+                       task:self
+       didCompleteWithError:error];
+
+        _delegate = nil;
+    }];
+}
+
+#pragma mark - curl callbacks
+
+- (size_t)receiveBytes:(const char *)bytes
+                length:(size_t)length
+{
+//    пока задача приостановлена, сокет не читается и сервер притормаживается самим TCP
+    [_condition lock];
+
+    while (_isSuspended && !_isCancelled)
+        [_condition wait];
+
+    BOOL isCancelled = _isCancelled;
+    [_condition unlock];
+
+    if (isCancelled)
+        return 0;
+
+    NSData *data = [NSData dataWithBytes:bytes
+                                  length:length];
+
+    [self performOnNetworkThread:^(id <VKTransportDelegate> delegate)
+    {
+        [delegate transport:_transport
+                       task:self
+             didReceiveData:data];
+    }];
+
+    return length;
+}
+
+- (void)receiveHeaderLine:(NSString *)line
+{
+    NSString *trimmedLine = [line stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+
+//    строка статуса начинает новый блок заголовков (перенаправление, 100 Continue)
+    if ([trimmedLine hasPrefix:@"HTTP/"]) {
+        NSArray *components = [trimmedLine componentsSeparatedByString:@" "];
+
+        _HTTPVersion = components[0];
+        _statusCode = ([components count] > 1 ? [components[1] integerValue] : 0);
+        [_headers removeAllObjects];
+
+        return;
+    }
+
+    if (0 != [trimmedLine length]) {
+        NSRange separator = [trimmedLine rangeOfString:@":"];
+
+        if (NSNotFound != separator.location) {
+            NSString *field = [trimmedLine substringToIndex:separator.location];
+            NSString *value = [[trimmedLine substringFromIndex:separator.location + 1]
+                                            stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+
+            _headers[field] = value;
+        }
+
+        return;
+    }
+
+//    пустая строка завершает блок заголовков, промежуточные ответы делегату не нужны
+    BOOL isRedirect = (_statusCode >= 300 && _statusCode < 400 && nil != _headers[@"Location"]);
+
+    if (100 == _statusCode || isRedirect)
+        return;
+
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:_request.URL
+                                                              statusCode:_statusCode
+                                                             HTTPVersion:_HTTPVersion
+                                                            headerFields:[_headers copy]];
+
+    [self performOnNetworkThread:^(id <VKTransportDelegate> delegate)
+    {
+        [delegate transport:_transport
+                       task:self
+         didReceiveResponse:response];
+    }];
+}
+
+- (size_t)readBodyBytes:(char *)buffer
+              maxLength:(size_t)length
+{
+    if (self.isCancelled)
+        return CURL_READFUNC_ABORT;
+
+    NSInteger count = [_bodyStream read:(uint8_t *) buffer
+                              maxLength:length];
+
+    return (count < 0 ? CURL_READFUNC_ABORT : (size_t) count);
+}
+
+- (void)sentBodyBytes:(int64_t)totalBytesSent
+{
+    if (totalBytesSent == _totalBytesSent)
+        return;
+
+    _totalBytesSent = totalBytesSent;
+    int64_t totalBytesExpected = MAX(0, [[_request valueForHTTPHeaderField:@"Content-Length"] longLongValue]);
+
+    [self performOnNetworkThread:^(id <VKTransportDelegate> delegate)
+    {
+        if ([delegate respondsToSelector:@selector(transport:task:didSendBodyData:totalBytesExpectedToSend:)])
+            [delegate transport:_transport
+                           task:self
+                didSendBodyData:totalBytesSent
+       totalBytesExpectedToSend:totalBytesExpected];
+    }];
+}
+
+#pragma mark - Private methods
+
+- (void)performOnNetworkThread:(void (^)(id <VKTransportDelegate> delegate))block
+{
+//    отмена выполняется в сетевом потоке, поэтому проверка там же исключает
+//    события после отмены
+    [VKNetworkThread performBlock:^
+    {
+        if (!self.isCancelled && nil != _delegate)
+            block(_delegate);
+    }];
+}
+
+- (NSError *)errorWithCode:(CURLcode)code
+{
+    NSInteger errorCode;
+
+    switch (code) {
+        case CURLE_OPERATION_TIMEDOUT:
+            errorCode = NSURLErrorTimedOut;
+            break;
+
+        case CURLE_COULDNT_RESOLVE_HOST:
+            errorCode = NSURLErrorCannotFindHost;
+            break;
+
+        case CURLE_COULDNT_CONNECT:
+            errorCode = NSURLErrorCannotConnectToHost;
+            break;
+
+        case CURLE_ABORTED_BY_CALLBACK:
+        case CURLE_WRITE_ERROR:
+            errorCode = NSURLErrorCancelled;
+            break;
+
+        default:
+            errorCode = NSURLErrorNetworkConnectionLost;
+            break;
+    }
+
+    return [NSError errorWithDomain:NSURLErrorDomain
+                               code:errorCode
+                           userInfo:@{
+                                   NSLocalizedDescriptionKey : @(curl_easy_strerror(code)),
+                                   NSURLErrorKey             : _request.URL,
+                                   @"CURLcode"               : @(code)
+                           }];
+}
+
+@end
+
+#endif
@@ -0,0 +1,125 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKTransport.h"
+
+
+/** Default size of the response portion passed to the delegate at once
+*/
+#define kVKLoopbackTransportDefaultChunkSize (16 * 1024)
+
+
+/** Canned response of the loopback transport
+*/
+@interface VKLoopbackResponse : NSObject
+
+/**
+@name Properties
+*/
+/** HTTP status code
+*/
+@property (nonatomic, assign, readonly) NSInteger statusCode;
+
+/** HTTP headers
+*/
+@property (nonatomic, copy, readonly) NSDictionary *headers;
+
+/** Response body
+*/
+@property (nonatomic, copy, readonly) NSData *body;
+
+/**
+@name Class methods
+*/
+/** Creates response with status code 200 and JSON body
+
+@param JSONObject Foundation object which is serialized to the response body
+@return response
+*/
++ (instancetype)responseWithJSONObject:(id)JSONObject;
+
+/** Creates response. If headers contain "Content-Encoding: gzip" (or deflate), body is
+expected to be compressed: it is decompressed before delivery, while bandwidth
+is applied to the compressed size
+
+@param statusCode HTTP status code
+@param headers HTTP headers
+@param body response body
+@return response
+*/
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode
+                               headers:(NSDictionary *)headers
+                                  body:(NSData *)body;
+
+@end
+
+
+/** In-process transport which serves canned responses without any network access.
+Latency and bandwidth of the "network" can be configured, so the whole
+request/parse/cache pipeline can be benchmarked deterministically.
+*/
+@interface VKLoopbackTransport : NSObject <VKTransport>
+
+/**
+@name Properties
+*/
+/** Delay in seconds before the response headers are delivered. By default equals to 0
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval latency;
+
+/** Bandwidth in bytes per second, 0 means unlimited (default value)
+*/
+@property (nonatomic, assign, readwrite) NSUInteger bandwidth;
+
+/** Size of the response portion passed to the delegate at once.
+By default equals to kVKLoopbackTransportDefaultChunkSize
+*/
+@property (nonatomic, assign, readwrite) NSUInteger chunkSize;
+
+/** Block which returns response for the request. If it is not set or returns nil,
+responses registered with setResponse:forMethod: are used
+*/
+@property (nonatomic, copy, readwrite) VKLoopbackResponse *(^responseHandler)(NSURLRequest *request);
+
+/** Number of tasks started by the transport
+*/
+@property (nonatomic, assign, readonly) NSUInteger startedTasksCount;
+
+/**
+@name Responses
+*/
+/** Registers response for the API method. Requests to unknown methods receive
+response with status code 404
+
+@param response response
+@param methodName name of the API method (users.get, friends.get etc) or
+the last path component of the URL
+*/
+- (void)setResponse:(VKLoopbackResponse *)response
+          forMethod:(NSString *)methodName;
+
+@end
@@ -0,0 +1,367 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKLoopbackTransport.h"
+#import "VKNetworkThread.h"
+#import "NSData+zlib.h"
+
+
+/** Single request served by the loopback transport
+*/
+@interface VKLoopbackTask : NSObject
+
+- (instancetype)initWithTransport:(VKLoopbackTransport *)transport
+                         response:(VKLoopbackResponse *)response
+                          request:(NSURLRequest *)request
+                         delegate:(id <VKTransportDelegate>)delegate;
+
+- (void)start;
+- (void)cancel;
+- (void)suspend;
+- (void)resume;
+
+@end
+
+
+@implementation VKLoopbackResponse
+
+#pragma mark Visible VKLoopbackResponse methods
+#pragma mark - Class methods
+
++ (instancetype)responseWithJSONObject:(id)JSONObject
+{
+    NSData *body = [NSJSONSerialization dataWithJSONObject:JSONObject
+                                                   options:0
+                                                     error:nil];
+
+    return [self responseWithStatusCode:200
+                                headers:@{@"Content-Type" : @"application/json; charset=utf-8"}
+                                   body:body];
+}
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode
+                               headers:(NSDictionary *)headers
+                                  body:(NSData *)body
+{
+    VKLoopbackResponse *response = [[self alloc] init];
+
+    response->_statusCode = statusCode;
+    response->_headers = [headers copy];
+    response->_body = (nil == body ? [NSData data] : [body copy]);
+
+    return response;
+}
+
+@end
+
+
+@implementation VKLoopbackTransport
+{
+    NSMutableDictionary *_responses;
+}
+
+#pragma mark Visible VKLoopbackTransport methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+        _responses = [[NSMutableDictionary alloc] init];
+        _chunkSize = kVKLoopbackTransportDefaultChunkSize;
+    }
+
+    return self;
+}
+
+#pragma mark - Setters
+
+- (void)setChunkSize:(NSUInteger)chunkSize
+{
+    _chunkSize = MAX(1, chunkSize);
+}
+
+#pragma mark - Responses
+
+- (void)setResponse:(VKLoopbackResponse *)response
+          forMethod:(NSString *)methodName
+{
+    @synchronized (_responses) {
+        if (nil == response)
+            [_responses removeObjectForKey:methodName];
+        else
+            _responses[methodName] = response;
+    }
+}
+
+#pragma mark - VKTransport
+
+- (id)startTaskWithRequest:(NSURLRequest *)request
+                  delegate:(id <VKTransportDelegate>)delegate
+{
+    VKLoopbackTask *task = [[VKLoopbackTask alloc] initWithTransport:self
+                                                            response:[self responseForRequest:request]
+                                                             request:request
+                                                            delegate:delegate];
+
+    @synchronized (self) {
+        _startedTasksCount++;
+    }
+
+    [VKNetworkThread performBlock:^
+    {
+        [task start];
+    }];
+
+    return task;
+}
+
+- (void)cancelTask:(VKLoopbackTask *)task
+{
+    [task cancel];
+}
+
+- (void)suspendTask:(VKLoopbackTask *)task
+{
+    [task suspend];
+}
+
+- (void)resumeTask:(VKLoopbackTask *)task
+{
+    [task resume];
+}
+
+#pragma mark - Private methods
+
+- (VKLoopbackResponse *)responseForRequest:(NSURLRequest *)request
+{
+    VKLoopbackResponse *response = nil;
+
+    if (nil != self.responseHandler)
+        response = self.responseHandler(request);
+
+    if (nil == response) {
+        @synchronized (_responses) {
+            response = _responses[[request.URL lastPathComponent]];
+        }
+    }
+
+    if (nil == response) {
+        NSData *body = [@"{\"error\":{\"error_code\":3,\"error_msg\":\"Unknown method passed\"}}" dataUsingEncoding:NSUTF8StringEncoding];
+
+        response = [VKLoopbackResponse responseWithStatusCode:404
+                                                      headers:@{}
+                                                         body:body];
+    }
+
+    return response;
+}
+
+@end
+
+
+@implementation VKLoopbackTask
+{
+    VKLoopbackTransport *_transport;
+    VKLoopbackResponse *_response;
+    NSURLRequest *_request;
+    id <VKTransportDelegate> _delegate;
+
+    NSData *_body;
+    double _compressionRatio;
+    NSUInteger _sentBytes;
+    BOOL _isCancelled;
+    BOOL _isSuspended;
+    BOOL _isWaitingForResume;
+}
+
+#pragma mark - Init methods
+
+- (instancetype)initWithTransport:(VKLoopbackTransport *)transport
+                         response:(VKLoopbackResponse *)response
+                          request:(NSURLRequest *)request
+                         delegate:(id <VKTransportDelegate>)delegate
+{
+    self = [super init];
+
+    if (self) {
+        _transport = transport;
+        _response = response;
+        _request = request;
+        _delegate = delegate;
+        _body = response.body;
+        _compressionRatio = 1;
+
+//        сжатый ответ распаковывается, как это делают настоящие транспорты, но время
+//        передачи определяется размером сжатых данных
+        NSString *contentEncoding = [response.headers[@"Content-Encoding"] lowercaseString];
+
+        if ([@"gzip" isEqualToString:contentEncoding] || [@"deflate" isEqualToString:contentEncoding]) {
+            NSData *inflatedBody = [response.body inflatedData];
+
+            if (0 != [inflatedBody length]) {
+                _compressionRatio = (double) [response.body length] / [inflatedBody length];
+                _body = inflatedBody;
+            }
+        }
+    }
+
+    return self;
+}
+
+#pragma mark - Task control
+
+- (void)start
+{
+    if (_isCancelled)
+        return;
+
+//    тело запроса "отправляется" мгновенно
+    int64_t bodyLength = [self consumeRequestBody];
+
+    if (0 != bodyLength && [_delegate respondsToSelector:@selector(transport:task:didSendBodyData:totalBytesExpectedToSend:)])
+        [_delegate transport:_transport
+                        task:self
+             didSendBodyData:bodyLength
+    totalBytesExpectedToSend:bodyLength];
+
+    [self performSelector:@selector(sendResponse)
+               withObject:nil
+               afterDelay:_transport.latency];
+}
+
+- (void)cancel
+{
+    _isCancelled = YES;
+    _delegate = nil;
+
+    [NSObject cancelPreviousPerformRequestsWithTarget:self];
+}
+
+- (void)suspend
+{
+    _isSuspended = YES;
+}
+
+- (void)resume
+{
+    _isSuspended = NO;
+
+    if (_isWaitingForResume) {
+        _isWaitingForResume = NO;
+        [self sendNextChunk];
+    }
+}
+
+#pragma mark - Private methods
+
+- (int64_t)consumeRequestBody
+{
+    if (nil != _request.HTTPBody)
+        return (int64_t) [_request.HTTPBody length];
+
+    NSInputStream *bodyStream = _request.HTTPBodyStream;
+
+    if (nil == bodyStream)
+        return 0;
+
+    int64_t bodyLength = 0;
+    uint8_t buffer[16 * 1024];
+
+    [bodyStream open];
+
+    while (YES) {
+        NSInteger count = [bodyStream read:buffer
+                                 maxLength:sizeof(buffer)];
+
+        if (count <= 0)
+            break;
+
+        bodyLength += count;
+    }
+
+    [bodyStream close];
+
+    return bodyLength;
+}
+
+- (void)sendResponse
+{
+    if (_isCancelled)
+        return;
+
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:_request.URL
+                                                              statusCode:_response.statusCode
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:_response.headers];
+
+    [_delegate transport:_transport
+                    task:self
+      didReceiveResponse:response];
+
+    [self sendNextChunk];
+}
+
+- (void)sendNextChunk
+{
+    if (_isCancelled)
+        return;
+
+    if (_isSuspended) {
+        _isWaitingForResume = YES;
+        return;
+    }
+
+    NSData *body = _body;
+
+    if (_sentBytes >= [body length]) {
+        id <VKTransportDelegate> delegate = _delegate;
+        _delegate = nil;
+
+        [delegate transport:_transport
+                       task:self
+       didCompleteWithError:nil];
+
+        return;
+    }
+
+    NSRange range = NSMakeRange(_sentBytes, MIN(_transport.chunkSize, [body length] - _sentBytes));
+    _sentBytes += range.length;
+
+    [_delegate transport:_transport
+                    task:self
+          didReceiveData:[body subdataWithRange:range]];
+
+//    время передачи очередной порции определяется пропускной способностью
+    NSTimeInterval delay = (0 == _transport.bandwidth ? 0 : range.length * _compressionRatio / _transport.bandwidth);
+
+    [self performSelector:@selector(sendNextChunk)
+               withObject:nil
+               afterDelay:delay];
+}
+
+@end
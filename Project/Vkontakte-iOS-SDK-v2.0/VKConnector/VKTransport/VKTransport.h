@@ -0,0 +1,149 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+@protocol VKTransport;
+
+
+/** Protocol of the transport task delegate (VKRequest).
+
+All methods are called on the network thread (see VKNetworkThread). After
+the task is cancelled delegate does not receive any messages.
+*/
+@protocol VKTransportDelegate <NSObject>
+
+@required
+/**
+@name Required
+*/
+/** Is called when response headers are received
+
+@param transport transport
+@param task task returned by startTaskWithRequest:delegate:
+@param response HTTP response
+*/
+- (void)transport:(id <VKTransport>)transport
+             task:(id)task
+didReceiveResponse:(NSHTTPURLResponse *)response;
+
+/** Is called with the next portion of the response body. Transport removes
+Content-Encoding (gzip, deflate), so data is always uncompressed
+
+@param transport transport
+@param task task
+@param data next portion of the response body
+*/
+- (void)transport:(id <VKTransport>)transport
+             task:(id)task
+   didReceiveData:(NSData *)data;
+
+/** Is called when task is completed
+
+@param transport transport
+@param task task
+@param error nil if response was received completely, otherwise connection error
+*/
+- (void)     transport:(id <VKTransport>)transport
+                  task:(id)task
+  didCompleteWithError:(NSError *)error;
+
+@optional
+/**
+@name Optional
+*/
+/** Is called when the next portion of the request body is sent
+
+@param transport transport
+@param task task
+@param totalBytesSent number of sent bytes
+@param totalBytesExpectedToSend size of the request body, 0 if unknown
+*/
+- (void)           transport:(id <VKTransport>)transport
+                        task:(id)task
+              didSendBodyData:(int64_t)totalBytesSent
+    totalBytesExpectedToSend:(int64_t)totalBytesExpectedToSend;
+
+/** Is called when request body stream has to be sent again (for example after redirect)
+
+@param transport transport
+@param task task
+@return new unopened stream with the same content
+*/
+- (NSInputStream *)transport:(id <VKTransport>)transport
+               needNewBodyStreamForTask:(id)task;
+
+@end
+
+
+/** Transport performs HTTP requests on behalf of VKRequest. Different transports
+can be used by different requests, see VKRequest transport property.
+
+Available transports:
+
+- VKURLConnectionTransport - NSURLConnection (default)
+- VKURLSessionTransport - NSURLSession (iOS 7 and later), reuses connections
+- VKCurlTransport - libcurl, only when the SDK is built with VK_HAS_LIBCURL
+- VKLoopbackTransport - in-process canned responses with configurable latency and bandwidth
+*/
+@protocol VKTransport <NSObject>
+
+@required
+/**
+@name Required
+*/
+/** Starts the task. Can be called from any thread
+
+@param request request to perform
+@param delegate delegate which receives task events on the network thread, is
+retained until task is completed or cancelled
+@return opaque task object
+*/
+- (id)startTaskWithRequest:(NSURLRequest *)request
+                  delegate:(id <VKTransportDelegate>)delegate;
+
+/** Cancels the task, delegate does not receive any messages afterwards. Should be
+called on the network thread
+
+@param task task
+*/
+- (void)cancelTask:(id)task;
+
+/** Stops reading response of the task until resumeTask: is called. Should be
+called on the network thread
+
+@param task task
+*/
+- (void)suspendTask:(id)task;
+
+/** Resumes reading response of the task. Should be called on the network thread
+
+@param task task
+*/
+- (void)resumeTask:(id)task;
+
+@end
@@ -0,0 +1,203 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKURLConnectionTransport.h"
+#import "VKNetworkThread.h"
+
+
+/** Single connection of the transport
+*/
+@interface VKURLConnectionTask : NSObject <NSURLConnectionDataDelegate>
+
+@property (nonatomic, strong, readwrite) NSURLConnection *connection;
+
+- (instancetype)initWithTransport:(VKURLConnectionTransport *)transport
+                         delegate:(id <VKTransportDelegate>)delegate;
+
+- (void)cancel;
+
+@end
+
+
+@implementation VKURLConnectionTransport
+
+#pragma mark Visible VKURLConnectionTransport methods
+#pragma mark - Class methods
+
++ (instancetype)sharedTransport
+{
+    static VKURLConnectionTransport *sharedTransport;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        sharedTransport = [[[self class] alloc] init];
+    });
+
+    return sharedTransport;
+}
+
+#pragma mark - VKTransport
+
+- (id)startTaskWithRequest:(NSURLRequest *)request
+                  delegate:(id <VKTransportDelegate>)delegate
+{
+    VKURLConnectionTask *task = [[VKURLConnectionTask alloc] initWithTransport:self
+                                                                      delegate:delegate];
+
+    NSURLConnection *connection = [[NSURLConnection alloc]
+                                                    initWithRequest:request
+                                                           delegate:task
+                                                   startImmediately:NO];
+
+    [connection scheduleInRunLoop:[VKNetworkThread runLoop]
+                          forMode:NSDefaultRunLoopMode];
+
+    task.connection = connection;
+    [connection start];
+
+    return task;
+}
+
+- (void)cancelTask:(VKURLConnectionTask *)task
+{
+    [task cancel];
+}
+
+- (void)suspendTask:(VKURLConnectionTask *)task
+{
+//    пока соединение не обслуживается циклом выполнения, данные из сокета не читаются
+    [task.connection unscheduleFromRunLoop:[VKNetworkThread runLoop]
+                                   forMode:NSDefaultRunLoopMode];
+}
+
+- (void)resumeTask:(VKURLConnectionTask *)task
+{
+    [task.connection scheduleInRunLoop:[VKNetworkThread runLoop]
+                               forMode:NSDefaultRunLoopMode];
+}
+
+@end
+
+
+@implementation VKURLConnectionTask
+{
+    VKURLConnectionTransport *_transport;
+    id <VKTransportDelegate> _delegate;
+}
+
+#pragma mark - Init methods
+
+- (instancetype)initWithTransport:(VKURLConnectionTransport *)transport
+                         delegate:(id <VKTransportDelegate>)delegate
+{
+    self = [super init];
+
+    if (self) {
+        _transport = transport;
+        _delegate = delegate;
+    }
+
+    return self;
+}
+
+- (void)cancel
+{
+    [self.connection cancel];
+    [self complete];
+}
+
+#pragma mark - NSURLConnectionDataDelegate
+
+- (void)connection:(NSURLConnection *)connection
+didReceiveResponse:(NSURLResponse *)response
+{
+    [_delegate transport:_transport
+                    task:self
+      didReceiveResponse:(NSHTTPURLResponse *) response];
+}
+
+- (void)connection:(NSURLConnection *)connection
+    didReceiveData:(NSData *)data
+{
+    [_delegate transport:_transport
+                    task:self
+          didReceiveData:data];
+}
+
+- (void)connection:(NSURLConnection *)connection
+   didSendBodyData:(NSInteger)bytesWritten
+        totalBytesWritten:(NSInteger)totalBytesWritten
+totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
+{
+    if ([_delegate respondsToSelector:@selector(transport:task:didSendBodyData:totalBytesExpectedToSend:)])
+        [_delegate transport:_transport
+                        task:self
+             didSendBodyData:totalBytesWritten
+    totalBytesExpectedToSend:MAX(0, totalBytesExpectedToWrite)];
+}
+
+- (NSInputStream *)connection:(NSURLConnection *)connection
+            needNewBodyStream:(NSURLRequest *)request
+{
+    if ([_delegate respondsToSelector:@selector(transport:needNewBodyStreamForTask:)])
+        return [_delegate transport:_transport
+           needNewBodyStreamForTask:self];
+
+    return nil;
+}
+
+- (void)connectionDidFinishLoading:(NSURLConnection *)connection
+{
+    id <VKTransportDelegate> delegate = _delegate;
+    [self complete];
+
+    [delegate transport:_transport
+                   task:self
+   didCompleteWithError:nil];
+}
+
+- (void)connection:(NSURLConnection *)connection
+  didFailWithError:(NSError *)error
+{
+    id <VKTransportDelegate> delegate = _delegate;
+    [self complete];
+
+    [delegate transport:_transport
+                   task:self
+   didCompleteWithError:error];
+}
+
+#pragma mark - Private methods
+
+- (void)complete
+{
+//    соединение удерживает задачу, а задача - соединение: разрываем цикл
+    self.connection = nil;
+    _delegate = nil;
+}
+
+@end
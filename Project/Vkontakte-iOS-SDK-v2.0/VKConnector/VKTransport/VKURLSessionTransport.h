@@ -0,0 +1,71 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+#import "VKTransport.h"
+
+
+/** Transport based on NSURLSession. All requests share one session, so connections
+to api.vk.com are reused (and multiplexed when server supports HTTP/2).
+
+NSURLSession is available since iOS 7, on earlier systems sharedTransport
+returns nil and VKURLConnectionTransport should be used.
+*/
+@interface VKURLSessionTransport : NSObject <VKTransport, NSURLSessionDataDelegate>
+
+/**
+@name Properties
+*/
+/** Session used by the transport
+*/
+@property (nonatomic, strong, readonly) NSURLSession *session;
+
+/**
+@name Class methods
+*/
+/** Checks if NSURLSession is available on the current system
+
+@return YES if transport can be used
+*/
++ (BOOL)isAvailable;
+
+/** Shared transport with default session configuration
+
+@return VKURLSessionTransport instance or nil if NSURLSession is not available
+*/
++ (instancetype)sharedTransport;
+
+/**
+@name Init methods
+*/
+/** Creates transport with the session configuration
+
+@param configuration session configuration
+@return VKURLSessionTransport instance or nil if NSURLSession is not available
+*/
+- (instancetype)initWithConfiguration:(NSURLSessionConfiguration *)configuration;
+
+@end
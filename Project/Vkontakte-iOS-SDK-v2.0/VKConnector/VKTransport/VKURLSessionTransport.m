@@ -0,0 +1,216 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKURLSessionTransport.h"
+#import "VKNetworkThread.h"
+
+
+@implementation VKURLSessionTransport
+{
+//    делегаты задач, доступ только из сетевого потока
+    NSMutableDictionary *_delegates;
+}
+
+#pragma mark Visible VKURLSessionTransport methods
+#pragma mark - Class methods
+
++ (BOOL)isAvailable
+{
+    return (nil != NSClassFromString(@"NSURLSession"));
+}
+
++ (instancetype)sharedTransport
+{
+    static VKURLSessionTransport *sharedTransport;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^
+    {
+        if ([self isAvailable])
+            sharedTransport = [[[self class] alloc] initWithConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration]];
+    });
+
+    return sharedTransport;
+}
+
+#pragma mark - Init methods
+
+- (instancetype)initWithConfiguration:(NSURLSessionConfiguration *)configuration
+{
+    if (![[self class] isAvailable])
+        return nil;
+
+    self = [super init];
+
+    if (self) {
+        _delegates = [[NSMutableDictionary alloc] init];
+
+//        события сессии все равно передаются в сетевой поток, поэтому
+//        достаточно одного потока очереди
+        NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+        delegateQueue.maxConcurrentOperationCount = 1;
+
+        _session = [NSURLSession sessionWithConfiguration:configuration
+                                                 delegate:self
+                                            delegateQueue:delegateQueue];
+    }
+
+    return self;
+}
+
+#pragma mark - VKTransport
+
+- (id)startTaskWithRequest:(NSURLRequest *)request
+                  delegate:(id <VKTransportDelegate>)delegate
+{
+    NSURLSessionDataTask *task = [self.session dataTaskWithRequest:request];
+
+//    задача запускается после регистрации делегата, иначе события могут его опередить
+    [VKNetworkThread performBlock:^
+    {
+        _delegates[@(task.taskIdentifier)] = delegate;
+        [task resume];
+    }];
+
+    return task;
+}
+
+- (void)cancelTask:(NSURLSessionTask *)task
+{
+    [_delegates removeObjectForKey:@(task.taskIdentifier)];
+    [task cancel];
+}
+
+- (void)suspendTask:(NSURLSessionTask *)task
+{
+    [task suspend];
+}
+
+- (void)resumeTask:(NSURLSessionTask *)task
+{
+    [task resume];
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+didReceiveResponse:(NSURLResponse *)response
+ completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler
+{
+    completionHandler(NSURLSessionResponseAllow);
+
+    [self performForTask:dataTask
+                   block:^(id <VKTransportDelegate> delegate)
+                   {
+                       [delegate transport:self
+                                      task:dataTask
+                        didReceiveResponse:(NSHTTPURLResponse *) response];
+                   }];
+}
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+    didReceiveData:(NSData *)data
+{
+    [self performForTask:dataTask
+                   block:^(id <VKTransportDelegate> delegate)
+                   {
+                       [delegate transport:self
+                                      task:dataTask
+                            didReceiveData:data];
+                   }];
+}
+
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)task
+   didSendBodyData:(int64_t)bytesSent
+    totalBytesSent:(int64_t)totalBytesSent
+totalBytesExpectedToSend:(int64_t)totalBytesExpectedToSend
+{
+    [self performForTask:task
+                   block:^(id <VKTransportDelegate> delegate)
+                   {
+                       if ([delegate respondsToSelector:@selector(transport:task:didSendBodyData:totalBytesExpectedToSend:)])
+                           [delegate transport:self
+                                          task:task
+                               didSendBodyData:totalBytesSent
+                      totalBytesExpectedToSend:MAX(0, totalBytesExpectedToSend)];
+                   }];
+}
+
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)task
+ needNewBodyStream:(void (^)(NSInputStream *bodyStream))completionHandler
+{
+    [VKNetworkThread performBlock:^
+    {
+        id <VKTransportDelegate> delegate = _delegates[@(task.taskIdentifier)];
+        NSInputStream *bodyStream = nil;
+
+        if ([delegate respondsToSelector:@selector(transport:needNewBodyStreamForTask:)])
+            bodyStream = [delegate transport:self
+                    needNewBodyStreamForTask:task];
+
+        completionHandler(bodyStream);
+    }];
+}
+
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)task
+didCompleteWithError:(NSError *)error
+{
+    [VKNetworkThread performBlock:^
+    {
+        id <VKTransportDelegate> delegate = _delegates[@(task.taskIdentifier)];
+
+        if (nil == delegate)
+            return;
+
+        [_delegates removeObjectForKey:@(task.taskIdentifier)];
+
+        [delegate transport:self
+                       task:task
+       didCompleteWithError:error];
+    }];
+}
+
+#pragma mark - Private methods
+
+- (void)performForTask:(NSURLSessionTask *)task
+                 block:(void (^)(id <VKTransportDelegate> delegate))block
+{
+//    делегат проверяется уже в сетевом потоке: отмененная задача событий не получает
+    [VKNetworkThread performBlock:^
+    {
+        id <VKTransportDelegate> delegate = _delegates[@(task.taskIdentifier)];
+
+        if (nil != delegate)
+            block(delegate);
+    }];
+}
+
+@end
@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 //
 #import <Foundation/Foundation.h>
+#import "VKCacheLogStore.h"
 
 /** Основной ключ используемый для хранения информации о токенах доступа содержащихся
 в хранилище.
@@ -49,6 +50,14 @@ static NSString *const kVKStoragePath = @"/Vkontakte-iOS-SDK-v2.0-Storage/";
  */
 static NSString *const kVKStorageCachePath = @"/Vkontakte-iOS-SDK-v2.0-Storage/Cache/";
 
+/** Default maximum size of cached data of all users in bytes
+ */
+#define kVKStorageDefaultCacheCapacity (50 * 1024 * 1024)
+
+/** Default maximum size of cached data of one user in bytes
+ */
+#define kVKStorageDefaultCacheCapacityPerUser (20 * 1024 * 1024)
+
 
 @class VKStorageItem;
 @class VKAccessToken;
@@ -82,6 +91,25 @@ static NSString *const kVKStorageCachePath = @"/Vkontakte-iOS-SDK-v2.0-Storage/C
 */
 @property (nonatomic, readonly) NSString *fullCacheStoragePath;
 
+/** Maximum size of cached data of all users in bytes, 0 means unlimited.
+ Capacity is checked against the total size of all users' caches, so one user's
+ cache can take all the space the other users do not use, but no more than
+ cacheCapacityPerUser. When capacity is exceeded, every user's cache is reduced in
+ proportion to its size (see VKCacheQuota).
+ By default equals to kVKStorageDefaultCacheCapacity
+ */
+@property (nonatomic, assign, readwrite) unsigned long long cacheCapacity;
+
+/** Maximum size of cached data of one user in bytes, 0 means unlimited.
+ By default equals to kVKStorageDefaultCacheCapacityPerUser
+ */
+@property (nonatomic, assign, readwrite) unsigned long long cacheCapacityPerUser;
+
+/** Order in which cached entries are evicted when capacity is exceeded.
+ By default equals to VKCacheEvictionPolicyLRU
+ */
+@property (nonatomic, assign, readwrite) VKCacheEvictionPolicy cacheEvictionPolicy;
+
 /**
 @name Instance initialization
 */
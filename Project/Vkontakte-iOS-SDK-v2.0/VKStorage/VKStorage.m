@@ -36,6 +36,7 @@
 @implementation VKStorage
 {
     NSMutableDictionary *_storageItems;
+    VKCacheQuota *_cacheQuota;
 }
 
 #pragma mark Visible VKStorage methods
@@ -49,8 +50,13 @@
 
     if (self) {
         _storageItems = [[NSMutableDictionary alloc] init];
+        _cacheQuota = [[VKCacheQuota alloc] init];
+        _cacheCapacity = kVKStorageDefaultCacheCapacity;
+        _cacheCapacityPerUser = kVKStorageDefaultCacheCapacityPerUser;
+        _cacheEvictionPolicy = VKCacheEvictionPolicyLRU;
 
         [self loadStorage];
+        [self applyCacheCapacity];
     }
 
     return self;
@@ -87,6 +93,35 @@
     return sharedStorage;
 }
 
+#pragma mark - Setters
+
+- (void)setCacheCapacity:(unsigned long long)cacheCapacity
+{
+    INFO_LOG();
+
+    _cacheCapacity = cacheCapacity;
+
+    [self applyCacheCapacity];
+}
+
+- (void)setCacheCapacityPerUser:(unsigned long long)cacheCapacityPerUser
+{
+    INFO_LOG();
+
+    _cacheCapacityPerUser = cacheCapacityPerUser;
+
+    [self applyCacheCapacity];
+}
+
+- (void)setCacheEvictionPolicy:(VKCacheEvictionPolicy)cacheEvictionPolicy
+{
+    INFO_LOG();
+
+    _cacheEvictionPolicy = cacheEvictionPolicy;
+
+    [self applyCacheCapacity];
+}
+
 #pragma mark - Getters
 
 - (BOOL)isEmpty
@@ -133,6 +168,7 @@
     id storageKey = @(item.accessToken.userID);
     _storageItems[storageKey] = item;
 
+    [self applyCacheCapacity];
     [self saveStorage];
 }
 
@@ -142,9 +178,11 @@
 
     id storageKey = @(item.accessToken.userID);
 
+    [_cacheQuota removeStore:item.cachedData.store];
     [item.cachedData removeCachedDataDirectory];
     [_storageItems removeObjectForKey:storageKey];
 
+    [self applyCacheCapacity];
     [self saveStorage];
 }
 
@@ -152,6 +190,9 @@
 {
     INFO_LOG();
 
+    for (VKStorageItem *item in [_storageItems allValues])
+        [_cacheQuota removeStore:item.cachedData.store];
+
     [_storageItems removeAllObjects];
     [self cleanCachedData];
 
@@ -207,6 +248,22 @@
 
 #pragma mark - Storage hidden methods
 
+- (void)applyCacheCapacity
+{
+    INFO_LOG();
+
+//    общий объем не делится между пользователями заранее: он проверяется по
+//    суммарному размеру их кэшей, вытеснение выполняется в фоне и порциями
+    _cacheQuota.capacity = self.cacheCapacity;
+
+    for (VKStorageItem *item in [_storageItems allValues]) {
+        item.cachedData.store.evictionPolicy = self.cacheEvictionPolicy;
+        item.cachedData.store.capacity = self.cacheCapacityPerUser;
+
+        [_cacheQuota addStore:item.cachedData.store];
+    }
+}
+
 - (void)loadStorage
 {
     INFO_LOG();
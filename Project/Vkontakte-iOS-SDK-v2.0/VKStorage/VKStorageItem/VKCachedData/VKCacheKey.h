@@ -0,0 +1,77 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Computes MurmurHash3 x64 128-bit hash of the data
+
+@param data bytes to hash
+@param length number of bytes
+@param seed hash seed
+@param hash array of two 64-bit words the hash is written to
+*/
+void VKMurmurHash3_x64_128(const void *data, size_t length, uint32_t seed, uint64_t hash[2]);
+
+
+/** Builds keys under which responses are stored in the cache.
+
+Key of the API method request is computed from the method name and options
+directly, without building and parsing URL: parameters are sorted by the bytes of
+their names (names are case sensitive), access_token is skipped (it changes with
+every login, but the response does not), values are taken by description as in
+the request URL. Every name and value of the canonical form is prefixed with its
+length in bytes, so separators inside them can not make different options look
+the same. The canonical form is hashed with MurmurHash3 x64 128-bit, key is 32 hex
+digits.
+
+URL of the API method request (https://api.vk.com/method/...) is parsed back into
+the method name and options, so it gets the same key regardless of the order of
+its parameters. Keys of other requests are computed from the URL as is,
+access_token parameter is removed from the query.
+*/
+@interface VKCacheKey : NSObject
+
+/**
+@name Keys
+*/
+/** Returns key of the API method request
+
+@param methodName API method name
+@param options parameters of the method
+@return 32 hex digits
+*/
++ (NSString *)keyForMethod:(NSString *)methodName
+                   options:(NSDictionary *)options;
+
+/** Returns key of the request to the URL
+
+@param url request URL
+@return 32 hex digits
+*/
++ (NSString *)keyForURL:(NSURL *)url;
+
+@end
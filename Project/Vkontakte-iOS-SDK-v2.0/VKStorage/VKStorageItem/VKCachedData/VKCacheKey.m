@@ -0,0 +1,312 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKCacheKey.h"
+
+
+static NSString *const kVKCacheKeyAccessTokenParameter = @"access_token";
+
+//    совпадает с kVKAPIURLPrefix, хранилище от VKRequest не зависит
+static NSString *const kVKCacheKeyAPIURLPrefix = @"https://api.vk.com/method/";
+
+
+#pragma mark - MurmurHash3
+
+static inline uint64_t VKRotl64(uint64_t x, int8_t r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t VKFmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+
+    return k;
+}
+
+void VKMurmurHash3_x64_128(const void *data, size_t length, uint32_t seed, uint64_t hash[2])
+{
+    const uint8_t *bytes = (const uint8_t *) data;
+    const size_t blocksCount = length / 16;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+
+    for (size_t i = 0; i < blocksCount; i++) {
+        uint64_t k1;
+        uint64_t k2;
+
+//        блоки читаются через memcpy - данные могут быть не выровнены
+        memcpy(&k1, bytes + i * 16, sizeof(k1));
+        memcpy(&k2, bytes + i * 16 + 8, sizeof(k2));
+
+        k1 = CFSwapInt64LittleToHost(k1);
+        k2 = CFSwapInt64LittleToHost(k2);
+
+        k1 *= c1;
+        k1 = VKRotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+
+        h1 = VKRotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = VKRotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+
+        h2 = VKRotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uint8_t *tail = bytes + blocksCount * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    switch (length & 15) {
+        case 15: k2 ^= ((uint64_t) tail[14]) << 48;
+        case 14: k2 ^= ((uint64_t) tail[13]) << 40;
+        case 13: k2 ^= ((uint64_t) tail[12]) << 32;
+        case 12: k2 ^= ((uint64_t) tail[11]) << 24;
+        case 11: k2 ^= ((uint64_t) tail[10]) << 16;
+        case 10: k2 ^= ((uint64_t) tail[9]) << 8;
+        case 9:
+            k2 ^= ((uint64_t) tail[8]);
+            k2 *= c2;
+            k2 = VKRotl64(k2, 33);
+            k2 *= c1;
+            h2 ^= k2;
+
+        case 8: k1 ^= ((uint64_t) tail[7]) << 56;
+        case 7: k1 ^= ((uint64_t) tail[6]) << 48;
+        case 6: k1 ^= ((uint64_t) tail[5]) << 40;
+        case 5: k1 ^= ((uint64_t) tail[4]) << 32;
+        case 4: k1 ^= ((uint64_t) tail[3]) << 24;
+        case 3: k1 ^= ((uint64_t) tail[2]) << 16;
+        case 2: k1 ^= ((uint64_t) tail[1]) << 8;
+        case 1:
+            k1 ^= ((uint64_t) tail[0]);
+            k1 *= c1;
+            k1 = VKRotl64(k1, 31);
+            k1 *= c2;
+            h1 ^= k1;
+
+        default:
+            break;
+    }
+
+    h1 ^= length;
+    h2 ^= length;
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = VKFmix64(h1);
+    h2 = VKFmix64(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    hash[0] = h1;
+    hash[1] = h2;
+}
+
+
+@implementation VKCacheKey
+
+#pragma mark Visible VKCacheKey methods
+#pragma mark - Keys
+
++ (NSString *)keyForMethod:(NSString *)methodName
+                   options:(NSDictionary *)options
+{
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionaryWithCapacity:[options count]];
+
+    [options enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop)
+    {
+        NSString *parameter = [key description];
+
+//        токен доступа в ключ не входит; регистр остальных имен не меняется,
+//        иначе параметры, отличающиеся только регистром, заменяли бы друг друга
+        if (NSOrderedSame != [kVKCacheKeyAccessTokenParameter caseInsensitiveCompare:parameter])
+            parameters[parameter] = [obj description];
+    }];
+
+//    порядок определяется кодами символов, а не правилами текущей локали
+    NSArray *sortedParameters = [[parameters allKeys] sortedArrayUsingComparator:^NSComparisonResult(NSString *parameter1, NSString *parameter2)
+    {
+        return [parameter1 compare:parameter2
+                           options:NSLiteralSearch];
+    }];
+    NSMutableData *canonicalForm = [NSMutableData dataWithCapacity:256];
+
+//    каждое поле предваряется своей длиной: разделители внутри имен и значений
+//    не должны превращать один набор параметров в другой
+    [self appendField:methodName
+               toData:canonicalForm];
+
+    for (NSString *parameter in sortedParameters) {
+        [self appendField:parameter
+                   toData:canonicalForm];
+        [self appendField:parameters[parameter]
+                   toData:canonicalForm];
+    }
+
+    return [self keyForData:canonicalForm];
+}
+
++ (NSString *)keyForURL:(NSURL *)url
+{
+    NSString *urlString = [url absoluteString];
+    NSString *APIKey = [self keyForAPIURLString:urlString];
+
+    if (nil != APIKey)
+        return APIKey;
+
+    NSRange queryStart = [urlString rangeOfString:@"?"];
+
+    if (NSNotFound == queryStart.location)
+        return [self keyForData:[urlString dataUsingEncoding:NSUTF8StringEncoding]];
+
+    NSMutableData *canonicalForm = [NSMutableData dataWithCapacity:[urlString length]];
+
+    [self appendString:[urlString substringToIndex:queryStart.location + 1]
+                toData:canonicalForm];
+
+    BOOL isFirstParameter = YES;
+    NSString *query = [urlString substringFromIndex:queryStart.location + 1];
+
+    for (NSString *parameter in [query componentsSeparatedByString:@"&"]) {
+        NSRange nameEnd = [parameter rangeOfString:@"="];
+        NSString *name = (NSNotFound == nameEnd.location ? parameter : [parameter substringToIndex:nameEnd.location]);
+
+        if ([kVKCacheKeyAccessTokenParameter isEqualToString:name])
+            continue;
+
+        if (!isFirstParameter)
+            [canonicalForm appendBytes:"&"
+                                length:1];
+
+        [self appendString:parameter
+                    toData:canonicalForm];
+        isFirstParameter = NO;
+    }
+
+    return [self keyForData:canonicalForm];
+}
+
+#pragma mark - Private methods
+
++ (NSString *)keyForAPIURLString:(NSString *)urlString
+{
+    if (![urlString hasPrefix:kVKCacheKeyAPIURLPrefix])
+        return nil;
+
+//    запрос к методу API по URL должен попадать в ту же запись кэша, что и запрос,
+//    созданный с именем метода и параметрами, - порядок параметров в URL не важен
+    NSString *path = [urlString substringFromIndex:[kVKCacheKeyAPIURLPrefix length]];
+    NSRange queryStart = [path rangeOfString:@"?"];
+    NSString *methodName = (NSNotFound == queryStart.location ? path : [path substringToIndex:queryStart.location]);
+
+    if (0 == [methodName length] || NSNotFound != [methodName rangeOfString:@"/"].location)
+        return nil;
+
+    NSMutableDictionary *options = [NSMutableDictionary dictionary];
+
+    if (NSNotFound != queryStart.location) {
+        NSString *query = [path substringFromIndex:queryStart.location + 1];
+
+        for (NSString *parameter in [query componentsSeparatedByString:@"&"]) {
+            if (0 == [parameter length])
+                continue;
+
+            NSRange nameEnd = [parameter rangeOfString:@"="];
+            NSString *name = (NSNotFound == nameEnd.location ? parameter : [parameter substringToIndex:nameEnd.location]);
+            NSString *value = (NSNotFound == nameEnd.location ? @"" : [parameter substringFromIndex:nameEnd.location + 1]);
+            NSString *decodedValue = [value stringByReplacingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
+
+            options[name] = (nil == decodedValue ? value : decodedValue);
+        }
+    }
+
+    return [self keyForMethod:methodName
+                      options:options];
+}
+
++ (void)appendString:(NSString *)string
+              toData:(NSMutableData *)data
+{
+    const char *bytes = [string UTF8String];
+
+    if (NULL != bytes)
+        [data appendBytes:bytes
+                   length:strlen(bytes)];
+}
+
++ (void)appendField:(NSString *)field
+              toData:(NSMutableData *)data
+{
+    NSData *bytes = [field dataUsingEncoding:NSUTF8StringEncoding];
+    NSString *length = [NSString stringWithFormat:@"%lu:", (unsigned long) [bytes length]];
+
+    [self appendString:length
+                toData:data];
+    [data appendData:bytes];
+}
+
++ (NSString *)keyForData:(NSData *)data
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    uint64_t hash[2];
+    VKMurmurHash3_x64_128([data bytes], [data length], 0, hash);
+
+    char key[33];
+
+    for (NSUInteger i = 0; i < 16; i++) {
+        uint8_t byte = (uint8_t) (hash[i / 8] >> (56 - 8 * (i % 8)));
+
+        key[2 * i] = hexDigits[byte >> 4];
+        key[2 * i + 1] = hexDigits[byte & 0x0f];
+    }
+
+    key[32] = '\0';
+
+    return [[NSString alloc] initWithBytes:key
+                                    length:32
+                                  encoding:NSASCIIStringEncoding];
+}
+
+@end
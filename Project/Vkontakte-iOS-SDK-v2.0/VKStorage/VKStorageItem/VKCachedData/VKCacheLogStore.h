@@ -0,0 +1,321 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Default maximum size of one segment file in bytes
+*/
+#define kVKCacheLogStoreDefaultMaxSegmentSize (4 * 1024 * 1024)
+
+/** Default fraction of dead bytes which makes sealed segment a subject to compaction
+*/
+#define kVKCacheLogStoreDefaultCompactionThreshold 0.5
+
+/** Default number of changes after which index file is saved in the background
+*/
+#define kVKCacheLogStoreDefaultIndexSaveInterval 256
+
+/** When capacity is exceeded, store is reduced until size of its segment files is
+not greater than this fraction of capacity
+*/
+#define kVKCacheLogStoreEvictionTargetRatio 0.9
+
+/** Default minimum interval in seconds between two background sweeps of expired
+entries
+*/
+#define kVKCacheLogStoreDefaultSweepInterval 60
+
+
+/** Policies which define the order entries are evicted in when store capacity is
+exceeded
+*/
+typedef enum
+{
+
+    VKCacheEvictionPolicyLRU = 0, // least recently used entries are evicted first
+    VKCacheEvictionPolicyLFU,     // least frequently used entries are evicted first
+
+} VKCacheEvictionPolicy;
+
+
+@class VKCacheQuota;
+
+
+/** Log-structured storage of cache entries.
+
+All entries of the store live in a few append-only segment files inside one
+directory instead of a file per entry. Adding an entry appends one record to the
+active segment, removing an entry appends a small tombstone record. Every record
+keeps the entry key, its data and expiration time.
+
+In-memory index maps every key to the segment, offset and length of its latest
+record. Segments are mapped into memory, so reading an entry makes no syscalls in
+most cases and returned data is not copied: it references the mapped segment. Index is saved to the compact
+index file from time to time and when synchronize is called; on startup it is
+loaded from this file and records appended after the last save are replayed from
+the segments' tails. If the index file does not exist, it is rebuilt by scanning
+all segments.
+
+When a segment reaches maxSegmentSize, a new active segment is started. Sealed
+segments in which the fraction of dead bytes (overwritten and removed entries)
+exceeds compactionThreshold are compacted in the background: their live records
+are moved to the active segment and the segment file is deleted.
+
+Store can be bounded by capacity. Index keeps time of the last access and number
+of accesses of every entry (they are saved in the index file too). When size of
+segment files exceeds capacity, the store is reduced in the background: first the
+segments with the most dead bytes are compacted, and only if that is not enough,
+entries are evicted in small batches according to evictionPolicy and their space
+is reclaimed by compaction as well. Several stores can also share one byte limit,
+see VKCacheQuota.
+
+Index also keeps entries ordered by expiration time in a binary heap. Expired
+entries are removed in the background in small batches (their tombstones are
+written with one call) no earlier than the nearest expiration time and no more
+often than once in sweepInterval seconds (the first sweep happens not earlier than
+sweepInterval seconds after the store is opened), so reading entries never has to remove
+them. Entries with zero expiration time never expire, but they still can be
+evicted.
+
+All methods are thread safe.
+*/
+@interface VKCacheLogStore : NSObject
+
+/**
+@name Properties
+*/
+/** Directory where segments and index are stored
+*/
+@property (nonatomic, copy, readonly) NSString *directoryPath;
+
+/** Maximum size of one segment file in bytes. Record which is larger than this
+value is written to a segment of its own.
+By default equals to kVKCacheLogStoreDefaultMaxSegmentSize
+*/
+@property (nonatomic, assign, readwrite) NSUInteger maxSegmentSize;
+
+/** Fraction of dead bytes (from 0 to 1) which makes sealed segment a subject to
+compaction. By default equals to kVKCacheLogStoreDefaultCompactionThreshold
+*/
+@property (nonatomic, assign, readwrite) double compactionThreshold;
+
+/** Number of changes after which index file is saved in the background.
+By default equals to kVKCacheLogStoreDefaultIndexSaveInterval
+*/
+@property (nonatomic, assign, readwrite) NSUInteger indexSaveInterval;
+
+/** Maximum size of segment files in bytes (live entries together with overwritten
+and removed records), 0 means unlimited (default)
+*/
+@property (nonatomic, assign, readwrite) unsigned long long capacity;
+
+/** Order in which entries are evicted when capacity is exceeded.
+By default equals to VKCacheEvictionPolicyLRU
+*/
+@property (nonatomic, assign, readwrite) VKCacheEvictionPolicy evictionPolicy;
+
+/** Minimum interval in seconds between two background sweeps of expired entries.
+By default equals to kVKCacheLogStoreDefaultSweepInterval
+*/
+@property (nonatomic, assign, readwrite) NSTimeInterval sweepInterval;
+
+/** Byte limit the store shares with other stores, nil by default. Store is added
+to the quota with addStore: method of VKCacheQuota
+*/
+@property (nonatomic, weak, readonly) VKCacheQuota *quota;
+
+/** Number of entries in the store
+*/
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/** Total size of records of the live entries in bytes
+*/
+@property (nonatomic, assign, readonly) unsigned long long liveBytes;
+
+/** Total size of all segment files in bytes
+*/
+@property (nonatomic, assign, readonly) unsigned long long totalBytes;
+
+/** Number of segment files
+*/
+@property (nonatomic, assign, readonly) NSUInteger segmentsCount;
+
+/**
+@name Initialization methods
+*/
+/** Opens store located in the directory, loads its index
+
+@param path directory where store files are located. If directory does not exist,
+it will be created
+@return VKCacheLogStore instance
+*/
+- (instancetype)initWithDirectory:(NSString *)path;
+
+/**
+@name Entries
+*/
+/** Adds entry to the store, replaces previous entry with the same key
+
+@param data entry data
+@param key entry key
+@param expirationTime time (since 1970) after which entry is considered expired
+and removed in the background, 0 means that entry never expires
+@return YES if record was written
+*/
+- (BOOL)setData:(NSData *)data
+         forKey:(NSString *)key
+ expirationTime:(NSTimeInterval)expirationTime;
+
+/** Reads entry data, records access to the entry
+
+@param key entry key
+@return entry data or nil if there is no such entry
+*/
+- (NSData *)dataForKey:(NSString *)key;
+
+/** Checks whether there is an entry, neither reads its data nor records access
+
+@param key entry key
+@return YES if there is an entry with such key
+*/
+- (BOOL)containsDataForKey:(NSString *)key;
+
+/** Records access to the entry, which data was read from the other place (for
+example, from memory cache)
+
+@param key entry key
+*/
+- (void)recordAccessForKey:(NSString *)key;
+
+/** Returns expiration time of the entry
+
+@param key entry key
+@return expiration time (since 1970) or 0 if there is no such entry
+*/
+- (NSTimeInterval)expirationTimeForKey:(NSString *)key;
+
+/** Removes entry from the store
+
+@param key entry key
+*/
+- (void)removeDataForKey:(NSString *)key;
+
+/** Removes all entries, segments and index file
+*/
+- (void)removeAllData;
+
+/** Keys of all entries
+
+@return array of NSString
+*/
+- (NSArray *)allKeys;
+
+/**
+@name Maintenance
+*/
+/** Flushes segments and saves index file
+
+@return YES if index was saved
+*/
+- (BOOL)synchronize;
+
+/** Evicts entries according to evictionPolicy if capacity is exceeded. Method
+returns when eviction is finished, usually it is performed automatically in the
+background
+*/
+- (void)evictToCapacity;
+
+/** Reduces the store until size of its segment files is not greater than passed
+size: compacts segments with dead bytes, then evicts entries according to
+evictionPolicy. Method returns when the store is reduced
+
+@param size size of segment files in bytes
+*/
+- (void)reduceToSize:(unsigned long long)size;
+
+/** Removes expired entries. Method returns when all expired entries are removed,
+usually it is performed automatically in the background
+
+@return number of removed entries
+*/
+- (NSUInteger)sweepExpiredEntries;
+
+/** Compacts all sealed segments which exceed compactionThreshold. Method
+returns when compaction is finished, usually it is performed automatically in the
+background
+*/
+- (void)compact;
+
+@end
+
+
+/** Byte limit shared by several stores.
+
+Stores of the quota are not bounded by equal shares of capacity: while total
+size of their segment files does not exceed capacity, every store can grow up to
+the whole capacity. When it is exceeded, every store is reduced (see reduceToSize:
+method of VKCacheLogStore) by a part of the excess proportional to its size, until
+total size is not greater than kVKCacheLogStoreEvictionTargetRatio of capacity.
+The check is performed in the background after stores change.
+
+Quota keeps weak references to its stores. All methods are thread safe.
+*/
+@interface VKCacheQuota : NSObject
+
+/** Maximum total size of segment files of all stores in bytes, 0 means
+unlimited (default)
+*/
+@property (nonatomic, assign, readwrite) unsigned long long capacity;
+
+/** Total size of segment files of all stores in bytes
+*/
+@property (nonatomic, assign, readonly) unsigned long long totalBytes;
+
+/** Stores sharing the quota
+
+@return array of VKCacheLogStore
+*/
+- (NSArray *)stores;
+
+/** Adds store to the quota, removes it from the previous quota of the store
+
+@param store store to add
+*/
+- (void)addStore:(VKCacheLogStore *)store;
+
+/** Removes store from the quota
+
+@param store store to remove
+*/
+- (void)removeStore:(VKCacheLogStore *)store;
+
+/** Reduces stores if capacity is exceeded. Method returns when stores are
+reduced, usually it is performed automatically in the background
+*/
+- (void)evictToCapacity;
+
+@end
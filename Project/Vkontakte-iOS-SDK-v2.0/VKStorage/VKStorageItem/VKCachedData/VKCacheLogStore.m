@@ -0,0 +1,1652 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import "VKCacheLogStore.h"
+#import "NSData+subdataNoCopy.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+
+static const uint32_t kVKCacheLogRecordMagic = 0x52434b56; // "VKCR"
+static const uint32_t kVKCacheLogIndexMagic = 0x49434b56; // "VKCI"
+static const uint32_t kVKCacheLogIndexVersion = 2;
+
+static const uint32_t kVKCacheLogRecordFlagTombstone = 1 << 0;
+
+static NSString *const kVKCacheLogIndexFileName = @"index";
+static NSString *const kVKCacheLogSegmentFilePrefix = @"segment-";
+static NSString *const kVKCacheLogSegmentFileExtension = @"log";
+
+#define kVKCacheLogCompactionBatchSize 64
+#define kVKCacheLogEvictionBatchSize 64
+#define kVKCacheLogSweepBatchSize 128
+
+
+/** Record header, followed by key bytes (UTF-8) and data bytes.
+Host byte order is used - store files never leave the device
+*/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t flags;
+    uint32_t keyLength;
+    uint32_t dataLength;
+    double expirationTime;
+} VKCacheLogRecordHeader;
+
+/** Index file header, followed by segments and entries
+*/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t segmentsCount;
+    uint32_t entriesCount;
+} VKCacheLogIndexHeader;
+
+/** Segment described by the index and number of its bytes covered by the index
+*/
+typedef struct
+{
+    uint32_t segmentID;
+    uint32_t reserved;
+    uint64_t length;
+} VKCacheLogIndexSegment;
+
+/** Index entry, followed by key bytes (UTF-8)
+*/
+typedef struct
+{
+    uint32_t segmentID;
+    uint32_t keyLength;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t accessCount;
+    double expirationTime;
+    double lastAccessTime;
+} VKCacheLogIndexEntry;
+
+
+/** Location of the latest record of the entry
+*/
+@interface VKCacheLogEntry : NSObject
+
+@property (nonatomic, copy) NSString *key;
+@property (nonatomic, assign) uint32_t segmentID;
+@property (nonatomic, assign) unsigned long long offset;
+@property (nonatomic, assign) uint32_t length;
+@property (nonatomic, assign) uint32_t keyLength;
+@property (nonatomic, assign) NSTimeInterval expirationTime;
+@property (nonatomic, assign) NSTimeInterval lastAccessTime;
+@property (nonatomic, assign) uint32_t accessCount;
+@property (nonatomic, assign) NSUInteger heapIndex; // position in the expiration heap
+
+- (unsigned long long)dataOffset;
+- (NSUInteger)dataLength;
+
+- (void)recordAccessAtTime:(NSTimeInterval)time;
+
+@end
+
+
+@implementation VKCacheLogEntry
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self)
+        _heapIndex = NSNotFound;
+
+    return self;
+}
+
+- (unsigned long long)dataOffset
+{
+    return self.offset + sizeof(VKCacheLogRecordHeader) + self.keyLength;
+}
+
+- (NSUInteger)dataLength
+{
+    return self.length - sizeof(VKCacheLogRecordHeader) - self.keyLength;
+}
+
+- (void)recordAccessAtTime:(NSTimeInterval)time
+{
+    self.lastAccessTime = time;
+
+    if (UINT32_MAX != self.accessCount)
+        self.accessCount++;
+}
+
+@end
+
+
+/** Open segment file
+*/
+@interface VKCacheLogSegment : NSObject
+
+@property (nonatomic, assign) uint32_t segmentID;
+@property (nonatomic, copy) NSString *path;
+@property (nonatomic, assign) int fileDescriptor;
+@property (nonatomic, assign) unsigned long long length;
+@property (nonatomic, assign) unsigned long long liveBytes;
+@property (nonatomic, assign) BOOL isDirty;
+@property (nonatomic, strong) NSData *mappedData;
+
+@end
+
+
+@implementation VKCacheLogSegment
+
+- (void)dealloc
+{
+    if (0 <= _fileDescriptor)
+        close(_fileDescriptor);
+}
+
+@end
+
+
+@interface VKCacheQuota ()
+
+- (void)scheduleEvictionIfNeeded;
+
+@end
+
+
+@interface VKCacheLogStore ()
+
+@property (nonatomic, weak, readwrite) VKCacheQuota *quota;
+
+@end
+
+
+@implementation VKCacheLogStore
+{
+    NSMutableDictionary *_entries;
+    NSMutableDictionary *_segments;
+    VKCacheLogSegment *_activeSegment;
+    uint32_t _lastSegmentID;
+
+    NSUInteger _changesCount;
+    BOOL _isIndexSaveScheduled;
+    BOOL _isCompactionScheduled;
+    BOOL _isEvictionScheduled;
+
+    dispatch_queue_t _indexQueue;
+    dispatch_queue_t _evictionQueue;
+
+//    двоичная куча записей по времени истечения, в корне - ближайшая
+    NSMutableArray *_expirationHeap;
+    dispatch_queue_t _sweepQueue;
+    dispatch_source_t _sweepTimer;
+    NSTimeInterval _sweepFireTime;
+    NSTimeInterval _lastSweepTime;
+}
+
+#pragma mark Visible VKCacheLogStore methods
+#pragma mark - Init methods
+
+- (instancetype)initWithDirectory:(NSString *)path
+{
+    self = [super init];
+
+    if (self) {
+        _directoryPath = [path copy];
+        _maxSegmentSize = kVKCacheLogStoreDefaultMaxSegmentSize;
+        _compactionThreshold = kVKCacheLogStoreDefaultCompactionThreshold;
+        _indexSaveInterval = kVKCacheLogStoreDefaultIndexSaveInterval;
+        _sweepInterval = kVKCacheLogStoreDefaultSweepInterval;
+//        первое удаление истекших записей - не раньше, чем через sweepInterval
+//        после открытия, чтобы не нагружать диск при запуске
+        _lastSweepTime = [[NSDate date] timeIntervalSince1970];
+
+        _entries = [[NSMutableDictionary alloc] init];
+        _segments = [[NSMutableDictionary alloc] init];
+        _expirationHeap = [[NSMutableArray alloc] init];
+        _indexQueue = dispatch_queue_create("VKCacheLogStore.index", DISPATCH_QUEUE_SERIAL);
+        _evictionQueue = dispatch_queue_create("VKCacheLogStore.eviction", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(_evictionQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+        _sweepQueue = dispatch_queue_create("VKCacheLogStore.sweep", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(_sweepQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0));
+
+        [self createSweepTimer];
+
+        [[NSFileManager defaultManager] createDirectoryAtPath:_directoryPath
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+
+        [self loadIndex];
+
+        @synchronized (self) {
+            [self scheduleCompactionIfNeeded];
+            [self scheduleSweepIfNeeded];
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    dispatch_source_cancel(_sweepTimer);
+
+//    все, что было дописано после последнего сохранения, попадает в индекс,
+//    при следующем запуске сегменты читать не придется
+    [self saveIndex];
+}
+
+#pragma mark - Setters
+
+- (void)setCapacity:(unsigned long long)capacity
+{
+    @synchronized (self) {
+        _capacity = capacity;
+
+        [self scheduleEvictionIfNeeded];
+    }
+}
+
+#pragma mark - Getters
+
+- (NSUInteger)count
+{
+    @synchronized (self) {
+        return [_entries count];
+    }
+}
+
+- (unsigned long long)liveBytes
+{
+    @synchronized (self) {
+        unsigned long long liveBytes = 0;
+
+        for (VKCacheLogSegment *segment in [_segments allValues])
+            liveBytes += segment.liveBytes;
+
+        return liveBytes;
+    }
+}
+
+- (unsigned long long)totalBytes
+{
+    @synchronized (self) {
+        unsigned long long totalBytes = 0;
+
+        for (VKCacheLogSegment *segment in [_segments allValues])
+            totalBytes += segment.length;
+
+        return totalBytes;
+    }
+}
+
+- (NSUInteger)segmentsCount
+{
+    @synchronized (self) {
+        return [_segments count];
+    }
+}
+
+#pragma mark - Entries
+
+- (BOOL)setData:(NSData *)data
+         forKey:(NSString *)key
+ expirationTime:(NSTimeInterval)expirationTime
+{
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+
+    if (nil == keyData)
+        return NO;
+
+    @synchronized (self) {
+        VKCacheLogEntry *entry = [self appendRecordWithKey:keyData
+                                                      data:data
+                                                     flags:0
+                                            expirationTime:expirationTime];
+
+        if (nil == entry)
+            return NO;
+
+//        частота использования относится к ключу, а не к записи
+        entry.accessCount = [(VKCacheLogEntry *) _entries[key] accessCount];
+        [entry recordAccessAtTime:[[NSDate date] timeIntervalSince1970]];
+
+        [self setEntry:entry
+                forKey:key];
+        [self didChange];
+    }
+
+    return YES;
+}
+
+- (NSData *)dataForKey:(NSString *)key
+{
+    if (nil == key)
+        return nil;
+
+    @synchronized (self) {
+        VKCacheLogEntry *entry = _entries[key];
+
+        if (nil == entry)
+            return nil;
+
+        [entry recordAccessAtTime:[[NSDate date] timeIntervalSince1970]];
+
+        return [self readDataOfEntry:entry];
+    }
+}
+
+- (BOOL)containsDataForKey:(NSString *)key
+{
+    if (nil == key)
+        return NO;
+
+    @synchronized (self) {
+        return (nil != _entries[key]);
+    }
+}
+
+- (void)recordAccessForKey:(NSString *)key
+{
+    if (nil == key)
+        return;
+
+    @synchronized (self) {
+        [(VKCacheLogEntry *) _entries[key] recordAccessAtTime:[[NSDate date] timeIntervalSince1970]];
+    }
+}
+
+- (NSTimeInterval)expirationTimeForKey:(NSString *)key
+{
+    if (nil == key)
+        return 0;
+
+    @synchronized (self) {
+        return [(VKCacheLogEntry *) _entries[key] expirationTime];
+    }
+}
+
+- (void)removeDataForKey:(NSString *)key
+{
+    if (nil == key)
+        return;
+
+    @synchronized (self) {
+        [self removeEntryForKey:key];
+    }
+}
+
+- (void)removeAllData
+{
+//    выполняется в очереди индекса, чтобы отложенное сохранение не записало
+//    индекс удаленных сегментов
+    dispatch_sync(_indexQueue, ^
+    {
+        @synchronized (self) {
+            for (VKCacheLogSegment *segment in [_segments allValues])
+                unlink([segment.path fileSystemRepresentation]);
+
+            unlink([[self indexFilePath] fileSystemRepresentation]);
+
+            [_segments removeAllObjects];
+            [_entries removeAllObjects];
+            [_expirationHeap removeAllObjects];
+            _activeSegment = nil;
+            _changesCount = 0;
+        }
+    });
+}
+
+- (NSArray *)allKeys
+{
+    @synchronized (self) {
+        return [_entries allKeys];
+    }
+}
+
+#pragma mark - Maintenance
+
+- (BOOL)synchronize
+{
+    __block BOOL isSaved = NO;
+
+    dispatch_sync(_indexQueue, ^
+    {
+        isSaved = [self saveIndex];
+    });
+
+    return isSaved;
+}
+
+- (void)evictToCapacity
+{
+//    вытеснения выполняются по очереди
+    dispatch_sync(_evictionQueue, ^
+    {
+        [self evictEntries];
+    });
+}
+
+- (void)reduceToSize:(unsigned long long)size
+{
+    dispatch_sync(_evictionQueue, ^
+    {
+        [self shrinkToSize:size];
+    });
+}
+
+- (NSUInteger)sweepExpiredEntries
+{
+    __block NSUInteger removedCount = 0;
+
+    dispatch_sync(_sweepQueue, ^
+    {
+        removedCount = [self removeExpiredEntries];
+    });
+
+    return removedCount;
+}
+
+- (void)compact
+{
+    NSArray *segmentIDs = nil;
+
+    @synchronized (self) {
+        segmentIDs = [self compactionCandidates];
+    }
+
+    for (NSNumber *segmentID in segmentIDs)
+        [self compactSegmentWithID:[segmentID unsignedIntValue]];
+}
+
+#pragma mark - Private methods
+#pragma mark - Records
+
+- (VKCacheLogEntry *)appendRecordWithKey:(NSData *)keyData
+                                    data:(NSData *)data
+                                   flags:(uint32_t)flags
+                          expirationTime:(NSTimeInterval)expirationTime
+{
+    unsigned long long recordLength = sizeof(VKCacheLogRecordHeader) + [keyData length] + [data length];
+
+    if (recordLength > UINT32_MAX)
+        return nil;
+
+    VKCacheLogSegment *segment = [self activeSegmentForRecordLength:recordLength];
+
+    if (nil == segment)
+        return nil;
+
+    VKCacheLogRecordHeader header;
+    header.magic = kVKCacheLogRecordMagic;
+    header.flags = flags;
+    header.keyLength = (uint32_t) [keyData length];
+    header.dataLength = (uint32_t) [data length];
+    header.expirationTime = expirationTime;
+
+//    заголовок, ключ и данные пишутся одним вызовом без промежуточного буфера
+    struct iovec parts[3] = {
+            {&header, sizeof(header)},
+            {(void *) [keyData bytes], [keyData length]},
+            {(void *) [data bytes], [data length]}
+    };
+
+    if (![self writeParts:parts
+                    count:3
+                   length:recordLength
+                toSegment:segment])
+        return nil;
+
+    VKCacheLogEntry *entry = [[VKCacheLogEntry alloc] init];
+    entry.segmentID = segment.segmentID;
+    entry.offset = segment.length;
+    entry.length = (uint32_t) recordLength;
+    entry.keyLength = header.keyLength;
+    entry.expirationTime = expirationTime;
+
+    segment.length += recordLength;
+    segment.isDirty = YES;
+
+    return entry;
+}
+
+- (BOOL)appendRecords:(NSData *)records
+{
+    VKCacheLogSegment *segment = [self activeSegmentForRecordLength:[records length]];
+
+    if (nil == segment)
+        return NO;
+
+    struct iovec parts[1] = {
+            {(void *) [records bytes], [records length]}
+    };
+
+    if (![self writeParts:parts
+                    count:1
+                   length:[records length]
+                toSegment:segment])
+        return NO;
+
+    segment.length += [records length];
+    segment.isDirty = YES;
+
+    return YES;
+}
+
+- (BOOL)writeParts:(struct iovec *)parts
+             count:(int)count
+            length:(unsigned long long)length
+         toSegment:(VKCacheLogSegment *)segment
+{
+    ssize_t writtenLength = -1;
+
+    if (segment.length == (unsigned long long) lseek(segment.fileDescriptor, (off_t) segment.length, SEEK_SET))
+        writtenLength = writev(segment.fileDescriptor, parts, count);
+
+    if (writtenLength != (ssize_t) length) {
+//        недописанная запись отрезается, иначе она испортит следующие
+        ftruncate(segment.fileDescriptor, (off_t) segment.length);
+        return NO;
+    }
+
+    return YES;
+}
+
+- (NSData *)readDataOfEntry:(VKCacheLogEntry *)entry
+{
+    VKCacheLogSegment *segment = _segments[@(entry.segmentID)];
+
+    if (nil == segment)
+        return nil;
+
+    NSRange dataRange = NSMakeRange((NSUInteger) [entry dataOffset], [entry dataLength]);
+
+//    сегмент отображается в память целиком и заново - только когда запись
+//    оказалась за пределами отображенной части (дописана позже)
+    if (NSMaxRange(dataRange) > [segment.mappedData length])
+        segment.mappedData = [NSData dataWithContentsOfFile:segment.path
+                                                    options:NSDataReadingMappedAlways
+                                                      error:nil];
+
+    if (NSMaxRange(dataRange) <= [segment.mappedData length])
+        return [segment.mappedData subdataNoCopyWithRange:dataRange];
+
+//    отобразить файл не удалось
+    NSMutableData *data = [NSMutableData dataWithLength:dataRange.length];
+
+    if (0 == dataRange.length)
+        return data;
+
+    ssize_t readLength = pread(segment.fileDescriptor, [data mutableBytes], dataRange.length, (off_t) dataRange.location);
+
+    if (readLength != (ssize_t) dataRange.length)
+        return nil;
+
+    return data;
+}
+
+- (void)removeEntryForKey:(NSString *)key
+{
+    [self removeEntriesForKeys:@[key]];
+}
+
+- (void)removeEntriesForKeys:(NSArray *)keys
+{
+//    надгробия всех записей пишутся одним вызовом
+    NSMutableData *tombstones = [[NSMutableData alloc] init];
+    NSMutableArray *removedKeys = [[NSMutableArray alloc] initWithCapacity:[keys count]];
+
+    for (NSString *key in keys) {
+        if (nil == _entries[key])
+            continue;
+
+        NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+
+        VKCacheLogRecordHeader header;
+        header.magic = kVKCacheLogRecordMagic;
+        header.flags = kVKCacheLogRecordFlagTombstone;
+        header.keyLength = (uint32_t) [keyData length];
+        header.dataLength = 0;
+        header.expirationTime = 0;
+
+        [tombstones appendBytes:&header
+                         length:sizeof(header)];
+        [tombstones appendData:keyData];
+        [removedKeys addObject:key];
+    }
+
+    if (0 == [removedKeys count])
+        return;
+
+//    без надгробий записи вернулись бы при восстановлении индекса из сегментов
+    [self appendRecords:tombstones];
+
+    for (NSString *key in removedKeys)
+        [self setEntry:nil
+                forKey:key];
+
+    [self didChange];
+}
+
+- (void)setEntry:(VKCacheLogEntry *)entry
+          forKey:(NSString *)key
+{
+    VKCacheLogEntry *previousEntry = _entries[key];
+
+    if (nil != previousEntry) {
+        VKCacheLogSegment *segment = _segments[@(previousEntry.segmentID)];
+        segment.liveBytes -= previousEntry.length;
+
+        [self removeEntryFromHeap:previousEntry];
+    }
+
+    if (nil == entry) {
+        [_entries removeObjectForKey:key];
+    } else {
+        VKCacheLogSegment *segment = _segments[@(entry.segmentID)];
+        segment.liveBytes += entry.length;
+
+        entry.key = key;
+        _entries[key] = entry;
+
+        [self insertEntryIntoHeap:entry];
+    }
+}
+
+- (void)didChange
+{
+    _changesCount++;
+
+    if (_changesCount >= self.indexSaveInterval && !_isIndexSaveScheduled) {
+        _isIndexSaveScheduled = YES;
+
+        dispatch_async(_indexQueue, ^
+        {
+            [self saveIndex];
+        });
+    }
+
+    [self scheduleEvictionIfNeeded];
+    [self scheduleCompactionIfNeeded];
+    [self scheduleSweepIfNeeded];
+}
+
+#pragma mark - Eviction
+
+- (NSArray *)keysInEvictionOrder
+{
+    VKCacheEvictionPolicy policy = self.evictionPolicy;
+
+    return [_entries keysSortedByValueUsingComparator:^NSComparisonResult(VKCacheLogEntry *entry1, VKCacheLogEntry *entry2)
+    {
+//        при равной частоте использования первой удаляется давно не читавшаяся запись
+        if (VKCacheEvictionPolicyLFU == policy && entry1.accessCount != entry2.accessCount)
+            return (entry1.accessCount < entry2.accessCount ? NSOrderedAscending : NSOrderedDescending);
+
+        if (entry1.lastAccessTime != entry2.lastAccessTime)
+            return (entry1.lastAccessTime < entry2.lastAccessTime ? NSOrderedAscending : NSOrderedDescending);
+
+        return NSOrderedSame;
+    }];
+}
+
+- (void)evictEntries
+{
+    unsigned long long capacity = 0;
+
+    @synchronized (self) {
+        capacity = self.capacity;
+
+        if (0 == capacity || self.totalBytes <= capacity)
+            return;
+    }
+
+    [self shrinkToSize:(unsigned long long) (capacity * kVKCacheLogStoreEvictionTargetRatio)];
+}
+
+- (void)shrinkToSize:(unsigned long long)size
+{
+//    сначала освобождается место перезаписанных и удаленных записей, живые
+//    записи вытесняются, только если этого не хватило
+    [self compactToSize:size];
+
+    unsigned long long totalBytes = self.totalBytes;
+
+    if (totalBytes <= size)
+        return;
+
+    [self evictEntriesOfSize:totalBytes - size];
+
+//    вытесненные записи остаются в сегментах мертвыми байтами
+    [self compactToSize:size];
+}
+
+- (void)evictEntriesOfSize:(unsigned long long)bytesToEvict
+{
+    NSArray *keys = nil;
+
+    @synchronized (self) {
+        keys = [self keysInEvictionOrder];
+    }
+
+//    записи удаляются небольшими порциями, между ними хранилище доступно
+    unsigned long long evictedBytes = 0;
+
+    for (NSUInteger i = 0; i < [keys count] && evictedBytes < bytesToEvict; i += kVKCacheLogEvictionBatchSize) {
+        NSRange batchRange = NSMakeRange(i, MIN(kVKCacheLogEvictionBatchSize, [keys count] - i));
+
+        @synchronized (self) {
+            NSMutableArray *batchKeys = [[NSMutableArray alloc] initWithCapacity:batchRange.length];
+
+            for (NSString *key in [keys subarrayWithRange:batchRange]) {
+                if (evictedBytes >= bytesToEvict)
+                    break;
+
+                VKCacheLogEntry *entry = _entries[key];
+
+                if (nil == entry)
+                    continue;
+
+                evictedBytes += entry.length;
+                [batchKeys addObject:key];
+            }
+
+            [self removeEntriesForKeys:batchKeys];
+        }
+    }
+}
+
+- (void)scheduleEvictionIfNeeded
+{
+//    общий объем нескольких хранилищ проверяется в очереди квоты
+    [self.quota scheduleEvictionIfNeeded];
+
+    if (_isEvictionScheduled || 0 == self.capacity || self.totalBytes <= self.capacity)
+        return;
+
+    _isEvictionScheduled = YES;
+
+    dispatch_async(_evictionQueue, ^
+    {
+        @synchronized (self) {
+            _isEvictionScheduled = NO;
+        }
+
+        [self evictEntries];
+    });
+}
+
+#pragma mark - Expiration
+
+- (void)insertEntryIntoHeap:(VKCacheLogEntry *)entry
+{
+//    записи без времени истечения не удаляются
+    if (0 == entry.expirationTime)
+        return;
+
+    entry.heapIndex = [_expirationHeap count];
+    [_expirationHeap addObject:entry];
+
+    [self siftUpHeapEntryAtIndex:entry.heapIndex];
+}
+
+- (void)removeEntryFromHeap:(VKCacheLogEntry *)entry
+{
+    NSUInteger index = entry.heapIndex;
+
+    if (NSNotFound == index)
+        return;
+
+    VKCacheLogEntry *lastEntry = [_expirationHeap lastObject];
+    [_expirationHeap removeLastObject];
+    entry.heapIndex = NSNotFound;
+
+    if (lastEntry == entry)
+        return;
+
+//    на место удаленной записи встает последняя и занимает свое место в куче
+    lastEntry.heapIndex = index;
+    _expirationHeap[index] = lastEntry;
+
+    [self siftUpHeapEntryAtIndex:index];
+    [self siftDownHeapEntryAtIndex:lastEntry.heapIndex];
+}
+
+- (void)siftUpHeapEntryAtIndex:(NSUInteger)index
+{
+    while (0 != index) {
+        NSUInteger parentIndex = (index - 1) / 2;
+
+        if ([_expirationHeap[parentIndex] expirationTime] <= [_expirationHeap[index] expirationTime])
+            break;
+
+        [self swapHeapEntryAtIndex:index
+                  withEntryAtIndex:parentIndex];
+        index = parentIndex;
+    }
+}
+
+- (void)siftDownHeapEntryAtIndex:(NSUInteger)index
+{
+    NSUInteger count = [_expirationHeap count];
+
+    while (YES) {
+        NSUInteger smallestIndex = index;
+        NSUInteger leftIndex = 2 * index + 1;
+        NSUInteger rightIndex = leftIndex + 1;
+
+        if (leftIndex < count && [_expirationHeap[leftIndex] expirationTime] < [_expirationHeap[smallestIndex] expirationTime])
+            smallestIndex = leftIndex;
+
+        if (rightIndex < count && [_expirationHeap[rightIndex] expirationTime] < [_expirationHeap[smallestIndex] expirationTime])
+            smallestIndex = rightIndex;
+
+        if (smallestIndex == index)
+            break;
+
+        [self swapHeapEntryAtIndex:index
+                  withEntryAtIndex:smallestIndex];
+        index = smallestIndex;
+    }
+}
+
+- (void)swapHeapEntryAtIndex:(NSUInteger)index1
+            withEntryAtIndex:(NSUInteger)index2
+{
+    VKCacheLogEntry *entry1 = _expirationHeap[index1];
+    VKCacheLogEntry *entry2 = _expirationHeap[index2];
+
+    _expirationHeap[index1] = entry2;
+    _expirationHeap[index2] = entry1;
+
+    entry1.heapIndex = index2;
+    entry2.heapIndex = index1;
+}
+
+- (void)buildHeap
+{
+    _expirationHeap = [[NSMutableArray alloc] initWithCapacity:[_entries count]];
+
+    for (VKCacheLogEntry *entry in [_entries allValues]) {
+        if (0 == entry.expirationTime)
+            continue;
+
+        entry.heapIndex = [_expirationHeap count];
+        [_expirationHeap addObject:entry];
+    }
+
+    for (NSUInteger i = [_expirationHeap count] / 2; 0 != i; i--)
+        [self siftDownHeapEntryAtIndex:i - 1];
+}
+
+- (void)createSweepTimer
+{
+    __weak VKCacheLogStore *weakSelf = self;
+
+    _sweepTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _sweepQueue);
+
+    dispatch_source_set_timer(_sweepTimer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+    dispatch_source_set_event_handler(_sweepTimer, ^
+    {
+        VKCacheLogStore *store = weakSelf;
+
+        [store removeExpiredEntries];
+    });
+    dispatch_resume(_sweepTimer);
+}
+
+- (void)scheduleSweepIfNeeded
+{
+    if (0 == [_expirationHeap count])
+        return;
+
+    VKCacheLogEntry *nextExpiredEntry = _expirationHeap[0];
+
+//    удаление выполняется не чаще, чем раз в sweepInterval секунд, так что
+//    истекающие в этом промежутке записи удаляются вместе
+    NSTimeInterval fireTime = MAX(nextExpiredEntry.expirationTime, _lastSweepTime + self.sweepInterval);
+
+    if (0 != _sweepFireTime && _sweepFireTime <= fireTime)
+        return;
+
+    _sweepFireTime = fireTime;
+
+    NSTimeInterval delay = MAX(0, fireTime - [[NSDate date] timeIntervalSince1970]);
+
+    dispatch_source_set_timer(_sweepTimer,
+                              dispatch_walltime(NULL, (int64_t) (delay * NSEC_PER_SEC)),
+                              DISPATCH_TIME_FOREVER,
+                              (uint64_t) (self.sweepInterval * 0.1 * NSEC_PER_SEC));
+}
+
+- (NSUInteger)removeExpiredEntries
+{
+    NSUInteger removedCount = 0;
+    BOOL hasExpiredEntries = YES;
+
+    @synchronized (self) {
+        _sweepFireTime = 0;
+        _lastSweepTime = [[NSDate date] timeIntervalSince1970];
+    }
+
+//    записи удаляются ограниченными порциями, между ними хранилище доступно
+    while (hasExpiredEntries) {
+        @synchronized (self) {
+            NSTimeInterval currentTime = [[NSDate date] timeIntervalSince1970];
+            NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:kVKCacheLogSweepBatchSize];
+
+            while ([keys count] < kVKCacheLogSweepBatchSize && 0 != [_expirationHeap count]) {
+                VKCacheLogEntry *entry = _expirationHeap[0];
+
+                if (entry.expirationTime > currentTime)
+                    break;
+
+                [self removeEntryFromHeap:entry];
+                [keys addObject:entry.key];
+            }
+
+            hasExpiredEntries = ([keys count] == kVKCacheLogSweepBatchSize);
+            removedCount += [keys count];
+
+            [self removeEntriesForKeys:keys];
+        }
+    }
+
+    @synchronized (self) {
+        [self scheduleSweepIfNeeded];
+    }
+
+    return removedCount;
+}
+
+#pragma mark - Segments
+
+- (NSString *)pathForSegmentWithID:(uint32_t)segmentID
+{
+    NSString *fileName = [NSString stringWithFormat:@"%@%010u.%@",
+                                                    kVKCacheLogSegmentFilePrefix,
+                                                    segmentID,
+                                                    kVKCacheLogSegmentFileExtension];
+
+    return [_directoryPath stringByAppendingPathComponent:fileName];
+}
+
+- (VKCacheLogSegment *)openSegmentWithID:(uint32_t)segmentID
+                                  create:(BOOL)create
+{
+    NSString *path = [self pathForSegmentWithID:segmentID];
+    int fileDescriptor = open([path fileSystemRepresentation], O_RDWR | (create ? O_CREAT : 0), 0644);
+
+    if (0 > fileDescriptor)
+        return nil;
+
+    struct stat fileStat;
+
+    if (0 != fstat(fileDescriptor, &fileStat)) {
+        close(fileDescriptor);
+        return nil;
+    }
+
+    VKCacheLogSegment *segment = [[VKCacheLogSegment alloc] init];
+    segment.segmentID = segmentID;
+    segment.path = path;
+    segment.fileDescriptor = fileDescriptor;
+    segment.length = (unsigned long long) fileStat.st_size;
+
+    return segment;
+}
+
+- (VKCacheLogSegment *)activeSegmentForRecordLength:(unsigned long long)recordLength
+{
+    if (nil != _activeSegment && (0 == _activeSegment.length || _activeSegment.length + recordLength <= self.maxSegmentSize))
+        return _activeSegment;
+
+//    каталог мог быть удален вместе с кэшем пользователя
+    [[NSFileManager defaultManager] createDirectoryAtPath:_directoryPath
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+
+    VKCacheLogSegment *segment = [self openSegmentWithID:_lastSegmentID + 1
+                                                  create:YES];
+
+    if (nil == segment)
+        return nil;
+
+    _lastSegmentID++;
+    _segments[@(segment.segmentID)] = segment;
+    _activeSegment = segment;
+
+    return segment;
+}
+
+- (NSArray *)compactionCandidates
+{
+    NSMutableArray *segmentIDs = [[NSMutableArray alloc] init];
+
+    for (VKCacheLogSegment *segment in [_segments allValues]) {
+        if (segment == _activeSegment)
+            continue;
+
+        unsigned long long deadBytes = segment.length - segment.liveBytes;
+
+        if (0 == segment.length || deadBytes >= self.compactionThreshold * segment.length)
+            [segmentIDs addObject:@(segment.segmentID)];
+    }
+
+    return [segmentIDs sortedArrayUsingSelector:@selector(compare:)];
+}
+
+- (NSArray *)segmentIDsWithDeadBytes
+{
+    NSMutableArray *segments = [[NSMutableArray alloc] init];
+
+    for (VKCacheLogSegment *segment in [_segments allValues]) {
+        if (segment.length > segment.liveBytes)
+            [segments addObject:segment];
+    }
+
+//    первыми уплотняются сегменты, которые освободят больше места
+    [segments sortUsingComparator:^NSComparisonResult(VKCacheLogSegment *segment1, VKCacheLogSegment *segment2)
+    {
+        unsigned long long deadBytes1 = segment1.length - segment1.liveBytes;
+        unsigned long long deadBytes2 = segment2.length - segment2.liveBytes;
+
+        if (deadBytes1 != deadBytes2)
+            return (deadBytes1 > deadBytes2 ? NSOrderedAscending : NSOrderedDescending);
+
+        return NSOrderedSame;
+    }];
+
+    return [segments valueForKey:@"segmentID"];
+}
+
+- (void)compactToSize:(unsigned long long)size
+{
+    NSArray *segmentIDs = nil;
+
+    @synchronized (self) {
+        segmentIDs = [self segmentIDsWithDeadBytes];
+    }
+
+//    в отличие от фонового уплотнения здесь уплотняются и сегменты с небольшой
+//    долей мертвых байтов, но только пока размер превышает нужный
+    for (NSNumber *segmentID in segmentIDs) {
+        if (self.totalBytes <= size)
+            return;
+
+        @synchronized (self) {
+//            активный сегмент закрывается, следующие записи попадут в новый
+            if (_activeSegment == _segments[segmentID])
+                _activeSegment = nil;
+        }
+
+        [self compactSegmentWithID:[segmentID unsignedIntValue]];
+    }
+}
+
+- (void)scheduleCompactionIfNeeded
+{
+    if (_isCompactionScheduled || 0 == [[self compactionCandidates] count])
+        return;
+
+    _isCompactionScheduled = YES;
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^
+    {
+        [self compact];
+
+        @synchronized (self) {
+            _isCompactionScheduled = NO;
+        }
+    });
+}
+
+- (void)compactSegmentWithID:(uint32_t)segmentID
+{
+    NSMutableArray *keys = [[NSMutableArray alloc] init];
+
+    @synchronized (self) {
+        VKCacheLogSegment *segment = _segments[@(segmentID)];
+
+        if (nil == segment || segment == _activeSegment)
+            return;
+
+        [_entries enumerateKeysAndObjectsUsingBlock:^(NSString *key, VKCacheLogEntry *entry, BOOL *stop)
+        {
+            if (segmentID == entry.segmentID)
+                [keys addObject:key];
+        }];
+    }
+
+//    живые записи переносятся небольшими порциями, чтобы не задерживать
+//    чтение и запись надолго
+    for (NSUInteger i = 0; i < [keys count]; i += kVKCacheLogCompactionBatchSize) {
+        NSRange batchRange = NSMakeRange(i, MIN(kVKCacheLogCompactionBatchSize, [keys count] - i));
+
+        @synchronized (self) {
+            for (NSString *key in [keys subarrayWithRange:batchRange]) {
+                VKCacheLogEntry *entry = _entries[key];
+
+//                запись могли перезаписать или удалить, пока шло уплотнение
+                if (nil == entry || segmentID != entry.segmentID)
+                    continue;
+
+                NSData *data = [self readDataOfEntry:entry];
+
+                if (nil == data) {
+                    [self setEntry:nil
+                            forKey:key];
+                    continue;
+                }
+
+                VKCacheLogEntry *movedEntry = [self appendRecordWithKey:[key dataUsingEncoding:NSUTF8StringEncoding]
+                                                                   data:data
+                                                                  flags:0
+                                                         expirationTime:entry.expirationTime];
+
+//                места на диске нет - сегмент остается как есть
+                if (nil == movedEntry)
+                    return;
+
+                movedEntry.lastAccessTime = entry.lastAccessTime;
+                movedEntry.accessCount = entry.accessCount;
+
+                [self setEntry:movedEntry
+                        forKey:key];
+            }
+        }
+    }
+
+//    индекс сохраняется до удаления сегмента, иначе после сбоя он ссылался бы на
+//    удаленный файл, а надгробия этого сегмента не понадобятся при восстановлении
+    if (![self synchronize])
+        return;
+
+    @synchronized (self) {
+        VKCacheLogSegment *segment = _segments[@(segmentID)];
+
+        if (nil == segment || 0 != segment.liveBytes)
+            return;
+
+        unlink([segment.path fileSystemRepresentation]);
+        [_segments removeObjectForKey:@(segmentID)];
+    }
+}
+
+#pragma mark - Index
+
+- (NSString *)indexFilePath
+{
+    return [_directoryPath stringByAppendingPathComponent:kVKCacheLogIndexFileName];
+}
+
+- (BOOL)saveIndex
+{
+    NSMutableData *indexData = nil;
+    NSMutableArray *dirtySegments = [[NSMutableArray alloc] init];
+
+//    под блокировкой снимаются только сегменты и индекс, долгие сброс сегментов
+//    на диск и запись файла индекса не задерживают чтение и запись записей
+    @synchronized (self) {
+        _isIndexSaveScheduled = NO;
+        _changesCount = 0;
+
+        for (VKCacheLogSegment *segment in [_segments allValues]) {
+            if (segment.isDirty) {
+                [dirtySegments addObject:segment];
+                segment.isDirty = NO;
+            }
+        }
+
+        indexData = [NSMutableData dataWithCapacity:sizeof(VKCacheLogIndexHeader) + [_entries count] * (sizeof(VKCacheLogIndexEntry) + 32)];
+
+        VKCacheLogIndexHeader header;
+        header.magic = kVKCacheLogIndexMagic;
+        header.version = kVKCacheLogIndexVersion;
+        header.segmentsCount = (uint32_t) [_segments count];
+        header.entriesCount = (uint32_t) [_entries count];
+
+        [indexData appendBytes:&header
+                        length:sizeof(header)];
+
+        for (VKCacheLogSegment *segment in [_segments allValues]) {
+            VKCacheLogIndexSegment indexSegment;
+            indexSegment.segmentID = segment.segmentID;
+            indexSegment.reserved = 0;
+            indexSegment.length = segment.length;
+
+            [indexData appendBytes:&indexSegment
+                            length:sizeof(indexSegment)];
+        }
+
+        [_entries enumerateKeysAndObjectsUsingBlock:^(NSString *key, VKCacheLogEntry *entry, BOOL *stop)
+        {
+            NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+
+            VKCacheLogIndexEntry indexEntry;
+            indexEntry.segmentID = entry.segmentID;
+            indexEntry.keyLength = (uint32_t) [keyData length];
+            indexEntry.offset = entry.offset;
+            indexEntry.length = entry.length;
+            indexEntry.accessCount = entry.accessCount;
+            indexEntry.expirationTime = entry.expirationTime;
+            indexEntry.lastAccessTime = entry.lastAccessTime;
+
+            [indexData appendBytes:&indexEntry
+                            length:sizeof(indexEntry)];
+            [indexData appendData:keyData];
+        }];
+    }
+
+//    индекс не должен описывать записи, которых еще нет на диске; снимок удерживает
+//    сегменты, поэтому их дескрипторы не закроются, даже если сегмент уже удален
+    for (VKCacheLogSegment *segment in dirtySegments) {
+        if (0 != fsync(segment.fileDescriptor)) {
+//            сегменты будут сброшены при следующем сохранении
+            @synchronized (self) {
+                for (VKCacheLogSegment *dirtySegment in dirtySegments)
+                    dirtySegment.isDirty = YES;
+            }
+
+            return NO;
+        }
+    }
+
+    return [indexData writeToFile:[self indexFilePath]
+                       atomically:YES];
+}
+
+- (NSDictionary *)readIndexFileIntoEntries:(NSMutableDictionary *)entries
+{
+    NSData *indexData = [NSData dataWithContentsOfFile:[self indexFilePath]
+                                               options:NSDataReadingMappedIfSafe
+                                                 error:nil];
+    const uint8_t *bytes = [indexData bytes];
+    NSUInteger length = [indexData length];
+    NSUInteger position = 0;
+
+    VKCacheLogIndexHeader header;
+
+    if (length < sizeof(header))
+        return nil;
+
+    memcpy(&header, bytes, sizeof(header));
+    position += sizeof(header);
+
+    if (kVKCacheLogIndexMagic != header.magic || kVKCacheLogIndexVersion != header.version)
+        return nil;
+
+    NSMutableDictionary *segmentLengths = [[NSMutableDictionary alloc] init];
+
+    for (uint32_t i = 0; i < header.segmentsCount; i++) {
+        VKCacheLogIndexSegment indexSegment;
+
+        if (length - position < sizeof(indexSegment))
+            return nil;
+
+        memcpy(&indexSegment, bytes + position, sizeof(indexSegment));
+        position += sizeof(indexSegment);
+
+        segmentLengths[@(indexSegment.segmentID)] = @(indexSegment.length);
+    }
+
+    for (uint32_t i = 0; i < header.entriesCount; i++) {
+        VKCacheLogIndexEntry indexEntry;
+
+        if (length - position < sizeof(indexEntry))
+            return nil;
+
+        memcpy(&indexEntry, bytes + position, sizeof(indexEntry));
+        position += sizeof(indexEntry);
+
+        if (length - position < indexEntry.keyLength)
+            return nil;
+
+        NSString *key = [[NSString alloc] initWithBytes:bytes + position
+                                                 length:indexEntry.keyLength
+                                               encoding:NSUTF8StringEncoding];
+        position += indexEntry.keyLength;
+
+        if (nil == key || indexEntry.length < sizeof(VKCacheLogRecordHeader) + indexEntry.keyLength)
+            return nil;
+
+        VKCacheLogEntry *entry = [[VKCacheLogEntry alloc] init];
+        entry.segmentID = indexEntry.segmentID;
+        entry.offset = indexEntry.offset;
+        entry.length = indexEntry.length;
+        entry.keyLength = indexEntry.keyLength;
+        entry.expirationTime = indexEntry.expirationTime;
+        entry.lastAccessTime = indexEntry.lastAccessTime;
+        entry.accessCount = indexEntry.accessCount;
+
+        entries[key] = entry;
+    }
+
+    return segmentLengths;
+}
+
+- (void)loadIndex
+{
+    NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_directoryPath
+                                                                              error:nil];
+    NSMutableArray *segmentIDs = [[NSMutableArray alloc] init];
+
+    for (NSString *fileName in fileNames) {
+        if (![fileName hasPrefix:kVKCacheLogSegmentFilePrefix] || ![[fileName pathExtension] isEqualToString:kVKCacheLogSegmentFileExtension])
+            continue;
+
+        NSString *segmentNumber = [[fileName stringByDeletingPathExtension] substringFromIndex:[kVKCacheLogSegmentFilePrefix length]];
+        uint32_t segmentID = (uint32_t) [segmentNumber longLongValue];
+        VKCacheLogSegment *segment = (0 == segmentID ? nil : [self openSegmentWithID:segmentID
+                                                                               create:NO]);
+
+        if (nil == segment)
+            continue;
+
+        _segments[@(segmentID)] = segment;
+        [segmentIDs addObject:@(segmentID)];
+    }
+
+    [segmentIDs sortUsingSelector:@selector(compare:)];
+
+//    без индекса все сегменты читаются с начала
+    NSMutableDictionary *entries = [[NSMutableDictionary alloc] init];
+    NSDictionary *indexedLengths = [self readIndexFileIntoEntries:entries];
+
+    if (nil == indexedLengths)
+        [entries removeAllObjects];
+
+//    записи удаленных или укороченных сегментов не используются
+    for (NSString *key in [entries allKeys]) {
+        VKCacheLogEntry *entry = entries[key];
+        VKCacheLogSegment *segment = _segments[@(entry.segmentID)];
+
+        if (nil == segment || entry.offset + entry.length > segment.length)
+            [entries removeObjectForKey:key];
+    }
+
+    _entries = entries;
+
+    BOOL hasReplayedRecords = NO;
+
+    for (NSNumber *segmentID in segmentIDs) {
+        VKCacheLogSegment *segment = _segments[segmentID];
+        unsigned long long indexedLength = [indexedLengths[segmentID] unsignedLongLongValue];
+
+        if (segment.length > indexedLength) {
+            [self replaySegment:segment
+                     fromOffset:indexedLength];
+            hasReplayedRecords = YES;
+        }
+    }
+
+    [_entries enumerateKeysAndObjectsUsingBlock:^(NSString *key, VKCacheLogEntry *entry, BOOL *stop)
+    {
+        VKCacheLogSegment *segment = _segments[@(entry.segmentID)];
+        segment.liveBytes += entry.length;
+
+        entry.key = key;
+    }];
+
+    [self buildHeap];
+
+    _lastSegmentID = [[segmentIDs lastObject] unsignedIntValue];
+    _activeSegment = _segments[[segmentIDs lastObject]];
+
+    if (hasReplayedRecords)
+        _changesCount = self.indexSaveInterval;
+}
+
+- (void)replaySegment:(VKCacheLogSegment *)segment
+           fromOffset:(unsigned long long)offset
+{
+    NSData *segmentData = [NSData dataWithContentsOfFile:segment.path
+                                                 options:NSDataReadingMappedIfSafe
+                                                   error:nil];
+    const uint8_t *bytes = [segmentData bytes];
+    unsigned long long length = MIN([segmentData length], segment.length);
+    NSTimeInterval replayTime = [[NSDate date] timeIntervalSince1970];
+
+    while (offset < length && length - offset >= sizeof(VKCacheLogRecordHeader)) {
+        VKCacheLogRecordHeader header;
+        memcpy(&header, bytes + offset, sizeof(header));
+
+        unsigned long long recordLength = sizeof(header) + (unsigned long long) header.keyLength + header.dataLength;
+
+        if (kVKCacheLogRecordMagic != header.magic || recordLength > length - offset)
+            break;
+
+        NSString *key = [[NSString alloc] initWithBytes:bytes + offset + sizeof(header)
+                                                 length:header.keyLength
+                                               encoding:NSUTF8StringEncoding];
+
+        if (nil == key)
+            break;
+
+        if (0 != (header.flags & kVKCacheLogRecordFlagTombstone)) {
+            [_entries removeObjectForKey:key];
+        } else {
+            VKCacheLogEntry *entry = [[VKCacheLogEntry alloc] init];
+            entry.segmentID = segment.segmentID;
+            entry.offset = offset;
+            entry.length = (uint32_t) recordLength;
+            entry.keyLength = header.keyLength;
+            entry.expirationTime = header.expirationTime;
+            entry.accessCount = [(VKCacheLogEntry *) _entries[key] accessCount];
+            [entry recordAccessAtTime:replayTime];
+
+            _entries[key] = entry;
+        }
+
+        offset += recordLength;
+    }
+
+//    хвост, оставшийся от прерванной записи, отрезается
+    if (offset < segment.length) {
+        ftruncate(segment.fileDescriptor, (off_t) offset);
+        segment.length = offset;
+    }
+}
+
+@end
+
+
+@implementation VKCacheQuota
+{
+    NSHashTable *_stores;
+
+    BOOL _isEvictionScheduled;
+    dispatch_queue_t _evictionQueue;
+}
+
+#pragma mark Visible VKCacheQuota methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self) {
+        _stores = [NSHashTable weakObjectsHashTable];
+        _evictionQueue = dispatch_queue_create("VKCacheQuota.eviction", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(_evictionQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+    }
+
+    return self;
+}
+
+#pragma mark - Setters
+
+- (void)setCapacity:(unsigned long long)capacity
+{
+    @synchronized (self) {
+        _capacity = capacity;
+    }
+
+    [self scheduleEvictionIfNeeded];
+}
+
+#pragma mark - Getters
+
+- (unsigned long long)capacity
+{
+    @synchronized (self) {
+        return _capacity;
+    }
+}
+
+- (unsigned long long)totalBytes
+{
+//    блокировки хранилищ не берутся под блокировкой квоты: хранилища
+//    обращаются к квоте под своими блокировками
+    unsigned long long totalBytes = 0;
+
+    for (VKCacheLogStore *store in [self stores])
+        totalBytes += store.totalBytes;
+
+    return totalBytes;
+}
+
+#pragma mark - Stores
+
+- (NSArray *)stores
+{
+    @synchronized (self) {
+        return [_stores allObjects];
+    }
+}
+
+- (void)addStore:(VKCacheLogStore *)store
+{
+    if (nil == store)
+        return;
+
+    VKCacheQuota *previousQuota = store.quota;
+
+    if (self == previousQuota)
+        return;
+
+    [previousQuota removeStore:store];
+
+    @synchronized (self) {
+        [_stores addObject:store];
+    }
+
+    store.quota = self;
+
+    [self scheduleEvictionIfNeeded];
+}
+
+- (void)removeStore:(VKCacheLogStore *)store
+{
+    if (nil == store)
+        return;
+
+    @synchronized (self) {
+        [_stores removeObject:store];
+    }
+
+    if (self == store.quota)
+        store.quota = nil;
+}
+
+#pragma mark - Maintenance
+
+- (void)evictToCapacity
+{
+    dispatch_sync(_evictionQueue, ^
+    {
+        [self evictStores];
+    });
+}
+
+#pragma mark - Private methods
+
+- (void)evictStores
+{
+    unsigned long long capacity = self.capacity;
+
+    if (0 == capacity)
+        return;
+
+    NSArray *stores = [self stores];
+    NSMutableArray *storesBytes = [[NSMutableArray alloc] initWithCapacity:[stores count]];
+    unsigned long long totalBytes = 0;
+
+    for (VKCacheLogStore *store in stores) {
+        unsigned long long storeBytes = store.totalBytes;
+
+        [storesBytes addObject:@(storeBytes)];
+        totalBytes += storeBytes;
+    }
+
+    if (totalBytes <= capacity)
+        return;
+
+//    каждое хранилище освобождает часть превышения, пропорциональную своему
+//    размеру, - пустые хранилища пользователей места не занимают и не теряют
+    unsigned long long targetBytes = (unsigned long long) (capacity * kVKCacheLogStoreEvictionTargetRatio);
+    double excessRatio = (double) (totalBytes - targetBytes) / totalBytes;
+
+    [stores enumerateObjectsUsingBlock:^(VKCacheLogStore *store, NSUInteger index, BOOL *stop)
+    {
+        unsigned long long storeBytes = [storesBytes[index] unsignedLongLongValue];
+        unsigned long long bytesToFree = (unsigned long long) ceil(storeBytes * excessRatio);
+
+        if (0 == bytesToFree)
+            return;
+
+        [store reduceToSize:storeBytes - MIN(storeBytes, bytesToFree)];
+    }];
+}
+
+- (void)scheduleEvictionIfNeeded
+{
+//    вызывается хранилищами при каждом изменении, поэтому суммарный размер
+//    считается уже в очереди квоты
+    @synchronized (self) {
+        if (_isEvictionScheduled || 0 == _capacity)
+            return;
+
+        _isEvictionScheduled = YES;
+    }
+
+    dispatch_async(_evictionQueue, ^
+    {
+        @synchronized (self) {
+            _isEvictionScheduled = NO;
+        }
+
+        [self evictStores];
+    });
+}
+
+@end
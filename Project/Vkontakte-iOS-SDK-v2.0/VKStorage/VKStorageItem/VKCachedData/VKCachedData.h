@@ -26,6 +26,11 @@
 //
 #import <Foundation/Foundation.h>
 
+
+@class VKCacheLogStore;
+@class VKMemoryCache;
+
+
 /** List of the possible cache expiration times
  */
 typedef enum
@@ -44,12 +49,86 @@ typedef enum
     
 } VKCachedDataLiveTime;
 
+/** List of the codecs cached data can be stored with
+ */
+typedef enum
+{
+
+    VKCachedDataCodecNone = 0,
+    VKCachedDataCodecDeflate,
+
+} VKCachedDataCodec;
+
+/** Data smaller than this number of bytes is stored uncompressed
+ */
+#define kVKCachedDataDefaultCompressionThreshold 1024
+
+/** Number of seconds entry added with retainForOffline is kept after its expiration,
+ so it can still be read in offline mode
+ */
+#define kVKCachedDataOfflineRetentionTime VKCachedDataLiveTimeOneMonth
+
+/** Entry flag: entry is kept after its expiration for kVKCachedDataOfflineRetentionTime,
+ so it can still be read in offline mode
+ */
+#define kVKCachedDataEntryFlagRetainForOffline (1 << 0)
+
+/** Header of the cache entry. Header is followed by dataLength bytes of the cached
+ data compressed with codec. Host byte order is used
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t codec;
+    double creationTime;
+    uint32_t liveTime;
+    uint32_t flags;
+    uint32_t dataLength;
+    uint32_t checksum; // CRC-32 of the stored data
+} VKCachedDataEntryHeader;
+
 /** This interface is intended for storing, retrieving and removing cache requests.
- Data will be stored on local drive and in the directory set during initialization process
+ Data will be stored on local drive and in the directory set during initialization process.
+ Entries are stored under keys built by VKCacheKey, methods which take URL use
+ [VKCacheKey keyForURL:]
+
+ All entries of the directory are kept in one log-structured store (see VKCacheLogStore)
+ instead of a file per entry. Every entry is a fixed VKCachedDataEntryHeader followed
+ by the raw data, so expiration is checked by the header only and uncompressed
+ data is returned without copying from the memory mapped segment
+
+ Expired entries are not removed when they are read: the store removes them in the
+ background some time after expiration (see VKCacheLogStore). Entries added with
+ retainForOffline are removed this way only kVKCachedDataOfflineRetentionTime after
+ their expiration
  */
 
 @interface VKCachedData : NSObject
 
+/**
+ @name Properties
+ */
+/** Log-structured store the entries are kept in
+ */
+@property (nonatomic, strong, readonly) VKCacheLogStore *store;
+
+/** Memory tier in front of the store. Keeps decoded data of recently added and read
+ entries, so repeated reads do not touch the disk. Its capacity (in bytes) can be
+ changed, by default equals to kVKMemoryCacheDefaultCapacity
+ */
+@property (nonatomic, strong, readonly) VKMemoryCache *memoryCache;
+
+/** Codec new cache entries are compressed with. By default equals to VKCachedDataCodecDeflate.
+ Codec is stored with every entry, so entries written with different codecs can be read at any time
+ */
+@property (nonatomic, assign, readwrite) VKCachedDataCodec compressionCodec;
+
+/** Data smaller than this number of bytes is stored uncompressed.
+ By default equals to kVKCachedDataDefaultCompressionThreshold
+ */
+@property (nonatomic, assign, readwrite) NSUInteger compressionThreshold;
+
 /**
  @name Initialization methods
  */
@@ -82,12 +161,45 @@ typedef enum
                forURL:(NSURL *)url
              liveTime:(VKCachedDataLiveTime)cacheLiveTime;
 
+/** Add data in cache under the key built by VKCacheKey
+ 
+ @param cache data to be cached
+ @param key cache key (see VKCacheKey)
+ @param cacheLiveTime cache ttl value
+ */
+- (void)addCachedData:(NSData *)cache
+               forKey:(NSString *)key
+             liveTime:(VKCachedDataLiveTime)cacheLiveTime;
+
+/** Add data in cache under the key built by VKCacheKey
+
+ @param cache data to be cached
+ @param key cache key (see VKCacheKey)
+ @param cacheLiveTime cache ttl value
+ @param maxStaleTime number of seconds expired data is going to be used, entry is
+ removed in the background after that
+ @param retainForOffline if YES, expired entry is removed in the background not earlier
+ than kVKCachedDataOfflineRetentionTime after its expiration, so it can be read in
+ offline mode
+ */
+- (void)addCachedData:(NSData *)cache
+               forKey:(NSString *)key
+             liveTime:(VKCachedDataLiveTime)cacheLiveTime
+         maxStaleTime:(NSTimeInterval)maxStaleTime
+     retainForOffline:(BOOL)retainForOffline;
+
 /** Remove data from cache that is associated with passed url
  
  @param url url which matches to cached data
  */
 - (void)removeCachedDataForURL:(NSURL *)url;
 
+/** Remove data from cache that is associated with passed key
+ 
+ @param key cache key (see VKCacheKey)
+ */
+- (void)removeCachedDataForKey:(NSString *)key;
+
 /** Remove all cached data from the current objects instance directory
  */
 - (void)clearCachedData;
@@ -110,8 +222,9 @@ typedef enum
 /** Retrieve cached data which matches to passed url.
  If associated item does not exist nil will be returned
  
- If offlineMode is passed as "YES" the data will be returned from the cache even if it's expired.
- If offlineMode is equal to "NO" the cached item will be deleted if it's expired
+ If offlineMode is passed as "YES" the data will be returned from the cache even if it's expired
+ (and was not removed in the background yet, see addCachedData:forKey:liveTime:maxStaleTime:retainForOffline:).
+ If offlineMode is equal to "NO" nil is returned for the expired item
  
  The offlineMode parameter is useful when there is no internet connection
  
@@ -122,4 +235,64 @@ typedef enum
 - (NSData *)cachedDataForURL:(NSURL *)url
                  offlineMode:(BOOL)offlineMode;
 
+/** Retrieve cached data which matches to passed url.
+ If associated item does not exist nil will be returned
+ 
+ Expired data is still returned during maxStaleTime seconds after its expiration,
+ in this case isStale will be set to YES. For data which is older than that nil
+ is returned
+ 
+ @param url url which matches to cached data
+ @param maxStaleTime number of seconds expired data can still be used. DBL_MAX means
+ expired data is returned while it is in the cache
+ @param isStale will be set to YES if returned data is expired, can be NULL
+ @return NSData instance
+ */
+- (NSData *)cachedDataForURL:(NSURL *)url
+                maxStaleTime:(NSTimeInterval)maxStaleTime
+                     isStale:(BOOL *)isStale;
+
+/** Retrieve cached data which matches to passed key. Parameters have the same
+ meaning as in cachedDataForURL:maxStaleTime:isStale:
+ 
+ @param key cache key (see VKCacheKey)
+ @param maxStaleTime number of seconds expired data can still be used
+ @param isStale will be set to YES if returned data is expired, can be NULL
+ @return NSData instance
+ */
+- (NSData *)cachedDataForKey:(NSString *)key
+                maxStaleTime:(NSTimeInterval)maxStaleTime
+                     isStale:(BOOL *)isStale;
+
+/** Check whether there is cached data for the passed key without reading it.
+ Existing data can still turn out to be expired or corrupted, but missing data
+ is known without going to the background queue.
+ 
+ @param key cache key (see VKCacheKey)
+ @return YES if there is an entry with such key in memory or on disk
+ */
+- (BOOL)containsCachedDataForKey:(NSString *)key;
+
+/** Retrieve cached data which matches to passed url asynchronously.
+ Reading and decompression are performed in the background queue, completion block
+ is called in the main queue. Parameters have the same meaning as in cachedDataForURL:maxStaleTime:isStale:
+ 
+ @param url url which matches to cached data
+ @param maxStaleTime number of seconds expired data can still be used
+ @param completion block which receives cached data (nil if it does not exist) and its staleness
+ */
+- (void)cachedDataForURL:(NSURL *)url
+            maxStaleTime:(NSTimeInterval)maxStaleTime
+              completion:(void (^)(NSData *data, BOOL isStale))completion;
+
+/** Retrieve cached data which matches to passed key asynchronously
+ 
+ @param key cache key (see VKCacheKey)
+ @param maxStaleTime number of seconds expired data can still be used
+ @param completion block which receives cached data (nil if it does not exist) and its staleness
+ */
+- (void)cachedDataForKey:(NSString *)key
+            maxStaleTime:(NSTimeInterval)maxStaleTime
+              completion:(void (^)(NSData *data, BOOL isStale))completion;
+
 @end
\ No newline at end of file
@@ -25,17 +25,48 @@
 // THE SOFTWARE.
 //
 #import "VKCachedData.h"
-#import "NSString+MD5.h"
+#import "VKCacheKey.h"
+#import "VKCacheLogStore.h"
+#import "VKMemoryCache.h"
+#import "NSData+zlib.h"
+#import "NSData+subdataNoCopy.h"
 
 
 #define INFO_LOG() NSLog(@"%s", __FUNCTION__)
 
 
+static const uint32_t kVKCachedDataEntryMagic = 0x45434b56; // "VKCE"
+static const uint16_t kVKCachedDataEntryVersion = 1;
+
+
+/** Decoded entry kept in the memory cache
+*/
+@interface VKCachedDataMemoryEntry : NSObject
+
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, assign) NSTimeInterval creationTime;
+@property (nonatomic, assign) NSTimeInterval liveTime;
+
+@end
+
+
+@implementation VKCachedDataMemoryEntry
+
+@end
+
+
+
 @implementation VKCachedData
 {
     NSString *_cacheDirectoryPath;
 
     dispatch_queue_t _backgroundQueue;
+
+//    ключи, удаление которых из хранилища еще не выполнено, и число еще не
+//    выполненных очисток: такие записи не читаются из хранилища и не попадают
+//    обратно в память
+    NSCountedSet *_pendingRemovals;
+    NSUInteger _pendingClearsCount;
 }
 
 #pragma mark Visible VKCachedData methods
@@ -49,9 +80,20 @@
 
     if (self) {
         [self createDirectoryIfNotExists:path];
-        _backgroundQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
+//        все обращения к хранилищу выполняются по очереди: запись, удаление и
+//        очистка, отправленные одна за другой, не должны поменяться местами
+        _backgroundQueue = dispatch_queue_create("VKCachedData.background", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(_backgroundQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
+        _compressionCodec = VKCachedDataCodecDeflate;
+        _compressionThreshold = kVKCachedDataDefaultCompressionThreshold;
 
         _cacheDirectoryPath = [path copy];
+        _store = [[VKCacheLogStore alloc] initWithDirectory:path];
+        _memoryCache = [[VKMemoryCache alloc] initWithCapacity:kVKMemoryCacheDefaultCapacity];
+        _pendingRemovals = [[NSCountedSet alloc] init];
+        _pendingClearsCount = 0;
+
+        [self removeLegacyEntries];
     }
 
     return self;
@@ -74,25 +116,105 @@
 {
     INFO_LOG();
 
+    [self addCachedData:cache
+                 forKey:[VKCacheKey keyForURL:url]
+               liveTime:cacheLiveTime];
+}
+
+- (void)addCachedData:(NSData *)cache
+               forKey:(NSString *)key
+             liveTime:(VKCachedDataLiveTime)cacheLiveTime
+{
+    INFO_LOG();
+
+    [self addCachedData:cache
+                 forKey:key
+               liveTime:cacheLiveTime
+           maxStaleTime:0
+       retainForOffline:NO];
+}
+
+- (void)addCachedData:(NSData *)cache
+               forKey:(NSString *)key
+             liveTime:(VKCachedDataLiveTime)cacheLiveTime
+         maxStaleTime:(NSTimeInterval)maxStaleTime
+     retainForOffline:(BOOL)retainForOffline
+{
+    INFO_LOG();
+
 //    нет надобности сохранять в кэше запрос с таким временем жизни
     if(VKCachedDataLiveTimeNever == cacheLiveTime)
         return;
 
+//    пустой ответ не кэшируется, а заменяет собой старый
+    if (nil == cache) {
+        [self removeCachedDataForKey:key];
+        return;
+    }
+
 //    сохраняем данные запроса в кэше
-    NSString *encodedCachedURL = [[url absoluteString] md5];
-    NSString *filePath = [_cacheDirectoryPath stringByAppendingFormat:@"%@",
-                                                                      encodedCachedURL];
-    NSUInteger creationTimestamp = ((NSUInteger) [[NSDate date]
-                                                          timeIntervalSince1970]);
+    NSTimeInterval creationTime = [[NSDate date] timeIntervalSince1970];
+
+//    в памяти запись появляется сразу, на диск попадает позже
+    VKCachedDataMemoryEntry *memoryEntry = [[VKCachedDataMemoryEntry alloc] init];
+    memoryEntry.data = [cache copy];
+    memoryEntry.creationTime = creationTime;
+    memoryEntry.liveTime = cacheLiveTime;
 
-    NSDictionary *options = @{@"liveTime"          : @(cacheLiveTime),
-                              @"data"              : (cache == nil ? [NSNull null] : cache),
-                              @"creationTimestamp" : @(creationTimestamp)};
+    [_memoryCache setObject:memoryEntry
+                     forKey:key
+                       cost:[cache length]];
+
+    VKCachedDataCodec codec = self.compressionCodec;
+    NSUInteger threshold = self.compressionThreshold;
+
+//    хранилище удалит запись в фоне, когда ее нельзя будет использовать даже
+//    устаревшей; сохраненные для оффлайн режима записи живут дольше, но тоже
+//    не вечно, неограниченное время использования (DBL_MAX) сводится к году
+    NSTimeInterval staleTime = MIN(maxStaleTime, VKCachedDataLiveTimeOneYear);
+
+    if (retainForOffline)
+        staleTime = MAX(staleTime, kVKCachedDataOfflineRetentionTime);
+
+    NSTimeInterval expirationTime = creationTime + cacheLiveTime + staleTime;
 
     dispatch_async(_backgroundQueue, ^
     {
-        [options writeToFile:filePath
-                  atomically:YES];
+//        сжатие выполняется в фоне, кодек выбирается для каждой записи отдельно
+        NSData *data = cache;
+        VKCachedDataCodec entryCodec = VKCachedDataCodecNone;
+
+        if (VKCachedDataCodecNone != codec && [cache length] >= threshold) {
+            NSData *compressedData = [cache deflatedData];
+
+//            плохо сжимаемые данные хранятся как есть
+            if (nil != compressedData && [compressedData length] < [cache length]) {
+                data = compressedData;
+                entryCodec = codec;
+            }
+        }
+
+//        заголовок фиксированного размера, за ним - данные как есть
+        VKCachedDataEntryHeader header;
+        memset(&header, 0, sizeof(header));
+
+        header.magic = kVKCachedDataEntryMagic;
+        header.version = kVKCachedDataEntryVersion;
+        header.codec = (uint16_t) entryCodec;
+        header.creationTime = creationTime;
+        header.liveTime = (uint32_t) cacheLiveTime;
+        header.flags = (retainForOffline ? kVKCachedDataEntryFlagRetainForOffline : 0);
+        header.dataLength = (uint32_t) [data length];
+        header.checksum = [data crc32Checksum];
+
+        NSMutableData *entryData = [NSMutableData dataWithCapacity:sizeof(header) + [data length]];
+        [entryData appendBytes:&header
+                        length:sizeof(header)];
+        [entryData appendData:data];
+
+        [_store setData:entryData
+                 forKey:key
+         expirationTime:expirationTime];
     });
 }
 
@@ -100,14 +222,25 @@
 {
     INFO_LOG();
 
-    NSString *encodedCachedURL = [[url absoluteString] md5];
-    NSString *filePath = [_cacheDirectoryPath stringByAppendingFormat:@"%@",
-                                                                      encodedCachedURL];
+    [self removeCachedDataForKey:[VKCacheKey keyForURL:url]];
+}
+
+- (void)removeCachedDataForKey:(NSString *)key
+{
+    INFO_LOG();
+
+    @synchronized (_pendingRemovals) {
+        [_pendingRemovals addObject:key];
+        [_memoryCache removeObjectForKey:key];
+    }
 
     dispatch_async(_backgroundQueue, ^
     {
-        [[NSFileManager defaultManager] removeItemAtPath:filePath
-                                                   error:nil];
+        [_store removeDataForKey:key];
+
+        @synchronized (_pendingRemovals) {
+            [_pendingRemovals removeObject:key];
+        }
     });
 }
 
@@ -115,17 +248,12 @@
 {
     INFO_LOG();
 
+    [self beginClear];
+
     dispatch_async(_backgroundQueue, ^{
 
-        [[NSFileManager defaultManager]
-                        removeItemAtPath:_cacheDirectoryPath
-                                   error:nil];
-
-        [[NSFileManager defaultManager]
-                        createDirectoryAtPath:_cacheDirectoryPath
-                  withIntermediateDirectories:YES
-                                   attributes:nil
-                                        error:nil];
+        [_store removeAllData];
+        [self endClear];
 
     });
 }
@@ -134,10 +262,14 @@
 {
     INFO_LOG();
 
+    [self beginClear];
+
     dispatch_async(_backgroundQueue, ^{
 
+        [_store removeAllData];
         [[NSFileManager defaultManager] removeItemAtPath:_cacheDirectoryPath
                                                    error:nil];
+        [self endClear];
 
     });
 }
@@ -154,34 +286,213 @@
 {
     INFO_LOG();
 
-    NSString *encodedCachedURL = [[url absoluteString] md5];
-    NSString *filePath = [_cacheDirectoryPath stringByAppendingFormat:@"%@",
-                                                                      encodedCachedURL];
+//    в оффлайн режиме устаревшие данные не удаляются
+    return [self cachedDataForURL:url
+                     maxStaleTime:(offlineMode ? DBL_MAX : 0)
+                          isStale:NULL];
+}
+
+- (NSData *)cachedDataForURL:(NSURL *)url
+                maxStaleTime:(NSTimeInterval)maxStaleTime
+                     isStale:(BOOL *)isStale
+{
+    INFO_LOG();
+
+    return [self cachedDataForKey:[VKCacheKey keyForURL:url]
+                     maxStaleTime:maxStaleTime
+                          isStale:isStale];
+}
+
+- (NSData *)cachedDataForKey:(NSString *)key
+                maxStaleTime:(NSTimeInterval)maxStaleTime
+                     isStale:(BOOL *)isStale
+{
+//    повторные чтения обслуживаются из памяти без обращения к диску
+    VKCachedDataMemoryEntry *memoryEntry = [_memoryCache objectForKey:key];
+
+    if (nil != memoryEntry) {
+        if (![self isEntryUsableWithCreationTime:memoryEntry.creationTime
+                                        liveTime:memoryEntry.liveTime
+                                    maxStaleTime:maxStaleTime
+                                         isStale:isStale])
+            return nil;
+
+//        порядок вытеснения с диска учитывает и чтения из памяти
+        [_store recordAccessForKey:key];
 
-    if (![[NSFileManager defaultManager] fileExistsAtPath:filePath])
+        return memoryEntry.data;
+    }
+
+//    запись, удаление которой еще не выполнено, уже считается удаленной
+    if ([self isRemovalPendingForKey:key])
         return nil;
 
-//    загружаем файл, получаем свойства
-    NSDictionary *cachedFile = [NSDictionary dictionaryWithContentsOfFile:filePath];
+    NSData *entryData = [_store dataForKey:key];
 
-    VKCachedDataLiveTime liveTime = (VKCachedDataLiveTime) [cachedFile[@"liveTime"] integerValue];
-    NSData *cachedData = cachedFile[@"data"];
-    NSUInteger creationTimestamp = [cachedFile[@"creationTimestamp"] unsignedIntegerValue];
+    if (nil == entryData)
+        return nil;
 
-//    определяем наши действия в соответствии с указанным временем жизни кэша запроса
-    NSUInteger currentTimestamp = ((NSUInteger) [[NSDate date]
-                                                         timeIntervalSince1970]);
-    if (!offlineMode && (creationTimestamp + liveTime) < currentTimestamp) {
-        [self removeCachedDataForURL:url];
+//    истекшие записи удаляются хранилищем в фоне, здесь удаляются только
+//    записи, которые нельзя прочитать
+//    для проверки времени жизни достаточно заголовка, данные записи при
+//    этом не читаются - сегменты хранилища отображены в память
+    VKCachedDataEntryHeader header;
+
+    if ([entryData length] < sizeof(header)) {
+        [self removeCachedDataForKey:key];
+        return nil;
+    }
+
+    memcpy(&header, [entryData bytes], sizeof(header));
+
+//    записи в другом формате (например, созданные прежними версиями) не читаются
+    if (kVKCachedDataEntryMagic != header.magic || kVKCachedDataEntryVersion != header.version ||
+            [entryData length] - sizeof(header) < header.dataLength) {
+        [self removeCachedDataForKey:key];
+        return nil;
+    }
+
+    if (![self isEntryUsableWithCreationTime:header.creationTime
+                                    liveTime:header.liveTime
+                                maxStaleTime:maxStaleTime
+                                     isStale:isStale])
+        return nil;
+
+//    данные не копируются - они ссылаются на отображенный в память сегмент
+    NSData *cachedData = [entryData subdataNoCopyWithRange:NSMakeRange(sizeof(header), header.dataLength)];
+
+//    поврежденная запись удаляется
+    if (header.checksum != [cachedData crc32Checksum]) {
+        [self removeCachedDataForKey:key];
         return nil;
     }
 
 //    кэш действителен
+    if (VKCachedDataCodecDeflate == header.codec)
+        cachedData = [cachedData inflatedData];
+
+    if (nil != cachedData) {
+        memoryEntry = [[VKCachedDataMemoryEntry alloc] init];
+        memoryEntry.data = cachedData;
+        memoryEntry.creationTime = header.creationTime;
+        memoryEntry.liveTime = header.liveTime;
+
+//        удаление, запрошенное во время чтения, не должно вернуть запись в память
+        @synchronized (_pendingRemovals) {
+            if (![self isRemovalPendingForKey:key])
+                [_memoryCache setObject:memoryEntry
+                                 forKey:key
+                                   cost:[cachedData length]];
+        }
+    }
+
     return cachedData;
 }
 
+- (BOOL)containsCachedDataForKey:(NSString *)key
+{
+    if ([_memoryCache containsObjectForKey:key])
+        return YES;
+
+    return (![self isRemovalPendingForKey:key] && [_store containsDataForKey:key]);
+}
+
+- (void)cachedDataForURL:(NSURL *)url
+            maxStaleTime:(NSTimeInterval)maxStaleTime
+              completion:(void (^)(NSData *data, BOOL isStale))completion
+{
+    INFO_LOG();
+
+    [self cachedDataForKey:[VKCacheKey keyForURL:url]
+              maxStaleTime:maxStaleTime
+                completion:completion];
+}
+
+- (void)cachedDataForKey:(NSString *)key
+            maxStaleTime:(NSTimeInterval)maxStaleTime
+              completion:(void (^)(NSData *data, BOOL isStale))completion
+{
+    INFO_LOG();
+
+    if (nil == completion)
+        return;
+
+    dispatch_async(_backgroundQueue, ^
+    {
+        BOOL isStale = NO;
+        NSData *data = [self cachedDataForKey:key
+                                 maxStaleTime:maxStaleTime
+                                      isStale:&isStale];
+
+        dispatch_async(dispatch_get_main_queue(), ^
+        {
+            completion(data, isStale);
+        });
+    });
+}
+
 #pragma mark - private methods
 
+- (BOOL)isEntryUsableWithCreationTime:(NSTimeInterval)creationTime
+                             liveTime:(NSTimeInterval)liveTime
+                         maxStaleTime:(NSTimeInterval)maxStaleTime
+                              isStale:(BOOL *)isStale
+{
+//    определяем наши действия в соответствии с указанным временем жизни кэша запроса
+    NSTimeInterval currentTime = [[NSDate date] timeIntervalSince1970];
+    NSTimeInterval expirationTime = creationTime + liveTime;
+    BOOL expired = (expirationTime < currentTime);
+
+    if (NULL != isStale)
+        *isStale = expired;
+
+//    устаревшие данные можно использовать еще какое-то время
+    return !expired || DBL_MAX == maxStaleTime || currentTime <= expirationTime + maxStaleTime;
+}
+
+- (BOOL)isRemovalPendingForKey:(NSString *)key
+{
+    @synchronized (_pendingRemovals) {
+        return (0 != _pendingClearsCount || 0 != [_pendingRemovals countForObject:key]);
+    }
+}
+
+- (void)beginClear
+{
+    @synchronized (_pendingRemovals) {
+        _pendingClearsCount++;
+        [_memoryCache removeAllObjects];
+    }
+}
+
+- (void)endClear
+{
+    @synchronized (_pendingRemovals) {
+        _pendingClearsCount--;
+    }
+}
+
+- (void)removeLegacyEntries
+{
+    INFO_LOG();
+
+//    раньше каждая запись хранилась в отдельном файле, имя которого - ключ из
+//    32 шестнадцатеричных цифр; такие файлы больше не читаются
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^
+    {
+        NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_cacheDirectoryPath
+                                                                                  error:nil];
+
+        for (NSString *fileName in fileNames) {
+            if (32 != [fileName length] || 0 != [[fileName pathExtension] length])
+                continue;
+
+            [[NSFileManager defaultManager] removeItemAtPath:[_cacheDirectoryPath stringByAppendingPathComponent:fileName]
+                                                       error:nil];
+        }
+    });
+}
+
 - (void)createDirectoryIfNotExists:(NSString *)path
 {
     INFO_LOG();
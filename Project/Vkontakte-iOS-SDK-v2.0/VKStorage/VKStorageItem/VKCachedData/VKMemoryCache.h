@@ -0,0 +1,127 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <Foundation/Foundation.h>
+
+
+/** Default capacity of the memory cache in bytes
+*/
+#define kVKMemoryCacheDefaultCapacity (4 * 1024 * 1024)
+
+
+/** In-memory cache of objects bounded by the total cost (usually size in bytes)
+of the stored objects.
+
+When the total cost exceeds capacity, least recently used objects are evicted.
+Reading and writing an object takes constant time and makes no syscalls.
+All stored objects are removed when application receives memory warning.
+
+All methods are thread safe.
+*/
+@interface VKMemoryCache : NSObject
+
+/**
+@name Properties
+*/
+/** Maximum total cost of the stored objects. Decreasing capacity evicts least
+recently used objects immediately
+*/
+@property (nonatomic, assign, readwrite) NSUInteger capacity;
+
+/** Total cost of the stored objects
+*/
+@property (nonatomic, assign, readonly) NSUInteger totalCost;
+
+/** Number of the stored objects
+*/
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/** Number of objectForKey: calls which found an object
+*/
+@property (nonatomic, assign, readonly) NSUInteger hitsCount;
+
+/** Number of objectForKey: calls which found nothing
+*/
+@property (nonatomic, assign, readonly) NSUInteger missesCount;
+
+/**
+@name Initialization methods
+*/
+/** Creates cache
+
+@param capacity maximum total cost of the stored objects
+@return VKMemoryCache instance
+*/
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+/**
+@name Objects
+*/
+/** Returns object and marks it as the most recently used
+
+@param key object key
+@return stored object or nil
+*/
+- (id)objectForKey:(id <NSCopying>)key;
+
+/** Checks whether object is stored. Unlike objectForKey: neither changes the
+order of objects nor counts as a hit or a miss
+
+@param key object key
+@return YES if there is an object with such key
+*/
+- (BOOL)containsObjectForKey:(id <NSCopying>)key;
+
+/** Stores object as the most recently used one, evicts least recently used
+objects if capacity is exceeded. Object which cost is greater than capacity is
+not stored (previous object with the same key is removed)
+
+@param object object to store
+@param key object key
+@param cost cost of the object, usually its size in bytes
+*/
+- (void)setObject:(id)object
+           forKey:(id <NSCopying>)key
+             cost:(NSUInteger)cost;
+
+/** Removes object
+
+@param key object key
+*/
+- (void)removeObjectForKey:(id <NSCopying>)key;
+
+/** Removes all objects
+*/
+- (void)removeAllObjects;
+
+/** Evicts least recently used objects until total cost is not greater than the
+passed one
+
+@param cost maximum total cost of objects left in the cache
+*/
+- (void)trimToCost:(NSUInteger)cost;
+
+@end
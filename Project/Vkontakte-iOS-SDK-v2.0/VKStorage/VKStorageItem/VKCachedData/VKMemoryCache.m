@@ -0,0 +1,274 @@
+//
+// Created by AndrewShmig on 10/17/26.
+//
+// Copyright (c) 2013 Andrew Shmig
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#import <UIKit/UIKit.h>
+#import "VKMemoryCache.h"
+
+
+/** Node of the usage list, head is the most recently used object
+*/
+@interface VKMemoryCacheNode : NSObject
+
+@property (nonatomic, strong) id key;
+@property (nonatomic, strong) id object;
+@property (nonatomic, assign) NSUInteger cost;
+
+@property (nonatomic, unsafe_unretained) VKMemoryCacheNode *previous;
+@property (nonatomic, unsafe_unretained) VKMemoryCacheNode *next;
+
+@end
+
+
+@implementation VKMemoryCacheNode
+
+@end
+
+
+@implementation VKMemoryCache
+{
+//    словарь владеет узлами, список только задает их порядок
+    NSMutableDictionary *_nodes;
+    VKMemoryCacheNode *_head;
+    VKMemoryCacheNode *_tail;
+
+    NSUInteger _capacity;
+    NSUInteger _totalCost;
+    NSUInteger _hitsCount;
+    NSUInteger _missesCount;
+}
+
+#pragma mark Visible VKMemoryCache methods
+#pragma mark - Init methods
+
+- (instancetype)init
+{
+    return [self initWithCapacity:kVKMemoryCacheDefaultCapacity];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    self = [super init];
+
+    if (self) {
+        _capacity = capacity;
+        _nodes = [[NSMutableDictionary alloc] init];
+
+        [[NSNotificationCenter defaultCenter]
+                               addObserver:self
+                                  selector:@selector(applicationDidReceiveMemoryWarning:)
+                                      name:UIApplicationDidReceiveMemoryWarningNotification
+                                    object:nil];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Setters & getters
+
+- (void)setCapacity:(NSUInteger)capacity
+{
+    @synchronized (self) {
+        _capacity = capacity;
+
+        [self trimToCost:capacity];
+    }
+}
+
+- (NSUInteger)capacity
+{
+    @synchronized (self) {
+        return _capacity;
+    }
+}
+
+- (NSUInteger)totalCost
+{
+    @synchronized (self) {
+        return _totalCost;
+    }
+}
+
+- (NSUInteger)count
+{
+    @synchronized (self) {
+        return [_nodes count];
+    }
+}
+
+- (NSUInteger)hitsCount
+{
+    @synchronized (self) {
+        return _hitsCount;
+    }
+}
+
+- (NSUInteger)missesCount
+{
+    @synchronized (self) {
+        return _missesCount;
+    }
+}
+
+#pragma mark - Objects
+
+- (id)objectForKey:(id <NSCopying>)key
+{
+    if (nil == key)
+        return nil;
+
+    @synchronized (self) {
+        VKMemoryCacheNode *node = _nodes[key];
+
+        if (nil == node) {
+            _missesCount++;
+            return nil;
+        }
+
+        _hitsCount++;
+
+        [self unlinkNode:node];
+        [self insertNodeAtHead:node];
+
+        return node.object;
+    }
+}
+
+- (BOOL)containsObjectForKey:(id <NSCopying>)key
+{
+    if (nil == key)
+        return NO;
+
+    @synchronized (self) {
+        return (nil != _nodes[key]);
+    }
+}
+
+- (void)setObject:(id)object
+           forKey:(id <NSCopying>)key
+             cost:(NSUInteger)cost
+{
+    if (nil == key)
+        return;
+
+    @synchronized (self) {
+        [self removeObjectForKey:key];
+
+        if (nil == object || cost > _capacity)
+            return;
+
+        VKMemoryCacheNode *node = [[VKMemoryCacheNode alloc] init];
+        node.key = key;
+        node.object = object;
+        node.cost = cost;
+
+        _nodes[key] = node;
+        _totalCost += cost;
+
+        [self insertNodeAtHead:node];
+        [self trimToCost:_capacity];
+    }
+}
+
+- (void)removeObjectForKey:(id <NSCopying>)key
+{
+    if (nil == key)
+        return;
+
+    @synchronized (self) {
+        VKMemoryCacheNode *node = _nodes[key];
+
+        if (nil == node)
+            return;
+
+        [self unlinkNode:node];
+        _totalCost -= node.cost;
+
+        [_nodes removeObjectForKey:key];
+    }
+}
+
+- (void)removeAllObjects
+{
+    @synchronized (self) {
+        _head = nil;
+        _tail = nil;
+        _totalCost = 0;
+
+        [_nodes removeAllObjects];
+    }
+}
+
+- (void)trimToCost:(NSUInteger)cost
+{
+    @synchronized (self) {
+        while (_totalCost > cost && nil != _tail)
+            [self removeObjectForKey:_tail.key];
+    }
+}
+
+#pragma mark - Private methods
+
+- (void)insertNodeAtHead:(VKMemoryCacheNode *)node
+{
+    node.previous = nil;
+    node.next = _head;
+
+    if (nil != _head)
+        _head.previous = node;
+
+    _head = node;
+
+    if (nil == _tail)
+        _tail = node;
+}
+
+- (void)unlinkNode:(VKMemoryCacheNode *)node
+{
+    if (nil != node.previous)
+        node.previous.next = node.next;
+    else
+        _head = node.next;
+
+    if (nil != node.next)
+        node.next.previous = node.previous;
+    else
+        _tail = node.previous;
+
+    node.previous = nil;
+    node.next = nil;
+}
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    [self removeAllObjects];
+}
+
+@end
@@ -26,11 +26,12 @@
 //
 #import <Foundation/Foundation.h>
 #import "VKCachedData.h"
+#import "VKRequest.h"
 
 
 @class VKAccessToken;
-@class VKRequest;
-@protocol VKRequestDelegate;
+@class VKRequestGroup;
+@class VKEntityStore;
 
 /**
  This class represents VKontakte user, which can issue API requests like
@@ -64,10 +65,15 @@
  VKRequest *userInfo = [[VKUser currentUser] info];
  
  // ... Something happend
- [userInfo start];
+ [[VKUser currentUser] startRequest:userInfo];
  
  Otherwise if there is no need in delayed request start
  [[VKUser currentUser] info];
+ 
+ Immediately started requests and requests passed to startRequest: go through the
+ shared VKRequestScheduler, which starts them respecting Vkontakte API rate limit
+ (and through VKRequestBatcher and VKRequestCoalescer if they are turned on).
+ Calling start of the request directly bypasses all of them.
  */
 @property (nonatomic, assign, readwrite) BOOL startAllRequestsImmediately;
 
@@ -76,6 +82,78 @@
  */
 @property (nonatomic, assign, readwrite) BOOL offlineMode;
 
+/** Keep cached responses of all requests issued by the user for offline mode, by
+ default equals to YES.
+
+ Expired cache entries are removed in the background. Responses cached while this
+ property is set to YES are removed only kVKCachedDataOfflineRetentionTime (one month)
+ after their expiration, so they can still be returned in offline mode meanwhile
+ (or evicted earlier when the cache exceeds its capacity, see cacheCapacity of VKStorage).
+ Set it to NO if the user never works offline, then expired responses stop occupying
+ the disk right away.
+ */
+@property (nonatomic, assign, readwrite) BOOL retainsCacheForOffline;
+
+/** Cache policy of all requests issued by the user, by default equals to
+ VKRequestCachePolicyCacheElseNetwork. Possible options can be found in
+ VKRequestCachePolicy enum
+ */
+@property (nonatomic, assign, readwrite) VKRequestCachePolicy cachePolicy;
+
+/** Automatic batching of requests, by default turned off.
+ 
+ If enabled, immediately started requests to API methods which do not change any
+ data (friends.get, groups.get, account.getCounters etc) are gathered by
+ VKRequestBatcher during a short time interval and executed with one execute
+ method call. Each request delegate receives its own result as usual.
+ */
+@property (nonatomic, assign, readwrite) BOOL batchRequestsAutomatically;
+
+/** Gather requests of items by ID into one call, by default equals to NO.
+
+ If enabled, immediately started requests to users.get (info, info:) and getById
+ methods (wallGetByID:, photosGetByID:, groupsGetByID:, audioGetByID:, docsGetByID:,
+ messagesGetByID: etc) with the same parameters which are issued during a short
+ time interval are executed by VKRequestCoalescer with one call with all their IDs.
+ Each request delegate receives its own items as usual.
+ */
+@property (nonatomic, assign, readwrite) BOOL coalesceRequestsAutomatically;
+
+/** Queue on which delegate methods of all requests issued by the user are called,
+ by default equals to the main queue. Responses are parsed on the network thread
+ before they reach this queue
+ */
+@property (nonatomic, strong, readwrite) dispatch_queue_t callbackQueue;
+
+/** Retry policy of all requests issued by the user, by default equals to nil -
+ requests are not retried. See VKRetryPolicy
+ */
+@property (nonatomic, strong, readwrite) VKRetryPolicy *retryPolicy;
+
+/** Priority class of all requests issued by the user, by default equals to
+ VKRequestPriorityInteractive. Requests created while it is set to VKRequestPriorityBackground
+ or VKRequestPriorityPrefetch do not delay interactive requests issued later
+ */
+@property (nonatomic, assign, readwrite) VKRequestPriority requestPriority;
+
+/** Store into which users, groups and posts of all responses are merged, by default
+ equals to nil - responses contain ordinary dictionaries. See VKEntityStore
+ */
+@property (nonatomic, strong, readwrite) VKEntityStore *entityStore;
+
+/** Number of seconds each request issued by the user has to be completed in, counted
+ from the moment request is started, so requests started later (see
+ startAllRequestsImmediately) do not expire before they start. By default equals
+ to 0 - requests have no deadline. See VKRequest timeout
+ */
+@property (nonatomic, assign, readwrite) NSTimeInterval requestTimeout;
+
+/** Group all requests issued by the user are added to. Cancelling the group
+ (for example when user logs out) cancels every queued and executing request of the user.
+ Group is also cancelled when another user is activated and this object is released
+ */
+@property (nonatomic, strong, readonly) VKRequestGroup *requestGroup;
+
 /**
  @name Available methods
  */
@@ -116,6 +194,17 @@
  */
 + (NSArray *)localUsers;
 
+/** Starts request created while startAllRequestsImmediately was set to NO
+
+ Request is passed to VKRequestCoalescer or VKRequestBatcher if coalesceRequestsAutomatically
+ or batchRequestsAutomatically is turned on and the request can be coalesced or
+ batched, otherwise to the shared VKRequestScheduler, which starts it respecting
+ Vkontakte API rate limit.
+
+ @param request request created by this user
+ */
+- (void)startRequest:(VKRequest *)request;
+
 /**
  @name Users
  */
@@ -30,6 +30,10 @@
 #import "VKAccessToken.h"
 #import "VKRequest.h"
 #import "VKMethods.h"
+#import "VKRequestGroup.h"
+#import "VKRequestScheduler.h"
+#import "VKRequestBatcher.h"
+#import "VKRequestCoalescer.h"
 
 
 @implementation VKUser
@@ -48,6 +52,14 @@
         _storageItem = storageItem;
         _startAllRequestsImmediately = YES;
         _offlineMode = NO;
+        _retainsCacheForOffline = YES;
+        _cachePolicy = VKRequestCachePolicyCacheElseNetwork;
+        _batchRequestsAutomatically = NO;
+        _coalesceRequestsAutomatically = NO;
+        _callbackQueue = dispatch_get_main_queue();
+        _requestTimeout = 0;
+        _requestPriority = VKRequestPriorityInteractive;
+        _requestGroup = [[VKRequestGroup alloc] init];
     }
 
     return self;
@@ -111,6 +123,29 @@ static VKUser *_currentUser;
     return localUsers;
 }
 
+#pragma mark - Requests
+
+- (void)startRequest:(VKRequest *)request
+{
+//    запросы профилей объединяются в один users.get
+    if (self.coalesceRequestsAutomatically && [[VKRequestCoalescer sharedCoalescer] canCoalesceRequest:request]) {
+        [[VKRequestCoalescer sharedCoalescer] addRequest:request
+                                                   token:self.accessToken.token];
+        return;
+    }
+
+//    независимые запросы на чтение можно объединить в один execute
+    if (self.batchRequestsAutomatically && [[VKRequestBatcher sharedBatcher] canBatchRequest:request]) {
+        [[VKRequestBatcher sharedBatcher] addRequest:request
+                                               token:self.accessToken.token];
+        return;
+    }
+
+//    запросы стартует планировщик, соблюдая ограничение на частоту запросов к API
+    [[VKRequestScheduler sharedScheduler] scheduleRequest:request
+                                                    token:self.accessToken.token];
+}
+
 #pragma mark - Users
 
 - (VKRequest *)info
@@ -2174,10 +2209,19 @@ static VKUser *_currentUser;
 
     req.signature = NSStringFromSelector(selector);
     req.offlineMode = self.offlineMode;
+    req.retainsCacheForOffline = self.retainsCacheForOffline;
+    req.cachePolicy = self.cachePolicy;
+    req.callbackQueue = self.callbackQueue;
+    req.retryPolicy = self.retryPolicy;
+    req.priority = self.requestPriority;
+    req.entityStore = self.entityStore;
+    req.timeout = self.requestTimeout;
     req.delegate = self.delegate;
 
+    [self.requestGroup addRequest:req];
+
     if (self.startAllRequestsImmediately)
-        [req start];
+        [self startRequest:req];
 
     return req;
 }